@@ -0,0 +1,224 @@
+#ifndef SYNTHETICAGGREGATES_HPP
+#define SYNTHETICAGGREGATES_HPP
+
+// Synthetic PSD1, PHA1 and PSD2 aggregates shared by the decoder benchmark
+// and the decoder check. The layouts follow RefMaterials/PSD1_Data,
+// PHA1_Data and the PSD2 data format; every workload is generated from a
+// fixed seed, so it is identical on every machine.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "ByteSwap.hpp"
+#include "IDigitizer.hpp"
+#include "PSD1Constants.hpp"
+#include "PSD2Constants.hpp"
+
+namespace SyntheticAggregates
+{
+
+using namespace DELILA::Digitizer;
+
+// ============================================================================
+// Scenarios
+// ============================================================================
+
+struct Scenario {
+  const char *name;
+  FirmwareType type;
+  uint32_t channels;        // Dig1: two per channel pair
+  uint32_t eventsPerBlock;  // Dig1: per channel pair, PSD2: per aggregate
+  uint32_t samples;         // Record length, 0 = no waveform
+  bool dualTrace;           // Dig1 only
+  bool extras;              // Dig1 only, extras word with option 0b010
+};
+
+inline const Scenario kScenarios[] = {
+    {"psd1 16ch no-wave extras", FirmwareType::PSD1, 16, 64, 0, false, true},
+    {"psd1 16ch no-wave", FirmwareType::PSD1, 16, 64, 0, false, false},
+    {"psd1 16ch rl=64", FirmwareType::PSD1, 16, 16, 64, false, true},
+    {"psd1 16ch rl=64 dual-trace", FirmwareType::PSD1, 16, 16, 64, true, true},
+    {"psd1 4ch rl=512", FirmwareType::PSD1, 4, 8, 512, false, true},
+    {"pha1 16ch no-wave extras", FirmwareType::PHA1, 16, 64, 0, false, true},
+    {"pha1 16ch no-wave", FirmwareType::PHA1, 16, 64, 0, false, false},
+    {"pha1 16ch rl=64", FirmwareType::PHA1, 16, 16, 64, false, true},
+    {"pha1 16ch rl=64 dual-trace", FirmwareType::PHA1, 16, 16, 64, true, true},
+    {"psd2 64ch no-wave", FirmwareType::PSD2, 64, 512, 0, false, false},
+    {"psd2 64ch rl=128", FirmwareType::PSD2, 64, 128, 128, false, false},
+    {"psd2 64ch rl=1024", FirmwareType::PSD2, 64, 32, 1024, false, false},
+};
+
+// Distinct aggregates generated per scenario; the run cycles through them
+constexpr size_t kDistinctAggregates = 16;
+
+struct Workload {
+  std::vector<std::vector<uint8_t>> aggregates;
+  std::vector<uint32_t> nEvents;
+  std::vector<uint8_t> startRecord;  // PSD2 only
+  size_t maxSize = 0;
+};
+
+// ============================================================================
+// Dig1 (PSD1 / PHA1) aggregates
+// ============================================================================
+
+// PHA1 shares the board header, channel header flag positions and event
+// layout with PSD1; its energy word sits where PSD1 has the charge word
+inline std::vector<uint8_t> MakeDig1Aggregate(std::mt19937 &rng, const Scenario &s,
+                                       uint32_t &nEvents)
+{
+  using namespace PSD1Constants;
+  const uint32_t pairs = std::max<uint32_t>(s.channels / 2, 1);
+  const uint32_t samplesPer8 = s.samples / Waveform::kSamplesPerGroup;
+  const size_t waveWords = samplesPer8 * Waveform::kSamplesPerWord;
+
+  std::vector<uint32_t> words(BoardHeader::kHeaderSizeWords);
+  uint32_t pairMask = 0;
+  nEvents = 0;
+
+  for (uint32_t pair = 0; pair < pairs; ++pair) {
+    pairMask |= 1u << pair;
+    size_t blockStart = words.size();
+    words.resize(blockStart + ChannelHeader::kHeaderSizeWords);
+
+    words[blockStart + 1] =
+        samplesPer8 | (1u << ChannelHeader::kDigitalProbe1Shift) |
+        (2u << ChannelHeader::kDigitalProbe2Shift) |
+        (1u << ChannelHeader::kAnalogProbeShift) |
+        (uint32_t{ExtraFormats::kExtendedFlagsFineTT}
+         << ChannelHeader::kExtraOptionShift) |
+        (uint32_t{s.samples > 0} << ChannelHeader::kSamplesEnabledShift) |
+        (uint32_t{s.extras} << ChannelHeader::kExtrasEnabledShift) |
+        (1u << ChannelHeader::kTimeEnabledShift) |
+        (1u << ChannelHeader::kChargeEnabledShift) |
+        (uint32_t{s.dualTrace} << ChannelHeader::kDualTraceShift);
+
+    uint32_t timeTag = rng() & 0x3FFFFFF;
+    for (uint32_t i = 0; i < s.eventsPerBlock; ++i) {
+      timeTag += 1 + rng() % 5000;
+      words.push_back((timeTag & Event::kTriggerTimeTagMask) |
+                      ((rng() & 1u) << Event::kChannelFlagShift));
+      for (size_t w = 0; w < waveWords; ++w) {
+        words.push_back(rng() & 0x3FFF3FFF);
+      }
+      if (s.extras) {
+        words.push_back((rng() & (Event::kExtendedTimeMask
+                                  << Event::kExtendedTimeShift)) |
+                        (rng() & Event::kFineTimeStampMask));
+      }
+      words.push_back(((100 + rng() % 30000) << Event::kChargeLongShift) |
+                      (50 + rng() % 10000));
+      nEvents++;
+    }
+    words[blockStart] = (1u << ChannelHeader::kDualChannelHeaderShift) |
+                        static_cast<uint32_t>(words.size() - blockStart);
+  }
+
+  words[0] = (BoardHeader::kTypeData << BoardHeader::kTypeShift) |
+             static_cast<uint32_t>(words.size());
+  words[1] = pairMask;
+  words[2] = 0;  // Aggregate counter, set per buffer by Run()
+  words[3] = rng();
+
+  std::vector<uint8_t> bytes(words.size() * kWordSize);
+  std::memcpy(bytes.data(), words.data(), bytes.size());
+  return bytes;
+}
+
+inline void SetDig1Counter(uint8_t *data, uint32_t counter)
+{
+  uint32_t word = counter & PSD1Constants::BoardHeader::kBoardCounterMask;
+  std::memcpy(data + 2 * PSD1Constants::kWordSize, &word, sizeof(word));
+}
+
+// ============================================================================
+// PSD2 aggregates (big endian, as read from the board)
+// ============================================================================
+
+inline std::vector<uint8_t> ToBigEndian(std::vector<uint64_t> words)
+{
+  std::vector<uint8_t> bytes(words.size() * PSD2Constants::kWordSize);
+  std::memcpy(bytes.data(), words.data(), bytes.size());
+  ByteSwap::SwapWords64(bytes.data(), words.size());
+  return bytes;
+}
+
+inline std::vector<uint8_t> MakePSD2Start()
+{
+  using namespace PSD2Constants::StartStop;
+  return ToBigEndian({kStartFirstWordType << kSignalTypeShift,
+                      kStartSecondWordType << kSignalSubTypeShift,
+                      kStartThirdWordType << kSignalSubTypeShift,
+                      kStartFourthWordType << kSignalSubTypeShift});
+}
+
+inline std::vector<uint8_t> MakePSD2Aggregate(std::mt19937 &rng, const Scenario &s,
+                                       uint32_t &nEvents)
+{
+  using namespace PSD2Constants;
+  const uint64_t waveWords = s.samples / 2;  // 2 points per word
+
+  std::vector<uint64_t> words(1);
+  uint64_t timeStamp = rng() & 0xFFFFFF;
+  for (uint32_t i = 0; i < s.eventsPerBlock; ++i) {
+    timeStamp += 1 + rng() % 1000;
+    uint64_t channel = rng() % s.channels;
+    words.push_back((channel << Event::kChannelShift) |
+                    (timeStamp & Event::kTimeStampMask));
+    words.push_back(
+        (uint64_t{waveWords == 0} << Event::kLastWordShift) |
+        (uint64_t{waveWords > 0} << Event::kWaveformFlagShift) |
+        ((rng() & Event::kEnergyShortMask) << Event::kEnergyShortShift) |
+        ((rng() & Event::kFineTimeMask) << Event::kFineTimeShift) |
+        (rng() & Event::kEnergyMask));
+    if (waveWords > 0) {
+      words.push_back((1ULL << Waveform::kWaveformCheck1Shift) |
+                      (1ULL << Waveform::kTimeResolutionShift) |
+                      (1ULL << Waveform::kDigitalProbe1TypeShift) |
+                      (2ULL << Waveform::kAnalogProbe2TypeShift));
+      words.push_back(waveWords);
+      for (uint64_t w = 0; w < waveWords; ++w) {
+        words.push_back((uint64_t{rng()} << 32) | rng());
+      }
+    }
+  }
+  nEvents = s.eventsPerBlock;
+  words[0] = (Header::kTypeData << Header::kTypeShift) | words.size();
+  return ToBigEndian(std::move(words));
+}
+
+inline void SetPSD2Counter(uint8_t *data, uint32_t counter)
+{
+  using namespace PSD2Constants::Header;
+  uint64_t word;
+  std::memcpy(&word, data, sizeof(word));
+  word = ByteSwap::Swap64(word);
+  word &= ~(kAggregateCounterMask << kAggregateCounterShift);
+  word |= (counter & kAggregateCounterMask) << kAggregateCounterShift;
+  word = ByteSwap::Swap64(word);
+  std::memcpy(data, &word, sizeof(word));
+}
+
+inline Workload MakeWorkload(const Scenario &s)
+{
+  std::mt19937 rng(12345);
+  Workload workload;
+  for (size_t i = 0; i < kDistinctAggregates; ++i) {
+    uint32_t nEvents = 0;
+    workload.aggregates.push_back(s.type == FirmwareType::PSD2
+                                      ? MakePSD2Aggregate(rng, s, nEvents)
+                                      : MakeDig1Aggregate(rng, s, nEvents));
+    workload.nEvents.push_back(nEvents);
+    workload.maxSize =
+        std::max(workload.maxSize, workload.aggregates.back().size());
+  }
+  if (s.type == FirmwareType::PSD2) workload.startRecord = MakePSD2Start();
+  return workload;
+}
+
+}  // namespace SyntheticAggregates
+
+#endif  // SYNTHETICAGGREGATES_HPP
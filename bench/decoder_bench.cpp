@@ -0,0 +1,279 @@
+// Decoder throughput benchmark
+//
+// Feeds synthetic PSD1, PHA1 and PSD2 aggregates through IDecoder::AddData()
+// and drains them with GetEventData() (or GetEventBatch()), reporting MB/s,
+// events/s and heap allocations per event for 1..N decode threads. No
+// hardware is needed, so it can run on any build machine. With --trace the
+// PipelineTracer is on and the per-stage span percentiles follow each row.
+//
+// Usage: decoder_bench [--threads N] [--aggregates N] [--batch]
+//                      [--filter TEXT] [--trace]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ByteSwap.hpp"
+#include "IDecoder.hpp"
+#include "IDigitizer.hpp"
+#include "PHA1Decoder.hpp"
+#include "PSD1Decoder.hpp"
+#include "PSD2Decoder.hpp"
+#include "PipelineTracer.hpp"
+#include "RawDataPool.hpp"
+#include "SyntheticAggregates.hpp"
+
+using namespace DELILA::Digitizer;
+using namespace SyntheticAggregates;
+
+// ============================================================================
+// Allocation counting
+// ============================================================================
+
+namespace
+{
+std::atomic<uint64_t> gAllocations{0};
+
+void *CountedAlloc(size_t size)
+{
+  gAllocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size ? size : 1)) return p;
+  throw std::bad_alloc();
+}
+}  // namespace
+
+void *operator new(size_t size) { return CountedAlloc(size); }
+void *operator new[](size_t size) { return CountedAlloc(size); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+void operator delete[](void *p, size_t) noexcept { std::free(p); }
+
+namespace
+{
+
+// Buffers in the raw data pool of each run
+constexpr size_t kPoolBuffers = 64;
+
+// ============================================================================
+// Measurement
+// ============================================================================
+
+struct Result {
+  double seconds = 0.0;
+  uint64_t bytes = 0;
+  uint64_t events = 0;
+  uint64_t expectedEvents = 0;
+  uint64_t allocations = 0;
+  DigitizerStatistics trace;  // traceStages only, with --trace
+};
+
+std::unique_ptr<IDecoder> MakeDecoder(FirmwareType type, uint32_t threads)
+{
+  switch (type) {
+    case FirmwareType::PSD1:
+      return std::make_unique<PSD1Decoder>(threads);
+    case FirmwareType::PHA1:
+      return std::make_unique<PHA1Decoder>(threads);
+    default:
+      return std::make_unique<PSD2Decoder>(threads);
+  }
+}
+
+std::unique_ptr<RawData_t> AcquireBuffer(RawDataPool &pool)
+{
+  auto rawData = pool.Acquire();
+  while (!rawData) rawData = pool.Acquire();
+  return rawData;
+}
+
+Result Run(const Scenario &s, const Workload &workload, uint32_t threads,
+           size_t nAggregates, bool batchOutput, bool trace)
+{
+  auto decoder = MakeDecoder(s.type, threads);
+  std::shared_ptr<PipelineTracer> tracer;
+  if (trace) {
+    PipelineTraceConfig config;
+    config.enabled = true;
+    tracer = std::make_shared<PipelineTracer>(config, 0);
+    decoder->SetTracer(tracer);
+  }
+  auto pool = std::make_shared<RawDataPool>(workload.maxSize, kPoolBuffers);
+  decoder->SetTimeStep(2);
+  decoder->SetRawDataPool(pool);
+  decoder->SetOutputFormat(batchOutput ? OutputFormat::EventBatch
+                                       : OutputFormat::EventData);
+
+  uint64_t sequence = 0;
+  if (!workload.startRecord.empty()) {
+    auto rawData = AcquireBuffer(*pool);
+    std::memcpy(rawData->data.data(), workload.startRecord.data(),
+                workload.startRecord.size());
+    rawData->size = workload.startRecord.size();
+    rawData->sequence = sequence++;
+    decoder->AddData(std::move(rawData));
+  }
+
+  Result result;
+  for (size_t i = 0; i < nAggregates; ++i) {
+    result.expectedEvents += workload.nEvents[i % workload.nEvents.size()];
+  }
+
+  // Drain on a separate thread, as a DAQ consumer would
+  std::atomic<bool> fed{false};
+  std::atomic<uint64_t> received{0};
+  auto drain = [&]() {
+    auto lastProgress = std::chrono::steady_clock::now();
+    while (received < result.expectedEvents) {
+      size_t n = 0;
+      if (batchOutput) {
+        auto batch = decoder->GetEventBatch();
+        n = batch ? batch->Size() : 0;
+        decoder->ReleaseEventBatch(std::move(batch));
+      } else {
+        auto events = decoder->GetEventData();
+        n = events ? events->size() : 0;
+      }
+
+      auto now = std::chrono::steady_clock::now();
+      if (n > 0) {
+        received += n;
+        lastProgress = now;
+      } else if (fed && now - lastProgress > std::chrono::seconds(5)) {
+        break;  // Events were lost, reported as incomplete
+      } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+      }
+    }
+  };
+
+  auto allocationsBefore = gAllocations.load();
+  auto start = std::chrono::steady_clock::now();
+  std::thread consumer(drain);
+
+  for (size_t i = 0; i < nAggregates; ++i) {
+    const auto index = i % workload.aggregates.size();
+    const auto &aggregate = workload.aggregates[index];
+    auto rawData = AcquireBuffer(*pool);
+    auto readTicks = tracer ? PipelineTracer::Now() : 0;
+    std::memcpy(rawData->data.data(), aggregate.data(), aggregate.size());
+    if (s.type == FirmwareType::PSD2) {
+      SetPSD2Counter(rawData->data.data(), static_cast<uint32_t>(i));
+    } else {
+      SetDig1Counter(rawData->data.data(), static_cast<uint32_t>(i));
+    }
+    rawData->size = aggregate.size();
+    rawData->nEvents = workload.nEvents[index];
+    rawData->sequence = sequence++;
+    if (tracer) {
+      tracer->Record(TraceStage::Read, rawData->sequence, readTicks,
+                     PipelineTracer::Now());
+    }
+    result.bytes += aggregate.size();
+    decoder->AddData(std::move(rawData));
+  }
+  fed = true;
+  consumer.join();
+
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  result.allocations = gAllocations.load() - allocationsBefore;
+  result.events = received;
+  if (tracer) tracer->Fill(result.trace);
+  return result;
+}
+
+void PrintUsage(const char *program)
+{
+  std::printf(
+      "Usage: %s [--threads N] [--aggregates N] [--batch] [--filter TEXT]\n"
+      "          [--trace]\n"
+      "  --threads N     Largest decode thread count (default: all cores)\n"
+      "  --aggregates N  Aggregates fed per measurement (default 2000)\n"
+      "  --batch         Drain with GetEventBatch() instead of "
+      "GetEventData()\n"
+      "  --filter TEXT   Only run scenarios whose name contains TEXT\n"
+      "  --trace         Trace the pipeline and print stage percentiles\n",
+      program);
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+  uint32_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  size_t nAggregates = 2000;
+  bool batchOutput = false;
+  bool trace = false;
+  std::string filter;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--threads" && hasValue) {
+      maxThreads = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--aggregates" && hasValue) {
+      nAggregates = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--batch") {
+      batchOutput = true;
+    } else if (arg == "--filter" && hasValue) {
+      filter = argv[++i];
+    } else if (arg == "--trace") {
+      trace = true;
+    } else {
+      PrintUsage(argv[0]);
+      return arg == "--help" ? 0 : 1;
+    }
+  }
+
+  std::vector<uint32_t> threadCounts;
+  for (uint32_t n = 1; n < maxThreads; n *= 2) threadCounts.push_back(n);
+  threadCounts.push_back(maxThreads);
+
+  std::printf("Output: %s, %zu aggregates per run, byte swap: %s\n\n",
+              batchOutput ? "EventBatch" : "EventData", nAggregates,
+              ByteSwap::GetKernelName());
+  std::printf("%-28s %7s %10s %12s %13s %8s\n", "scenario", "threads",
+              "MB/s", "Mevents/s", "allocs/event", "events");
+
+  bool complete = true;
+  for (const auto &scenario : kScenarios) {
+    if (!filter.empty() &&
+        std::string(scenario.name).find(filter) == std::string::npos) {
+      continue;
+    }
+
+    auto workload = MakeWorkload(scenario);
+    for (auto threads : threadCounts) {
+      auto r =
+          Run(scenario, workload, threads, nAggregates, batchOutput, trace);
+      bool ok = r.events == r.expectedEvents;
+      complete &= ok;
+      std::printf("%-28s %7u %10.1f %12.3f %13.3f %8llu%s\n", scenario.name,
+                  threads, r.bytes / r.seconds / 1e6,
+                  r.events / r.seconds / 1e6,
+                  r.events ? static_cast<double>(r.allocations) / r.events
+                           : 0.0,
+                  static_cast<unsigned long long>(r.events),
+                  ok ? "" : " INCOMPLETE");
+      for (size_t stage = 0; trace && stage < kNumTraceStages; ++stage) {
+        const auto &latency = r.trace.traceStages[stage];
+        if (latency.count == 0) continue;
+        std::printf("  %-8s p50 %9.1f us  p99 %9.1f us  max %9.1f us\n",
+                    GetTraceStageName(static_cast<TraceStage>(stage)),
+                    latency.p50Ns / 1e3, latency.p99Ns / 1e3,
+                    latency.maxNs / 1e3);
+      }
+    }
+  }
+  return complete ? 0 : 1;
+}
@@ -0,0 +1,841 @@
+// Decoder output check and fuzzer
+//
+// Decodes fixed aggregates in every decoder mode and checks that the
+// output is bit-identical to a serial, scalar reference: EventData vs
+// EventBatch, Decode vs Lazy/Compact + UnpackWaveform, serial vs parallel
+// channel-pair blocks, one vs several decode threads, and each byte swap
+// kernel the CPU supports. The fixtures are the synthetic workloads of
+// decoder_bench, or raw run files written by RawRecorder (so recordings of
+// real boards can be added). Event counts, digests and events/s of each
+// fixture can be recorded to a reference file and later runs compared with
+// it, so a change that alters the decoded output or slows a fixture down
+// shows up. Every fixture is then mutated (bit flips, truncation, corrupted
+// size words, garbage) and fed through the modes again; the decoders must
+// neither crash nor emit events that could not have come from the buffer.
+// Build with DELILA_CHECKED_READS=ON (and -fsanitize=address) to catch
+// reads past a buffer that do not crash.
+//
+// Usage: decoder_check [--fixtures DIR] [--write-fixtures DIR]
+//                      [--reference FILE] [--record FILE]
+//                      [--max-slowdown X] [--fuzz N] [--seed N]
+//                      [--filter TEXT]
+
+#include <dirent.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ByteSwap.hpp"
+#include "DecoderLogger.hpp"
+#include "IDecoder.hpp"
+#include "IDigitizer.hpp"
+#include "PHA1Decoder.hpp"
+#include "PSD1Decoder.hpp"
+#include "PSD2Decoder.hpp"
+#include "RawDataPool.hpp"
+#include "RawFileFormat.hpp"
+#include "SyntheticAggregates.hpp"
+
+using namespace DELILA::Digitizer;
+
+namespace
+{
+
+constexpr uint8_t kModuleNumber = 3;
+constexpr uint32_t kDefaultTimeStep = 2;
+constexpr size_t kPoolBuffers = 64;
+// Events each throughput measurement decodes at least
+constexpr uint64_t kMinThroughputEvents = 200000;
+constexpr auto kDrainTimeout = std::chrono::seconds(30);
+
+// ============================================================================
+// Fixtures
+// ============================================================================
+
+struct Fixture {
+  std::string id;  // No whitespace, used in the reference file
+  FirmwareType type = FirmwareType::UNKNOWN;
+  uint32_t timeStep = kDefaultTimeStep;
+  std::vector<std::vector<uint8_t>> buffers;  // Readout order
+  std::vector<uint32_t> nEvents;              // As reported by the board
+  uint64_t expectedEvents = 0;                // 0 = not known
+};
+
+std::string MakeId(const std::string &name)
+{
+  std::string id;
+  for (char c : name) {
+    bool keep = std::isalnum(static_cast<unsigned char>(c)) != 0;
+    if (keep) {
+      id += c;
+    } else if (!id.empty() && id.back() != '_') {
+      id += '_';
+    }
+  }
+  return id;
+}
+
+Fixture MakeSyntheticFixture(const SyntheticAggregates::Scenario &scenario)
+{
+  auto workload = SyntheticAggregates::MakeWorkload(scenario);
+
+  Fixture fixture;
+  fixture.id = MakeId(scenario.name);
+  fixture.type = scenario.type;
+  if (!workload.startRecord.empty()) {
+    fixture.buffers.push_back(workload.startRecord);
+    fixture.nEvents.push_back(0);
+  }
+  for (size_t i = 0; i < workload.aggregates.size(); ++i) {
+    auto aggregate = workload.aggregates[i];
+    if (scenario.type == FirmwareType::PSD2) {
+      SyntheticAggregates::SetPSD2Counter(aggregate.data(),
+                                          static_cast<uint32_t>(i));
+    } else {
+      SyntheticAggregates::SetDig1Counter(aggregate.data(),
+                                          static_cast<uint32_t>(i));
+    }
+    fixture.buffers.push_back(std::move(aggregate));
+    fixture.nEvents.push_back(workload.nEvents[i]);
+    fixture.expectedEvents += workload.nEvents[i];
+  }
+  return fixture;
+}
+
+// <id>_mod<NN>_0000.raw, as RawRecorder names the first file of a module
+std::string FixtureFileName(const Fixture &fixture)
+{
+  return fixture.id + "_mod00_0000.raw";
+}
+
+std::string IdFromFileName(std::string name)
+{
+  name = name.substr(0, name.size() - 4);  // .raw
+  const std::string suffix = "_0000";
+  auto mod = name.rfind("_mod");
+  if (mod != std::string::npos && name.size() == mod + 6 + suffix.size() &&
+      name.compare(mod + 6, suffix.size(), suffix) == 0) {
+    name.resize(mod);
+  }
+  return MakeId(name);
+}
+
+bool WriteFixture(const Fixture &fixture, const std::string &dir)
+{
+  auto path = dir + "/" + FixtureFileName(fixture);
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    std::fprintf(stderr, "Cannot create %s\n", path.c_str());
+    return false;
+  }
+
+  RawFile::FileHeader header{};
+  std::memcpy(header.magic, RawFile::kRunMagic, sizeof(header.magic));
+  header.version = RawFile::kVersion;
+  header.headerSize = sizeof(header);
+  header.firmwareType = static_cast<uint32_t>(fixture.type);
+  header.timeStepNs = fixture.timeStep;
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+  for (size_t i = 0; i < fixture.buffers.size(); ++i) {
+    RawFile::RecordHeader record{};
+    record.size = fixture.buffers[i].size();
+    record.sequence = i;
+    record.nEvents = fixture.nEvents[i];
+    file.write(reinterpret_cast<const char *>(&record), sizeof(record));
+    file.write(reinterpret_cast<const char *>(fixture.buffers[i].data()),
+               fixture.buffers[i].size());
+  }
+  return static_cast<bool>(file);
+}
+
+bool ReadFixture(const std::string &path, Fixture &fixture)
+{
+  std::ifstream file(path, std::ios::binary);
+  RawFile::FileHeader header{};
+  if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+      std::memcmp(header.magic, RawFile::kRunMagic, sizeof(header.magic)) !=
+          0 ||
+      header.version != RawFile::kVersion ||
+      header.headerSize < sizeof(header)) {
+    std::fprintf(stderr, "%s is not a raw data run file\n", path.c_str());
+    return false;
+  }
+  file.seekg(header.headerSize);
+
+  fixture.type = static_cast<FirmwareType>(header.firmwareType);
+  fixture.timeStep = header.timeStepNs ? header.timeStepNs : kDefaultTimeStep;
+  RawFile::RecordHeader record{};
+  while (file.read(reinterpret_cast<char *>(&record), sizeof(record))) {
+    std::vector<uint8_t> buffer(record.size);
+    if (!file.read(reinterpret_cast<char *>(buffer.data()), record.size)) {
+      std::fprintf(stderr, "Warning: %s ends with a truncated record\n",
+                   path.c_str());
+      break;
+    }
+    fixture.buffers.push_back(std::move(buffer));
+    fixture.nEvents.push_back(record.nEvents);
+  }
+  return true;
+}
+
+bool LoadFixtures(const std::string &dir, std::vector<Fixture> &fixtures)
+{
+  DIR *handle = opendir(dir.c_str());
+  if (!handle) {
+    std::fprintf(stderr, "Cannot open %s\n", dir.c_str());
+    return false;
+  }
+  std::vector<std::string> names;
+  while (auto *entry = readdir(handle)) {
+    std::string name = entry->d_name;
+    if (name.size() > 4 && name.compare(name.size() - 4, 4, ".raw") == 0) {
+      names.push_back(name);
+    }
+  }
+  closedir(handle);
+  std::sort(names.begin(), names.end());
+
+  for (const auto &name : names) {
+    Fixture fixture;
+    fixture.id = IdFromFileName(name);
+    if (!ReadFixture(dir + "/" + name, fixture)) return false;
+    fixtures.push_back(std::move(fixture));
+  }
+  return true;
+}
+
+// ============================================================================
+// Decoder Modes
+// ============================================================================
+
+struct Mode {
+  const char *name;
+  OutputFormat output;
+  WaveformMode waveform;
+  uint32_t decodeThreads;
+  uint32_t pairThreads;
+  OutputOrder order;
+  const char *swapKernel;  // ByteSwap kernel, nullptr = automatic
+
+  // Events come out in readout order, so the sequence can be compared
+  bool Ordered() const
+  {
+    return decodeThreads == 1 || order == OutputOrder::Sequence;
+  }
+};
+
+// The first mode is the reference the others are compared with
+const Mode kModes[] = {
+    {"reference", OutputFormat::EventData, WaveformMode::Decode, 1, 1,
+     OutputOrder::None, "scalar"},
+    {"batch", OutputFormat::EventBatch, WaveformMode::Decode, 1, 1,
+     OutputOrder::None, nullptr},
+    {"lazy", OutputFormat::EventData, WaveformMode::Lazy, 1, 1,
+     OutputOrder::None, nullptr},
+    {"batch lazy", OutputFormat::EventBatch, WaveformMode::Lazy, 1, 1,
+     OutputOrder::None, nullptr},
+    {"pair threads", OutputFormat::EventData, WaveformMode::Decode, 1, 4,
+     OutputOrder::None, nullptr},
+    {"batch lazy pair threads", OutputFormat::EventBatch, WaveformMode::Lazy,
+     1, 4, OutputOrder::None, nullptr},
+    {"compact", OutputFormat::EventData, WaveformMode::Compact, 1, 1,
+     OutputOrder::None, nullptr},
+    {"batch compact delta", OutputFormat::EventBatch,
+     WaveformMode::CompactDelta, 1, 1, OutputOrder::None, nullptr},
+    {"decode threads", OutputFormat::EventData, WaveformMode::Decode, 4, 1,
+     OutputOrder::None, nullptr},
+    {"decode threads ordered", OutputFormat::EventBatch, WaveformMode::Decode,
+     4, 2, OutputOrder::Sequence, nullptr},
+    {"swap ssse3", OutputFormat::EventData, WaveformMode::Decode, 1, 1,
+     OutputOrder::None, "ssse3"},
+    {"swap avx2", OutputFormat::EventData, WaveformMode::Decode, 1, 1,
+     OutputOrder::None, "avx2"},
+};
+
+// Only PSD2 data is byte swapped
+bool AppliesTo(const Mode &mode, const Fixture &fixture)
+{
+  if (mode.swapKernel && &mode != &kModes[0]) {
+    return fixture.type == FirmwareType::PSD2;
+  }
+  return true;
+}
+
+std::unique_ptr<IDecoder> MakeDecoder(FirmwareType type, uint32_t threads)
+{
+  switch (type) {
+    case FirmwareType::PSD1:
+      return std::make_unique<PSD1Decoder>(threads);
+    case FirmwareType::PHA1:
+      return std::make_unique<PHA1Decoder>(threads);
+    case FirmwareType::PSD2:
+      return std::make_unique<PSD2Decoder>(threads);
+    default:
+      return nullptr;
+  }
+}
+
+// ============================================================================
+// Digests
+// ============================================================================
+
+// FNV-1a, stable across machines and runs
+class Digest
+{
+ public:
+  template <typename T>
+  void Add(const T &value)
+  {
+    AddBytes(&value, sizeof(value));
+  }
+  template <typename T>
+  void Add(const std::vector<T> &values, size_t n)
+  {
+    AddBytes(values.data(), n * sizeof(T));
+  }
+  void AddBytes(const void *data, size_t size)
+  {
+    auto bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; ++i) {
+      fHash = (fHash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+  }
+  uint64_t Value() const { return fHash; }
+
+ private:
+  uint64_t fHash = 0xcbf29ce484222325ULL;
+};
+
+uint64_t HashEvent(const EventData &event)
+{
+  Digest digest;
+  digest.Add(event.timeStampNs);
+  digest.Add(event.timeStampPs);
+  digest.Add(event.energy);
+  digest.Add(event.energyShort);
+  digest.Add(event.module);
+  digest.Add(event.channel);
+  digest.Add(event.flags);
+  digest.Add(event.timeResolution);
+  digest.Add(event.analogProbe1Type);
+  digest.Add(event.analogProbe2Type);
+  digest.Add(event.digitalProbe1Type);
+  digest.Add(event.digitalProbe2Type);
+  digest.Add(event.digitalProbe3Type);
+  digest.Add(event.digitalProbe4Type);
+  digest.Add(event.downSampleFactor);
+  const size_t n = event.waveformSize;
+  digest.Add(n);
+  digest.Add(event.analogProbe1, n);
+  digest.Add(event.analogProbe2, n);
+  digest.Add(event.digitalProbe1, n);
+  digest.Add(event.digitalProbe2, n);
+  digest.Add(event.digitalProbe3, n);
+  digest.Add(event.digitalProbe4, n);
+  return digest.Value();
+}
+
+// ============================================================================
+// Decoding
+// ============================================================================
+
+struct RunResult {
+  uint64_t events = 0;
+  uint64_t ordered = 0;    // Digest of the event sequence
+  uint64_t unordered = 0;  // Digest of the sorted event hashes
+  uint64_t badEvents = 0;  // Failed the plausibility check
+  double seconds = 0.0;
+  bool drained = true;
+  DecoderStatistics stats;
+};
+
+// An event taken from the decoder is plausible if it belongs to the module
+// and its trace is no longer than the largest buffer could hold
+bool IsPlausible(const EventData &event, size_t maxSamples)
+{
+  const size_t n = event.waveformSize;
+  return event.module == kModuleNumber && n <= maxSamples &&
+         event.analogProbe1.size() >= n && event.analogProbe2.size() >= n &&
+         event.digitalProbe1.size() >= n && event.digitalProbe2.size() >= n &&
+         event.digitalProbe3.size() >= n && event.digitalProbe4.size() >= n;
+}
+
+std::unique_ptr<RawData_t> AcquireBuffer(RawDataPool &pool)
+{
+  auto rawData = pool.Acquire();
+  while (!rawData) {
+    std::this_thread::yield();
+    rawData = pool.Acquire();
+  }
+  return rawData;
+}
+
+/**
+ * Decode buffers `repeats` times in the given mode. With collect, every
+ * event is unpacked (Lazy), checked and hashed; otherwise only counted.
+ */
+RunResult Decode(const Fixture &fixture,
+                 const std::vector<std::vector<uint8_t>> &buffers,
+                 const Mode &mode, bool collect, size_t repeats = 1)
+{
+  RunResult result;
+  size_t maxSize = 0;
+  for (const auto &buffer : buffers) maxSize = std::max(maxSize, buffer.size());
+  const size_t maxSamples = maxSize / 2;  // At most two samples per word
+
+  auto decoder = MakeDecoder(fixture.type, mode.decodeThreads);
+  auto pool =
+      std::make_shared<RawDataPool>(std::max<size_t>(maxSize, 8), kPoolBuffers);
+  decoder->SetTimeStep(fixture.timeStep);
+  decoder->SetModuleNumber(kModuleNumber);
+  decoder->SetRawDataPool(pool);
+  decoder->SetOutputFormat(mode.output);
+  decoder->SetWaveformMode(mode.waveform);
+  decoder->SetChannelPairThreads(mode.pairThreads);
+  OrderingConfig ordering;
+  ordering.order = mode.order;
+  decoder->SetOrdering(ordering);
+
+  // Drain on a separate thread, as a DAQ consumer would
+  std::vector<uint64_t> hashes;
+  std::atomic<bool> done{false};
+  auto take = [&](EventData &event) {
+    if (!collect) return;
+    if (event.HasPackedWaveform()) event.UnpackWaveform();
+    if (!IsPlausible(event, maxSamples)) result.badEvents++;
+    hashes.push_back(HashEvent(event));
+  };
+  auto drain = [&]() {
+    constexpr auto kPoll = std::chrono::milliseconds(10);
+    while (true) {
+      bool finished = done;
+      size_t n = 0;
+      if (mode.output == OutputFormat::EventBatch) {
+        auto batch = decoder->GetEventBatch(kPoll);
+        n = batch ? batch->Size() : 0;
+        for (size_t i = 0; i < n; ++i) {
+          auto event = batch->GetEvent(i);
+          take(event);
+        }
+        decoder->ReleaseEventBatch(std::move(batch));
+      } else {
+        auto events = decoder->GetEventData(kPoll);
+        n = events ? events->size() : 0;
+        for (size_t i = 0; i < n; ++i) take(*(*events)[i]);
+      }
+      result.events += n;
+      if (n == 0 && finished) break;
+    }
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  std::thread consumer(drain);
+
+  uint64_t sequence = 0;
+  for (size_t r = 0; r < repeats; ++r) {
+    for (size_t i = 0; i < buffers.size(); ++i) {
+      auto rawData = AcquireBuffer(*pool);
+      std::memcpy(rawData->data.data(), buffers[i].data(), buffers[i].size());
+      rawData->size = buffers[i].size();
+      rawData->nEvents = i < fixture.nEvents.size() ? fixture.nEvents[i] : 0;
+      rawData->sequence = sequence++;
+      decoder->AddData(std::move(rawData));
+    }
+  }
+  result.drained = decoder->Drain(kDrainTimeout);
+  done = true;
+  consumer.join();
+
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  result.stats = decoder->GetStatistics();
+
+  Digest ordered;
+  for (auto hash : hashes) ordered.Add(hash);
+  result.ordered = ordered.Value();
+  std::sort(hashes.begin(), hashes.end());
+  Digest unordered;
+  for (auto hash : hashes) unordered.Add(hash);
+  result.unordered = unordered.Value();
+  return result;
+}
+
+// ============================================================================
+// Fuzzing
+// ============================================================================
+
+// Word size of the format, for mutations that respect word boundaries
+size_t WordSize(FirmwareType type)
+{
+  return type == FirmwareType::PSD2 ? sizeof(uint64_t) : sizeof(uint32_t);
+}
+
+// Replace the low bits of a word with a small number, as a corrupted size
+// or count field would read; the type bits on top are kept
+void CorruptWord(std::vector<uint8_t> &buffer, FirmwareType type,
+                 std::mt19937 &rng)
+{
+  const size_t wordSize = WordSize(type);
+  const size_t nWords = buffer.size() / wordSize;
+  if (nWords == 0) return;
+  const size_t offset = rng() % nWords * wordSize;
+  const uint64_t value = rng() % (2 * nWords + 16);
+
+  if (type == FirmwareType::PSD2) {
+    uint64_t word;
+    std::memcpy(&word, buffer.data() + offset, sizeof(word));
+    word = ByteSwap::Swap64(word);
+    word = (word & 0xFFFFFFFF00000000ULL) | value;
+    word = ByteSwap::Swap64(word);
+    std::memcpy(buffer.data() + offset, &word, sizeof(word));
+  } else {
+    uint32_t word;
+    std::memcpy(&word, buffer.data() + offset, sizeof(word));
+    word = (word & 0xF0000000u) | static_cast<uint32_t>(value);
+    std::memcpy(buffer.data() + offset, &word, sizeof(word));
+  }
+}
+
+std::vector<uint8_t> Mutate(const Fixture &fixture, std::mt19937 &rng)
+{
+  auto buffer = fixture.buffers[rng() % fixture.buffers.size()];
+  const size_t wordSize = WordSize(fixture.type);
+
+  switch (rng() % 5) {
+    case 0: {  // Bit flips
+      const size_t flips = 1 + rng() % 8;
+      for (size_t i = 0; i < flips && !buffer.empty(); ++i) {
+        const size_t bit = rng() % (buffer.size() * 8);
+        buffer[bit / 8] ^= static_cast<uint8_t>(1u << (bit % 8));
+      }
+      break;
+    }
+    case 1:  // Truncated, mostly on a word boundary
+      buffer.resize(rng() % 4 == 0
+                        ? rng() % (buffer.size() + 1)
+                        : rng() % (buffer.size() / wordSize + 1) * wordSize);
+      break;
+    case 2: {  // Corrupted size or count fields
+      const size_t n = 1 + rng() % 3;
+      for (size_t i = 0; i < n; ++i) CorruptWord(buffer, fixture.type, rng);
+      break;
+    }
+    case 3: {  // Trailing garbage past the declared size
+      const size_t extra = (1 + rng() % 64) * wordSize;
+      for (size_t i = 0; i < extra; ++i) buffer.push_back(rng() & 0xFF);
+      break;
+    }
+    default:  // Garbage of about the same size
+      for (auto &byte : buffer) byte = rng() & 0xFF;
+      break;
+  }
+  return buffer;
+}
+
+// ============================================================================
+// Reference File
+// ============================================================================
+
+struct Reference {
+  uint64_t events = 0;
+  uint64_t digest = 0;
+  double eventsPerSecond = 0.0;
+};
+
+// One line per fixture: <id> <events> <digest> <events/s>
+bool ReadReference(const std::string &path,
+                   std::map<std::string, Reference> &references)
+{
+  std::ifstream file(path);
+  if (!file) {
+    std::fprintf(stderr, "Cannot open %s\n", path.c_str());
+    return false;
+  }
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#') continue;
+    std::istringstream fields(line);
+    std::string id, digest;
+    Reference reference;
+    if (fields >> id >> reference.events >> digest) {
+      reference.digest = std::strtoull(digest.c_str(), nullptr, 16);
+      fields >> reference.eventsPerSecond;
+      references[id] = reference;
+    }
+  }
+  return true;
+}
+
+bool WriteReference(const std::string &path,
+                    const std::map<std::string, Reference> &references)
+{
+  std::ofstream file(path, std::ios::trunc);
+  if (!file) {
+    std::fprintf(stderr, "Cannot create %s\n", path.c_str());
+    return false;
+  }
+  file << "# decoder_check reference: fixture, events, digest, events/s\n";
+  for (const auto &[id, reference] : references) {
+    char digest[17];
+    std::snprintf(digest, sizeof(digest), "%016llx",
+                  static_cast<unsigned long long>(reference.digest));
+    file << id << ' ' << reference.events << ' ' << digest << ' '
+         << static_cast<uint64_t>(reference.eventsPerSecond) << '\n';
+  }
+  return static_cast<bool>(file);
+}
+
+// ============================================================================
+// Checks
+// ============================================================================
+
+struct Options {
+  std::string fixtureDir;
+  std::string writeDir;
+  std::string referencePath;
+  std::string recordPath;
+  double maxSlowdown = 0.0;  // 0 = throughput not checked
+  size_t fuzzBuffers = 1000;
+  uint32_t seed = 1;
+  std::string filter;
+};
+
+// Every mode against the reference mode; returns false on a mismatch
+bool CheckModes(const Fixture &fixture, const RunResult &reference)
+{
+  bool ok = true;
+  for (const auto &mode : kModes) {
+    if (&mode == &kModes[0] || !AppliesTo(mode, fixture)) continue;
+    if (mode.swapKernel && !ByteSwap::SelectKernel(mode.swapKernel)) {
+      continue;  // Not supported by this CPU
+    }
+    auto r = Decode(fixture, fixture.buffers, mode, true);
+    ByteSwap::SelectKernel("scalar");
+
+    bool same = r.drained && r.events == reference.events &&
+                r.badEvents == 0 &&
+                (mode.Ordered() ? r.ordered == reference.ordered
+                                : r.unordered == reference.unordered);
+    if (!same) {
+      std::printf("  %-24s MISMATCH: %llu events, digest %016llx%s\n",
+                  mode.name, static_cast<unsigned long long>(r.events),
+                  static_cast<unsigned long long>(
+                      mode.Ordered() ? r.ordered : r.unordered),
+                  r.drained ? "" : ", not drained");
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+// Mutated buffers through every mode; returns false if one went wrong
+bool Fuzz(const Fixture &fixture, const Options &options, std::mt19937 &rng)
+{
+  std::vector<std::vector<uint8_t>> buffers;
+  buffers.reserve(options.fuzzBuffers + 1);
+  // PSD2 decoders need the start record to accept data
+  if (fixture.type == FirmwareType::PSD2 && fixture.nEvents[0] == 0) {
+    buffers.push_back(fixture.buffers[0]);
+  }
+  for (size_t i = 0; i < options.fuzzBuffers; ++i) {
+    buffers.push_back(Mutate(fixture, rng));
+  }
+
+  // The decoders log every malformed buffer; keep the report readable
+  DecoderLogger::Flush();
+  auto *errorBuffer = std::cerr.rdbuf(nullptr);
+  auto *outputBuffer = std::cout.rdbuf(nullptr);
+
+  bool ok = true;
+  for (const auto &mode : kModes) {
+    if (mode.swapKernel && &mode != &kModes[0]) continue;
+    if (mode.swapKernel) ByteSwap::SelectKernel(mode.swapKernel);
+    auto r = Decode(fixture, buffers, mode, true);
+    if (!r.drained || r.badEvents > 0) {
+      std::printf("  fuzz %-19s FAILED: %llu implausible events%s\n",
+                  mode.name, static_cast<unsigned long long>(r.badEvents),
+                  r.drained ? "" : ", not drained");
+      ok = false;
+    }
+  }
+
+  DecoderLogger::Flush();
+  std::cerr.rdbuf(errorBuffer);
+  std::cout.rdbuf(outputBuffer);
+  return ok;
+}
+
+void PrintUsage(const char *program)
+{
+  std::printf(
+      "Usage: %s [options]\n"
+      "  --fixtures DIR        Check the raw run files (*.raw) in DIR instead "
+      "of\n"
+      "                        the synthetic fixtures\n"
+      "  --write-fixtures DIR  Write the fixtures as raw run files and exit\n"
+      "  --reference FILE      Compare events and digests (and, with\n"
+      "                        --max-slowdown, events/s) with FILE\n"
+      "  --record FILE         Write the results as a reference to FILE\n"
+      "  --max-slowdown X      Fail fixtures more than X times slower than "
+      "the\n"
+      "                        reference\n"
+      "  --fuzz N              Mutated buffers per fixture (default 1000, 0 = "
+      "off)\n"
+      "  --seed N              Fuzzing seed (default 1)\n"
+      "  --filter TEXT         Only check fixtures whose id contains TEXT\n",
+      program);
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--fixtures" && hasValue) {
+      options.fixtureDir = argv[++i];
+    } else if (arg == "--write-fixtures" && hasValue) {
+      options.writeDir = argv[++i];
+    } else if (arg == "--reference" && hasValue) {
+      options.referencePath = argv[++i];
+    } else if (arg == "--record" && hasValue) {
+      options.recordPath = argv[++i];
+    } else if (arg == "--max-slowdown" && hasValue) {
+      options.maxSlowdown = std::atof(argv[++i]);
+    } else if (arg == "--fuzz" && hasValue) {
+      options.fuzzBuffers = std::max(0, std::atoi(argv[++i]));
+    } else if (arg == "--seed" && hasValue) {
+      options.seed = static_cast<uint32_t>(std::atoi(argv[++i]));
+    } else if (arg == "--filter" && hasValue) {
+      options.filter = argv[++i];
+    } else {
+      PrintUsage(argv[0]);
+      return arg == "--help" ? 0 : 1;
+    }
+  }
+
+  std::vector<Fixture> fixtures;
+  if (!options.fixtureDir.empty()) {
+    if (!LoadFixtures(options.fixtureDir, fixtures)) return 1;
+  } else {
+    for (const auto &scenario : SyntheticAggregates::kScenarios) {
+      fixtures.push_back(MakeSyntheticFixture(scenario));
+    }
+  }
+  if (!options.filter.empty()) {
+    fixtures.erase(std::remove_if(fixtures.begin(), fixtures.end(),
+                                  [&](const Fixture &f) {
+                                    return f.id.find(options.filter) ==
+                                           std::string::npos;
+                                  }),
+                   fixtures.end());
+  }
+
+  if (!options.writeDir.empty()) {
+    for (const auto &fixture : fixtures) {
+      if (!WriteFixture(fixture, options.writeDir)) return 1;
+    }
+    std::printf("Wrote %zu fixtures to %s\n", fixtures.size(),
+                options.writeDir.c_str());
+    return 0;
+  }
+
+  std::map<std::string, Reference> references;
+  if (!options.referencePath.empty() &&
+      !ReadReference(options.referencePath, references)) {
+    return 1;
+  }
+
+  std::printf("Byte swap: %s, fuzzing %zu buffers per fixture, seed %u\n\n",
+              ByteSwap::GetKernelName(), options.fuzzBuffers, options.seed);
+  std::printf("%-28s %9s %16s %10s %6s\n", "fixture", "events", "digest",
+              "Mevents/s", "result");
+
+  const auto bestKernel = std::string(ByteSwap::GetKernelName());
+  std::mt19937 rng(options.seed);
+  std::map<std::string, Reference> recorded;
+  bool allOk = true;
+
+  for (const auto &fixture : fixtures) {
+    if (!MakeDecoder(fixture.type, 1)) {
+      std::printf("%-28s no decoder for this firmware, skipped\n",
+                  fixture.id.c_str());
+      continue;
+    }
+
+    ByteSwap::SelectKernel("scalar");
+    auto reference = Decode(fixture, fixture.buffers, kModes[0], true);
+    bool ok = reference.drained && reference.badEvents == 0 &&
+              (fixture.expectedEvents == 0 ||
+               reference.events == fixture.expectedEvents);
+    ok &= CheckModes(fixture, reference);
+
+    // Throughput with the library defaults
+    ByteSwap::SelectKernel(bestKernel.c_str());
+    size_t repeats = 1;
+    if (reference.events > 0) {
+      repeats = static_cast<size_t>(
+          (kMinThroughputEvents + reference.events - 1) / reference.events);
+    }
+    Mode fast = kModes[0];
+    fast.swapKernel = nullptr;
+    auto timed = Decode(fixture, fixture.buffers, fast, false, repeats);
+    double eventsPerSecond =
+        timed.seconds > 0.0 ? timed.events / timed.seconds : 0.0;
+
+    auto it = references.find(fixture.id);
+    if (it != references.end()) {
+      const auto &expected = it->second;
+      if (expected.events != reference.events ||
+          expected.digest != reference.ordered) {
+        std::printf("  output differs, the reference has %llu events, "
+                    "digest %016llx\n",
+                    static_cast<unsigned long long>(expected.events),
+                    static_cast<unsigned long long>(expected.digest));
+        ok = false;
+      }
+      if (options.maxSlowdown > 0.0 && expected.eventsPerSecond > 0.0 &&
+          eventsPerSecond * options.maxSlowdown < expected.eventsPerSecond) {
+        std::printf("  slower than the reference: %.3f Mevents/s\n",
+                    expected.eventsPerSecond / 1e6);
+        ok = false;
+      }
+    } else if (!references.empty()) {
+      std::printf("  not in the reference\n");
+    }
+
+    if (options.fuzzBuffers > 0) ok &= Fuzz(fixture, options, rng);
+
+    recorded[fixture.id] = {reference.events, reference.ordered,
+                            eventsPerSecond};
+    allOk &= ok;
+    std::printf("%-28s %9llu %016llx %10.3f %6s\n", fixture.id.c_str(),
+                static_cast<unsigned long long>(reference.events),
+                static_cast<unsigned long long>(reference.ordered),
+                eventsPerSecond / 1e6, ok ? "ok" : "FAIL");
+  }
+
+  if (!options.recordPath.empty() &&
+      !WriteReference(options.recordPath, recorded)) {
+    return 1;
+  }
+  return allOk ? 0 : 1;
+}
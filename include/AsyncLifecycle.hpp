@@ -0,0 +1,144 @@
+#ifndef ASYNCLIFECYCLE_HPP
+#define ASYNCLIFECYCLE_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+
+#include "ConfigurationManager.hpp"
+#include "IDigitizer.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+enum class LifecycleStatus {
+  Ok,
+  Failed,     // The call returned false or threw
+  TimedOut,   // Cancelled at its deadline
+  Cancelled   // Cancel() before or during the call
+};
+
+inline const char *GetLifecycleStatusName(LifecycleStatus status)
+{
+  switch (status) {
+    case LifecycleStatus::Ok:
+      return "ok";
+    case LifecycleStatus::Failed:
+      return "failed";
+    case LifecycleStatus::TimedOut:
+      return "timed out";
+    case LifecycleStatus::Cancelled:
+      return "cancelled";
+  }
+  return "unknown";
+}
+
+/**
+ * @brief Outcome of one asynchronous lifecycle call
+ */
+struct LifecycleResult {
+  LifecycleStatus status = LifecycleStatus::Failed;
+  // From submission, including the wait behind earlier calls
+  std::chrono::milliseconds elapsed{0};
+
+  bool Ok() const { return status == LifecycleStatus::Ok; }
+};
+
+/**
+ * @brief Runs the lifecycle calls of one digitizer off the caller's thread
+ *
+ * Each call returns at once with a future of its result, so a run
+ * controller can bring up or tear down many boards at the same time and
+ * wait for all of them. Calls of one board run in submission order on a
+ * worker thread of its own.
+ *
+ * A timeout is a deadline counted from submission. When it passes, or on
+ * Cancel(), the running call is asked to give up through
+ * IDigitizer::CancelLifecycle(); a FELib call already blocked still runs to
+ * its own timeout, so the future can become ready somewhat after the
+ * deadline. A call that succeeds despite the request reports Ok, since the
+ * board then is in the requested state. Calls still queued are not started
+ * after Cancel() and report Cancelled.
+ *
+ * The digitizer must outlive this object; the destructor cancels whatever
+ * is queued or running and waits for the running call to return.
+ */
+class AsyncLifecycle
+{
+ public:
+  // No deadline
+  static constexpr std::chrono::milliseconds kNoTimeout{0};
+
+  explicit AsyncLifecycle(IDigitizer &digitizer);
+  ~AsyncLifecycle();
+
+  AsyncLifecycle(const AsyncLifecycle &) = delete;
+  AsyncLifecycle &operator=(const AsyncLifecycle &) = delete;
+
+  // === Lifecycle ===
+  std::shared_future<LifecycleResult> Initialize(
+      const ConfigurationManager &config,
+      std::chrono::milliseconds timeout = kNoTimeout);
+  std::shared_future<LifecycleResult> Configure(
+      std::chrono::milliseconds timeout = kNoTimeout);
+  std::shared_future<LifecycleResult> StartAcquisition(
+      std::chrono::milliseconds timeout = kNoTimeout);
+  std::shared_future<LifecycleResult> ArmAcquisition(
+      std::chrono::milliseconds timeout = kNoTimeout);
+  std::shared_future<LifecycleResult> SendSWStart(
+      std::chrono::milliseconds timeout = kNoTimeout);
+  std::shared_future<LifecycleResult> StopAcquisition(
+      std::chrono::milliseconds timeout = kNoTimeout);
+
+  /**
+   * @brief Cancel the running call and every queued one (any thread)
+   */
+  void Cancel();
+
+  /**
+   * @brief True if no call is running or queued
+   */
+  bool IsIdle() const;
+
+  IDigitizer &GetDigitizer() { return fDigitizer; }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Operation {
+    std::function<bool()> call;
+    Clock::time_point submitted;
+    Clock::time_point deadline;  // max() = none
+    uint64_t cancelGeneration;   // fCancelGeneration at submission
+    std::promise<LifecycleResult> promise;
+  };
+
+  std::shared_future<LifecycleResult> Submit(
+      std::function<bool()> call, std::chrono::milliseconds timeout);
+  void WorkerLoop();
+  LifecycleResult Run(Operation &operation);
+
+  IDigitizer &fDigitizer;
+
+  mutable std::mutex fMutex;
+  std::condition_variable fCondition;
+  std::deque<Operation> fQueue;
+  bool fRunning = false;        // A call is in progress
+  bool fCallDone = false;       // The call in progress has returned
+  uint64_t fCancelGeneration = 0;  // Bumped by Cancel()
+  bool fStopping = false;
+
+  std::thread fWorker;
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // ASYNCLIFECYCLE_HPP
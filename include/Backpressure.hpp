@@ -0,0 +1,151 @@
+#ifndef BACKPRESSURE_HPP
+#define BACKPRESSURE_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "BlockingQueue.hpp"
+#include "DigitizerStatistics.hpp"
+#include "RawData.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief What a decoder does when a memory limit is reached
+ */
+enum class BackpressurePolicy {
+  Block,       // Wait for room: decoding and then AddData() (the readout)
+               // stall, so the board's own buffers absorb the burst
+  DropOldest,  // Discard the oldest waiting data to make room, counted
+  DropNewest   // Discard the incoming data, counted
+};
+
+/**
+ * @brief Memory limits of the decoder pipeline
+ *
+ * maxQueuedBytes bounds the raw data waiting for the decode threads (on top
+ * of SetRawDataQueueCapacity(), which bounds the number of buffers);
+ * maxPendingEvents bounds the decoded events not yet taken with
+ * GetEventData()/GetEventBatch(). The event limit is checked before each
+ * decode batch, so it may be exceeded by one batch per decode thread.
+ */
+struct BackpressureConfig {
+  size_t maxQueuedBytes = 0;    // 0 = unbounded
+  size_t maxPendingEvents = 0;  // 0 = unbounded
+  BackpressurePolicy policy = BackpressurePolicy::Block;
+};
+
+/**
+ * @brief Applies a BackpressureConfig on behalf of a decoder
+ *
+ * PushRawData() replaces the plain queue push in AddData(); decode threads
+ * call MakeRoomForEvents() before decoding and consumers call
+ * NotifyDrained() after taking events. Waits, drops and evictions are
+ * recorded in the decoder's DecoderCounters.
+ */
+class Backpressure
+{
+ public:
+  using RawDataQueue = BlockingQueue<std::unique_ptr<RawData_t>>;
+
+  void Configure(const BackpressureConfig &config);
+  BackpressurePolicy GetPolicy() const { return fConfig.policy; }
+
+  /**
+   * @brief Queue a buffer for decoding according to the policy
+   * @param drop Called with every buffer that is dropped, incoming or
+   *             evicted from the queue, after it has been counted
+   * @return false if the queue is closed; rawData is then left untouched
+   */
+  template <typename DropFunction>
+  bool PushRawData(RawDataQueue &queue, std::unique_ptr<RawData_t> &rawData,
+                   DecoderCounters &counters, DropFunction drop)
+  {
+    size_t bytes = rawData->size;
+    switch (fConfig.policy) {
+      case BackpressurePolicy::DropOldest: {
+        std::vector<std::unique_ptr<RawData_t>> evicted;
+        if (!queue.PushEvictOldest(std::move(rawData), bytes, evicted)) {
+          return false;
+        }
+        for (auto &old : evicted) {
+          counters.RecordDroppedAggregate(old->size);
+          drop(std::move(old));
+        }
+        return true;
+      }
+      case BackpressurePolicy::DropNewest:
+        if (queue.TryPush(std::move(rawData), bytes)) return true;
+        if (queue.IsClosed()) return false;
+        counters.RecordDroppedAggregate(bytes);
+        drop(std::move(rawData));
+        return true;
+      case BackpressurePolicy::Block:
+      default:
+        return queue.Push(std::move(rawData), bytes);
+    }
+  }
+
+  /**
+   * @brief Apply the event limit before a decode thread adds events
+   * @param pending Returns the decoded events not yet taken
+   * @param discard Drops those events and returns how many it dropped
+   * @return false if the buffers about to be decoded must be dropped
+   *         (DropNewest)
+   */
+  template <typename PendingFunction, typename DiscardFunction>
+  bool MakeRoomForEvents(PendingFunction pending, DiscardFunction discard,
+                         DecoderCounters &counters)
+  {
+    if (fConfig.maxPendingEvents == 0 ||
+        pending() < fConfig.maxPendingEvents) {
+      return true;
+    }
+
+    switch (fConfig.policy) {
+      case BackpressurePolicy::DropOldest:
+        counters.RecordDroppedEvents(discard());
+        return true;
+      case BackpressurePolicy::DropNewest:
+        return false;
+      case BackpressurePolicy::Block:
+      default: {
+        counters.RecordBackpressureWait();
+        std::unique_lock<std::mutex> lock(fMutex);
+        while (!fClosed && pending() >= fConfig.maxPendingEvents) {
+          fDrainedCV.wait_for(lock, std::chrono::milliseconds(10));
+        }
+        return true;
+      }
+    }
+  }
+
+  /**
+   * @brief Wake decode threads waiting for the consumer; call after taking
+   *        events
+   */
+  void NotifyDrained();
+
+  /**
+   * @brief Release waiting decode threads for good; call before joining them
+   */
+  void Close();
+
+ private:
+  BackpressureConfig fConfig;
+  std::mutex fMutex;
+  std::condition_variable fDrainedCV;
+  bool fClosed = false;
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // BACKPRESSURE_HPP
@@ -0,0 +1,288 @@
+#ifndef BLOCKINGQUEUE_HPP
+#define BLOCKINGQUEUE_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Snapshot of queue occupancy counters
+ */
+struct QueueStatistics {
+  size_t depth = 0;          // Items currently queued
+  size_t highWaterMark = 0;  // Largest depth observed
+  size_t capacity = 0;       // Maximum depth (0 = unbounded)
+  uint64_t pushed = 0;       // Total items pushed
+  uint64_t popped = 0;       // Total items popped
+  size_t bytes = 0;          // Bytes currently queued (as given to Push)
+  size_t highWaterBytes = 0;  // Largest byte count observed
+  size_t byteCapacity = 0;    // Maximum bytes (0 = unbounded)
+  uint64_t blockedPushes = 0;  // Push() calls that had to wait for room
+  uint64_t evicted = 0;        // Items removed by PushEvictOldest()
+};
+
+/**
+ * @brief Multi-producer/multi-consumer queue with blocking waits
+ *
+ * Consumers sleep on a condition variable until data arrives instead of
+ * polling, and can drain several items per wakeup with PopBatch(). With a
+ * non-zero capacity Push() blocks while the queue is full. Items may carry
+ * a byte size, bounded by a byte capacity in the same way; an item larger
+ * than the byte capacity is still accepted into an empty queue. Close()
+ * wakes every waiter so worker threads can shut down promptly.
+ */
+template <typename T>
+class BlockingQueue
+{
+ public:
+  explicit BlockingQueue(size_t capacity = 0) : fCapacity(capacity) {}
+  ~BlockingQueue() = default;
+
+  BlockingQueue(const BlockingQueue &) = delete;
+  BlockingQueue &operator=(const BlockingQueue &) = delete;
+
+  /**
+   * @brief Append an item, waiting while the queue is full
+   * @param item Item to push, moved from only on success
+   * @param bytes Size counted against the byte capacity
+   * @return false if the queue was closed before space became available
+   */
+  bool Push(T &&item, size_t bytes = 0)
+  {
+    {
+      std::unique_lock<std::mutex> lock(fMutex);
+      if (!fClosed && IsFullLocked(bytes)) {
+        fBlockedPushes++;
+        fNotFullCV.wait(lock,
+                        [&] { return fClosed || !IsFullLocked(bytes); });
+      }
+      if (fClosed) return false;
+      PushLocked(std::move(item), bytes);
+    }
+    fNotEmptyCV.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Append an item without waiting
+   * @param item Item to push, moved from only on success
+   * @param bytes Size counted against the byte capacity
+   * @return false if the queue is full or closed
+   */
+  bool TryPush(T &&item, size_t bytes = 0)
+  {
+    {
+      std::lock_guard<std::mutex> lock(fMutex);
+      if (fClosed || IsFullLocked(bytes)) return false;
+      PushLocked(std::move(item), bytes);
+    }
+    fNotEmptyCV.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Append an item, removing the oldest items until it fits
+   * @param item Item to push, moved from only on success
+   * @param bytes Size counted against the byte capacity
+   * @param evicted The removed items are appended to this vector
+   * @return false if the queue is closed
+   */
+  bool PushEvictOldest(T &&item, size_t bytes, std::vector<T> &evicted)
+  {
+    {
+      std::lock_guard<std::mutex> lock(fMutex);
+      if (fClosed) return false;
+      while (IsFullLocked(bytes)) {
+        evicted.push_back(std::move(fQueue.front()));
+        PopFrontLocked();
+        fEvicted++;
+      }
+      PushLocked(std::move(item), bytes);
+    }
+    fNotEmptyCV.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Remove the oldest item, waiting up to timeout for one to arrive
+   * @return true if an item was stored in item
+   */
+  bool Pop(T &item, std::chrono::milliseconds timeout)
+  {
+    {
+      std::unique_lock<std::mutex> lock(fMutex);
+      if (!fNotEmptyCV.wait_for(lock, timeout, [this] {
+            return fClosed || !fQueue.empty();
+          })) {
+        return false;
+      }
+      if (fQueue.empty()) return false;
+      item = std::move(fQueue.front());
+      PopFrontLocked();
+      fPopped++;
+    }
+    fNotFullCV.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Remove up to maxItems items in one wakeup
+   * @param out Items are appended to this vector
+   * @param maxItems Maximum number of items to take
+   * @param timeout Maximum time to wait for the first item
+   * @return Number of items appended
+   */
+  size_t PopBatch(std::vector<T> &out, size_t maxItems,
+                  std::chrono::milliseconds timeout)
+  {
+    size_t count = 0;
+    {
+      std::unique_lock<std::mutex> lock(fMutex);
+      if (!fNotEmptyCV.wait_for(lock, timeout, [this] {
+            return fClosed || !fQueue.empty();
+          })) {
+        return 0;
+      }
+      while (!fQueue.empty() && count < maxItems) {
+        out.push_back(std::move(fQueue.front()));
+        PopFrontLocked();
+        count++;
+      }
+      fPopped += count;
+    }
+    if (count > 0) fNotFullCV.notify_all();
+    return count;
+  }
+
+  /**
+   * @brief Reject further pushes and wake all waiting threads
+   *
+   * Items already queued can still be popped.
+   */
+  void Close()
+  {
+    {
+      std::lock_guard<std::mutex> lock(fMutex);
+      fClosed = true;
+    }
+    fNotEmptyCV.notify_all();
+    fNotFullCV.notify_all();
+  }
+
+  /**
+   * @brief Accept pushes again after Close()
+   */
+  void Reopen()
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fClosed = false;
+  }
+
+  void SetCapacity(size_t capacity)
+  {
+    {
+      std::lock_guard<std::mutex> lock(fMutex);
+      fCapacity = capacity;
+    }
+    fNotFullCV.notify_all();
+  }
+
+  void SetByteCapacity(size_t byteCapacity)
+  {
+    {
+      std::lock_guard<std::mutex> lock(fMutex);
+      fByteCapacity = byteCapacity;
+    }
+    fNotFullCV.notify_all();
+  }
+
+  bool IsClosed() const
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    return fClosed;
+  }
+
+  size_t Size() const
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    return fQueue.size();
+  }
+
+  bool Empty() const
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    return fQueue.empty();
+  }
+
+  QueueStatistics GetStatistics() const
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    QueueStatistics stats;
+    stats.depth = fQueue.size();
+    stats.highWaterMark = fHighWaterMark;
+    stats.capacity = fCapacity;
+    stats.pushed = fPushed;
+    stats.popped = fPopped;
+    stats.bytes = fBytes;
+    stats.highWaterBytes = fHighWaterBytes;
+    stats.byteCapacity = fByteCapacity;
+    stats.blockedPushes = fBlockedPushes;
+    stats.evicted = fEvicted;
+    return stats;
+  }
+
+ private:
+  bool IsFullLocked(size_t bytes) const
+  {
+    if (fCapacity > 0 && fQueue.size() >= fCapacity) return true;
+    return fByteCapacity > 0 && !fQueue.empty() &&
+           fBytes + bytes > fByteCapacity;
+  }
+
+  void PushLocked(T &&item, size_t bytes)
+  {
+    fQueue.push_back(std::move(item));
+    fItemBytes.push_back(bytes);
+    fBytes += bytes;
+    fPushed++;
+    if (fQueue.size() > fHighWaterMark) fHighWaterMark = fQueue.size();
+    if (fBytes > fHighWaterBytes) fHighWaterBytes = fBytes;
+  }
+
+  void PopFrontLocked()
+  {
+    fQueue.pop_front();
+    fBytes -= fItemBytes.front();
+    fItemBytes.pop_front();
+  }
+
+  mutable std::mutex fMutex;
+  std::condition_variable fNotEmptyCV;
+  std::condition_variable fNotFullCV;
+  std::deque<T> fQueue;
+  std::deque<size_t> fItemBytes;  // Parallel to fQueue
+  size_t fCapacity = 0;
+  size_t fByteCapacity = 0;
+  size_t fBytes = 0;
+  size_t fHighWaterMark = 0;
+  size_t fHighWaterBytes = 0;
+  uint64_t fPushed = 0;
+  uint64_t fPopped = 0;
+  uint64_t fBlockedPushes = 0;
+  uint64_t fEvicted = 0;
+  bool fClosed = false;
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // BLOCKINGQUEUE_HPP
@@ -0,0 +1,51 @@
+#ifndef BYTESWAP_HPP
+#define BYTESWAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Byte-order conversion of 64-bit big-endian digitizer words
+ *
+ * SwapWords64() picks the widest kernel the CPU supports at first use
+ * (AVX2, then SSSE3 pshufb, then one bswap per word) so a single binary
+ * runs everywhere and still uses the vector units where available.
+ */
+class ByteSwap
+{
+ public:
+  /**
+   * @brief Reverse the byte order of every 64-bit word, in place
+   * @param data Start of the buffer, no alignment required
+   * @param nWords Number of 64-bit words to convert
+   */
+  static void SwapWords64(uint8_t *data, size_t nWords);
+
+  /**
+   * @brief Name of the kernel SwapWords64() dispatches to
+   * @return "avx2", "ssse3" or "scalar"
+   */
+  static const char *GetKernelName();
+
+  /**
+   * @brief Use the named kernel instead of the automatic choice
+   *
+   * Meant for tests and benchmarks comparing the kernels; call it while
+   * no other thread converts data.
+   * @param name "avx2", "ssse3" or "scalar"
+   * @return false if the CPU or build does not support it
+   */
+  static bool SelectKernel(const char *name);
+
+  static uint64_t Swap64(uint64_t word) { return __builtin_bswap64(word); }
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // BYTESWAP_HPP
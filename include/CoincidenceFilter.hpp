@@ -0,0 +1,103 @@
+#ifndef COINCIDENCEFILTER_HPP
+#define COINCIDENCEFILTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ConfigurationManager.hpp"
+#include "EventBatch.hpp"
+#include "EventBatchPool.hpp"
+#include "EventData.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+enum class CoincidenceMode {
+  Off,             // Every event is kept
+  Coincidence,     // Keep trigger hits with a partner hit in the window
+  Anticoincidence  // Keep trigger hits without a partner hit in the window
+};
+
+/**
+ * @brief Channel masks and window of the coincidence filter
+ *
+ * Bit n of a mask selects channel n. In Coincidence mode a trigger hit is
+ * kept if a partner hit of another channel (or another module) lies within
+ * ±windowNs, and a partner hit is kept if such a trigger hit lies within
+ * ±windowNs of it. In Anticoincidence mode trigger hits are kept only
+ * without a partner hit in the window and partner (veto) hits are dropped.
+ * Channels in neither mask always pass.
+ */
+struct CoincidenceConfig {
+  CoincidenceMode mode = CoincidenceMode::Off;
+  uint64_t triggerMask = 0;
+  uint64_t partnerMask = 0;
+  double windowNs = 100.0;
+};
+
+/**
+ * @brief Drops the hits a CoincidenceConfig rejects
+ *
+ * Decoders apply it to the sorted events of each aggregate, so a hit is
+ * only judged against hits of the same aggregate. DigitizerGroup applies
+ * it across boards to the merged stream and keeps windowNs of context on
+ * either side of each release. Select() has no mutable state and may be
+ * called from several decode threads at once.
+ */
+class CoincidenceFilter
+{
+ public:
+  struct Hit {
+    double timeStampNs;
+    uint8_t module;
+    uint8_t channel;
+  };
+
+  void Configure(const CoincidenceConfig &config) { fConfig = config; }
+  const CoincidenceConfig &GetConfig() const { return fConfig; }
+  bool IsEnabled() const { return fConfig.mode != CoincidenceMode::Off; }
+
+  /**
+   * @brief Parse the Coincidence* parameters of a digitizer configuration
+   *
+   * Invalid values are reported and leave the default in place.
+   */
+  static CoincidenceConfig ParseConfig(const ConfigurationManager &config);
+
+  /**
+   * @brief Decide hits [begin, end) of hits, which is sorted by time
+   * @param keep Resized to end - begin; keep[i] is 1 if hits[begin + i]
+   *             passes. Hits outside [begin, end) only serve as partners.
+   */
+  void Select(const std::vector<Hit> &hits, size_t begin, size_t end,
+              std::vector<uint8_t> &keep) const;
+
+  /**
+   * @brief Remove rejected events from time-sorted decoder output
+   * @return Number of events removed
+   */
+  size_t Apply(std::vector<std::unique_ptr<EventData>> &events) const;
+  size_t Apply(std::unique_ptr<EventBatch> &batch, EventBatchPool &pool) const;
+
+ private:
+  bool IsTrigger(uint8_t channel) const
+  {
+    return channel < 64 && ((fConfig.triggerMask >> channel) & 1);
+  }
+  bool IsPartner(uint8_t channel) const
+  {
+    return channel < 64 && ((fConfig.partnerMask >> channel) & 1);
+  }
+  bool Keep(const std::vector<Hit> &hits, size_t index) const;
+
+  CoincidenceConfig fConfig;
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // COINCIDENCEFILTER_HPP
@@ -0,0 +1,78 @@
+#ifndef CONFIGURATIONPLANNER_HPP
+#define CONFIGURATIONPLANNER_HPP
+
+#include <array>
+#include <cstddef>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Parameter writes needed to apply a configuration
+ */
+struct ConfigurationPlan {
+  std::vector<std::array<std::string, 2>> writes;  // {path, value}
+  size_t requested = 0;   // Parameters set by the configuration, per channel
+  size_t unchanged = 0;   // Already at the requested value, not written
+  size_t overridden = 0;  // Set again by a later line, earlier value dropped
+};
+
+/**
+ * @brief Reduces configuration lines to the writes that change something
+ *
+ * Channel ranges (/ch/0..63/par/X) are expanded, a parameter set twice keeps
+ * only its last value, and parameters that stay at their device tree default
+ * are dropped. The remaining per-channel writes with the same parameter and
+ * value are collapsed back into as few range paths as possible, as long as
+ * that moves no write ahead of a board-level write or an earlier write of
+ * the same channel; the configuration's write order is otherwise kept.
+ *
+ * Diffing against the defaults assumes the board was just reset and that
+ * the reset leaves every parameter at its defaultvalue attribute, which is
+ * not read back from the board; the digitizers therefore only diff when
+ * DiffConfiguration is enabled. It needs only the static part of the tree,
+ * so a cached tree works as well as a fresh one. Parameters without a
+ * default are always written. A parameter that the firmware derives from
+ * another one (e.g. a length in samples and in ns) may need diffing
+ * disabled.
+ */
+class ConfigurationPlanner
+{
+ public:
+  /**
+   * @brief Build the write list for config
+   * @param config Configuration lines; only paths starting with '/' are used
+   * @param deviceTree Device tree whose defaults are diffed against, nullptr
+   *                   to write every parameter
+   */
+  static ConfigurationPlan Plan(
+      const std::vector<std::array<std::string, 2>> &config,
+      const nlohmann::json *deviceTree);
+
+  /**
+   * @brief Value of path in a device tree (names are case-insensitive)
+   * @param field "value" for the value when the tree was read, or an
+   *              attribute such as "defaultvalue"
+   */
+  static std::optional<std::string> LookupValue(
+      const nlohmann::json &deviceTree, const std::string &path,
+      const std::string &field = "value");
+
+  /**
+   * @brief Compare values the way the firmware reads them back
+   *
+   * Case-insensitive, and numbers compare by value ("500" == "500.000").
+   */
+  static bool SameValue(const std::string &a, const std::string &b);
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // CONFIGURATIONPLANNER_HPP
@@ -143,23 +143,22 @@ inline DecoderResult DataValidator::ValidateRawData(const uint8_t *data,
                                                     size_t size)
 {
   if (data == nullptr) {
-    DecoderLogger::LogError("DataValidator", "Raw data pointer is null");
+    DECODER_LOG_ERROR("DataValidator", "Raw data pointer is null");
     return DecoderResult::CorruptedData;
   }
 
   if (size < PSD1Constants::Validation::kMinimumDataSize) {
-    DecoderLogger::LogError(
-        "DataValidator",
-        "Raw data size too small: " + std::to_string(size) +
-            " bytes (minimum: " +
-            std::to_string(PSD1Constants::Validation::kMinimumDataSize) + ")");
+    DECODER_LOG_ERROR("DataValidator",
+                      "Raw data size too small: " << size << " bytes (minimum: "
+                          << PSD1Constants::Validation::kMinimumDataSize
+                          << ")");
     return DecoderResult::InsufficientData;
   }
 
   if (size % PSD1Constants::kWordSize != 0) {
-    DecoderLogger::LogError("DataValidator",
-                            "Raw data size not aligned to word boundary: " +
-                                std::to_string(size) + " bytes");
+    DECODER_LOG_ERROR("DataValidator",
+                      "Raw data size not aligned to word boundary: " << size
+                          << " bytes");
     return DecoderResult::CorruptedData;
   }
 
@@ -171,8 +170,7 @@ inline DecoderResult DataValidator::ValidateChannelPair(int channelPair)
   if (channelPair < 0 ||
       channelPair >=
           static_cast<int>(PSD1Constants::Validation::kMaxChannelPairs)) {
-    DecoderLogger::LogError("DataValidator", "Invalid channel pair: " +
-                                                 std::to_string(channelPair));
+    DECODER_LOG_ERROR("DataValidator", "Invalid channel pair: " << channelPair);
     return DecoderResult::InvalidChannelPair;
   }
   return DecoderResult::Success;
@@ -182,10 +180,9 @@ inline bool DataValidator::IsInRange(uint32_t value, uint32_t min, uint32_t max,
                                      const std::string &name)
 {
   if (value < min || value > max) {
-    DecoderLogger::LogError("DataValidator",
-                            name + " value " + std::to_string(value) +
-                                " out of range [" + std::to_string(min) + ", " +
-                                std::to_string(max) + "]");
+    DECODER_LOG_ERROR("DataValidator",
+                      name << " value " << value << " out of range [" << min
+                          << ", " << max << "]");
     return false;
   }
   return true;
@@ -196,10 +193,9 @@ inline bool DataValidator::IsSizeSufficient(size_t availableSize,
                                             const std::string &description)
 {
   if (availableSize < requiredSize) {
-    DecoderLogger::LogError("DataValidator",
-                            description + " insufficient size: available=" +
-                                std::to_string(availableSize) +
-                                ", required=" + std::to_string(requiredSize));
+    DECODER_LOG_ERROR("DataValidator",
+                      description << " insufficient size: available="
+                          << availableSize << ", required=" << requiredSize);
     return false;
   }
   return true;
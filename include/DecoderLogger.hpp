@@ -1,6 +1,9 @@
 #ifndef DECODERLOGGER_HPP
 #define DECODERLOGGER_HPP
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
@@ -31,15 +34,60 @@ enum class DecoderResult {
 // ============================================================================
 enum class LogLevel { Error, Warning, Info, Debug };
 
+// Most verbose level compiled in: 0 Error, 1 Warning, 2 Info, 3 Debug.
+// Sites above it are removed by the compiler, arguments included.
+#ifndef DELILA_DECODER_LOG_LEVEL
+#define DELILA_DECODER_LOG_LEVEL 3
+#endif
+
+// ============================================================================
+// Log Site
+// ============================================================================
+/**
+ * @brief Rate limit and counters of one logging statement
+ *
+ * The DECODER_LOG_* macros keep one static LogSite per statement. A site
+ * prints at most DecoderLogger::kMaxPerSecond messages per second; the
+ * rest are only counted, and reported as one line by the first message
+ * of a later second. Debug sites are not limited.
+ */
+struct LogSite {
+  LogSite(LogLevel siteLevel, const char *siteContext)
+      : level(siteLevel), context(siteContext)
+  {
+  }
+
+  const LogLevel level;
+  const char *const context;
+  std::atomic<int64_t> windowStartNs{0};
+  std::atomic<uint32_t> windowCount{0};
+  std::atomic<uint64_t> suppressed{0};
+  std::atomic<uint64_t> count{0};  // Every time the site was reached
+};
+
 // ============================================================================
 // Decoder Logger Class
 // ============================================================================
+/**
+ * @brief Leveled, rate-limited logging with an asynchronous sink
+ *
+ * Messages are formatted only once they pass the level check and their
+ * site's rate limit, then queued for a sink thread that writes them to
+ * std::cerr (errors, warnings) or std::cout, so decode threads never block
+ * on the terminal. When the queue is full the message is dropped and
+ * counted, except debug output, which waits for room. Use the
+ * DECODER_LOG_* macros on hot paths; the Log*() functions take preformatted
+ * strings and skip the rate limit.
+ */
 class DecoderLogger
 {
  public:
+  static constexpr uint32_t kMaxPerSecond = 10;  // Per site
+  static constexpr size_t kQueueCapacity = 4096;
+
   /**
-   * @brief Set the global log level
-   * @param level Minimum level to log
+   * @brief Set the least severe level that is logged
+   * @param level Messages of this level and more severe ones are logged
    */
   static void SetLogLevel(LogLevel level) { sLogLevel = level; }
 
@@ -49,6 +97,41 @@ class DecoderLogger
    */
   static void SetDebugEnabled(bool enable) { sDebugEnabled = enable; }
 
+  static constexpr bool IsCompiled(LogLevel level)
+  {
+    return static_cast<int>(level) <= DELILA_DECODER_LOG_LEVEL;
+  }
+
+  // Debug output follows the dump flag alone, independent of the level
+  static bool IsEnabled(LogLevel level)
+  {
+    if (level == LogLevel::Debug) {
+      return sDebugEnabled.load(std::memory_order_relaxed);
+    }
+    return level <= sLogLevel.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Count a message at site and apply its rate limit
+   * @return true if the message should be formatted and written
+   */
+  static bool Admit(LogSite &site);
+
+  /**
+   * @brief Queue a formatted message for the sink thread
+   */
+  static void Write(LogLevel level, const char *context, std::string message);
+
+  /**
+   * @brief Wait until every queued message has been written (at most 1 s)
+   */
+  static void Flush();
+
+  /**
+   * @brief Messages dropped because the sink queue was full
+   */
+  static uint64_t GetDroppedCount();
+
   /**
    * @brief Log an error message
    * @param context Context where error occurred
@@ -56,8 +139,8 @@ class DecoderLogger
    */
   static void LogError(const std::string &context, const std::string &message)
   {
-    if (sLogLevel <= LogLevel::Error) {
-      std::cerr << "[ERROR] " << context << ": " << message << std::endl;
+    if (IsEnabled(LogLevel::Error)) {
+      Write(LogLevel::Error, context.c_str(), message);
     }
   }
 
@@ -68,8 +151,8 @@ class DecoderLogger
    */
   static void LogWarning(const std::string &context, const std::string &message)
   {
-    if (sLogLevel <= LogLevel::Warning) {
-      std::cerr << "[WARNING] " << context << ": " << message << std::endl;
+    if (IsEnabled(LogLevel::Warning)) {
+      Write(LogLevel::Warning, context.c_str(), message);
     }
   }
 
@@ -80,8 +163,8 @@ class DecoderLogger
    */
   static void LogInfo(const std::string &context, const std::string &message)
   {
-    if (sLogLevel <= LogLevel::Info) {
-      std::cout << "[INFO] " << context << ": " << message << std::endl;
+    if (IsEnabled(LogLevel::Info)) {
+      Write(LogLevel::Info, context.c_str(), message);
     }
   }
 
@@ -92,8 +175,8 @@ class DecoderLogger
    */
   static void LogDebug(const std::string &context, const std::string &message)
   {
-    if (sDebugEnabled && sLogLevel <= LogLevel::Debug) {
-      std::cout << "[DEBUG] " << context << ": " << message << std::endl;
+    if (IsEnabled(LogLevel::Debug)) {
+      Write(LogLevel::Debug, context.c_str(), message);
     }
   }
 
@@ -129,7 +212,7 @@ class DecoderLogger
   static void LogMemoryAccess(const std::string &context, size_t wordIndex,
                               size_t totalWords, const std::string &operation)
   {
-    if (sDebugEnabled) {
+    if (IsEnabled(LogLevel::Debug)) {
       std::ostringstream oss;
       oss << operation << " at word " << wordIndex << "/" << totalWords;
       LogDebug(context, oss.str());
@@ -146,7 +229,7 @@ class DecoderLogger
   static void LogHexDump(const std::string &context, const uint8_t *data,
                          size_t size, size_t maxBytes = 64)
   {
-    if (!sDebugEnabled) return;
+    if (!IsEnabled(LogLevel::Debug)) return;
 
     std::ostringstream oss;
     oss << "Hex dump (" << size << " bytes):\n";
@@ -216,13 +299,60 @@ class DecoderLogger
   }
 
  private:
-  static LogLevel sLogLevel;
-  static bool sDebugEnabled;
+  static std::atomic<LogLevel> sLogLevel;
+  static std::atomic<bool> sDebugEnabled;
 };
 
 // Static member initialization
-inline LogLevel DecoderLogger::sLogLevel = LogLevel::Warning;
-inline bool DecoderLogger::sDebugEnabled = false;
+inline std::atomic<LogLevel> DecoderLogger::sLogLevel{LogLevel::Warning};
+inline std::atomic<bool> DecoderLogger::sDebugEnabled{false};
+
+// ============================================================================
+// Logging Macros
+// ============================================================================
+// The message is a stream expression, e.g.
+//   DECODER_LOG_ERROR("DecodeData", "bad size " << size << " bytes");
+// It is only evaluated if the level is compiled in, enabled, and the
+// site is within its rate limit.
+#define DECODER_LOG(level, context, message)                                 \
+  do {                                                                       \
+    if constexpr (::DELILA::Digitizer::DecoderLogger::IsCompiled(level)) {   \
+      if (::DELILA::Digitizer::DecoderLogger::IsEnabled(level)) {            \
+        static ::DELILA::Digitizer::LogSite decoderLogSite(level, context);  \
+        if (::DELILA::Digitizer::DecoderLogger::Admit(decoderLogSite)) {     \
+          std::ostringstream decoderLogStream;                               \
+          decoderLogStream << message;                                       \
+          ::DELILA::Digitizer::DecoderLogger::Write(level, context,          \
+                                                    decoderLogStream.str()); \
+        }                                                                    \
+      }                                                                      \
+    }                                                                        \
+  } while (0)
+
+#define DECODER_LOG_ERROR(context, message) \
+  DECODER_LOG(::DELILA::Digitizer::LogLevel::Error, context, message)
+#define DECODER_LOG_WARNING(context, message) \
+  DECODER_LOG(::DELILA::Digitizer::LogLevel::Warning, context, message)
+#define DECODER_LOG_INFO(context, message) \
+  DECODER_LOG(::DELILA::Digitizer::LogLevel::Info, context, message)
+#define DECODER_LOG_DEBUG(context, message) \
+  DECODER_LOG(::DELILA::Digitizer::LogLevel::Debug, context, message)
+
+// Success is logged at debug level, every other result as an error
+#define DECODER_LOG_RESULT(result, context, message)                     \
+  do {                                                                   \
+    if ((result) == ::DELILA::Digitizer::DecoderResult::Success) {       \
+      DECODER_LOG_DEBUG(context,                                         \
+                        ::DELILA::Digitizer::DecoderLogger::ResultToString( \
+                            result)                                      \
+                            << " - " << message);                        \
+    } else {                                                             \
+      DECODER_LOG_ERROR(context,                                         \
+                        ::DELILA::Digitizer::DecoderLogger::ResultToString( \
+                            result)                                      \
+                            << " - " << message);                        \
+    }                                                                    \
+  } while (0)
 
 }  // namespace Digitizer
 }  // namespace DELILA
@@ -0,0 +1,64 @@
+#ifndef DEVICETREECACHE_HPP
+#define DEVICETREECACHE_HPP
+
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief On-disk cache of device trees, keyed by board identity
+ *
+ * A device tree only changes with the model, serial number and firmware,
+ * so a tree fetched once can be reused on the next Initialize() instead of
+ * downloading and parsing the full JSON again. Entries are stored as CBOR
+ * behind a small header holding a magic number, the payload size and an
+ * FNV-1a checksum; Load() maps the file and rejects anything that fails the
+ * checks. Parameter values in a cached tree are those of the board when it
+ * was stored; only the static part (parameter definitions, allowed values,
+ * ranges, defaults) should be relied on.
+ */
+class DeviceTreeCache
+{
+ public:
+  /**
+   * @param directory Directory holding the cache files, created on Store()
+   */
+  explicit DeviceTreeCache(std::string directory);
+
+  /**
+   * @brief $XDG_CACHE_HOME/delila-digitizer, or ~/.cache/delila-digitizer
+   */
+  static std::string GetDefaultDirectory();
+
+  /**
+   * @brief Build a file-name safe key from identity strings
+   *        (model, serial number, firmware versions, ...)
+   */
+  static std::string MakeKey(const std::vector<std::string> &identity);
+
+  /**
+   * @brief Load the tree stored under key
+   * @return false if there is no valid entry
+   */
+  bool Load(const std::string &key, nlohmann::json &deviceTree) const;
+
+  /**
+   * @brief Store a tree under key, replacing any previous entry atomically
+   */
+  bool Store(const std::string &key, const nlohmann::json &deviceTree) const;
+
+  std::string GetPath(const std::string &key) const;
+
+ private:
+  std::string fDirectory;
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // DEVICETREECACHE_HPP
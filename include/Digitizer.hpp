@@ -1,10 +1,13 @@
 #ifndef DIGITIZER_HPP
 #define DIGITIZER_HPP
 
+#include <chrono>
 #include <memory>
 #include <string>
 
 #include "ConfigurationManager.hpp"
+#include "DigitizerStatistics.hpp"
+#include "EventBatch.hpp"
 #include "EventData.hpp"
 #include "IDigitizer.hpp"
 
@@ -30,6 +33,15 @@ class Digitizer
 
   // Data access
   std::unique_ptr<std::vector<std::unique_ptr<EventData>>> GetEventData();
+  std::unique_ptr<EventBatch> GetEventBatch();
+  std::unique_ptr<std::vector<std::unique_ptr<EventData>>> GetEventData(
+      std::chrono::milliseconds timeout);
+  std::unique_ptr<EventBatch> GetEventBatch(std::chrono::milliseconds timeout);
+  void ReleaseEventBatch(std::unique_ptr<EventBatch> batch);
+
+  // Monitoring
+  DigitizerStatistics GetStatistics() const;
+  std::shared_ptr<OnlineHistograms> GetHistograms() const;
 
   // Device information
   const nlohmann::json &GetDeviceTreeJSON() const;
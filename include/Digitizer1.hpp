@@ -1,6 +1,8 @@
 #ifndef DIGITIZER1_HPP
 #define DIGITIZER1_HPP
 
+#include <atomic>
+#include <chrono>
 #include <deque>
 #include <memory>
 #include <mutex>
@@ -10,13 +12,23 @@
 #include <vector>
 
 #include "ConfigurationManager.hpp"
+#include "ConfigurationPlanner.hpp"
+#include "DeviceTreeCache.hpp"
+#include "HistogramServer.hpp"
 #include "IDecoder.hpp"
 #include "PHA1Decoder.hpp"
 #include "PSD1Decoder.hpp"
 #include "EventData.hpp"
+#include "EventRing.hpp"
+#include "EventStreamer.hpp"
+#include "EventWriter.hpp"
 #include "IDigitizer.hpp"
 #include "ParameterValidator.hpp"
+#include "PipelineTracer.hpp"
 #include "RawData.hpp"
+#include "RawDataPool.hpp"
+#include "ReadoutController.hpp"
+#include "RawRecorder.hpp"
 
 namespace DELILA
 {
@@ -41,10 +53,24 @@ class Digitizer1 : public IDigitizer
   bool Configure() override;
   bool StartAcquisition() override;
   bool StopAcquisition() override;
+  bool ArmAcquisition() override;
+  bool SendSWStart() override;
+  void CancelLifecycle() override { fCancelRequested = true; }
 
   // Data access
   std::unique_ptr<std::vector<std::unique_ptr<EventData>>> GetEventData()
       override;
+  std::unique_ptr<EventBatch> GetEventBatch() override;
+  std::unique_ptr<std::vector<std::unique_ptr<EventData>>> GetEventData(
+      std::chrono::milliseconds timeout) override;
+  std::unique_ptr<EventBatch> GetEventBatch(
+      std::chrono::milliseconds timeout) override;
+  void ReleaseEventBatch(std::unique_ptr<EventBatch> batch) override;
+  DigitizerStatistics GetStatistics() const override;
+  std::shared_ptr<OnlineHistograms> GetHistograms() const override
+  {
+    return fHistograms;
+  }
 
   // Device information
   const nlohmann::json &GetDeviceTreeJSON() const override
@@ -67,12 +93,41 @@ class Digitizer1 : public IDigitizer
   uint64_t fHandle = 0;
   uint64_t fReadDataHandle = 0;
   uint64_t fRecordLength = 0;
+  uint32_t fTimeStepNs = 0;  // Sampling period from /par/ADC_SamplRate
   size_t fMaxRawDataSize = 0;
+  std::shared_ptr<RawDataPool> fRawDataPool;
+  std::shared_ptr<OnlineHistograms> fHistograms;
+  std::shared_ptr<EventWriter> fEventWriter;  // Shared with the decoder
+  std::shared_ptr<EventStreamer> fEventStreamer;  // Shared with the decoder
+  std::shared_ptr<EventRingPublisher> fEventRing;  // Shared with the decoder
+  std::shared_ptr<PipelineTracer> fTracer;  // Shared with the decoder
+  std::unique_ptr<HistogramServer> fHistogramServer;
 
   // === Configuration ===
   std::string fURL;
   bool fDebugFlag = false;
   uint32_t fNThreads = 1;
+  uint32_t fRawDataPoolSize = 32;
+  uint32_t fRawDataQueueSize = 0;  // 0 = unbounded
+  BackpressureConfig fBackpressure;
+  CoincidenceConfig fCoincidence;
+  ZeroSuppressionConfig fZeroSuppression;
+  PulseProcessingConfig fPulseProcessing;
+  ReadoutControlConfig fReadoutControl;
+  HistogramConfig fHistogramConfig;
+  EventWriterConfig fEventWriterConfig;
+  EventStreamerConfig fEventStreamerConfig;
+  EventRingConfig fEventRingConfig;
+  PipelineTraceConfig fTraceConfig;
+  ThreadPlacementConfig fPlacement;
+  OutputFormat fOutputFormat = OutputFormat::EventData;
+  OrderingConfig fOrdering;
+  WaveformMode fWaveformMode = WaveformMode::Decode;
+  bool fDiffConfiguration = false;  // Write only parameters that differ
+  std::string fDeviceTreeCacheDir;  // Empty = no device tree cache
+  RawRecorderConfig fRawRecorderConfig;
+  bool fRawRecordOnly = false;  // Recorded buffers are not decoded
+  uint32_t fChannelPairThreads = 1;
   uint8_t fModuleNumber = 0;
   std::vector<std::array<std::string, 2>> fConfig;
 
@@ -84,9 +139,16 @@ class Digitizer1 : public IDigitizer
   // === Data Processing ===
   std::unique_ptr<IDecoder> fDecoder;
   std::unique_ptr<ParameterValidator> fParameterValidator;
-  bool fDataTakingFlag = false;
-  std::vector<std::thread> fReadDataThreads;
-  std::mutex fReadDataMutex;
+  std::atomic<bool> fDataTakingFlag{false};
+  bool fSWStartMode = false;  // Run waits for SendSWStart()
+  bool fArmed = false;  // Reader started, until StopAcquisition()
+  std::atomic<bool> fCancelRequested{false};  // See CancelLifecycle()
+  // One blocking reader per endpoint; Threads only sets decode parallelism
+  std::thread fReadDataThread;
+  uint64_t fReadSequence = 0;  // Reader thread or run markers, never reset
+  ReadoutCounters fReadoutCounters;
+  ReadoutController fReadoutController;  // Read timeout, aggregate size
+  std::unique_ptr<RawRecorder> fRawRecorder;  // Between readout and decoder
 
   // === Hardware Communication ===
   bool Open(const std::string &url);
@@ -98,6 +160,8 @@ class Digitizer1 : public IDigitizer
 
   // === Device Tree Management ===
   std::string GetDeviceTree();
+  bool LoadDeviceTree();
+  std::string GetDeviceTreeCacheKey();
   void DetermineFirmwareType();
 
   // === Configuration Validation ===
@@ -115,7 +179,12 @@ class Digitizer1 : public IDigitizer
   bool EndpointConfigure();
   nlohmann::json GetReadDataFormatRAW();
   void ReadDataThread();
-  int ReadDataWithLock(std::unique_ptr<RawData_t> &rawData, int timeOut);
+  void StopReadDataThread();  // Clear fDataTakingFlag, join the reader
+  bool StartRawRecorder();
+  // While the reader is not running; false if no buffer was free
+  bool AddRunMarker(uint32_t kind);
+  void AdaptEventsPerAggregate();     // Sets /par/EventAggr before a run
+  int ReadData(std::unique_ptr<RawData_t> &rawData, int timeOut);
 
   // === EventData Conversion (Dig1-specific) ===
   void EventConversionThread();
@@ -1,6 +1,8 @@
 #ifndef DIGITIZER2_HPP
 #define DIGITIZER2_HPP
 
+#include <atomic>
+#include <chrono>
 #include <deque>
 #include <memory>
 #include <mutex>
@@ -10,11 +12,21 @@
 #include <vector>
 
 #include "ConfigurationManager.hpp"
+#include "ConfigurationPlanner.hpp"
+#include "DeviceTreeCache.hpp"
+#include "HistogramServer.hpp"
 #include "PSD2Decoder.hpp"
 #include "EventData.hpp"
+#include "EventRing.hpp"
+#include "EventStreamer.hpp"
+#include "EventWriter.hpp"
 #include "IDigitizer.hpp"
 #include "ParameterValidator.hpp"
+#include "PipelineTracer.hpp"
 #include "RawData.hpp"
+#include "RawDataPool.hpp"
+#include "ReadoutController.hpp"
+#include "RawRecorder.hpp"
 
 namespace DELILA
 {
@@ -33,10 +45,24 @@ class Digitizer2 : public IDigitizer
   bool Configure() override;
   bool StartAcquisition() override;
   bool StopAcquisition() override;
+  bool ArmAcquisition() override;
+  bool SendSWStart() override;
+  void CancelLifecycle() override { fCancelRequested = true; }
 
   // Data access
   std::unique_ptr<std::vector<std::unique_ptr<EventData>>> GetEventData()
       override;
+  std::unique_ptr<EventBatch> GetEventBatch() override;
+  std::unique_ptr<std::vector<std::unique_ptr<EventData>>> GetEventData(
+      std::chrono::milliseconds timeout) override;
+  std::unique_ptr<EventBatch> GetEventBatch(
+      std::chrono::milliseconds timeout) override;
+  void ReleaseEventBatch(std::unique_ptr<EventBatch> batch) override;
+  DigitizerStatistics GetStatistics() const override;
+  std::shared_ptr<OnlineHistograms> GetHistograms() const override
+  {
+    return fHistograms;
+  }
 
   // Device information
   const nlohmann::json &GetDeviceTreeJSON() const override
@@ -59,12 +85,41 @@ class Digitizer2 : public IDigitizer
   uint64_t fHandle = 0;
   uint64_t fReadDataHandle = 0;
   uint64_t fRecordLength = 0;
+  uint32_t fTimeStepNs = 0;  // Sampling period from /par/ADC_SamplRate
   size_t fMaxRawDataSize = 0;
+  std::shared_ptr<RawDataPool> fRawDataPool;
+  std::shared_ptr<OnlineHistograms> fHistograms;
+  std::shared_ptr<EventWriter> fEventWriter;  // Shared with the decoder
+  std::shared_ptr<EventStreamer> fEventStreamer;  // Shared with the decoder
+  std::shared_ptr<EventRingPublisher> fEventRing;  // Shared with the decoder
+  std::shared_ptr<PipelineTracer> fTracer;  // Shared with the decoder
+  std::unique_ptr<HistogramServer> fHistogramServer;
 
   // === Configuration ===
   std::string fURL;
   bool fDebugFlag = false;
   uint32_t fNThreads = 1;
+  uint32_t fRawDataPoolSize = 32;
+  uint32_t fRawDataQueueSize = 0;  // 0 = unbounded
+  BackpressureConfig fBackpressure;
+  CoincidenceConfig fCoincidence;
+  ZeroSuppressionConfig fZeroSuppression;
+  PulseProcessingConfig fPulseProcessing;
+  ReadoutControlConfig fReadoutControl;
+  HistogramConfig fHistogramConfig;
+  EventWriterConfig fEventWriterConfig;
+  EventStreamerConfig fEventStreamerConfig;
+  EventRingConfig fEventRingConfig;
+  PipelineTraceConfig fTraceConfig;
+  ThreadPlacementConfig fPlacement;
+  OutputFormat fOutputFormat = OutputFormat::EventData;
+  OrderingConfig fOrdering;
+  WaveformMode fWaveformMode = WaveformMode::Decode;
+  bool fDiffConfiguration = false;  // Write only parameters that differ
+  std::string fDeviceTreeCacheDir;  // Empty = no device tree cache
+  RawRecorderConfig fRawRecorderConfig;
+  bool fRawRecordOnly = false;  // Recorded buffers are not decoded
+  bool fSwapOnDecode = false;
   uint8_t fModuleNumber = 0;
   std::vector<std::array<std::string, 2>> fConfig;
 
@@ -75,9 +130,15 @@ class Digitizer2 : public IDigitizer
   // === Data Processing ===
   std::unique_ptr<PSD2Decoder> fPSD2Decoder;
   std::unique_ptr<ParameterValidator> fParameterValidator;
-  bool fDataTakingFlag = false;
-  std::vector<std::thread> fReadDataThreads;
-  std::mutex fReadDataMutex;
+  std::atomic<bool> fDataTakingFlag{false};
+  bool fSWStartMode = false;  // Run waits for SendSWStart()
+  std::atomic<bool> fCancelRequested{false};  // See CancelLifecycle()
+  // One blocking reader per endpoint; Threads only sets decode parallelism
+  std::thread fReadDataThread;
+  uint64_t fReadSequence = 0;  // Reader thread only, never reset
+  ReadoutCounters fReadoutCounters;
+  ReadoutController fReadoutController;  // Read timeout, aggregate size
+  std::unique_ptr<RawRecorder> fRawRecorder;  // Between readout and decoder
 
   // === Event Data Processing ===
   // Note: Event data processing is now handled by Dig2Decoder
@@ -92,6 +153,8 @@ class Digitizer2 : public IDigitizer
 
   // === Device Tree Management ===
   std::string GetDeviceTree();
+  bool LoadDeviceTree();
+  std::string GetDeviceTreeCacheKey();
   void DetermineFirmwareType();
 
   // === Configuration Validation ===
@@ -109,7 +172,9 @@ class Digitizer2 : public IDigitizer
   bool EndpointConfigure();
   nlohmann::json GetReadDataFormatRAW();
   void ReadDataThread();
-  int ReadDataWithLock(std::unique_ptr<RawData_t> &rawData, int timeOut);
+  void StopReadDataThread();  // Clear fDataTakingFlag, join the reader
+  bool StartRawRecorder();
+  int ReadData(std::unique_ptr<RawData_t> &rawData, int timeOut);
 
   // === Note: All data is automatically converted to EventData ===
 };
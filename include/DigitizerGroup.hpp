@@ -0,0 +1,172 @@
+#ifndef DIGITIZERGROUP_HPP
+#define DIGITIZERGROUP_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "AsyncLifecycle.hpp"
+#include "CoincidenceFilter.hpp"
+#include "ConfigurationManager.hpp"
+#include "EventData.hpp"
+#include "IDigitizer.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Bounds of the cross-board merge
+ */
+struct GroupMergeConfig {
+  // Events are held until every active board has reported a timestamp this
+  // far past them
+  double mergeWindowNs = 1.0e6;
+  // A board that delivers nothing for this long stops holding back the
+  // merge until it produces data again
+  std::chrono::milliseconds idleTimeout{100};
+};
+
+/**
+ * @brief Several digitizers run as one, with a time-merged event stream
+ *
+ * Boards are created with DigitizerFactory and initialized, configured and
+ * stopped concurrently, each through an AsyncLifecycle, so a lifecycle step
+ * takes as long as its slowest board. StartAcquisition() arms every board
+ * first and only then sends the software start commands, so boards in
+ * software start mode begin as close together as the command round trips
+ * allow. With SetLifecycleTimeout() a board that hangs fails the step
+ * instead of blocking it; CancelLifecycle() aborts a step from another
+ * thread.
+ *
+ * GetEventData() polls every board and performs a watermark merge: each
+ * board's newest timestamp is tracked and events are released in timestamp
+ * order once they are older than the smallest of those minus mergeWindowNs.
+ * Boards idle for longer than idleTimeout are left out of the watermark so
+ * a quiet board cannot stall the others. Events that arrive behind the
+ * released watermark are emitted straight away and counted as late. Boards
+ * must use OutputFormat EventData; events are told apart by
+ * EventData::module (the ModID parameter), which should be unique.
+ *
+ * With SetCoincidenceConfig() the merged stream is filtered across boards;
+ * events are then held a further windowNs so every released hit is judged
+ * against all hits within its window.
+ */
+class DigitizerGroup
+{
+ public:
+  DigitizerGroup() = default;
+  ~DigitizerGroup();
+
+  DigitizerGroup(const DigitizerGroup &) = delete;
+  DigitizerGroup &operator=(const DigitizerGroup &) = delete;
+
+  // === Lifecycle ===
+  /**
+   * @brief Create one digitizer per configuration and initialize them
+   * @return false if any board could not be created or initialized
+   */
+  bool Initialize(const std::vector<ConfigurationManager> &configs);
+  bool Configure();
+  bool StartAcquisition();
+  bool StopAcquisition();
+
+  // Asynchronous variants: return at once with the result of the blocking
+  // call to come. The group must stay alive and otherwise untouched until
+  // the future is ready (its destructor waits for the call)
+  std::future<bool> InitializeAsync(std::vector<ConfigurationManager> configs);
+  std::future<bool> ConfigureAsync();
+  std::future<bool> StartAcquisitionAsync();
+  std::future<bool> StopAcquisitionAsync();
+
+  /**
+   * @brief Deadline of each board's part of a lifecycle step
+   *        (AsyncLifecycle::kNoTimeout = none, the default)
+   */
+  void SetLifecycleTimeout(std::chrono::milliseconds timeout);
+
+  /**
+   * @brief Cancel the lifecycle step in progress on every board
+   *
+   * May be called from any thread; the step then returns false.
+   */
+  void CancelLifecycle();
+
+  // === Merge Configuration ===
+  void SetMergeConfig(const GroupMergeConfig &config);
+  void SetCoincidenceConfig(const CoincidenceConfig &config);
+
+  // === Data Access ===
+  /**
+   * @brief Time-ordered events of all boards that passed the watermark
+   *
+   * After StopAcquisition() everything still held is released.
+   */
+  std::unique_ptr<std::vector<std::unique_ptr<EventData>>> GetEventData();
+
+  // === Board Access ===
+  size_t GetSize() const { return fBoards.size(); }
+  IDigitizer *GetDigitizer(size_t index);
+  IDigitizer *FindModule(uint8_t moduleNumber);
+
+  // Information
+  uint64_t GetLateCount() const;
+  uint64_t GetCoincidenceRejectedCount() const;
+  size_t GetHeldCount() const;
+
+ private:
+  struct Board {
+    std::unique_ptr<IDigitizer> digitizer;
+    // Destroyed first, waiting for a call still running on digitizer
+    std::unique_ptr<AsyncLifecycle> lifecycle;
+    bool hasData = false;
+    uint64_t newestTimeStampPs = 0;
+    std::chrono::steady_clock::time_point lastData;
+  };
+
+  // Submit a lifecycle call to every board with submit(index) and wait for
+  // all of them, true if all succeeded
+  bool ForEachBoard(
+      const char *step,
+      const std::function<std::shared_future<LifecycleResult>(size_t)>
+          &submit);
+
+  void PollBoardsLocked();
+  void ReleaseLocked(std::vector<std::unique_ptr<EventData>> &out);
+  void FilterReleaseLocked(size_t count,
+                           std::vector<std::unique_ptr<EventData>> &out);
+
+  std::vector<Board> fBoards;
+  GroupMergeConfig fConfig;
+  std::chrono::milliseconds fLifecycleTimeout = AsyncLifecycle::kNoTimeout;
+
+  mutable std::mutex fMutex;
+  bool fRunning = false;
+
+  // === Watermark Merge ===
+  std::vector<std::unique_ptr<EventData>> fHeldEvents;  // Sorted by time
+  std::vector<std::unique_ptr<EventData>> fIncoming;    // Scratch
+  uint64_t fReleasedTimeStampPs = 0;  // Newest timestamp released so far
+  bool fHasReleased = false;
+  uint64_t fLateCount = 0;
+
+  // === Coincidence Filter ===
+  CoincidenceFilter fCoincidence;
+  // Released hits within windowNs of the newest one, partners for the next
+  // release
+  std::vector<CoincidenceFilter::Hit> fCoincidenceContext;
+  std::vector<CoincidenceFilter::Hit> fCoincidenceHits;  // Scratch
+  std::vector<uint8_t> fCoincidenceKeep;                 // Scratch
+  uint64_t fCoincidenceRejected = 0;
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // DIGITIZERGROUP_HPP
@@ -0,0 +1,296 @@
+#ifndef DIGITIZERSTATISTICS_HPP
+#define DIGITIZERSTATISTICS_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "BlockingQueue.hpp"
+#include "EventBatch.hpp"
+#include "EventData.hpp"
+#include "EventSorter.hpp"
+#include "TraceStage.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Power-of-two latency histogram
+ *
+ * Bucket 0 counts samples below 1 us, bucket i (i > 0) counts samples in
+ * [2^(i-1), 2^i) us. The last bucket also takes everything longer.
+ */
+struct LatencyHistogram {
+  static constexpr size_t kNumBuckets = 24;  // Last bucket starts at ~4.2 s
+  std::array<uint64_t, kNumBuckets> counts{};
+  uint64_t entries = 0;
+  uint64_t totalNs = 0;  // Sum of all samples
+  uint64_t maxNs = 0;    // Longest sample
+
+  double GetMeanNs() const
+  {
+    return entries > 0 ? static_cast<double>(totalNs) / entries : 0.0;
+  }
+
+  /**
+   * @brief Bucket a sample of the given length falls into
+   */
+  static size_t GetBucket(uint64_t ns);
+};
+
+/**
+ * @brief Snapshot of the counters maintained by a decoder
+ */
+struct DecoderStatistics {
+  static constexpr size_t kMaxChannels = 64;
+
+  uint64_t aggregatesDecoded = 0;
+  uint64_t eventsDecoded = 0;
+  // Events by channel number; channels >= kMaxChannels only count in total
+  std::array<uint64_t, kMaxChannels> eventsPerChannel{};
+  // Buffers returned to the pool without being decoded: decoder not running,
+  // unknown data type, bad size, or queue already closed
+  uint64_t discardedBuffers = 0;
+  // Buffers that failed header or raw data validation
+  uint64_t decodeErrors = 0;
+  // Aggregate counter jumps (checked with a single decode thread only)
+  uint64_t counterDiscontinuities = 0;
+  // Wall time spent decoding one aggregate
+  LatencyHistogram decodeLatency;
+  // EventOrderer gaps skipped and aggregates that arrived after their gap
+  uint64_t orderingSkipped = 0;
+  uint64_t orderingLate = 0;
+  // Backpressure (see BackpressureConfig): buffers dropped before decoding
+  // with their payload bytes, decoded events dropped before being taken,
+  // and decode batches that had to wait for the consumer
+  uint64_t droppedAggregates = 0;
+  uint64_t droppedBytes = 0;
+  uint64_t droppedEvents = 0;
+  uint64_t backpressureWaits = 0;
+  // Events removed by the coincidence filter (still counted as decoded)
+  uint64_t coincidenceRejected = 0;
+  // Hits skipped by zero suppression before decoding (not counted as
+  // decoded), in total and by channel
+  uint64_t eventsSuppressed = 0;
+  std::array<uint64_t, kMaxChannels> suppressedPerChannel{};
+
+  // Per-aggregate time sort (see EventSorter): aggregates found in order,
+  // merged from a few runs or radix sorted, and the wall time spent
+  uint64_t sortSkipped = 0;
+  uint64_t sortMerged = 0;
+  uint64_t sortRadix = 0;
+  uint64_t sortTimeNs = 0;
+};
+
+/**
+ * @brief Span lengths of one pipeline stage (see PipelineTracer)
+ */
+struct StageLatency {
+  uint64_t count = 0;  // Spans in the trace, not since the start of the run
+  uint64_t p50Ns = 0;
+  uint64_t p90Ns = 0;
+  uint64_t p99Ns = 0;
+  uint64_t maxNs = 0;
+};
+
+/**
+ * @brief Snapshot returned by IDigitizer::GetStatistics()
+ */
+struct DigitizerStatistics {
+  // === Readout ===
+  uint64_t bytesRead = 0;
+  uint64_t aggregatesRead = 0;
+  uint64_t readTimeouts = 0;  // CAEN_FELib_Timeout from HasData/ReadData
+  uint64_t readErrors = 0;    // Any other ReadData failure
+  uint64_t rawDataPoolExhausted = 0;
+  // Reader thread time blocked in CAEN_FELib_HasData/ReadData, and time
+  // spent handing buffers on and getting the next one from the pool
+  uint64_t readWaitNs = 0;
+  uint64_t handoffNs = 0;
+  // Adaptive readout (see ReadoutController): read timeout in use, how
+  // often it changed, estimated read and event rates, and the events per
+  // aggregate written at the last arm (0 = not adapted)
+  uint32_t readTimeoutMs = 0;
+  uint64_t readTimeoutChanges = 0;
+  double readRateHz = 0.0;
+  double eventRateHz = 0.0;
+  uint32_t eventsPerAggregate = 0;
+
+  // === Decoding ===
+  QueueStatistics rawDataQueue;
+  DecoderStatistics decoder;
+
+  // === Raw Recording ===
+  uint64_t recordedBytes = 0;  // Including record headers
+  uint64_t recordedAggregates = 0;
+  uint64_t recordedFiles = 0;
+  uint64_t recordErrors = 0;  // Write failures; recording stops at the first
+
+  // === Event Output ===
+  uint64_t eventsWritten = 0;
+  uint64_t eventsWriteDropped = 0;  // Buffer full, not running or failed
+  uint64_t eventBytesWritten = 0;   // File size, after ROOT compression
+  uint64_t eventFilesWritten = 0;
+  uint64_t eventWriteErrors = 0;  // Output stops at the first
+
+  // === Event Streaming ===
+  uint64_t eventsStreamed = 0;  // Not counted while nobody is subscribed
+  uint64_t eventsStreamDropped = 0;  // Buffer full or not running
+  uint64_t streamMessages = 0;
+  uint64_t streamBytes = 0;        // Summed over subscribers
+  uint64_t streamSubscribers = 0;  // Connected now
+  uint64_t streamDisconnects = 0;  // Slow or failed subscribers dropped
+
+  // === Shared-Memory Ring ===
+  uint64_t eventsRingPublished = 0;
+  uint64_t ringWaveformsSkipped = 0;  // Longer than half the region
+
+  // === Pipeline Trace ===
+  // By TraceStage, over the spans the tracer still holds; all zero while
+  // tracing is off
+  std::array<StageLatency, kNumTraceStages> traceStages{};
+};
+
+/**
+ * @brief Readout counters updated by the digitizer read threads
+ *
+ * All counters are relaxed atomics: one uncontended increment per
+ * FELib call, cheap enough to stay enabled.
+ */
+class ReadoutCounters
+{
+ public:
+  void RecordRead(size_t bytes)
+  {
+    fBytesRead.fetch_add(bytes, std::memory_order_relaxed);
+    fAggregatesRead.fetch_add(1, std::memory_order_relaxed);
+  }
+  void RecordTimeout() { fReadTimeouts.fetch_add(1, std::memory_order_relaxed); }
+  void RecordError() { fReadErrors.fetch_add(1, std::memory_order_relaxed); }
+  void RecordReadWait(std::chrono::steady_clock::duration time)
+  {
+    fReadWaitNs.fetch_add(ToNs(time), std::memory_order_relaxed);
+  }
+  void RecordHandoff(std::chrono::steady_clock::duration time)
+  {
+    fHandoffNs.fetch_add(ToNs(time), std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Copy the readout fields into stats
+   */
+  void Fill(DigitizerStatistics &stats) const;
+
+ private:
+  std::atomic<uint64_t> fBytesRead{0};
+  std::atomic<uint64_t> fAggregatesRead{0};
+  std::atomic<uint64_t> fReadTimeouts{0};
+  std::atomic<uint64_t> fReadErrors{0};
+  std::atomic<uint64_t> fReadWaitNs{0};
+  std::atomic<uint64_t> fHandoffNs{0};
+
+  static uint64_t ToNs(std::chrono::steady_clock::duration time)
+  {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+  }
+};
+
+/**
+ * @brief Decoder counters updated concurrently by the decode threads
+ *
+ * Updates happen once per aggregate: events are tallied per channel into a
+ * local array first and only non-zero channels touch the shared atomics.
+ * Snapshot() reads each counter independently, so a snapshot taken while
+ * decoding is running may not be exactly consistent across fields.
+ */
+class DecoderCounters
+{
+ public:
+  DecoderCounters();
+
+  DecoderCounters(const DecoderCounters &) = delete;
+  DecoderCounters &operator=(const DecoderCounters &) = delete;
+
+  // === Recording ===
+  void RecordAggregate(std::chrono::steady_clock::duration decodeTime);
+  void RecordEvents(const std::vector<std::unique_ptr<EventData>> &events);
+  void RecordEvents(const EventBatch &batch);
+  void RecordDiscarded()
+  {
+    fDiscardedBuffers.fetch_add(1, std::memory_order_relaxed);
+  }
+  void RecordDecodeError()
+  {
+    fDecodeErrors.fetch_add(1, std::memory_order_relaxed);
+  }
+  void RecordCounterDiscontinuity()
+  {
+    fCounterDiscontinuities.fetch_add(1, std::memory_order_relaxed);
+  }
+  void RecordDroppedAggregate(size_t bytes)
+  {
+    fDroppedAggregates.fetch_add(1, std::memory_order_relaxed);
+    fDroppedBytes.fetch_add(bytes, std::memory_order_relaxed);
+  }
+  void RecordDroppedEvents(size_t events)
+  {
+    fDroppedEvents.fetch_add(events, std::memory_order_relaxed);
+  }
+  void RecordBackpressureWait()
+  {
+    fBackpressureWaits.fetch_add(1, std::memory_order_relaxed);
+  }
+  void RecordCoincidenceRejected(size_t events)
+  {
+    if (events == 0) return;
+    fCoincidenceRejected.fetch_add(events, std::memory_order_relaxed);
+  }
+  void RecordSuppressed(
+      const std::array<uint64_t, DecoderStatistics::kMaxChannels> &counts);
+  void RecordSort(SortMethod method,
+                  std::chrono::steady_clock::duration sortTime);
+
+  // === Access ===
+  DecoderStatistics Snapshot() const;
+
+ private:
+  void AddChannelCounts(
+      const std::array<uint64_t, DecoderStatistics::kMaxChannels> &counts,
+      uint64_t total);
+
+  std::atomic<uint64_t> fAggregatesDecoded;
+  std::atomic<uint64_t> fEventsDecoded;
+  std::array<std::atomic<uint64_t>, DecoderStatistics::kMaxChannels>
+      fEventsPerChannel;
+  std::atomic<uint64_t> fDiscardedBuffers;
+  std::atomic<uint64_t> fDecodeErrors;
+  std::atomic<uint64_t> fCounterDiscontinuities;
+  std::atomic<uint64_t> fDroppedAggregates;
+  std::atomic<uint64_t> fDroppedBytes;
+  std::atomic<uint64_t> fDroppedEvents;
+  std::atomic<uint64_t> fBackpressureWaits;
+  std::atomic<uint64_t> fCoincidenceRejected;
+  std::atomic<uint64_t> fEventsSuppressed;
+  std::array<std::atomic<uint64_t>, DecoderStatistics::kMaxChannels>
+      fSuppressedPerChannel;
+  std::array<std::atomic<uint64_t>, 3> fSortCounts;  // By SortMethod
+  std::atomic<uint64_t> fSortTimeNs;
+
+  // === Decode Latency ===
+  std::array<std::atomic<uint64_t>, LatencyHistogram::kNumBuckets>
+      fLatencyCounts;
+  std::atomic<uint64_t> fLatencyTotalNs;
+  std::atomic<uint64_t> fLatencyMaxNs;
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // DIGITIZERSTATISTICS_HPP
@@ -0,0 +1,163 @@
+#ifndef EVENTBATCH_HPP
+#define EVENTBATCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "EventData.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Output format produced by the decoders
+ */
+enum class OutputFormat {
+  EventData,  // One heap-allocated EventData per hit (GetEventData)
+  EventBatch  // Columnar EventBatch (GetEventBatch)
+};
+
+/**
+ * @brief Per-event waveform metadata stored alongside the sample arena
+ */
+struct WaveformInfo {
+  uint8_t timeResolution = 0;
+  uint8_t analogProbe1Type = 0;
+  uint8_t analogProbe2Type = 0;
+  uint8_t digitalProbe1Type = 0;
+  uint8_t digitalProbe2Type = 0;
+  uint8_t digitalProbe3Type = 0;
+  uint8_t digitalProbe4Type = 0;
+  uint8_t downSampleFactor = 0;
+};
+
+/**
+ * @brief Non-owning view of one event's samples inside an EventBatch arena
+ *
+ * Pointers stay valid until the owning batch is modified, cleared or
+ * released back to its pool.
+ */
+struct WaveformView {
+  size_t size = 0;
+  const int32_t *analogProbe1 = nullptr;
+  const int32_t *analogProbe2 = nullptr;
+  const uint8_t *digitalProbe1 = nullptr;
+  const uint8_t *digitalProbe2 = nullptr;
+  const uint8_t *digitalProbe3 = nullptr;
+  const uint8_t *digitalProbe4 = nullptr;
+};
+
+/**
+ * @brief Structure-of-arrays container for decoded events
+ *
+ * Event i is described by element i of every per-event column. Waveform
+ * samples of all events share one set of contiguous probe arrays (the
+ * arena); event i owns samples [waveformOffset[i], waveformOffset[i] +
+ * waveformSize[i]). Events without a waveform have waveformSize 0 and add
+ * nothing to the arena. Traces kept packed (WaveformMode::Lazy or Compact)
+ * live in a second byte arena and are unpacked through GetEvent().
+ */
+class EventBatch
+{
+ public:
+  EventBatch() = default;
+  ~EventBatch() = default;
+
+  EventBatch(const EventBatch &) = default;
+  EventBatch &operator=(const EventBatch &) = default;
+  EventBatch(EventBatch &&) noexcept = default;
+  EventBatch &operator=(EventBatch &&) noexcept = default;
+
+  // === Size Management ===
+  size_t Size() const { return timeStampNs.size(); }
+  bool Empty() const { return timeStampNs.empty(); }
+  size_t GetTotalSamples() const { return analogProbe1.size(); }
+
+  /**
+   * @brief Remove all events, keeping the allocated capacity
+   */
+  void Clear();
+
+  /**
+   * @brief Reserve space for events and waveform samples
+   * @param nEvents Expected number of events
+   * @param nSamples Expected total number of waveform samples
+   */
+  void Reserve(size_t nEvents, size_t nSamples = 0);
+
+  // === Filling ===
+  /**
+   * @brief Append one event, copying its waveform into the arena
+   */
+  void Append(const EventData &event);
+
+  /**
+   * @brief Append event index of another batch
+   */
+  void Append(const EventBatch &other, size_t index);
+
+  /**
+   * @brief Append every event of another batch
+   */
+  void Append(const EventBatch &other);
+
+  /**
+   * @brief Reorder all columns by ascending timeStampPs
+   */
+  void SortByTimeStamp();
+
+  /**
+   * @brief Reorder all columns by ascending timeStampPs
+   * @param scratch Batch used as the gather target; on return it holds the
+   *                previous (unsorted) storage and can be recycled
+   */
+  void SortByTimeStamp(EventBatch &scratch);
+
+  // === Conversion ===
+  /**
+   * @brief Rebuild event index as a standalone EventData
+   */
+  EventData GetEvent(size_t index) const;
+
+  /**
+   * @brief Access the samples of event index without copying
+   * @return View with size 0 and null pointers if the event has no waveform
+   *         or its trace is still packed
+   */
+  WaveformView GetWaveform(size_t index) const;
+
+  // === Per-event Columns ===
+  std::vector<double> timeStampNs;
+  std::vector<uint64_t> timeStampPs;
+  std::vector<uint16_t> energy;
+  std::vector<uint16_t> energyShort;
+  std::vector<uint8_t> module;
+  std::vector<uint8_t> channel;
+  std::vector<uint64_t> flags;
+  std::vector<PulseFeatures> pulseFeatures;  // See PulseProcessor
+
+  // === Waveform Arena ===
+  std::vector<size_t> waveformOffset;
+  std::vector<uint32_t> waveformSize;
+  std::vector<WaveformInfo> waveformInfo;
+  std::vector<int32_t> analogProbe1;
+  std::vector<int32_t> analogProbe2;
+  std::vector<uint8_t> digitalProbe1;
+  std::vector<uint8_t> digitalProbe2;
+  std::vector<uint8_t> digitalProbe3;
+  std::vector<uint8_t> digitalProbe4;
+
+  // === Packed Waveform Arena (WaveformMode::Lazy or Compact) ===
+  std::vector<size_t> packedWaveformOffset;
+  std::vector<uint32_t> packedWaveformSize;  // Bytes, 0 = nothing packed
+  std::vector<PackedWaveformInfo> packedWaveformInfo;
+  std::vector<uint8_t> packedWaveform;
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // EVENTBATCH_HPP
@@ -0,0 +1,62 @@
+#ifndef EVENTBATCHPOOL_HPP
+#define EVENTBATCHPOOL_HPP
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "EventBatch.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Free list of EventBatch objects that keeps their capacity
+ *
+ * A released batch is cleared but its columns and waveform arena keep
+ * their allocations, so the next aggregate of similar size decodes
+ * without touching the allocator. Unlike RawDataPool this pool never
+ * blocks: Acquire() allocates a new batch when the free list is empty,
+ * and Release() drops batches beyond maxFreeBatches.
+ */
+class EventBatchPool
+{
+ public:
+  /**
+   * @brief Construct a pool
+   * @param maxFreeBatches Maximum number of idle batches kept for reuse
+   */
+  explicit EventBatchPool(size_t maxFreeBatches = 16);
+  ~EventBatchPool() = default;
+
+  EventBatchPool(const EventBatchPool &) = delete;
+  EventBatchPool &operator=(const EventBatchPool &) = delete;
+
+  /**
+   * @brief Get an empty batch, reusing a released one when available
+   */
+  std::unique_ptr<EventBatch> Acquire();
+
+  /**
+   * @brief Return a batch to the pool (nullptr is ignored)
+   */
+  void Release(std::unique_ptr<EventBatch> batch);
+
+  // Information
+  size_t GetMaxFreeBatches() const { return fMaxFreeBatches; }
+  size_t GetFreeCount() const;
+
+ private:
+  const size_t fMaxFreeBatches;
+
+  mutable std::mutex fMutex;
+  std::vector<std::unique_ptr<EventBatch>> fFreeBatches;
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // EVENTBATCHPOOL_HPP
@@ -11,6 +11,57 @@ namespace DELILA
 namespace Digitizer
 {
 
+/**
+ * @brief How decoders treat the waveform samples of an event
+ */
+enum class WaveformMode {
+  Decode,  // Unpack every trace (default)
+  Skip,    // Step over the trace words, waveformSize stays 0
+  Lazy,    // Keep the raw trace words, unpack with UnpackWaveform()
+  Compact,       // Keep a compact copy (see WaveformCodec), same unpacking
+  CompactDelta   // Compact, delta encoding the analog probes where smaller
+};
+
+/**
+ * @brief Whether a mode leaves traces packed for UnpackWaveform()
+ */
+inline bool IsPackedWaveformMode(WaveformMode mode)
+{
+  return mode == WaveformMode::Lazy || mode == WaveformMode::Compact ||
+         mode == WaveformMode::CompactDelta;
+}
+
+/**
+ * @brief Layout of a trace kept packed by WaveformMode::Lazy or Compact
+ */
+struct PackedWaveformInfo {
+  // Raw PSD2 or Dig1 trace words, or the WaveformCodec encoding
+  enum class Format : uint8_t { None, PSD2, Dig1, Compact };
+  Format format = Format::None;
+  bool dualTrace = false;  // Dig1 dual-trace mode
+  bool ap1Signed = false;  // PSD2 analog probe configuration
+  bool ap2Signed = false;
+  int32_t ap1MulFactor = 1;
+  int32_t ap2MulFactor = 1;
+  uint32_t nSamples = 0;  // waveformSize after unpacking
+};
+
+/**
+ * @brief Features of analogProbe1 computed by PulseProcessor
+ *
+ * Amplitude and charges are in ADC counts above the baseline with the
+ * pulse made positive; positions are (fractional) sample indices.
+ */
+struct PulseFeatures {
+  bool valid = false;  // Computed from a decoded trace
+  float baseline = 0.0f;
+  float amplitude = 0.0f;
+  float chargeShort = 0.0f;
+  float chargeLong = 0.0f;
+  float cfdSample = -1.0f;  // Zero crossing, -1 if none was found
+  float trapezoidHeight = 0.0f;
+};
+
 /**
  * @brief Event data structure for digitizer events
  *
@@ -36,6 +87,22 @@ class EventData
   void ResizeWaveform(size_t size);
   void ClearWaveform();
 
+  /**
+   * @brief Decode a packed trace (WaveformMode::Lazy or Compact) into the
+   *        probe vectors
+   * @return false if there was no packed trace
+   */
+  bool UnpackWaveform();
+
+  /**
+   * @brief Replace the decoded trace by its compact encoding (see
+   *        WaveformCodec) and release the probe vectors
+   * @param delta Allow delta encoding of the analog probes
+   * @return false if there was no decoded trace
+   */
+  bool PackWaveform(bool delta = false);
+  bool HasPackedWaveform() const { return !packedWaveform.empty(); }
+
   // Display methods
   void Print() const;
   void PrintSummary() const;
@@ -43,6 +110,9 @@ class EventData
 
   // Public data members
   double timeStampNs;
+  // Same time in integer picoseconds, exact for the whole 48-bit range;
+  // sorting and merging use this one
+  uint64_t timeStampPs;
   size_t waveformSize;
   std::vector<int32_t> analogProbe1;
   std::vector<int32_t> analogProbe2;
@@ -66,6 +136,16 @@ class EventData
   // NEW: Flags field for status information (dig1/dig2)
   uint64_t flags;
 
+  // Packed trace (WaveformMode::Lazy or Compact), emptied by
+  // UnpackWaveform()
+  std::vector<uint8_t> packedWaveform;
+  PackedWaveformInfo packedWaveformInfo;
+
+  // Filled by the optional pulse processing stage (see PulseProcessor)
+  PulseFeatures pulseFeatures;
+
+  static constexpr uint64_t kPsPerNs = 1000;
+
   // Flag bit definitions for PSD1/PSD2
   static constexpr uint64_t FLAG_PILEUP = 0x01;          // Pileup detected
   static constexpr uint64_t FLAG_TRIGGER_LOST = 0x02;    // Trigger lost
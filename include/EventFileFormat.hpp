@@ -0,0 +1,52 @@
+#ifndef EVENTFILEFORMAT_HPP
+#define EVENTFILEFORMAT_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Layout of the binary event files written by EventWriter
+ *
+ * A file (.evt) is a FileHeader followed by fixed-size Records, one per
+ * decoded event, so event n is at headerSize + n * recordSize. Waveforms
+ * are not stored. All fields are host (little) endian.
+ */
+namespace EventFile
+{
+constexpr char kMagic[8] = {'D', 'L', 'E', 'V', 'T', 'v', '0', '1'};
+constexpr uint32_t kVersion = 1;
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t headerSize;  // sizeof(FileHeader)
+  uint32_t recordSize;  // sizeof(Record)
+  uint32_t moduleNumber;
+  uint32_t fileIndex;  // Rotation counter within the run
+  uint32_t reserved;
+  uint64_t creationTimeNs;  // system_clock, since the epoch
+};
+
+struct Record {
+  uint64_t timeStampPs;
+  uint64_t flags;  // EventData::FLAG_*
+  uint16_t energy;
+  uint16_t energyShort;
+  uint8_t module;
+  uint8_t channel;
+  uint16_t reserved;
+};
+
+static_assert(sizeof(FileHeader) == 40, "EventFile::FileHeader layout");
+static_assert(sizeof(Record) == 24, "EventFile::Record layout");
+}  // namespace EventFile
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // EVENTFILEFORMAT_HPP
@@ -0,0 +1,60 @@
+#ifndef EVENTNOTIFIER_HPP
+#define EVENTNOTIFIER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Wakes consumers waiting for decoded events
+ *
+ * Decode threads call Notify() once per batch of decoded buffers. A
+ * consumer reads GetGeneration() before checking for events and, if there
+ * were none, waits with WaitFor() for the generation to move on, so
+ * events stored between the check and the wait are never missed.
+ */
+class EventNotifier
+{
+ public:
+  uint64_t GetGeneration() const
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    return fGeneration;
+  }
+
+  void Notify()
+  {
+    {
+      std::lock_guard<std::mutex> lock(fMutex);
+      fGeneration++;
+    }
+    fCV.notify_all();
+  }
+
+  /**
+   * @brief Wait until Notify() is called after generation was read
+   * @return false on timeout
+   */
+  bool WaitFor(uint64_t generation, std::chrono::milliseconds timeout)
+  {
+    std::unique_lock<std::mutex> lock(fMutex);
+    return fCV.wait_for(lock, timeout,
+                        [&] { return fGeneration != generation; });
+  }
+
+ private:
+  mutable std::mutex fMutex;
+  std::condition_variable fCV;
+  uint64_t fGeneration = 0;
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // EVENTNOTIFIER_HPP
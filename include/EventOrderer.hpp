@@ -0,0 +1,152 @@
+#ifndef EVENTORDERER_HPP
+#define EVENTORDERER_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "EventBatch.hpp"
+#include "EventBatchPool.hpp"
+#include "EventData.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Ordering guarantee of decoder output across decode threads
+ */
+enum class OutputOrder {
+  None,      // Aggregates appear in whatever order the threads finish
+  Sequence,  // Aggregates are released in readout order
+  TimeStamp  // Events are merged into global timestamp order
+};
+
+/**
+ * @brief Ordering mode and its latency bounds
+ */
+struct OrderingConfig {
+  OutputOrder order = OutputOrder::None;
+  // Finished aggregates held back waiting for a missing one before it is
+  // skipped
+  size_t maxPendingAggregates = 64;
+  // Longest time finished output may wait behind a gap or in the merge
+  // window
+  std::chrono::milliseconds maxLatency{100};
+  // TimeStamp mode: events are held until the newest timestamp seen is this
+  // far ahead of them
+  double mergeWindowNs = 1.0e6;
+};
+
+/**
+ * @brief Reorder buffer and watermark merge for decoded aggregates
+ *
+ * Every raw buffer carries the readout sequence number assigned by the
+ * reader thread. Decode threads Push() the sorted events of a buffer and
+ * then Finish() its sequence number; buffers that are never decoded (start
+ * and stop markers, discarded data) are only finished. Finished buffers are
+ * released strictly in sequence order. In TimeStamp mode released events
+ * also pass through a holding buffer that emits events once they fall
+ * behind the watermark (newest timestamp - mergeWindowNs), giving globally
+ * sorted output.
+ *
+ * Latency is bounded: if more than maxPendingAggregates finished buffers
+ * wait behind a missing one, or they have waited longer than maxLatency,
+ * the gap is skipped. A skipped buffer that finishes later is released
+ * immediately and counted as late.
+ */
+class EventOrderer
+{
+ public:
+  explicit EventOrderer(EventBatchPool &batchPool);
+  ~EventOrderer() = default;
+
+  EventOrderer(const EventOrderer &) = delete;
+  EventOrderer &operator=(const EventOrderer &) = delete;
+
+  // Configuration
+  void Configure(const OrderingConfig &config);
+  bool IsEnabled() const { return fOrder != OutputOrder::None; }
+
+  // === Producer Side (decode threads) ===
+  void Push(uint64_t sequence,
+            std::vector<std::unique_ptr<EventData>> &&events);
+  void Push(uint64_t sequence, std::unique_ptr<EventBatch> batch);
+  void Finish(uint64_t sequence);
+
+  // === Consumer Side ===
+  std::unique_ptr<std::vector<std::unique_ptr<EventData>>> TakeEventData();
+  std::unique_ptr<EventBatch> TakeEventBatch();
+
+  /**
+   * @brief Release everything held, ignoring gaps and the merge window
+   */
+  void Flush();
+
+  // Information
+  uint64_t GetSkippedCount() const;
+  uint64_t GetLateCount() const;
+  size_t GetPendingCount() const;
+
+  /**
+   * @brief Number of released events waiting to be taken
+   */
+  size_t GetReadyCount() const;
+
+  /**
+   * @brief Drop the released events waiting to be taken
+   * @return Number of events dropped
+   */
+  size_t DiscardReady();
+
+ private:
+  struct Pending {
+    std::vector<std::unique_ptr<EventData>> events;
+    std::unique_ptr<EventBatch> batch;
+    bool finished = false;
+  };
+
+  void ReleaseLocked(bool force);
+  void EmitLocked(Pending &pending);
+  void EmitReadyLocked(Pending &pending);
+  void ReleaseHeldLocked(bool force);
+  void MergeBatchLocked(std::unique_ptr<EventBatch> &held,
+                        std::unique_ptr<EventBatch> incoming);
+
+  EventBatchPool &fBatchPool;
+  OrderingConfig fConfig;
+  OutputOrder fOrder = OutputOrder::None;
+
+  mutable std::mutex fMutex;
+
+  // === Reorder Buffer ===
+  std::map<uint64_t, Pending> fPending;
+  uint64_t fNextSequence = 0;
+  size_t fFinishedCount = 0;
+  bool fBlocked = false;  // Finished aggregates wait behind a gap
+  std::chrono::steady_clock::time_point fBlockedSince;
+
+  // === Watermark Merge (TimeStamp mode) ===
+  std::vector<std::unique_ptr<EventData>> fHeldEvents;
+  std::unique_ptr<EventBatch> fHeldBatch;
+  uint64_t fNewestTimeStampPs = 0;
+  std::chrono::steady_clock::time_point fLastHeldInput;
+
+  // === Released Output ===
+  std::unique_ptr<std::vector<std::unique_ptr<EventData>>> fReadyEvents;
+  std::unique_ptr<EventBatch> fReadyBatch;
+
+  // === Statistics ===
+  uint64_t fSkippedCount = 0;
+  uint64_t fLateCount = 0;
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // EVENTORDERER_HPP
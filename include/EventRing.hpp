@@ -0,0 +1,178 @@
+#ifndef EVENTRING_HPP
+#define EVENTRING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ConfigurationManager.hpp"
+#include "DigitizerStatistics.hpp"
+#include "EventBatch.hpp"
+#include "EventData.hpp"
+#include "EventRingFormat.hpp"
+#include "IEventSink.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Settings of the shared-memory event ring
+ */
+struct EventRingConfig {
+  // POSIX shared-memory name prefix such as "/delila"; the object is
+  // <name>_modNN. Empty = disabled
+  std::string name;
+  // Records in the ring, rounded up to a power of two
+  size_t capacityEvents = 1 << 20;
+  // Size of the analogProbe1 region, rounded up to a power of two
+  // (0 = no waveforms)
+  size_t waveformBytes = 0;
+  // Events are only published, never stored for GetEventData()
+  bool ringOnly = false;
+};
+
+/**
+ * @brief Publishes decoded events into a shared-memory ring
+ *
+ * Any number of processes on the host attach with EventRingReader and
+ * read the same records (see EventRingFormat.hpp), each at its own pace.
+ * The publisher never waits for them: it overwrites the oldest records,
+ * and a reader that falls a full ring behind skips ahead and counts the
+ * events it lost. The decode threads serialize on a mutex only among
+ * themselves; readers take no lock.
+ *
+ * The shared-memory object is created by the first Start() and removed
+ * when the publisher is destroyed, so readers stay attached between runs
+ * and the event index continues.
+ */
+class EventRingPublisher : public IEventSink
+{
+ public:
+  EventRingPublisher(EventRingConfig config, uint8_t moduleNumber);
+  ~EventRingPublisher() override;
+
+  EventRingPublisher(const EventRingPublisher &) = delete;
+  EventRingPublisher &operator=(const EventRingPublisher &) = delete;
+
+  /**
+   * @brief Parse the EventRing* parameters of a digitizer configuration
+   */
+  static EventRingConfig ParseConfig(const ConfigurationManager &config);
+
+  /**
+   * @brief Shared-memory object name of a module
+   */
+  static std::string GetObjectName(const std::string &prefix,
+                                   uint8_t moduleNumber);
+
+  /**
+   * @brief Create the ring (first call) and start publishing
+   * @return false if the shared-memory object cannot be created
+   */
+  bool Start();
+  void Stop();
+
+  // === Publishing (decode threads) ===
+  void Write(const std::vector<std::unique_ptr<EventData>> &events) override;
+  void Write(const EventBatch &batch) override;
+  bool IsExclusive() const override { return fConfig.ringOnly; }
+
+  const EventRingConfig &GetConfig() const { return fConfig; }
+
+  /**
+   * @brief Copy the ring counters into stats
+   */
+  void Fill(DigitizerStatistics &stats) const;
+
+ private:
+  const EventRingConfig fConfig;
+  const uint8_t fModuleNumber;
+  const std::string fObjectName;
+
+  // === Mapping ===
+  void *fMapping = nullptr;
+  size_t fMappingSize = 0;
+  EventRing::Header *fHeader = nullptr;
+  EventRing::Record *fRecords = nullptr;
+  uint8_t *fWaveforms = nullptr;
+  uint64_t fCapacity = 0;
+  uint64_t fWaveformBytes = 0;
+
+  // === Publishing ===
+  std::mutex fMutex;
+  bool fRunning = false;
+  uint64_t fNextIndex = 0;  // Under fMutex
+
+  // === Statistics ===
+  std::atomic<uint64_t> fEventsPublished{0};
+  std::atomic<uint64_t> fWaveformsSkipped{0};
+
+  bool Create();
+  void PublishLocked(uint64_t timeStampPs, uint64_t flags, uint16_t energy,
+                     uint16_t energyShort, uint8_t module, uint8_t channel,
+                     const int32_t *samples, size_t nSamples);
+};
+
+/**
+ * @brief Attaches to the ring of an EventRingPublisher, usually from
+ *        another process
+ *
+ * Each reader tracks its own position and only reads shared memory, so
+ * readers neither slow the publisher nor each other. A reader starts at
+ * the events published after Open().
+ */
+class EventRingReader
+{
+ public:
+  EventRingReader() = default;
+  ~EventRingReader();
+
+  EventRingReader(const EventRingReader &) = delete;
+  EventRingReader &operator=(const EventRingReader &) = delete;
+
+  /**
+   * @brief Map the ring read-only
+   * @param objectName See EventRingPublisher::GetObjectName()
+   * @return false if it does not exist or is not a compatible ring
+   */
+  bool Open(const std::string &objectName);
+  void Close();
+  bool IsOpen() const { return fHeader != nullptr; }
+
+  /**
+   * @brief Append up to maxEvents newly published events to batch
+   * @return Number of events appended
+   */
+  size_t Read(EventBatch &batch, size_t maxEvents);
+
+  uint32_t GetModuleNumber() const;
+  // Events overwritten before this reader got to them
+  uint64_t GetLostEvents() const { return fLostEvents; }
+  // Events read without their overwritten waveform
+  uint64_t GetLostWaveforms() const { return fLostWaveforms; }
+
+ private:
+  const void *fMapping = nullptr;
+  size_t fMappingSize = 0;
+  const EventRing::Header *fHeader = nullptr;
+  const EventRing::Record *fRecords = nullptr;
+  const uint8_t *fWaveforms = nullptr;
+  uint64_t fCapacity = 0;
+  uint64_t fWaveformBytes = 0;
+
+  uint64_t fNextIndex = 0;
+  uint64_t fLostEvents = 0;
+  uint64_t fLostWaveforms = 0;
+  EventData fScratch;  // Reused for each appended event
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // EVENTRING_HPP
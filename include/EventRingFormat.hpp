@@ -0,0 +1,76 @@
+#ifndef EVENTRINGFORMAT_HPP
+#define EVENTRINGFORMAT_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Layout of the shared-memory event ring written by
+ *        EventRingPublisher
+ *
+ * The POSIX shared-memory object holds a Header, capacity Records and,
+ * if waveformBytes > 0, a waveform region:
+ *
+ *   Header
+ *   Record   records[capacity]           event i in records[i % capacity]
+ *   uint8_t  waveforms[waveformBytes]
+ *
+ * Event i is published by writing records[i % capacity] with sequence
+ * kBusy, filling it, then storing sequence = i (release) and finally
+ * writeIndex = i + 1 (release). A reader keeps its own next index and
+ * takes a record as valid if sequence equals that index both before and
+ * after copying it (acquire); anything else means the publisher lapped
+ * the reader. The analogProbe1 samples of an event (int32_t) start at
+ * byte waveformPosition % waveformBytes of the waveform region and are
+ * contiguous; waveformHead is advanced past them before they are
+ * written, so they are intact if waveformHead - waveformPosition <=
+ * waveformBytes after copying. capacity and waveformBytes are powers of
+ * two. All fields are host (little) endian.
+ */
+namespace EventRing
+{
+constexpr char kMagic[8] = {'D', 'L', 'R', 'I', 'N', 'G', '0', '1'};
+constexpr uint32_t kVersion = 1;
+constexpr uint64_t kBusy = UINT64_MAX;  // Record being rewritten
+
+struct Header {
+  char magic[8];  // Written last, once the ring is initialized
+  uint32_t version;
+  uint32_t headerSize;  // sizeof(Header), records start here
+  uint32_t moduleNumber;
+  uint32_t recordSize;     // sizeof(Record)
+  uint64_t capacity;       // Records
+  uint64_t waveformBytes;  // 0 = no waveforms
+  alignas(64) std::atomic<uint64_t> writeIndex;  // Events published
+  alignas(64) std::atomic<uint64_t> waveformHead;  // Waveform bytes claimed
+};
+
+struct Record {
+  std::atomic<uint64_t> sequence;  // Event index held, kBusy while written
+  uint64_t timeStampPs;
+  uint64_t flags;             // EventData::FLAG_*
+  uint64_t waveformPosition;  // Byte position in the waveform stream
+  uint32_t waveformSize;      // analogProbe1 samples, 0 = none stored
+  uint16_t energy;
+  uint16_t energyShort;
+  uint8_t module;
+  uint8_t channel;
+  uint8_t reserved[6];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "EventRing needs address-free 64-bit atomics");
+static_assert(sizeof(Header) == 192, "EventRing::Header layout");
+static_assert(sizeof(Record) == 48, "EventRing::Record layout");
+}  // namespace EventRing
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // EVENTRINGFORMAT_HPP
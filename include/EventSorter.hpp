@@ -0,0 +1,73 @@
+#ifndef EVENTSORTER_HPP
+#define EVENTSORTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "EventBatch.hpp"
+#include "EventData.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief How EventSorter ordered an aggregate
+ */
+enum class SortMethod {
+  None,   // Already in time order
+  Merge,  // Few ascending runs, merged pairwise
+  Radix   // LSD radix sort on the timestamp
+};
+
+/**
+ * @brief Stable time sort of decoded aggregates on timeStampPs
+ *
+ * The key of every event is copied once next to its index, so sorting
+ * never follows an EventData pointer. Dig1 aggregates are time ordered
+ * per channel pair and PSD2 aggregates are nearly sorted, so the common
+ * cases are a single run (nothing to do) or a handful of runs, which are
+ * merged in log2(runs) passes. Anything less ordered goes through an LSD
+ * radix sort on the key relative to the aggregate's earliest timestamp,
+ * with only as many 8-bit passes as the aggregate's time span needs.
+ * Scratch buffers are per thread, so decode threads sort concurrently.
+ */
+class EventSorter
+{
+ public:
+  static constexpr size_t kMaxMergeRuns = 16;
+
+  struct SortKey {
+    uint64_t key;
+    uint32_t index;
+  };
+
+  static SortMethod Sort(std::vector<std::unique_ptr<EventData>> &events);
+
+  /**
+   * @brief Sort every column of batch
+   * @param scratch Gather target; on return it holds the previous
+   *                (unsorted) storage and can be recycled
+   */
+  static SortMethod Sort(EventBatch &batch, EventBatch &scratch);
+
+  /**
+   * @brief Stable sort of keys by key
+   * @param temp Scratch of any size, resized as needed
+   */
+  static SortMethod SortKeys(std::vector<SortKey> &keys,
+                             std::vector<SortKey> &temp);
+
+ private:
+  static void MergeRuns(std::vector<SortKey> &keys, std::vector<SortKey> &temp,
+                        std::vector<size_t> &runStarts);
+  static void RadixSort(std::vector<SortKey> &keys, std::vector<SortKey> &temp);
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // EVENTSORTER_HPP
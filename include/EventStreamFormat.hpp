@@ -0,0 +1,55 @@
+#ifndef EVENTSTREAMFORMAT_HPP
+#define EVENTSTREAMFORMAT_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Wire format of the event stream sent by EventStreamer
+ *
+ * The TCP stream is a sequence of messages, each a MessageHeader followed
+ * by payloadSize bytes holding the columns of nEvents events one after
+ * the other, in this order:
+ *
+ *   uint64_t timeStampPs[nEvents]
+ *   uint64_t flags[nEvents]        EventData::FLAG_*
+ *   uint16_t energy[nEvents]
+ *   uint16_t energyShort[nEvents]
+ *   uint8_t  channel[nEvents]
+ *
+ * so payloadSize == nEvents * kBytesPerEvent. Events are time ordered
+ * within each decoded aggregate. sequence counts the messages of a module
+ * from 0, so a subscriber that connects late starts at a later value;
+ * events the streamer could not buffer never reach any message and are
+ * totalled in droppedEvents instead. All fields are host (little) endian.
+ */
+namespace EventStream
+{
+constexpr char kMagic[8] = {'D', 'L', 'S', 'T', 'R', 'v', '0', '1'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kBytesPerEvent = 8 + 8 + 2 + 2 + 1;
+
+struct MessageHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t headerSize;  // sizeof(MessageHeader)
+  uint32_t moduleNumber;
+  uint32_t nEvents;
+  uint64_t sequence;
+  uint64_t payloadSize;    // Bytes following this header
+  uint64_t sendTimeNs;     // system_clock, since the epoch
+  uint64_t droppedEvents;  // Not streamed since the streamer was created
+};
+
+static_assert(sizeof(MessageHeader) == 56, "EventStream::MessageHeader layout");
+}  // namespace EventStream
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // EVENTSTREAMFORMAT_HPP
@@ -0,0 +1,138 @@
+#ifndef EVENTSTREAMER_HPP
+#define EVENTSTREAMER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ConfigurationManager.hpp"
+#include "DigitizerStatistics.hpp"
+#include "EventBatch.hpp"
+#include "EventData.hpp"
+#include "EventStreamFormat.hpp"
+#include "IEventSink.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Settings of the network event stream
+ */
+struct EventStreamerConfig {
+  int port = 0;  // TCP port subscribers connect to; 0 = disabled
+  std::string bindAddress = "0.0.0.0";
+  // A message is sent once this many events are buffered...
+  size_t maxMessageEvents = 65536;
+  // ...or at the latest after this interval
+  uint32_t flushIntervalMs = 100;
+  // Events waiting to be sent; more are dropped, not waited for
+  size_t bufferEvents = 1 << 20;
+  // A subscriber that takes longer to accept a message is disconnected
+  uint32_t sendTimeoutMs = 1000;
+  // Events are only streamed, never stored for GetEventData()
+  bool streamOnly = false;
+};
+
+/**
+ * @brief Publishes decoded events over TCP to any number of subscribers
+ *
+ * Like EventWriter, the decode threads copy each aggregate into the front
+ * half of a double buffer and a sender thread works on the other half.
+ * The sender serializes the columns once per message (see
+ * EventStreamFormat.hpp) and sends the same bytes to every connected
+ * subscriber, so a remote event builder receives compact columnar batches
+ * without any per-event objects. A subscriber that cannot keep up is
+ * disconnected rather than slowing the others; with no subscriber the
+ * events are discarded.
+ *
+ * The listening socket and the connections persist across Stop() and
+ * Start(), so a builder stays subscribed between runs and the message
+ * sequence continues.
+ */
+class EventStreamer : public IEventSink
+{
+ public:
+  EventStreamer(EventStreamerConfig config, uint8_t moduleNumber);
+  ~EventStreamer() override;
+
+  EventStreamer(const EventStreamer &) = delete;
+  EventStreamer &operator=(const EventStreamer &) = delete;
+
+  /**
+   * @brief Parse the EventStream* parameters of a digitizer configuration
+   */
+  static EventStreamerConfig ParseConfig(const ConfigurationManager &config);
+
+  /**
+   * @brief Listen on the configured port (first call) and start sending
+   * @return false if the port cannot be bound
+   */
+  bool Start();
+
+  /**
+   * @brief Send everything buffered and stop the sender thread
+   */
+  void Stop();
+
+  // === Streaming (decode threads) ===
+  void Write(const std::vector<std::unique_ptr<EventData>> &events) override;
+  void Write(const EventBatch &batch) override;
+  bool IsExclusive() const override { return fConfig.streamOnly; }
+
+  const EventStreamerConfig &GetConfig() const { return fConfig; }
+
+  /**
+   * @brief Copy the streaming counters into stats
+   */
+  void Fill(DigitizerStatistics &stats) const;
+
+ private:
+  const EventStreamerConfig fConfig;
+  const uint8_t fModuleNumber;
+
+  // === Double Buffer ===
+  // Only the streamed columns are filled, so sizes come from timeStampPs
+  std::mutex fMutex;
+  std::condition_variable fCondition;
+  EventBatch fFront;  // Filled by the decode threads under fMutex
+  EventBatch fBack;   // Sender thread only
+  bool fRunning = false;
+  std::thread fSenderThread;
+
+  // === Connections (sender thread only once started) ===
+  int fListenFd = -1;
+  std::vector<int> fClients;
+  uint64_t fSequence = 0;
+  std::vector<uint8_t> fPayload;
+
+  // === Statistics ===
+  std::atomic<uint64_t> fEventsStreamed{0};
+  std::atomic<uint64_t> fEventsDropped{0};
+  std::atomic<uint64_t> fMessagesSent{0};
+  std::atomic<uint64_t> fBytesSent{0};
+  std::atomic<uint64_t> fSubscribers{0};
+  std::atomic<uint64_t> fDisconnects{0};
+
+  void SenderThread();
+  void SendBack();
+  void SendMessage(size_t first, size_t count);
+  bool Listen();
+  void AcceptSubscribers();
+  void Disconnect(size_t client, const char *reason);
+
+  bool AdmitLocked(size_t nEvents);  // fMutex held; counts drops
+  size_t FrontSizeLocked() const { return fFront.timeStampPs.size(); }
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // EVENTSTREAMER_HPP
@@ -0,0 +1,153 @@
+#ifndef EVENTWRITER_HPP
+#define EVENTWRITER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ConfigurationManager.hpp"
+#include "DigitizerStatistics.hpp"
+#include "EventBatch.hpp"
+#include "EventData.hpp"
+#include "EventFileFormat.hpp"
+#include "IEventSink.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief File format of the decoded event output
+ */
+enum class EventFileFormat {
+  Root,   // TTree "events", one branch per column
+  Binary  // Fixed-size EventFile::Record, see EventFileFormat.hpp
+};
+
+/**
+ * @brief Settings of the decoded event output
+ */
+struct EventWriterConfig {
+  // Files are named <pathPrefix>_mod<NN>_<NNNN>.root/.evt; empty = disabled
+  std::string pathPrefix;
+  EventFileFormat format = EventFileFormat::Root;
+  int compressionLevel = 1;  // ROOT only, 0 (none) to 9
+  // A new file is started once a file has grown past this size
+  uint64_t maxFileSize = 2048ULL << 20;
+  // Events each of the two buffers holds; more are dropped, not waited for
+  size_t bufferEvents = 1 << 20;
+  bool writeWaveforms = false;  // ROOT only, analog probes as vector branches
+  // Events are only written, never stored for GetEventData()
+  bool writeOnly = false;
+};
+
+/**
+ * @brief Persists decoded events on a background thread
+ *
+ * The decode threads Write() every aggregate after sorting and the
+ * coincidence filter. Events are copied into the front buffer under a
+ * short lock; the writer thread swaps it with the back buffer and writes
+ * the back buffer while decoding fills the front one, so disk I/O never
+ * blocks a decode thread. When the front buffer is full the aggregate is
+ * dropped and counted instead. Files rotate by size and existing files
+ * are never overwritten.
+ *
+ * Events are in time order within each aggregate; aggregates follow each
+ * other in decode order. A write failure stops the output for the rest of
+ * the run and is counted.
+ */
+class EventWriter : public IEventSink
+{
+ public:
+  EventWriter(EventWriterConfig config, uint8_t moduleNumber);
+  ~EventWriter() override;
+
+  EventWriter(const EventWriter &) = delete;
+  EventWriter &operator=(const EventWriter &) = delete;
+
+  /**
+   * @brief Parse the EventWrite* parameters of a digitizer configuration
+   */
+  static EventWriterConfig ParseConfig(const ConfigurationManager &config);
+
+  /**
+   * @brief Open the next file and start the writer thread
+   * @return false if the file cannot be created
+   */
+  bool Start();
+
+  /**
+   * @brief Write everything buffered, then close the file
+   *
+   * Events written after Stop() are counted as dropped.
+   */
+  void Stop();
+
+  // === Writing (decode threads) ===
+  void Write(const std::vector<std::unique_ptr<EventData>> &events) override;
+  void Write(const EventBatch &batch) override;
+  bool IsExclusive() const override { return fConfig.writeOnly; }
+
+  const EventWriterConfig &GetConfig() const { return fConfig; }
+
+  /**
+   * @brief Copy the event output counters into stats
+   */
+  void Fill(DigitizerStatistics &stats) const;
+
+ private:
+  struct RootOutput;  // TFile and TTree, defined with the ROOT code
+
+  const EventWriterConfig fConfig;
+  const uint8_t fModuleNumber;
+
+  // === Double Buffer ===
+  std::mutex fMutex;
+  std::condition_variable fCondition;
+  EventBatch fFront;  // Filled by the decode threads under fMutex
+  EventBatch fBack;   // Writer thread only
+  const size_t fWakeEvents;  // Front buffer fill that wakes the writer early
+  bool fRunning = false;
+  std::thread fWriterThread;
+
+  // === Files (writer thread only once started) ===
+  int fBinaryFd = -1;
+  std::unique_ptr<RootOutput> fRoot;
+  std::vector<EventFile::Record> fRecords;
+  uint32_t fFileIndex = 0;  // Continues across Start() calls
+  uint64_t fFileSize = 0;
+  bool fFailed = false;
+
+  // === Statistics ===
+  std::atomic<uint64_t> fEventsWritten{0};
+  std::atomic<uint64_t> fEventsDropped{0};
+  std::atomic<uint64_t> fBytesWritten{0};
+  std::atomic<uint64_t> fFilesWritten{0};
+  std::atomic<uint64_t> fWriteErrors{0};
+
+  void WriterThread();
+  void WriteBack();
+  void WriteBinary();
+  void WriteRoot();
+  bool OpenFile();
+  void CloseFile();
+  void Fail(const std::string &what);
+  std::string MakePath() const;
+
+  // Copies the written columns (and waveforms if enabled) into fFront
+  void AppendLocked(const EventBatch &batch);
+  void AppendLocked(const EventData &event);
+  bool AdmitLocked(size_t nEvents);  // fMutex held; counts drops
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // EVENTWRITER_HPP
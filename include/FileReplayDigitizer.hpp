@@ -0,0 +1,155 @@
+#ifndef FILEREPLAYDIGITIZER_HPP
+#define FILEREPLAYDIGITIZER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ConfigurationManager.hpp"
+#include "EventRing.hpp"
+#include "EventStreamer.hpp"
+#include "EventWriter.hpp"
+#include "HistogramServer.hpp"
+#include "IDecoder.hpp"
+#include "IDigitizer.hpp"
+#include "PipelineTracer.hpp"
+#include "RawData.hpp"
+#include "RawDataPool.hpp"
+#include "RawFileFormat.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Offline data source that replays run files written by RawRecorder
+ *
+ * Selected by the factory for URL=file://<path>.raw. The file and the
+ * rotated continuations that follow it (<prefix>_mod<NN>_0001.raw, ...) are
+ * mapped read-only and their records fed, in order, into the decoder of the
+ * recorded firmware type, so the decode and output path is exactly the one
+ * of a live board. Each record is copied into a pool buffer first: decoders
+ * own their input and PSD2 byte-swaps it in place.
+ *
+ * ReplaySpeed 0 replays as fast as the decoder accepts data; any other
+ * value paces the records by their recorded write times, divided by the
+ * speed. CheckStatus() turns false once the last record has been fed.
+ */
+class FileReplayDigitizer : public IDigitizer
+{
+ public:
+  FileReplayDigitizer();
+  ~FileReplayDigitizer() override;
+
+  // Main lifecycle methods
+  bool Initialize(const ConfigurationManager &config) override;
+  bool Configure() override;
+  bool StartAcquisition() override;
+  bool StopAcquisition() override;
+  bool ArmAcquisition() override;
+  bool SendSWStart() override;
+  void CancelLifecycle() override { fCancelRequested = true; }
+
+  // Data access
+  std::unique_ptr<std::vector<std::unique_ptr<EventData>>> GetEventData()
+      override;
+  std::unique_ptr<EventBatch> GetEventBatch() override;
+  std::unique_ptr<std::vector<std::unique_ptr<EventData>>> GetEventData(
+      std::chrono::milliseconds timeout) override;
+  std::unique_ptr<EventBatch> GetEventBatch(
+      std::chrono::milliseconds timeout) override;
+  void ReleaseEventBatch(std::unique_ptr<EventBatch> batch) override;
+  DigitizerStatistics GetStatistics() const override;
+  std::shared_ptr<OnlineHistograms> GetHistograms() const override
+  {
+    return fHistograms;
+  }
+
+  // Device information (there is no device tree for a file)
+  const nlohmann::json &GetDeviceTreeJSON() const override
+  {
+    return fDeviceTree;
+  }
+  void PrintDeviceInfo() override;
+  FirmwareType GetType() const override { return fFirmwareType; }
+
+  // Control methods
+  bool SendSWTrigger() override { return false; }
+  bool CheckStatus() override { return fReplaying; }
+
+  // Getters
+  uint64_t GetHandle() const override { return 0; }
+  uint8_t GetModuleNumber() const override { return fModuleNumber; }
+
+ private:
+  // === Input Files ===
+  std::vector<std::string> fFiles;  // First file and its continuations
+  RawFile::FileHeader fFileHeader{};  // Of the first file
+  size_t fMaxRecordSize = 0;  // Largest payload, sizes the pool buffers
+  uint64_t fTotalRecords = 0;
+
+  // === Configuration ===
+  std::string fURL;
+  bool fDebugFlag = false;
+  uint32_t fNThreads = 1;
+  uint32_t fRawDataPoolSize = 32;
+  uint32_t fRawDataQueueSize = 0;  // 0 = unbounded
+  BackpressureConfig fBackpressure;
+  CoincidenceConfig fCoincidence;
+  ZeroSuppressionConfig fZeroSuppression;
+  PulseProcessingConfig fPulseProcessing;
+  HistogramConfig fHistogramConfig;
+  EventWriterConfig fEventWriterConfig;
+  EventStreamerConfig fEventStreamerConfig;
+  EventRingConfig fEventRingConfig;
+  PipelineTraceConfig fTraceConfig;
+  ThreadPlacementConfig fPlacement;
+  OutputFormat fOutputFormat = OutputFormat::EventData;
+  OrderingConfig fOrdering;
+  WaveformMode fWaveformMode = WaveformMode::Decode;
+  uint32_t fChannelPairThreads = 1;
+  bool fSwapOnDecode = false;
+  double fReplaySpeed = 0.0;  // 0 = as fast as possible
+  uint32_t fTimeStepNs = 0;
+  uint8_t fModuleNumber = 0;
+
+  // === Device Information ===
+  nlohmann::json fDeviceTree;
+  FirmwareType fFirmwareType = FirmwareType::UNKNOWN;
+
+  // === Data Processing ===
+  std::unique_ptr<IDecoder> fDecoder;
+  std::shared_ptr<RawDataPool> fRawDataPool;
+  std::shared_ptr<OnlineHistograms> fHistograms;
+  std::shared_ptr<EventWriter> fEventWriter;  // Shared with the decoder
+  std::shared_ptr<EventStreamer> fEventStreamer;  // Shared with the decoder
+  std::shared_ptr<EventRingPublisher> fEventRing;  // Shared with the decoder
+  std::shared_ptr<PipelineTracer> fTracer;  // Shared with the decoder
+  std::unique_ptr<HistogramServer> fHistogramServer;
+  std::atomic<bool> fDataTakingFlag{false};
+  std::atomic<bool> fReplaying{false};
+  std::atomic<bool> fCancelRequested{false};  // See CancelLifecycle()
+  std::thread fReplayThread;
+  uint64_t fReplaySequence = 0;  // Replay thread only, never reset
+  ReadoutCounters fReadoutCounters;
+
+  // === File Handling ===
+  bool FindFiles(const std::string &firstFile);
+  bool ScanFile(const std::string &path, bool isFirst);
+
+  // === Replay ===
+  void ReplayThread();
+  bool ReplayFile(const std::string &path, bool &havePace,
+                  uint64_t &firstWriteTimeNs,
+                  std::chrono::steady_clock::time_point &replayStart);
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // FILEREPLAYDIGITIZER_HPP
@@ -0,0 +1,60 @@
+#ifndef HISTOGRAMSERVER_HPP
+#define HISTOGRAMSERVER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "OnlineHistograms.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Publishes OnlineHistograms through ROOT's THttpServer
+ *
+ * A single thread owns the THttpServer and the TH1D objects: it copies a
+ * Snapshot() of every source into the histograms each update interval
+ * and serves HTTP requests in between, so no ROOT object is touched from
+ * any other thread. Histograms appear under /modNN/chNN/ once the channel
+ * has entries. Several digitizers can share one server through Add().
+ */
+class HistogramServer
+{
+ public:
+  HistogramServer() = default;
+  ~HistogramServer();
+
+  HistogramServer(const HistogramServer &) = delete;
+  HistogramServer &operator=(const HistogramServer &) = delete;
+
+  /**
+   * @brief Publish a set of histograms; call before Start()
+   */
+  void Add(std::shared_ptr<OnlineHistograms> histograms);
+
+  /**
+   * @brief Start serving on the given port
+   * @return false if already running or the port is invalid
+   */
+  bool Start(int port, std::chrono::milliseconds updateInterval);
+  void Stop();
+
+ private:
+  void ServerThread();
+
+  std::vector<std::shared_ptr<OnlineHistograms>> fSources;
+  int fPort = 0;
+  std::chrono::milliseconds fUpdateInterval{1000};
+  std::atomic<bool> fRunning{false};
+  std::thread fThread;
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // HISTOGRAMSERVER_HPP
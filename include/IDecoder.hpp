@@ -1,13 +1,29 @@
 #ifndef IDECODER_HPP
 #define IDECODER_HPP
 
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <vector>
 
+#include "Backpressure.hpp"
+#include "BlockingQueue.hpp"
+#include "CoincidenceFilter.hpp"
 #include "DataType.hpp"
+#include "DigitizerStatistics.hpp"
+#include "EventBatch.hpp"
 #include "EventData.hpp"
+#include "EventNotifier.hpp"
+#include "EventOrderer.hpp"
+#include "IEventSink.hpp"
+#include "InFlightCounter.hpp"
+#include "OnlineHistograms.hpp"
+#include "PipelineTracer.hpp"
+#include "PulseProcessor.hpp"
 #include "RawData.hpp"
+#include "RawDataPool.hpp"
+#include "ThreadPlacement.hpp"
+#include "ZeroSuppression.hpp"
 
 namespace DELILA
 {
@@ -24,9 +40,77 @@ class IDecoder
   virtual void SetDumpFlag(bool dumpFlag) = 0;
   virtual void SetModuleNumber(uint8_t moduleNumber) = 0;
 
+  // Buffers passed to AddData() are handed back to this pool once decoded
+  virtual void SetRawDataPool(std::shared_ptr<RawDataPool> pool) = 0;
+
+  // Maximum number of aggregates waiting for decoding (0 = unbounded)
+  virtual void SetRawDataQueueCapacity(size_t capacity) = 0;
+  virtual QueueStatistics GetRawDataQueueStatistics() const = 0;
+
+  // Byte and pending-event limits and what to do when they are reached
+  virtual void SetBackpressure(const BackpressureConfig &config) = 0;
+
+  // Snapshot of the decode counters, safe to call while decoding
+  virtual DecoderStatistics GetStatistics() const = 0;
+
+  // Selects whether GetEventData() or GetEventBatch() receives decoded events
+  virtual void SetOutputFormat(OutputFormat format) = 0;
+
+  // Threads used to decode the channel-pair blocks of one aggregate in
+  // parallel (1 = serial). Formats without channel-pair blocks ignore it
+  virtual void SetChannelPairThreads(uint32_t nThreads) = 0;
+
+  // Restores readout or timestamp order across decode threads (see
+  // EventOrderer); OutputOrder::None keeps the unordered fast path
+  virtual void SetOrdering(const OrderingConfig &config) = 0;
+
+  // Unpack, skip, or keep undecoded (EventData::UnpackWaveform) the traces
+  virtual void SetWaveformMode(WaveformMode mode) = 0;
+
+  // Keep only hits in (anti)coincidence within each aggregate
+  virtual void SetCoincidence(const CoincidenceConfig &config) = 0;
+
+  // Skip hits outside their channel's energy window or with a vetoed flag
+  // before they are decoded
+  virtual void SetZeroSuppression(const ZeroSuppressionConfig &config) = 0;
+
+  // Compute PulseFeatures from each decoded trace after the coincidence
+  // filter
+  virtual void SetPulseProcessing(const PulseProcessingConfig &config) = 0;
+
+  // Fill per-channel histograms from every decoded aggregate (nullptr = off)
+  virtual void SetHistograms(std::shared_ptr<OnlineHistograms> histograms) = 0;
+
+  // Record the queue, decode and sort spans of every aggregate and the
+  // consumer pickups (nullptr = off)
+  virtual void SetTracer(std::shared_ptr<PipelineTracer> tracer) = 0;
+
+  // Hand every aggregate to these sinks after the coincidence filter
+  virtual void SetEventSinks(EventSinks sinks) = 0;
+
+  // Pin the decode threads (see ThreadPlacementConfig)
+  virtual void SetThreadPlacement(const ThreadPlacementConfig &config) = 0;
+
   // Data processing methods
   virtual DataType AddData(std::unique_ptr<RawData_t> rawData) = 0;
   virtual std::unique_ptr<std::vector<std::unique_ptr<EventData>>> GetEventData() = 0;
+  virtual std::unique_ptr<EventBatch> GetEventBatch() = 0;
+
+  // Wait up to timeout for decoded events instead of polling; the result is
+  // empty if none arrived in time
+  virtual std::unique_ptr<std::vector<std::unique_ptr<EventData>>>
+  GetEventData(std::chrono::milliseconds timeout) = 0;
+  virtual std::unique_ptr<EventBatch> GetEventBatch(
+      std::chrono::milliseconds timeout) = 0;
+
+  // Hand a batch from GetEventBatch() back so its storage is reused
+  virtual void ReleaseEventBatch(std::unique_ptr<EventBatch> batch) = 0;
+
+  // End of run: wait up to timeout until every buffer passed to AddData()
+  // is decoded (or dropped), then release what the orderer still holds.
+  // GetStatistics() afterwards holds the final counts of the run. Returns
+  // false on timeout; call it once the reader has stopped adding data
+  virtual bool Drain(std::chrono::milliseconds timeout) = 0;
 };
 
 }  // namespace Digitizer
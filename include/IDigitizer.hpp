@@ -1,13 +1,17 @@
 #ifndef IDIGITIZER_HPP
 #define IDIGITIZER_HPP
 
+#include <chrono>
 #include <memory>
 #include <nlohmann/json.hpp>
 #include <string>
 #include <vector>
 
 #include "ConfigurationManager.hpp"
+#include "DigitizerStatistics.hpp"
+#include "EventBatch.hpp"
 #include "EventData.hpp"
+#include "OnlineHistograms.hpp"
 
 namespace DELILA
 {
@@ -36,6 +40,21 @@ class IDigitizer
   virtual bool StartAcquisition() = 0;
   virtual bool StopAcquisition() = 0;
 
+  // Two-phase start used to start several boards together:
+  // StartAcquisition() is ArmAcquisition() followed by SendSWStart().
+  // ArmAcquisition() starts readout and arms the board; SendSWStart() then
+  // issues the software start command if the board's start mode expects
+  // one, and does nothing otherwise
+  virtual bool ArmAcquisition() = 0;
+  virtual bool SendSWStart() = 0;
+
+  // Ask the lifecycle call running on another thread to give up: it returns
+  // false at its next wait or parameter write (StopAcquisition() still
+  // tears down, it only skips draining the board). A FELib call already in
+  // progress runs to its own timeout first. Every lifecycle call clears the
+  // request when it starts
+  virtual void CancelLifecycle() = 0;
+
   // Control methods
   virtual bool SendSWTrigger() = 0;
   virtual bool CheckStatus() = 0;
@@ -43,6 +62,20 @@ class IDigitizer
   // Data access
   virtual std::unique_ptr<std::vector<std::unique_ptr<EventData>>>
   GetEventData() = 0;
+  virtual std::unique_ptr<EventBatch> GetEventBatch() = 0;
+  // Blocking variants: wait up to timeout for decoded events instead of
+  // polling, returning an empty container if none arrived in time
+  virtual std::unique_ptr<std::vector<std::unique_ptr<EventData>>>
+  GetEventData(std::chrono::milliseconds timeout) = 0;
+  virtual std::unique_ptr<EventBatch> GetEventBatch(
+      std::chrono::milliseconds timeout) = 0;
+  virtual void ReleaseEventBatch(std::unique_ptr<EventBatch> batch) = 0;
+
+  // Monitoring: snapshot of the readout and decode counters
+  virtual DigitizerStatistics GetStatistics() const = 0;
+
+  // Histograms filled by the decoder; nullptr unless Histograms is enabled
+  virtual std::shared_ptr<OnlineHistograms> GetHistograms() const = 0;
 
   // Device information
   virtual void PrintDeviceInfo() = 0;
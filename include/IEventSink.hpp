@@ -0,0 +1,55 @@
+#ifndef IEVENTSINK_HPP
+#define IEVENTSINK_HPP
+
+#include <memory>
+#include <vector>
+
+#include "EventBatch.hpp"
+#include "EventData.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Consumer of decoded aggregates inside the decoder (file output,
+ *        network streaming)
+ *
+ * Write() is called by the decode threads after sorting and the
+ * coincidence filter, concurrently and in decode order. Implementations
+ * copy what they need and return; they must never block on I/O.
+ */
+class IEventSink
+{
+ public:
+  virtual ~IEventSink() = default;
+
+  virtual void Write(const std::vector<std::unique_ptr<EventData>> &events) = 0;
+  virtual void Write(const EventBatch &batch) = 0;
+
+  // Events go to the sinks only, not to GetEventData()/GetEventBatch()
+  virtual bool IsExclusive() const = 0;
+};
+
+using EventSinks = std::vector<std::shared_ptr<IEventSink>>;
+
+/**
+ * @brief Hand events to every sink
+ * @return true if a sink takes them exclusively and they are not stored
+ */
+template <typename Events>
+inline bool WriteToSinks(const EventSinks &sinks, const Events &events)
+{
+  bool exclusive = false;
+  for (const auto &sink : sinks) {
+    sink->Write(events);
+    exclusive |= sink->IsExclusive();
+  }
+  return exclusive;
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // IEVENTSINK_HPP
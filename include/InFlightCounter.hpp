@@ -0,0 +1,66 @@
+#ifndef INFLIGHTCOUNTER_HPP
+#define INFLIGHTCOUNTER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Counts buffers a decoder has accepted but not finished
+ *
+ * AddData() calls Add() for every buffer and the buffer's single
+ * FinishSequence() calls Done(), whether it was decoded, dropped or
+ * ignored. Drain() waits with WaitIdle() for the count to reach zero, which
+ * means every buffer handed over so far has reached its decoded events.
+ */
+class InFlightCounter
+{
+ public:
+  void Add()
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fCount++;
+  }
+
+  void Done()
+  {
+    {
+      std::lock_guard<std::mutex> lock(fMutex);
+      fCount--;
+      if (fCount != 0) return;
+    }
+    fCV.notify_all();
+  }
+
+  /**
+   * @brief Wait until no buffer is in flight
+   * @return false on timeout
+   */
+  bool WaitIdle(std::chrono::milliseconds timeout)
+  {
+    std::unique_lock<std::mutex> lock(fMutex);
+    return fCV.wait_for(lock, timeout, [&] { return fCount == 0; });
+  }
+
+  uint64_t GetCount() const
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    return fCount;
+  }
+
+ private:
+  mutable std::mutex fMutex;
+  std::condition_variable fCV;
+  uint64_t fCount = 0;
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // INFLIGHTCOUNTER_HPP
@@ -6,6 +6,11 @@
 #include <stdexcept>
 #include <vector>
 
+// 1 makes ReadWord32Unchecked() check bounds too (set by CMake)
+#ifndef DELILA_CHECKED_READS
+#define DELILA_CHECKED_READS 0
+#endif
+
 namespace DELILA
 {
 namespace Digitizer
@@ -15,7 +20,8 @@ namespace Digitizer
  * @brief Safe memory reading utility for binary data parsing
  *
  * Provides bounds-checked memory access with clear error handling
- * for reading 32-bit words from byte arrays.
+ * for reading 32-bit words from byte arrays. Decoders check the extent of a
+ * block or event once and read its words with ReadWord32Unchecked().
  */
 class MemoryReader
 {
@@ -36,6 +42,15 @@ class MemoryReader
    */
   uint32_t ReadWord32(size_t wordIndex) const;
 
+  /**
+   * @brief Read a 32-bit word the caller has already bounds-checked
+   * @param wordIndex Index in 32-bit words from start
+   * @return The 32-bit word value
+   *
+   * No check in normal builds; with DELILA_CHECKED_READS it is ReadWord32().
+   */
+  uint32_t ReadWord32Unchecked(size_t wordIndex) const;
+
   /**
    * @brief Safely read a 32-bit word with bounds checking
    * @param wordIndex Index in 32-bit words from start
@@ -72,6 +87,16 @@ class MemoryReader
    */
   bool AdvanceIndex(size_t &wordIndex, size_t count) const;
 
+  /**
+   * @brief Raw pointer to a word, for kernels that read a checked range
+   * @param wordIndex Index in 32-bit words from start
+   * @return Pointer to the first byte of the word (not bounds checked)
+   */
+  const uint8_t *GetWordPointer(size_t wordIndex) const
+  {
+    return &(*(fDataStart + wordIndex * kWordSize));
+  }
+
  private:
   const std::vector<uint8_t>::iterator fDataStart;
   const size_t fTotalSizeWords;
@@ -102,6 +127,18 @@ inline uint32_t MemoryReader::ReadWord32(size_t wordIndex) const
   return value;
 }
 
+inline uint32_t MemoryReader::ReadWord32Unchecked(size_t wordIndex) const
+{
+#if DELILA_CHECKED_READS
+  return ReadWord32(wordIndex);
+#else
+  uint32_t value = 0;
+  std::memcpy(&value, &(*(fDataStart + wordIndex * kWordSize)),
+              sizeof(uint32_t));
+  return value;
+#endif
+}
+
 inline bool MemoryReader::ReadWordSafe(size_t wordIndex, uint32_t &value) const
 {
   if (wordIndex >= fTotalSizeWords) {
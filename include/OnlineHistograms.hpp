@@ -0,0 +1,134 @@
+#ifndef ONLINEHISTOGRAMS_HPP
+#define ONLINEHISTOGRAMS_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ConfigurationManager.hpp"
+#include "DigitizerStatistics.hpp"
+#include "EventBatch.hpp"
+#include "EventData.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Binning of the online histograms
+ *
+ * Energy covers the full 16-bit range, PSD is energyShort / energy in
+ * [0, 1) and the time difference is measured to the previous hit of the
+ * same channel in the same aggregate, in [0, timeRangeNs).
+ */
+struct HistogramConfig {
+  bool enabled = false;
+  uint32_t energyBins = 4096;
+  uint32_t psdBins = 256;
+  uint32_t timeBins = 1000;
+  double timeRangeNs = 1.0e6;
+  // Events are only histogrammed, never stored for GetEventData()
+  bool histogramOnly = false;
+  int httpPort = 0;  // > 0 publishes through THttpServer (HistogramServer)
+  uint32_t updateIntervalMs = 1000;
+};
+
+/**
+ * @brief Merged contents of OnlineHistograms, channel-major
+ *
+ * Bin b of channel ch is at index ch * bins + b of its vector.
+ */
+struct HistogramSnapshot {
+  static constexpr size_t kMaxChannels = DecoderStatistics::kMaxChannels;
+
+  HistogramConfig config;
+  uint8_t module = 0;
+  std::vector<uint64_t> energy;
+  std::vector<uint64_t> psd;
+  std::vector<uint64_t> timeDifference;
+  std::array<uint64_t, kMaxChannels> entries{};
+};
+
+/**
+ * @brief Per-channel energy, PSD and time-difference histograms filled by
+ *        the decode threads
+ *
+ * Every filling thread owns a shard of counters that only it writes, with
+ * relaxed atomic loads and stores instead of read-modify-write, so filling
+ * takes no lock and shares no cache lines. Snapshot() sums the shards
+ * on demand and may be called at any time. Channels >= kMaxChannels are
+ * not histogrammed.
+ */
+class OnlineHistograms
+{
+ public:
+  static constexpr size_t kMaxChannels = HistogramSnapshot::kMaxChannels;
+
+  OnlineHistograms(const HistogramConfig &config, uint8_t moduleNumber);
+  ~OnlineHistograms() = default;
+
+  OnlineHistograms(const OnlineHistograms &) = delete;
+  OnlineHistograms &operator=(const OnlineHistograms &) = delete;
+
+  /**
+   * @brief Parse the Histogram* parameters of a digitizer configuration
+   */
+  static HistogramConfig ParseConfig(const ConfigurationManager &config);
+
+  // === Filling (decode threads) ===
+  void Fill(const std::vector<std::unique_ptr<EventData>> &events);
+  void Fill(const EventBatch &batch);
+
+  // === Access ===
+  const HistogramConfig &GetConfig() const { return fConfig; }
+  uint8_t GetModuleNumber() const { return fModuleNumber; }
+  HistogramSnapshot Snapshot() const;
+  void Reset();
+
+ private:
+  struct Shard {
+    explicit Shard(size_t size) : counts(new std::atomic<uint64_t>[size]) {}
+    std::unique_ptr<std::atomic<uint64_t>[]> counts;
+  };
+
+  // Per-aggregate state for the time differences
+  struct LastHit {
+    std::array<double, kMaxChannels> timeStampNs;
+    std::array<bool, kMaxChannels> valid{};
+  };
+
+  Shard &GetLocalShard();
+  void FillHit(Shard &shard, LastHit &last, uint8_t channel, uint16_t energy,
+               uint16_t energyShort, double timeStampNs) const;
+  static void Increment(std::atomic<uint64_t> &count)
+  {
+    count.store(count.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+  }
+
+  const HistogramConfig fConfig;
+  const uint8_t fModuleNumber;
+  const uint64_t fId;  // Tells instances apart in the thread-local cache
+
+  // === Shard Layout (per channel) ===
+  const size_t fEnergyOffset = 0;
+  const size_t fPSDOffset;
+  const size_t fTimeOffset;
+  const size_t fEntriesOffset;
+  const size_t fChannelStride;
+
+  mutable std::mutex fShardMutex;
+  std::map<std::thread::id, std::unique_ptr<Shard>> fShards;
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // ONLINEHISTOGRAMS_HPP
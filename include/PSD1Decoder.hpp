@@ -1,22 +1,29 @@
 #ifndef PSD1DECODER_HPP
 #define PSD1DECODER_HPP
 
+#include <array>
 #include <cstdint>
-#include <deque>
 #include <memory>
 #include <mutex>
 #include <thread>
 #include <vector>
 
+#include "BlockingQueue.hpp"
 #include "DataType.hpp"
+#include "DigitizerStatistics.hpp"
 #include "DataValidator.hpp"
 #include "DecoderLogger.hpp"
+#include "EventBatch.hpp"
+#include "EventBatchPool.hpp"
+#include "EventOrderer.hpp"
 #include "EventData.hpp"
 #include "IDecoder.hpp"
 #include "MemoryReader.hpp"
 #include "PSD1Constants.hpp"
 #include "PSD1Structures.hpp"
 #include "RawData.hpp"
+#include "RawDataPool.hpp"
+#include "RunMarker.hpp"
 
 namespace DELILA
 {
@@ -42,6 +49,67 @@ class PSD1Decoder : public IDecoder
     DecoderLogger::SetDebugEnabled(dumpFlag);
   }
   void SetModuleNumber(uint8_t moduleNumber) override { fModuleNumber = moduleNumber; }
+  void SetRawDataPool(std::shared_ptr<RawDataPool> pool) override
+  {
+    fRawDataPool = std::move(pool);
+  }
+  void SetRawDataQueueCapacity(size_t capacity) override
+  {
+    fRawDataQueue.SetCapacity(capacity);
+  }
+  void SetBackpressure(const BackpressureConfig &config) override
+  {
+    fRawDataQueue.SetByteCapacity(config.maxQueuedBytes);
+    fBackpressure.Configure(config);
+  }
+  QueueStatistics GetRawDataQueueStatistics() const override
+  {
+    return fRawDataQueue.GetStatistics();
+  }
+  DecoderStatistics GetStatistics() const override;
+  void SetOutputFormat(OutputFormat format) override
+  {
+    fOutputFormat = format;
+  }
+  void SetChannelPairThreads(uint32_t nThreads) override
+  {
+    fChannelPairThreads = nThreads < 1 ? 1 : nThreads;
+  }
+  void SetOrdering(const OrderingConfig &config) override
+  {
+    fOrderer.Configure(config);
+  }
+  void SetWaveformMode(WaveformMode mode) override { fWaveformMode = mode; }
+  void SetCoincidence(const CoincidenceConfig &config) override
+  {
+    fCoincidence.Configure(config);
+  }
+  void SetZeroSuppression(const ZeroSuppressionConfig &config) override
+  {
+    fZeroSuppression.Configure(config);
+  }
+  void SetPulseProcessing(const PulseProcessingConfig &config) override
+  {
+    fPulseProcessor.Configure(config);
+  }
+  void SetHistograms(std::shared_ptr<OnlineHistograms> histograms) override
+  {
+    fHistograms = std::move(histograms);
+  }
+  void SetTracer(std::shared_ptr<PipelineTracer> tracer) override
+  {
+    fTracer = std::move(tracer);
+  }
+  void SetEventSinks(EventSinks sinks) override
+  {
+    fEventSinks = std::move(sinks);
+  }
+  void SetThreadPlacement(const ThreadPlacementConfig &config) override
+  {
+    for (size_t i = 0; i < fDecodeThreads.size(); ++i) {
+      ThreadPlacement::PlaceDecoder(fDecodeThreads[i], i, config);
+    }
+  }
   void SetLogLevel(LogLevel level) { DecoderLogger::SetLogLevel(level); }
   void SetEventDataCacheSize(size_t size) { fEventDataCacheSize = size; }
 
@@ -52,31 +120,61 @@ class PSD1Decoder : public IDecoder
   // Data Processing
   DataType AddData(std::unique_ptr<RawData_t> rawData) override;
   std::unique_ptr<std::vector<std::unique_ptr<EventData>>> GetEventData() override;
+  std::unique_ptr<EventBatch> GetEventBatch() override;
+  std::unique_ptr<std::vector<std::unique_ptr<EventData>>> GetEventData(
+      std::chrono::milliseconds timeout) override;
+  std::unique_ptr<EventBatch> GetEventBatch(
+      std::chrono::milliseconds timeout) override;
+  void ReleaseEventBatch(std::unique_ptr<EventBatch> batch) override
+  {
+    fEventBatchPool.Release(std::move(batch));
+  }
+  bool Drain(std::chrono::milliseconds timeout) override;
 
  private:
   // === Configuration ===
   uint32_t fTimeStep = 1;
   bool fDumpFlag = false;
   uint8_t fModuleNumber = 0;
+  OutputFormat fOutputFormat = OutputFormat::EventData;
+  uint32_t fChannelPairThreads = 1;  // > 1 decodes pairs with OpenMP
+  WaveformMode fWaveformMode = WaveformMode::Decode;
+  CoincidenceFilter fCoincidence;
+  ZeroSuppression fZeroSuppression;
+  PulseProcessor fPulseProcessor;
+  std::shared_ptr<OnlineHistograms> fHistograms;  // nullptr = off
+  std::shared_ptr<PipelineTracer> fTracer;        // nullptr = off
+  EventSinks fEventSinks;                         // File output, streaming
 
   // === Threading Control ===
   bool fDecodeFlag = false;
   std::vector<std::thread> fDecodeThreads;
+  static constexpr size_t kDecodeBatchSize = 8;  // Buffers taken per wakeup
 
   // === Start/Stop State ===
   bool fIsRunning = false;
 
   // === Raw Data Queue ===
-  std::deque<std::unique_ptr<RawData_t>> fRawDataQueue;
-  std::mutex fRawDataMutex;
+  BlockingQueue<std::unique_ptr<RawData_t>> fRawDataQueue;
+  std::shared_ptr<RawDataPool> fRawDataPool;
+  Backpressure fBackpressure;
 
   // === Processed Data Storage ===
   std::unique_ptr<std::vector<std::unique_ptr<EventData>>> fEventDataVec;
   std::mutex fEventDataMutex;
+  std::unique_ptr<EventBatch> fEventBatch;
+  std::mutex fEventBatchMutex;
+  EventBatchPool fEventBatchPool;
+  EventOrderer fOrderer{fEventBatchPool};  // Declared after its pool
+  EventNotifier fEventNotifier;  // Signalled after each decode batch
+  InFlightCounter fInFlight;     // From AddData() to FinishSequence()
 
   // === Data Processing State ===
   uint64_t fLastCounter = 0;
 
+  // === Statistics ===
+  DecoderCounters fCounters;
+
   // === Performance Optimization Cache ===
   mutable std::unique_ptr<std::vector<std::unique_ptr<EventData>>>
       fEventDataCache;
@@ -84,6 +182,7 @@ class PSD1Decoder : public IDecoder
 
   // === Pre-computed Values ===
   double fFineTimeMultiplier = 0.0;  // Cached fine time multiplier
+  uint64_t fTimeStepPs = EventData::kPsPerNs;  // fTimeStep in picoseconds
 
   // === Data Type Detection ===
   DataType CheckDataType(std::unique_ptr<RawData_t> &rawData);
@@ -92,24 +191,56 @@ class PSD1Decoder : public IDecoder
 
   // === Data Processing ===
   void DecodeThread();
-  void DecodeData(std::unique_ptr<RawData_t> rawData);
+  void DecodeData(std::unique_ptr<RawData_t> &rawData);
+  void RecycleRawData(std::unique_ptr<RawData_t> rawData);
+  void FinishSequence(const RawData_t &rawData);
+  bool MakeRoomForEvents();
+  void StoreEventBatch(std::unique_ptr<EventBatch> eventBatch,
+                       uint64_t sequence);
 
   // === Data Decoding Helpers ===
   void DumpRawData(const RawData_t &rawData) const;
   DecoderResult ValidateDataHeader(uint32_t headerWord, size_t dataSize);
   DecoderResult ProcessEventData(
-      const std::vector<uint8_t>::iterator &dataStart, uint32_t totalSize);
+      const std::vector<uint8_t>::iterator &dataStart, uint32_t totalSize,
+      uint64_t sequence);
 
   // === Decomposed Processing Methods ===
   DecoderResult ProcessBoardAggregateBlock(
       MemoryReader &reader, size_t &wordIndex,
-      std::vector<std::unique_ptr<EventData>> &eventDataVec);
+      std::vector<std::unique_ptr<EventData>> &eventDataVec,
+      EventBatch &eventBatch);
   DecoderResult ProcessChannelPairs(
       MemoryReader &reader, size_t &wordIndex, const BoardHeaderInfo &boardInfo,
       size_t boardEndIndex,
-      std::vector<std::unique_ptr<EventData>> &eventDataVec);
+      std::vector<std::unique_ptr<EventData>> &eventDataVec,
+      EventBatch &eventBatch);
   DecoderResult ValidateBlockBounds(size_t currentIndex, size_t endIndex,
                                     size_t totalSize);
+  void DecodeChannelPairEvents(
+      MemoryReader &reader, size_t &wordIndex, size_t endIndex, int pair,
+      const DualChannelInfo &dualChInfo, EventData &scratchEvent,
+      std::vector<std::unique_ptr<EventData>> &eventDataVec,
+      EventBatch &eventBatch);
+  bool SkipSuppressedEvent(
+      MemoryReader &reader, size_t &wordIndex, size_t eventWords, int pair,
+      const DualChannelInfo &dualChInfo,
+      std::array<uint64_t, ZeroSuppression::kMaxChannels> &suppressed) const;
+  static size_t GetEventSizeWords(const DualChannelInfo &dualChInfo);
+
+  // === Parallel Channel-Pair Decoding ===
+  struct ChannelPairBlock {
+    int pair = 0;
+    DualChannelInfo dualChInfo{};
+    size_t beginIndex = 0;  // First event word after the dual channel header
+    size_t endIndex = 0;    // One past the last word of the block
+  };
+  DecoderResult LocateChannelPairBlocks(MemoryReader &reader,
+                                        std::vector<ChannelPairBlock> &blocks);
+  void ProcessChannelPairsParallel(
+      MemoryReader &reader,
+      std::vector<std::unique_ptr<EventData>> &eventDataVec,
+      EventBatch &eventBatch);
 
   // === PSD1 Format Structures (defined in PSD1Structures.hpp) ===
 
@@ -120,22 +251,35 @@ class PSD1Decoder : public IDecoder
                                         DualChannelInfo &dualChInfo);
 
   // === Decomposed Event Decoding Methods ===
-  std::unique_ptr<EventData> DecodeEventDirect(
-      MemoryReader &reader, size_t &wordIndex,
-      const DualChannelInfo &dualChInfo);
-  DecoderResult DecodeEventHeader(MemoryReader &reader, size_t &wordIndex,
-                                  uint32_t &triggerTimeTag, bool &isOddChannel);
-  DecoderResult DecodeEventTimestamp(MemoryReader &reader, size_t &wordIndex,
-                                     const DualChannelInfo &dualChInfo,
-                                     uint32_t triggerTimeTag,
-                                     EventData &eventData);
-  DecoderResult DecodeEventDataComponents(MemoryReader &reader,
+  // The dual channel header options are fixed for a channel-pair block, so
+  // each combination gets its own DecodeEvent() instantiation, picked once
+  // per block by SelectEventDecoder(); the per-event code has no branches on
+  // them
+  using EventDecoder = void (PSD1Decoder::*)(MemoryReader &reader,
                                           size_t &wordIndex,
                                           const DualChannelInfo &dualChInfo,
                                           EventData &eventData);
+  static const EventDecoder kEventDecoders[16];
+  static EventDecoder SelectEventDecoder(const DualChannelInfo &dualChInfo);
+
+  template <bool kExtras, bool kFineTT, bool kWaveform, bool kCharge>
+  void DecodeEvent(MemoryReader &reader, size_t &wordIndex,
+                   const DualChannelInfo &dualChInfo, EventData &eventData);
+  void DecodeEventHeader(MemoryReader &reader, size_t &wordIndex,
+                         uint32_t &triggerTimeTag, bool &isOddChannel);
+  template <bool kExtras, bool kFineTT>
+  void DecodeEventTimestamp(MemoryReader &reader, size_t &wordIndex,
+                            const DualChannelInfo &dualChInfo,
+                            uint32_t triggerTimeTag, EventData &eventData);
+  template <bool kWaveform, bool kCharge>
+  void DecodeEventDataComponents(MemoryReader &reader, size_t &wordIndex,
+                                 const DualChannelInfo &dualChInfo,
+                                 EventData &eventData);
 
   void DecodeWaveform(MemoryReader &reader, size_t &wordIndex,
                       const DualChannelInfo &dualChInfo, EventData &eventData);
+  static uint64_t ConvertExtrasFlags(uint8_t flags);
+  template <bool kFineTT>
   void DecodeExtrasWord(uint32_t extrasWord, uint8_t extraOption,
                         EventData &eventData, uint16_t &extendedTime,
                         uint16_t &fineTimeStamp);
@@ -1,19 +1,25 @@
 #ifndef PSD2DECODER_HPP
 #define PSD2DECODER_HPP
 
+#include <array>
 #include <cstdint>
-#include <deque>
 #include <memory>
 #include <mutex>
 #include <thread>
 #include <vector>
 
+#include "BlockingQueue.hpp"
 #include "DataType.hpp"
+#include "DigitizerStatistics.hpp"
+#include "EventBatch.hpp"
+#include "EventBatchPool.hpp"
+#include "EventOrderer.hpp"
 #include "EventData.hpp"
 #include "IDecoder.hpp"
 #include "PSD2Constants.hpp"
 #include "PSD2Structures.hpp"
 #include "RawData.hpp"
+#include "RawDataPool.hpp"
 
 namespace DELILA
 {
@@ -28,58 +34,173 @@ class PSD2Decoder : public IDecoder
   ~PSD2Decoder() override;
 
   // Configuration
-  void SetTimeStep(uint32_t timeStep) override { fTimeStep = timeStep; }
+  void SetTimeStep(uint32_t timeStep) override
+  {
+    fTimeStep = timeStep;
+    fTimeStepPs = static_cast<uint64_t>(timeStep) * EventData::kPsPerNs;
+  }
   void SetDumpFlag(bool dumpFlag) override { fDumpFlag = dumpFlag; }
   void SetModuleNumber(uint8_t moduleNumber) override
   {
     fModuleNumber = moduleNumber;
   }
+  void SetRawDataPool(std::shared_ptr<RawDataPool> pool) override
+  {
+    fRawDataPool = std::move(pool);
+  }
+  void SetRawDataQueueCapacity(size_t capacity) override
+  {
+    fRawDataQueue.SetCapacity(capacity);
+  }
+  void SetBackpressure(const BackpressureConfig &config) override
+  {
+    fRawDataQueue.SetByteCapacity(config.maxQueuedBytes);
+    fBackpressure.Configure(config);
+  }
+  QueueStatistics GetRawDataQueueStatistics() const override
+  {
+    return fRawDataQueue.GetStatistics();
+  }
+  DecoderStatistics GetStatistics() const override;
+  void SetOutputFormat(OutputFormat format) override { fOutputFormat = format; }
+  /**
+   * @brief Byte-swap buffers on the decode threads instead of in AddData()
+   *
+   * Takes the full pass over every buffer off the readout thread. Set before
+   * acquisition starts.
+   */
+  void SetSwapOnDecode(bool swapOnDecode) { fSwapOnDecode = swapOnDecode; }
+  // PSD2 aggregates have no channel-pair blocks to split
+  void SetChannelPairThreads(uint32_t) override {}
+  void SetOrdering(const OrderingConfig &config) override
+  {
+    fOrderer.Configure(config);
+  }
+  void SetWaveformMode(WaveformMode mode) override { fWaveformMode = mode; }
+  void SetCoincidence(const CoincidenceConfig &config) override
+  {
+    fCoincidence.Configure(config);
+  }
+  void SetZeroSuppression(const ZeroSuppressionConfig &config) override
+  {
+    fZeroSuppression.Configure(config);
+  }
+  void SetPulseProcessing(const PulseProcessingConfig &config) override
+  {
+    fPulseProcessor.Configure(config);
+  }
+  void SetHistograms(std::shared_ptr<OnlineHistograms> histograms) override
+  {
+    fHistograms = std::move(histograms);
+  }
+  void SetTracer(std::shared_ptr<PipelineTracer> tracer) override
+  {
+    fTracer = std::move(tracer);
+  }
+  void SetEventSinks(EventSinks sinks) override
+  {
+    fEventSinks = std::move(sinks);
+  }
+  void SetThreadPlacement(const ThreadPlacementConfig &config) override
+  {
+    for (size_t i = 0; i < fDecodeThreads.size(); ++i) {
+      ThreadPlacement::PlaceDecoder(fDecodeThreads[i], i, config);
+    }
+  }
 
   // Data Processing
   DataType AddData(std::unique_ptr<RawData_t> rawData) override;
   std::unique_ptr<std::vector<std::unique_ptr<EventData>>> GetEventData()
       override;
+  std::unique_ptr<EventBatch> GetEventBatch() override;
+  std::unique_ptr<std::vector<std::unique_ptr<EventData>>> GetEventData(
+      std::chrono::milliseconds timeout) override;
+  std::unique_ptr<EventBatch> GetEventBatch(
+      std::chrono::milliseconds timeout) override;
+  void ReleaseEventBatch(std::unique_ptr<EventBatch> batch) override
+  {
+    fEventBatchPool.Release(std::move(batch));
+  }
+  bool Drain(std::chrono::milliseconds timeout) override;
 
  private:
   // === Configuration ===
   uint32_t fTimeStep = 1;
+  uint64_t fTimeStepPs = EventData::kPsPerNs;  // fTimeStep in picoseconds
   bool fDumpFlag = false;
   uint8_t fModuleNumber = 0;
+  OutputFormat fOutputFormat = OutputFormat::EventData;
+  bool fSwapOnDecode = false;
+  WaveformMode fWaveformMode = WaveformMode::Decode;
+  CoincidenceFilter fCoincidence;
+  ZeroSuppression fZeroSuppression;
+  PulseProcessor fPulseProcessor;
+  std::shared_ptr<OnlineHistograms> fHistograms;  // nullptr = off
+  std::shared_ptr<PipelineTracer> fTracer;        // nullptr = off
+  EventSinks fEventSinks;                         // File output, streaming
 
   // === Threading Control ===
   bool fDecodeFlag = false;
   std::vector<std::thread> fDecodeThreads;
+  static constexpr size_t kDecodeBatchSize = 8;  // Buffers taken per wakeup
 
   // === Start/Stop State ===
   bool fIsRunning = false;
 
   // === Raw Data Queue ===
-  std::deque<std::unique_ptr<RawData_t>> fRawDataQueue;
-  std::mutex fRawDataMutex;
+  BlockingQueue<std::unique_ptr<RawData_t>> fRawDataQueue;
+  std::shared_ptr<RawDataPool> fRawDataPool;
+  Backpressure fBackpressure;
 
   // === Processed Data Storage ===
   std::unique_ptr<std::vector<std::unique_ptr<EventData>>> fEventDataVec;
   std::mutex fEventDataMutex;
+  std::unique_ptr<EventBatch> fEventBatch;
+  std::mutex fEventBatchMutex;
+  EventBatchPool fEventBatchPool;
+  EventOrderer fOrderer{fEventBatchPool};  // Declared after its pool
+  EventNotifier fEventNotifier;  // Signalled after each decode batch
+  InFlightCounter fInFlight;     // From AddData() to FinishSequence()
 
   // === Data Processing State ===
   uint64_t fLastCounter = 0;
 
+  // === Statistics ===
+  DecoderCounters fCounters;
+
   // === Data Type Detection ===
   DataType CheckDataType(std::unique_ptr<RawData_t> &rawData);
   bool CheckStart(std::unique_ptr<RawData_t> &rawData);
   bool CheckStop(std::unique_ptr<RawData_t> &rawData);
+  uint64_t LoadWord(const RawData_t &rawData, size_t index) const;
 
   // === Data Processing ===
   void DecodeThread();
-  void DecodeData(std::unique_ptr<RawData_t> rawData);
+  void DecodeData(std::unique_ptr<RawData_t> &rawData);
+  void RecycleRawData(std::unique_ptr<RawData_t> rawData);
+  void FinishSequence(const RawData_t &rawData);
+  bool MakeRoomForEvents();
+  void StoreEventBatch(std::unique_ptr<EventBatch> eventBatch,
+                       uint64_t sequence);
 
   // === Data Decoding Helpers ===
   void DumpRawData(const RawData_t &rawData) const;
   bool ValidateDataHeader(uint64_t headerWord, size_t dataSize);
   void ProcessEventData(const std::vector<uint8_t>::iterator &dataStart,
-                        uint32_t totalSize);
+                        uint32_t totalSize, uint64_t sequence);
+  // Whether the event at wordIndex ends within totalSize (counted as a
+  // decode error if not)
+  bool IsEventComplete(const std::vector<uint8_t>::iterator &dataStart,
+                       size_t wordIndex, size_t totalSize);
   std::unique_ptr<EventData> DecodeEventPair(
       const std::vector<uint8_t>::iterator &dataStart, size_t &wordIndex);
+  void DecodeEvent(const std::vector<uint8_t>::iterator &dataStart,
+                   size_t &wordIndex, EventData &eventData);
+  bool SkipSuppressedEvent(
+      const std::vector<uint8_t>::iterator &dataStart, size_t &wordIndex,
+      size_t totalSize,
+      std::array<uint64_t, ZeroSuppression::kMaxChannels> &suppressed) const;
+  static uint64_t ConvertFlags(uint64_t secondWord);
   void DecodeFirstWord(uint64_t word, EventData &eventData) const;
   void DecodeSecondWord(uint64_t word, EventData &eventData,
                         uint64_t rawTimeStamp) const;
@@ -97,9 +218,6 @@ class PSD2Decoder : public IDecoder
 
   WaveformConfig ExtractWaveformConfig(uint64_t header) const;
   uint32_t GetMultiplicationFactor(uint32_t encodedValue) const;
-  void DecodeWaveformPoint(uint32_t point, size_t dataIndex,
-                           const WaveformConfig &config,
-                           EventData &eventData) const;
 };
 
 }  // namespace Digitizer
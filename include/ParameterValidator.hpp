@@ -7,8 +7,9 @@
 #include <memory>
 #include <nlohmann/json.hpp>
 #include <optional>
+#include <regex>
 #include <string>
-#include <unordered_set>
+#include <unordered_map>
 #include <vector>
 
 namespace DELILA
@@ -22,6 +23,11 @@ namespace Digitizer
  * This class provides comprehensive validation of digitizer parameters
  * using device tree definitions, with support for custom validation rules,
  * detailed error reporting, and extensible validation types.
+ *
+ * The device tree is indexed once on construction: every board and channel
+ * parameter path maps to its type, range and allowed values, so validation
+ * and the parameter queries are hash lookups without walking the JSON.
+ * Channels with identical definitions share one interned entry.
  */
 class ParameterValidator
 {
@@ -114,7 +120,22 @@ class ParameterValidator
   void RemoveCustomValidator(const std::string &paramPattern);
   void ClearCustomValidators();
 
+  // Indexed definition of one parameter
+  struct ParameterInfo {
+    std::string name;  // Lowercase device tree name
+    ParameterType type = ParameterType::Unknown;
+    std::string description;
+    std::string minText;  // Empty if the tree has no minimum
+    std::string maxText;  // Empty if the tree has no maximum
+    std::optional<double> minValue;
+    std::optional<double> maxValue;
+    std::vector<std::string> allowedValues;
+
+    bool operator==(const ParameterInfo &other) const;
+  };
+
   // Parameter information
+  const ParameterInfo *GetParameterInfo(const std::string &paramPath) const;
   ParameterType GetParameterType(const std::string &paramPath) const;
   std::optional<std::string> GetParameterDescription(
       const std::string &paramPath) const;
@@ -124,6 +145,7 @@ class ParameterValidator
 
   // Device tree utilities
   bool IsParameterSupported(const std::string &paramPath) const;
+  // Board parameters, then channel parameters as /ch/A..B/par/name ranges
   std::vector<std::string> GetSupportedParameters() const;
   std::vector<std::string> GetChannelParameters(
       const std::string &channel) const;
@@ -140,6 +162,21 @@ class ParameterValidator
                                const std::string &filename) const;
 
  private:
+  // Pattern compiled once; falls back to substring match if not a regex
+  struct CompiledPattern {
+    std::string pattern;
+    std::optional<std::regex> regex;
+
+    explicit CompiledPattern(const std::string &pat);
+    bool Matches(const std::string &path) const;
+  };
+
+  // Index entry of one concrete path
+  struct IndexEntry {
+    size_t info = 0;                           // Into parameterInfos_
+    const nlohmann::json *definition = nullptr;  // For custom validators
+  };
+
   // Data members
   const nlohmann::json &deviceTree_;
   bool allowUnknownParameters_ = false;
@@ -147,41 +184,51 @@ class ParameterValidator
   bool verboseOutput_ = false;
   bool silentMode_ = false;
 
-  std::map<std::string, CustomValidator> customValidators_;
-  std::unordered_set<std::string> ignorePatterns_;
+  std::map<std::string, std::pair<CompiledPattern, CustomValidator>>
+      customValidators_;
+  std::unordered_map<std::string, CompiledPattern> ignorePatterns_;
+
+  // Parameter index
+  std::vector<ParameterInfo> parameterInfos_;
+  std::unordered_map<std::string, IndexEntry> index_;  // Lowercase path key
+  std::vector<std::string> supportedParameters_;
+  std::map<std::string, std::vector<std::string>> channelParameters_;
+
+  void BuildIndex();
+  size_t InternParameterInfo(
+      ParameterInfo info,
+      std::unordered_map<std::string, std::vector<size_t>> &infosByName);
+  std::string MakeIndexKey(const std::string &paramPath) const;
+  const IndexEntry *FindEntry(const std::string &paramPath) const;
 
   // Parameter path processing
   std::vector<std::string> ExpandChannelRange(
       const std::string &configPath) const;
   std::string MapConfigToDeviceTree(const std::string &configParam) const;
-  bool MatchesPattern(const std::string &path,
-                      const std::string &pattern) const;
 
   // Validation engine
-  ValidationResult ValidateParameterValue(const nlohmann::json &paramDef,
+  ValidationResult ValidateParameterValue(const ParameterInfo &info,
                                           const std::string &paramPath,
                                           const std::string &value) const;
-  ValidationResult ValidateNumberParameter(const nlohmann::json &paramDef,
+  ValidationResult ValidateNumberParameter(const ParameterInfo &info,
                                            const std::string &paramPath,
                                            const std::string &value) const;
-  ValidationResult ValidateIntegerParameter(const nlohmann::json &paramDef,
+  ValidationResult ValidateIntegerParameter(const ParameterInfo &info,
                                             const std::string &paramPath,
                                             const std::string &value) const;
-  ValidationResult ValidateStringParameter(const nlohmann::json &paramDef,
+  ValidationResult ValidateStringParameter(const ParameterInfo &info,
                                            const std::string &paramPath,
                                            const std::string &value) const;
-  ValidationResult ValidateBooleanParameter(const nlohmann::json &paramDef,
+  ValidationResult ValidateBooleanParameter(const ParameterInfo &info,
                                             const std::string &paramPath,
                                             const std::string &value) const;
-  ValidationResult ValidateEnumParameter(const nlohmann::json &paramDef,
+  ValidationResult ValidateEnumParameter(const ParameterInfo &info,
                                          const std::string &paramPath,
                                          const std::string &value) const;
 
   // Device tree navigation
-  nlohmann::json GetParameterDefinition(const std::string &paramPath) const;
-  nlohmann::json GetChannelParameterDefinition(
-      const std::string &channel, const std::string &paramName) const;
-  nlohmann::json GetRootParameterDefinition(const std::string &paramName) const;
+  ParameterInfo MakeParameterInfo(const std::string &name,
+                                  const nlohmann::json &paramDef) const;
 
   // Utility methods
   std::string FormatValidationMessage(const ValidationResult &result) const;
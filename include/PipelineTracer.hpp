@@ -0,0 +1,164 @@
+#ifndef PIPELINETRACER_HPP
+#define PIPELINETRACER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ConfigurationManager.hpp"
+#include "DigitizerStatistics.hpp"
+#include "TraceStage.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Settings of the pipeline tracer
+ */
+struct PipelineTraceConfig {
+  bool enabled = false;
+  // Spans kept per thread; older ones are overwritten
+  size_t spansPerThread = 65536;
+  // Path prefix of the Chrome trace written at the end of each run, as
+  // <path>_modNN_NNNN.json (empty = no file, statistics only)
+  std::string path;
+};
+
+/**
+ * @brief Timestamps each aggregate at every pipeline stage
+ *
+ * The reader, decode and consumer threads record a span (stage, readout
+ * sequence, begin, end) per aggregate into a ring of their own, so
+ * recording takes no lock and touches no shared cache line. Timestamps are
+ * raw TSC ticks on x86 (steady_clock ns elsewhere) and are converted to
+ * nanoseconds only when the spans are read, against a steady_clock
+ * reference taken at construction; this assumes an invariant TSC, which
+ * every x86 CPU of the last decade has.
+ *
+ * Callers hold a shared_ptr that is nullptr while tracing is off, so a
+ * disabled trace point costs one branch. The rings keep the last
+ * spansPerThread spans of each thread; Fill() and WriteChromeTrace() read
+ * them while recording goes on and skip spans overwritten meanwhile.
+ */
+class PipelineTracer
+{
+ public:
+  PipelineTracer(PipelineTraceConfig config, uint8_t moduleNumber);
+
+  PipelineTracer(const PipelineTracer &) = delete;
+  PipelineTracer &operator=(const PipelineTracer &) = delete;
+
+  /**
+   * @brief Parse the PipelineTrace* parameters of a digitizer configuration
+   */
+  static PipelineTraceConfig ParseConfig(const ConfigurationManager &config);
+
+  const PipelineTraceConfig &GetConfig() const { return fConfig; }
+
+  /**
+   * @brief Current timestamp in tracer ticks
+   */
+  static uint64_t Now();
+
+  // === Recording (any thread) ===
+  void Record(TraceStage stage, uint64_t sequence, uint64_t begin,
+              uint64_t end);
+
+  /**
+   * @brief Note that decoded events are waiting for the consumer
+   *
+   * Only the first call since the last pickup stamps the time.
+   */
+  void MarkPending()
+  {
+    if (fPendingSince.load(std::memory_order_relaxed) != 0) return;
+    uint64_t expected = 0;
+    fPendingSince.compare_exchange_strong(expected, Now(),
+                                          std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Record a Pickup span if events were pending; call when
+   *        GetEventData()/GetEventBatch() returns events
+   */
+  void RecordPickup();
+
+  // === Access ===
+  /**
+   * @brief Copy per-stage percentiles of the held spans into stats
+   */
+  void Fill(DigitizerStatistics &stats) const;
+
+  /**
+   * @brief Write the held spans as Chrome trace JSON (chrome://tracing,
+   *        ui.perfetto.dev)
+   * @return false if the file cannot be written
+   */
+  bool WriteChromeTrace(const std::string &path) const;
+
+  /**
+   * @brief Write the trace of the run just finished to the next
+   *        <path>_modNN_NNNN.json if a path is configured
+   */
+  void WriteRunTrace();
+
+  /**
+   * @brief Forget all spans; call between runs
+   */
+  void Reset();
+
+ private:
+  struct Span {
+    std::atomic<uint64_t> begin{0};
+    std::atomic<uint64_t> end{0};
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<uint8_t> stage{0};
+  };
+
+  // Spans of one thread; only that thread writes
+  struct Ring {
+    explicit Ring(size_t capacity) : spans(capacity) {}
+    std::vector<Span> spans;
+    std::atomic<uint64_t> head{0};  // Spans recorded
+    std::thread::id owner;
+  };
+
+  struct SpanCopy {
+    uint64_t begin;
+    uint64_t end;
+    uint64_t sequence;
+    TraceStage stage;
+  };
+
+  const PipelineTraceConfig fConfig;
+  const uint8_t fModuleNumber;
+  const uint64_t fId;  // Never reused, keys the per-thread ring cache
+
+  // Reference for converting ticks to ns
+  const uint64_t fTicks0;
+  const uint64_t fNs0;
+
+  mutable std::mutex fRingsMutex;
+  std::vector<std::unique_ptr<Ring>> fRings;  // Never shrinks
+
+  std::atomic<uint64_t> fPendingSince{0};  // 0 = nothing pending
+  std::atomic<uint64_t> fPickups{0};
+  uint32_t fRunIndex = 0;
+
+  Ring &GetRing();
+  static uint64_t SteadyNs();
+  double GetNsPerTick() const;
+  std::vector<SpanCopy> Snapshot(const Ring &ring) const;
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // PIPELINETRACER_HPP
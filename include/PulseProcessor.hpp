@@ -0,0 +1,95 @@
+#ifndef PULSEPROCESSOR_HPP
+#define PULSEPROCESSOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ConfigurationManager.hpp"
+#include "EventBatch.hpp"
+#include "EventData.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+enum class PulsePolarity {
+  Negative,  // Pulses go below the baseline (default)
+  Positive
+};
+
+/**
+ * @brief Features computed from analogProbe1 and their parameters
+ *
+ * All positions are sample indices into the trace. The baseline is the
+ * mean of the first baselineSamples samples; every other feature works on
+ * the baseline-subtracted trace with the pulse made positive. Charges sum
+ * gates [gateStart, gateStart + shortGate) and [gateStart, gateStart +
+ * longGate), cut at the trace end. The CFD compares the trace delayed by
+ * cfdDelay with cfdFraction of the trace (cfdDelay 0 = off). The trapezoid
+ * filter has rise and flat top lengths trapRise and trapFlat (trapRise 0 =
+ * off), with pole-zero correction for an exponential decay constant of
+ * trapDecay samples (0 = step-like pulses).
+ */
+struct PulseProcessingConfig {
+  bool enabled = false;
+  PulsePolarity polarity = PulsePolarity::Negative;
+  uint32_t baselineSamples = 16;
+  uint32_t gateStart = 0;
+  uint32_t shortGate = 0;
+  uint32_t longGate = 0;
+  double cfdFraction = 0.25;
+  uint32_t cfdDelay = 0;
+  uint32_t trapRise = 0;
+  uint32_t trapFlat = 0;
+  double trapDecay = 0.0;
+};
+
+/**
+ * @brief Optional processing stage run by the decoders after decoding
+ *
+ * Works through every decoded trace of an aggregate in bulk, straight from
+ * the EventBatch sample arena or the EventData probe vectors, and stores
+ * the result in the event's pulseFeatures. Each pass over a trace is a
+ * whole-trace loop carrying `omp simd` (see WaveformUnpack), only the CFD
+ * search and the trapezoid recursion are sequential. Events without an
+ * unpacked trace (no waveform, WaveformMode::Skip, Lazy or Compact) are
+ * left with pulseFeatures.valid false. Process() keeps its scratch buffers per
+ * thread and may be called from several decode threads at once.
+ */
+class PulseProcessor
+{
+ public:
+  void Configure(const PulseProcessingConfig &config) { fConfig = config; }
+  const PulseProcessingConfig &GetConfig() const { return fConfig; }
+  bool IsEnabled() const { return fConfig.enabled; }
+
+  /**
+   * @brief Parse the Pulse* parameters of a digitizer configuration
+   *
+   * Invalid values are reported and leave the default in place.
+   */
+  static PulseProcessingConfig ParseConfig(const ConfigurationManager &config);
+
+  /**
+   * @brief Compute the features of every event with a decoded trace
+   */
+  void Process(std::vector<std::unique_ptr<EventData>> &events) const;
+  void Process(EventBatch &batch) const;
+
+  /**
+   * @brief Compute the features of one trace of nSamples samples
+   */
+  void Compute(const int32_t *samples, size_t nSamples,
+               PulseFeatures &features) const;
+
+ private:
+  PulseProcessingConfig fConfig;
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // PULSEPROCESSOR_HPP
@@ -44,6 +44,8 @@ class RawData
   std::vector<uint8_t> data;
   size_t size = 0;
   uint32_t nEvents = 0;
+  uint64_t sequence = 0;  // Readout order, assigned by the reader thread
+  uint64_t queuedTicks = 0;  // PipelineTracer::Now() when queued, if tracing
 };
 
 // Type aliases
@@ -0,0 +1,80 @@
+#ifndef RAWDATAPOOL_HPP
+#define RAWDATAPOOL_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "RawData.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Bounded pool of reusable RawData buffers
+ *
+ * Buffers are allocated lazily with a fixed size (normally
+ * /par/MaxRawDataSize) up to a maximum count, and are handed back by the
+ * decoders once an aggregate has been decoded. When every buffer is in
+ * flight, Acquire() blocks instead of allocating, so a slow decoder stalls
+ * the readout rather than growing memory without bound.
+ */
+class RawDataPool
+{
+ public:
+  /**
+   * @brief Construct a pool
+   * @param bufferSize Size of each buffer in bytes
+   * @param maxBuffers Maximum number of buffers alive at the same time
+   */
+  RawDataPool(size_t bufferSize, size_t maxBuffers);
+  ~RawDataPool() = default;
+
+  RawDataPool(const RawDataPool &) = delete;
+  RawDataPool &operator=(const RawDataPool &) = delete;
+
+  /**
+   * @brief Get a buffer, blocking while the pool is exhausted
+   * @param timeout Maximum time to wait for a buffer to be released
+   * @return A buffer of GetBufferSize() bytes, or nullptr on timeout
+   */
+  std::unique_ptr<RawData_t> Acquire(
+      std::chrono::milliseconds timeout = std::chrono::milliseconds(100));
+
+  /**
+   * @brief Return a buffer to the pool
+   * @param rawData Buffer obtained from Acquire() (nullptr is ignored)
+   */
+  void Release(std::unique_ptr<RawData_t> rawData);
+
+  // Information
+  size_t GetBufferSize() const { return fBufferSize; }
+  size_t GetMaxBuffers() const { return fMaxBuffers; }
+  size_t GetAllocatedCount() const;
+  size_t GetFreeCount() const;
+  uint64_t GetExhaustedCount() const { return fExhaustedCount.load(); }
+
+ private:
+  const size_t fBufferSize;
+  const size_t fMaxBuffers;
+
+  mutable std::mutex fMutex;
+  std::condition_variable fReleasedCV;
+  std::vector<std::unique_ptr<RawData_t>> fFreeBuffers;
+  size_t fAllocatedCount = 0;
+
+  // Number of Acquire() calls that found the pool exhausted
+  std::atomic<uint64_t> fExhaustedCount{0};
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // RAWDATAPOOL_HPP
@@ -0,0 +1,65 @@
+#ifndef RAWFILEFORMAT_HPP
+#define RAWFILEFORMAT_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Layout of the raw run files written by RawRecorder
+ *
+ * A run file (.raw) is a RawFileHeader followed by one record per readout
+ * buffer: a RawRecordHeader and then exactly size bytes, as delivered by
+ * CAEN_FELib_ReadData (Dig2 data is still big endian). The sidecar index
+ * (.idx) is a RawFileHeader with kIndexMagic followed by one RawIndexEntry
+ * per record. All fields are host (little) endian.
+ */
+namespace RawFile
+{
+constexpr char kRunMagic[8] = {'D', 'L', 'R', 'A', 'W', 'v', '0', '1'};
+constexpr char kIndexMagic[8] = {'D', 'L', 'I', 'D', 'X', 'v', '0', '1'};
+constexpr uint32_t kVersion = 1;
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t headerSize;    // sizeof(FileHeader)
+  uint32_t firmwareType;  // FirmwareType of the board
+  uint32_t moduleNumber;
+  uint32_t fileIndex;   // Rotation counter within the recording
+  uint32_t timeStepNs;  // Sampling period, 0 if not known
+  uint64_t creationTimeNs;  // system_clock, since the epoch
+};
+
+struct RecordHeader {
+  uint64_t size;         // Payload bytes following this header
+  uint64_t sequence;     // RawData::sequence, readout order
+  uint64_t writeTimeNs;  // system_clock when its batch was written
+  uint32_t nEvents;      // As reported by CAEN_FELib_ReadData
+  uint32_t reserved;
+};
+
+// IndexEntry::flags
+constexpr uint32_t kIndexInfoValid = 0x1;  // Counter and timestamp are set
+
+struct IndexEntry {
+  uint64_t offset;          // Of the RecordHeader in the run file
+  uint64_t sequence;        // RawData::sequence
+  uint64_t firstTimeStamp;  // Board clock ticks, see RawRecorder::PeekFunction
+  uint32_t aggregateCounter;
+  uint32_t flags;
+};
+
+static_assert(sizeof(FileHeader) == 40, "RawFile::FileHeader layout");
+static_assert(sizeof(RecordHeader) == 32, "RawFile::RecordHeader layout");
+static_assert(sizeof(IndexEntry) == 32, "RawFile::IndexEntry layout");
+}  // namespace RawFile
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // RAWFILEFORMAT_HPP
@@ -0,0 +1,134 @@
+#ifndef RAWRECORDER_HPP
+#define RAWRECORDER_HPP
+
+#include <sys/uio.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BlockingQueue.hpp"
+#include "DigitizerStatistics.hpp"
+#include "IDigitizer.hpp"
+#include "RawData.hpp"
+#include "RawFileFormat.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Settings of the raw recording stage
+ */
+struct RawRecorderConfig {
+  // Files are named <pathPrefix>_mod<NN>_<NNNN>.raw/.idx; empty = disabled
+  std::string pathPrefix;
+  // A new file is started before a record would take a file past this size
+  uint64_t maxFileSize = 2048ULL << 20;
+  // Buffers written with one writev() call at most
+  size_t maxBatch = 64;
+};
+
+/**
+ * @brief Writes every readout buffer to disk before it is decoded
+ *
+ * The read threads Push() their buffers here instead of into the decoder.
+ * A writer thread takes them in batches, appends each as a length-prefixed
+ * record with a single writev() per batch, and then hands the same buffers
+ * on to the sink (normally IDecoder::AddData), so nothing is copied. Files
+ * rotate by size and each gets a sidecar index; see RawFileFormat.hpp.
+ *
+ * A write failure stops the recording but not the data flow: later
+ * buffers still reach the sink and the failure is counted.
+ */
+class RawRecorder
+{
+ public:
+  // Receives each buffer once it has been written
+  using Sink = std::function<void(std::unique_ptr<RawData_t>)>;
+  // Extracts the aggregate counter and first timestamp for the index;
+  // returns false for buffers that carry none (e.g. start/stop records)
+  using PeekFunction = std::function<bool(
+      const RawData_t &rawData, uint32_t &aggregateCounter,
+      uint64_t &firstTimeStamp)>;
+
+  RawRecorder(RawRecorderConfig config, FirmwareType firmwareType,
+              uint8_t moduleNumber);
+  ~RawRecorder();
+
+  RawRecorder(const RawRecorder &) = delete;
+  RawRecorder &operator=(const RawRecorder &) = delete;
+
+  void SetSink(Sink sink) { fSink = std::move(sink); }
+  void SetPeekFunction(PeekFunction peek) { fPeek = std::move(peek); }
+  // Stored in the file header for replay; applies from the next file
+  void SetTimeStep(uint32_t timeStepNs) { fTimeStepNs = timeStepNs; }
+
+  /**
+   * @brief Open the next file and start the writer thread
+   * @return false if the file cannot be created (existing files are never
+   *         overwritten)
+   */
+  bool Start();
+
+  /**
+   * @brief Write and forward everything queued, then close the files
+   *
+   * Call after the read threads have stopped pushing.
+   */
+  void Stop();
+
+  /**
+   * @brief Queue a buffer for writing; called by the read threads
+   */
+  void Push(std::unique_ptr<RawData_t> rawData);
+
+  /**
+   * @brief Copy the recording counters into stats
+   */
+  void Fill(DigitizerStatistics &stats) const;
+
+ private:
+  RawRecorderConfig fConfig;
+  FirmwareType fFirmwareType;
+  uint8_t fModuleNumber;
+  uint32_t fTimeStepNs = 0;
+  Sink fSink;
+  PeekFunction fPeek;
+
+  BlockingQueue<std::unique_ptr<RawData_t>> fQueue;
+  std::thread fWriterThread;
+  std::atomic<bool> fStopping{false};
+
+  // === Files (writer thread only once started) ===
+  int fRunFd = -1;
+  int fIndexFd = -1;
+  uint32_t fFileIndex = 0;  // Continues across Start() calls
+  uint64_t fFileSize = 0;
+  bool fFailed = false;
+
+  // === Statistics ===
+  std::atomic<uint64_t> fBytesWritten{0};
+  std::atomic<uint64_t> fRecordsWritten{0};
+  std::atomic<uint64_t> fFilesWritten{0};
+  std::atomic<uint64_t> fWriteErrors{0};
+
+  void WriterThread();
+  void WriteBatch(const std::vector<std::unique_ptr<RawData_t>> &batch);
+  bool OpenFiles();
+  void CloseFiles();
+  bool WriteAll(int fd, std::vector<iovec> &iov);
+  void Fail(const std::string &what);
+  std::string MakePath(const char *extension) const;
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // RAWRECORDER_HPP
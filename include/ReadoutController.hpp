@@ -0,0 +1,134 @@
+#ifndef READOUTCONTROLLER_HPP
+#define READOUTCONTROLLER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "ConfigurationManager.hpp"
+#include "DigitizerStatistics.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+enum class ReadoutGoal {
+  Fixed,      // Constant read timeout, aggregate size left alone (default)
+  Latency,    // Aggregates that fill within targetLatencyMs
+  Throughput  // Aggregates that use about half of a raw data buffer
+};
+
+/**
+ * @brief Read timeout and aggregate size settings
+ *
+ * With an adaptive goal the read timeout follows the observed interval
+ * between reads (kTimeoutIntervals of them), kept within
+ * [minReadTimeoutMs, maxReadTimeoutMs] and, for the Latency goal, below
+ * targetLatencyMs.
+ */
+struct ReadoutControlConfig {
+  ReadoutGoal goal = ReadoutGoal::Fixed;
+  uint32_t readTimeoutMs = 100;  // Fixed value and adaptive start value
+  uint32_t minReadTimeoutMs = 10;
+  uint32_t maxReadTimeoutMs = 1000;
+  double targetLatencyMs = 100.0;
+};
+
+/**
+ * @brief Tunes the readout from a running rate estimate
+ *
+ * The reader thread asks for the timeout of each read and reports every
+ * read; the estimates are exponential moving averages of the interval
+ * between reads and of the bytes and events per read. Between runs the
+ * digitizer asks for a new events-per-aggregate setting: the current one
+ * scaled so a read carries the events of targetLatencyMs (Latency) or
+ * half a raw data buffer (Throughput). Only the reader thread reports;
+ * the published values are relaxed atomics, so GetStatistics() may read
+ * them from any thread.
+ */
+class ReadoutController
+{
+ public:
+  // Interval estimates a read waits before timing out
+  static constexpr double kTimeoutIntervals = 4.0;
+  // Weight of the newest read in the moving averages
+  static constexpr double kSmoothing = 0.1;
+  // Largest Dig1 /par/EventAggr value
+  static constexpr uint32_t kMaxEventsPerAggregate = 1023;
+
+  /**
+   * @brief Apply a configuration and forget the previous estimates
+   * @param maxRawDataSize Size of one raw data buffer in bytes
+   */
+  void Configure(const ReadoutControlConfig &config, size_t maxRawDataSize);
+  const ReadoutControlConfig &GetConfig() const { return fConfig; }
+  bool IsAdaptive() const { return fConfig.goal != ReadoutGoal::Fixed; }
+
+  /**
+   * @brief Parse the Readout* and ReadTimeout* parameters of a digitizer
+   * configuration
+   *
+   * Invalid values are reported and leave the default in place.
+   */
+  static ReadoutControlConfig ParseConfig(const ConfigurationManager &config);
+
+  /**
+   * @brief Call before the reader thread starts a run
+   *
+   * Estimates carry over from the previous run, but the time between runs
+   * is not taken as a read interval.
+   */
+  void BeginRun() { fHasLastRead = false; }
+
+  // === Reader Thread ===
+  int GetReadTimeoutMs() const
+  {
+    return static_cast<int>(fReadTimeoutMs.load(std::memory_order_relaxed));
+  }
+  void RecordRead(size_t bytes, uint32_t nEvents);
+
+  // === Between Runs ===
+  /**
+   * @brief Events-per-aggregate setting for the next run
+   * @param current Setting of the last run (0 = firmware automatic)
+   * @return current if there is no estimate yet, it is 0, or the goal is
+   *         Fixed
+   */
+  uint32_t RecommendEventsPerAggregate(uint32_t current) const;
+
+  /**
+   * @brief Note the events-per-aggregate setting written to the board
+   */
+  void RecordEventsPerAggregate(uint32_t value)
+  {
+    fEventsPerAggregate.store(value, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Copy the adaptive readout fields into stats
+   */
+  void Fill(DigitizerStatistics &stats) const;
+
+ private:
+  ReadoutControlConfig fConfig;
+  size_t fMaxRawDataSize = 0;
+
+  // Reader thread only
+  std::chrono::steady_clock::time_point fLastRead;
+  bool fHasLastRead = false;
+
+  // Published estimates
+  std::atomic<uint32_t> fReadTimeoutMs{100};
+  std::atomic<double> fIntervalMs{0.0};  // 0 = no estimate yet
+  std::atomic<double> fBytesPerRead{0.0};
+  std::atomic<double> fEventsPerRead{0.0};
+  std::atomic<uint32_t> fEventsPerAggregate{0};
+  std::atomic<uint64_t> fTimeoutChanges{0};
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // READOUTCONTROLLER_HPP
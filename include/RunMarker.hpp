@@ -0,0 +1,78 @@
+#ifndef RUNMARKER_HPP
+#define RUNMARKER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "RawData.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Start and stop markers around a DPP-PSD/DPP-PHA (Dig1) run
+ *
+ * The Dig1 firmware sends board aggregates only, so Digitizer1 adds a
+ * four-word buffer of its own before the first and after the last
+ * aggregate of a run. They travel the raw path like aggregates (raw
+ * recorder, then AddData()), so a replayed file has the same run
+ * boundaries as the live readout:
+ *
+ *   word 0  [28:31] kType, [24:27] kKindStart or kKindStop, [0:23] size (4)
+ *   word 1  kMagic
+ *   word 2  buffers read before the marker [0:31]
+ *   word 3  buffers read before the marker [32:63]
+ *
+ * A board aggregate always has type 0xA in word 0, so a marker is never
+ * mistaken for one.
+ */
+namespace RunMarker
+{
+constexpr uint32_t kType = 0x3;
+constexpr int kTypeShift = 28;
+constexpr uint32_t kTypeMask = 0xF;
+constexpr uint32_t kKindStart = 0x0;
+constexpr uint32_t kKindStop = 0x2;
+constexpr int kKindShift = 24;
+constexpr uint32_t kKindMask = 0xF;
+constexpr uint32_t kMagic = 0x4D524C44;  // "DLRM"
+constexpr size_t kSizeWords = 4;
+constexpr size_t kSizeBytes = kSizeWords * sizeof(uint32_t);
+
+/**
+ * @brief Turn rawData into a marker of the given kind
+ */
+inline void Fill(RawData_t &rawData, uint32_t kind, uint64_t buffersRead)
+{
+  const uint32_t words[kSizeWords] = {
+      (kType << kTypeShift) | (kind << kKindShift) |
+          static_cast<uint32_t>(kSizeWords),
+      kMagic, static_cast<uint32_t>(buffersRead),
+      static_cast<uint32_t>(buffersRead >> 32)};
+  if (rawData.data.size() < kSizeBytes) rawData.data.resize(kSizeBytes);
+  std::memcpy(rawData.data.data(), words, kSizeBytes);
+  rawData.size = kSizeBytes;
+  rawData.nEvents = 0;
+}
+
+/**
+ * @brief Whether rawData is a marker of the given kind
+ */
+inline bool Is(const RawData_t &rawData, uint32_t kind)
+{
+  if (rawData.size != kSizeBytes) return false;
+  uint32_t words[2];
+  std::memcpy(words, rawData.data.data(), sizeof(words));
+  return ((words[0] >> kTypeShift) & kTypeMask) == kType &&
+         ((words[0] >> kKindShift) & kKindMask) == kind &&
+         words[1] == kMagic;
+}
+}  // namespace RunMarker
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // RUNMARKER_HPP
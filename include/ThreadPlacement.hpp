@@ -0,0 +1,91 @@
+#ifndef THREADPLACEMENT_HPP
+#define THREADPLACEMENT_HPP
+
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ConfigurationManager.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Where the reader and decode threads of a digitizer may run
+ *
+ * With a CPU list, thread i is pinned to the single CPU list[i % size].
+ * Without one, threads are pinned to all CPUs of numaNode if it is set,
+ * and left to the scheduler otherwise. Raw data buffers are allocated and
+ * first touched by the reader threads, so pinning them near the NIC also
+ * places the buffers in that node's memory.
+ */
+struct ThreadPlacementConfig {
+  std::vector<int> readerCPUs;
+  std::vector<int> decoderCPUs;
+  int numaNode = -1;          // -1 = no node
+  std::vector<int> nodeCPUs;  // CPUs of numaNode, filled by ParseConfig
+  int readerPriority = 0;     // SCHED_FIFO priority 1-99, 0 = normal
+
+  bool IsEnabled() const
+  {
+    return !readerCPUs.empty() || !decoderCPUs.empty() || !nodeCPUs.empty() ||
+           readerPriority > 0;
+  }
+};
+
+/**
+ * @brief CPU affinity and scheduling helpers (Linux)
+ *
+ * All functions only warn on failure, e.g. a CPU that does not exist or
+ * missing CAP_SYS_NICE for real-time priority; the thread keeps running
+ * with its previous placement.
+ */
+class ThreadPlacement
+{
+ public:
+  /**
+   * @brief Parse ReaderCPUs, DecoderCPUs, NUMANode and ReaderPriority
+   */
+  static ThreadPlacementConfig ParseConfig(const ConfigurationManager &config);
+
+  /**
+   * @brief Parse a CPU list such as "0-3,8,10-11"
+   * @return false on a malformed list
+   */
+  static bool ParseCPUList(const std::string &list, std::vector<int> &cpus);
+
+  /**
+   * @brief CPUs of a NUMA node from /sys/devices/system/node
+   * @return Empty if the node does not exist
+   */
+  static std::vector<int> GetNodeCPUs(int node);
+
+  /**
+   * @brief Apply the reader placement and priority to reader thread index
+   */
+  static void PlaceReader(std::thread &thread, size_t index,
+                          const ThreadPlacementConfig &config);
+
+  /**
+   * @brief Apply the decoder placement to decode thread index
+   */
+  static void PlaceDecoder(std::thread &thread, size_t index,
+                           const ThreadPlacementConfig &config);
+
+  static bool Pin(std::thread &thread, const std::vector<int> &cpus);
+  static bool SetRealtimePriority(std::thread &thread, int priority);
+
+ private:
+  // CPUs for thread index: one CPU of list, else the whole node
+  static std::vector<int> SelectCPUs(const std::vector<int> &list,
+                                     size_t index,
+                                     const ThreadPlacementConfig &config);
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // THREADPLACEMENT_HPP
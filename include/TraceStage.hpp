@@ -0,0 +1,48 @@
+#ifndef TRACESTAGE_HPP
+#define TRACESTAGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Pipeline stages timed by PipelineTracer, in pipeline order
+ */
+enum class TraceStage : uint8_t {
+  Read,    // FELib ReadData call (or replay file read) of one aggregate
+  Swap,    // Big-endian to host byte swap (Dig2)
+  Queue,   // Waiting in the raw data queue for a decode thread
+  Decode,  // DecodeData() of one aggregate, including the sort
+  Sort,    // Time sort of one decoded aggregate
+  Pickup   // First stored aggregate until GetEventData()/GetEventBatch()
+};
+
+constexpr size_t kNumTraceStages = 6;
+
+inline const char *GetTraceStageName(TraceStage stage)
+{
+  switch (stage) {
+    case TraceStage::Read:
+      return "Read";
+    case TraceStage::Swap:
+      return "Swap";
+    case TraceStage::Queue:
+      return "Queue";
+    case TraceStage::Decode:
+      return "Decode";
+    case TraceStage::Sort:
+      return "Sort";
+    case TraceStage::Pickup:
+      return "Pickup";
+  }
+  return "Unknown";
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // TRACESTAGE_HPP
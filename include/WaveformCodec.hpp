@@ -0,0 +1,71 @@
+#ifndef WAVEFORMCODEC_HPP
+#define WAVEFORMCODEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "EventData.hpp"
+#include "WaveformUnpack.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Lossless compact encoding of a decoded trace
+ *        (PackedWaveformInfo::Format::Compact)
+ *
+ * Each analog probe drops the trailing zero bits common to all its samples
+ * (the probe multiplication factor) and is stored as one constant, as
+ * int16_t, as zigzag varint deltas (only if delta is allowed and smaller)
+ * or, if nothing narrower is lossless, as int32_t. Digital probes are all
+ * zero, one bit per sample, or one byte per sample if they hold anything
+ * but 0 and 1. A typical 14-bit trace takes 2.5-4.5 bytes per sample
+ * instead of 12, or 1-2 with delta. Layout, all little endian:
+ *
+ *   uint8_t  analog[2]   Analog encoding | shift << 2, probe 1 then 2
+ *   uint8_t  digital     Digital encoding, 2 bits per probe from probe 1
+ *   payload of analog probe 1, analog probe 2, digital probes 1..4
+ *
+ * The sample count is not stored; it is PackedWaveformInfo::nSamples.
+ */
+class WaveformCodec
+{
+ public:
+  enum class Analog : uint8_t { Constant, Int16, Delta, Int32 };
+  enum class Digital : uint8_t { Zero, Bits, Bytes };
+
+  static constexpr size_t kHeaderSize = 3;
+
+  /**
+   * @brief Encode the decoded waveform of event into out (replacing it)
+   * @param delta Allow delta encoding of the analog probes
+   */
+  static void Encode(const EventData &event, bool delta,
+                     std::vector<uint8_t> &out);
+
+  /**
+   * @brief Decode nSamples samples into out, each probe with room for them
+   * @return false if data is shorter than its header says
+   */
+  static bool Decode(const uint8_t *data, size_t size, size_t nSamples,
+                     const WaveformUnpack::Output &out);
+
+  /**
+   * @brief Store the raw trace words described by raw compactly in event
+   *
+   * Decoders call this instead of keeping the words for
+   * WaveformMode::Compact; the trace is unpacked into per-thread scratch,
+   * so the event never holds the full-width probes.
+   */
+  static void Compress(const uint8_t *words, size_t size,
+                       const PackedWaveformInfo &raw, bool delta,
+                       EventData &event);
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // WAVEFORMCODEC_HPP
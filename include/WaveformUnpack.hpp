@@ -0,0 +1,241 @@
+#ifndef WAVEFORMUNPACK_HPP
+#define WAVEFORMUNPACK_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "EventData.hpp"
+#include "PSD1Constants.hpp"
+#include "PSD2Constants.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Whole-trace waveform unpack kernels
+ *
+ * Each kernel decodes a complete trace in one branch-free pass so the
+ * compiler can vectorize it (the loops carry `omp simd`, the library is
+ * always built with -fopenmp). Options that are constant for a trace, such
+ * as probe signedness or dual-trace mode, are template parameters; the
+ * decoders select the instantiation once per event.
+ */
+class WaveformUnpack
+{
+ public:
+  /**
+   * @brief Outputs of one trace, each with room for the decoded samples
+   */
+  struct Output {
+    int32_t *analogProbe1 = nullptr;
+    int32_t *analogProbe2 = nullptr;
+    uint8_t *digitalProbe1 = nullptr;
+    uint8_t *digitalProbe2 = nullptr;
+    uint8_t *digitalProbe3 = nullptr;
+    uint8_t *digitalProbe4 = nullptr;
+  };
+
+  /**
+   * @brief Output pointing at the (already sized) waveform of eventData
+   */
+  static Output ForEvent(EventData &eventData)
+  {
+    Output out;
+    out.analogProbe1 = eventData.analogProbe1.data();
+    out.analogProbe2 = eventData.analogProbe2.data();
+    out.digitalProbe1 = eventData.digitalProbe1.data();
+    out.digitalProbe2 = eventData.digitalProbe2.data();
+    out.digitalProbe3 = eventData.digitalProbe3.data();
+    out.digitalProbe4 = eventData.digitalProbe4.data();
+    return out;
+  }
+
+  /**
+   * @brief Unpack a PSD2 trace (two 32-bit points per 64-bit word)
+   * @param data First waveform word, already converted to little endian
+   * @param nSamples Number of points to decode
+   * @param ap1Mul Analog probe 1 multiplication factor
+   * @param ap2Mul Analog probe 2 multiplication factor
+   */
+  template <bool Ap1Signed, bool Ap2Signed>
+  static void UnpackPSD2(const uint8_t *data, size_t nSamples, int32_t ap1Mul,
+                         int32_t ap2Mul, const Output &out);
+
+  /**
+   * @brief Runtime dispatch to the UnpackPSD2 specialization
+   */
+  static void UnpackPSD2(const uint8_t *data, size_t nSamples, bool ap1Signed,
+                         bool ap2Signed, int32_t ap1Mul, int32_t ap2Mul,
+                         const Output &out);
+
+  /**
+   * @brief Unpack a PSD1/PHA1 trace (two 16-bit samples per 32-bit word)
+   *
+   * Fills all nSamples outputs of analog probes 1/2 and digital probes 1/2.
+   * Only the first 2 * nWords samples carry data, the rest are zeroed. In
+   * dual-trace mode each word holds one sample of each analog probe.
+   * @param data First waveform word
+   * @param nWords Number of 32-bit waveform words to decode
+   * @param nSamples Size of the output trace
+   */
+  template <bool DualTrace>
+  static void UnpackDig1(const uint8_t *data, size_t nWords, size_t nSamples,
+                         const Output &out);
+
+  /**
+   * @brief Runtime dispatch to the UnpackDig1 specialization
+   */
+  static void UnpackDig1(const uint8_t *data, size_t nWords, size_t nSamples,
+                         bool dualTrace, const Output &out);
+
+ private:
+  static uint32_t Load32(const uint8_t *data, size_t index)
+  {
+    uint32_t value = 0;
+    std::memcpy(&value, data + index * sizeof(uint32_t), sizeof(uint32_t));
+    return value;
+  }
+
+  // Sign extend the 14-bit analog field
+  static int32_t SignExtend14(uint32_t value)
+  {
+    return static_cast<int32_t>(value << 18) >> 18;
+  }
+};
+
+// ============================================================================
+// Inline Implementation
+// ============================================================================
+
+template <bool Ap1Signed, bool Ap2Signed>
+inline void WaveformUnpack::UnpackPSD2(const uint8_t *data, size_t nSamples,
+                                       int32_t ap1Mul, int32_t ap2Mul,
+                                       const Output &out)
+{
+  using namespace PSD2Constants;
+
+  // Local restrict pointers let the loop vectorize: stores through out's
+  // members could otherwise alias the members themselves
+  int32_t *__restrict ap1 = out.analogProbe1;
+  int32_t *__restrict ap2 = out.analogProbe2;
+  uint8_t *__restrict dp1 = out.digitalProbe1;
+  uint8_t *__restrict dp2 = out.digitalProbe2;
+  uint8_t *__restrict dp3 = out.digitalProbe3;
+  uint8_t *__restrict dp4 = out.digitalProbe4;
+
+#pragma omp simd
+  for (size_t i = 0; i < nSamples; ++i) {
+    const uint32_t point = Load32(data, i);
+    const uint32_t analog1 = point & Waveform::kAnalogProbeMask;
+    const uint32_t analog2 = (point >> 16) & Waveform::kAnalogProbeMask;
+
+    ap1[i] =
+        (Ap1Signed ? SignExtend14(analog1) : static_cast<int32_t>(analog1)) *
+        ap1Mul;
+    ap2[i] =
+        (Ap2Signed ? SignExtend14(analog2) : static_cast<int32_t>(analog2)) *
+        ap2Mul;
+
+    dp1[i] = (point >> 14) & Waveform::kDigitalProbeMask;
+    dp2[i] = (point >> 15) & Waveform::kDigitalProbeMask;
+    dp3[i] = (point >> 30) & Waveform::kDigitalProbeMask;
+    dp4[i] = (point >> 31) & Waveform::kDigitalProbeMask;
+  }
+}
+
+inline void WaveformUnpack::UnpackPSD2(const uint8_t *data, size_t nSamples,
+                                       bool ap1Signed, bool ap2Signed,
+                                       int32_t ap1Mul, int32_t ap2Mul,
+                                       const Output &out)
+{
+  if (ap1Signed && ap2Signed) {
+    UnpackPSD2<true, true>(data, nSamples, ap1Mul, ap2Mul, out);
+  } else if (ap1Signed) {
+    UnpackPSD2<true, false>(data, nSamples, ap1Mul, ap2Mul, out);
+  } else if (ap2Signed) {
+    UnpackPSD2<false, true>(data, nSamples, ap1Mul, ap2Mul, out);
+  } else {
+    UnpackPSD2<false, false>(data, nSamples, ap1Mul, ap2Mul, out);
+  }
+}
+
+template <bool DualTrace>
+inline void WaveformUnpack::UnpackDig1(const uint8_t *data, size_t nWords,
+                                       size_t nSamples, const Output &out)
+{
+  using namespace PSD1Constants;
+
+  nWords = std::min(nWords, nSamples / Waveform::kSamplesPerWord);
+
+  int32_t *__restrict ap1 = out.analogProbe1;
+  int32_t *__restrict ap2 = out.analogProbe2;
+  uint8_t *__restrict dp1 = out.digitalProbe1;
+  uint8_t *__restrict dp2 = out.digitalProbe2;
+  constexpr int kOddShift = Waveform::kSecondSampleShift;
+
+#pragma omp simd
+  for (size_t i = 0; i < nWords; ++i) {
+    const uint32_t word = Load32(data, i);
+    const int32_t analog1 = word & Waveform::kAnalogSampleMask;
+    const int32_t analog2 = (word >> kOddShift) & Waveform::kAnalogSampleMask;
+    const size_t even = i * Waveform::kSamplesPerWord;
+    const size_t odd = even + 1;
+
+    dp1[even] = (word >> Waveform::kDigitalProbe1WaveShift) & 0x1;
+    dp2[even] = (word >> Waveform::kDigitalProbe2WaveShift) & 0x1;
+    dp1[odd] = (word >> (kOddShift + Waveform::kDigitalProbe1WaveShift)) & 0x1;
+    dp2[odd] = (word >> (kOddShift + Waveform::kDigitalProbe2WaveShift)) & 0x1;
+
+    if (DualTrace) {
+      // Probe 1 holds the first sample of the word for both positions,
+      // probe 2 takes the second sample at odd positions
+      ap1[even] = analog1;
+      ap1[odd] = analog1;
+      ap2[odd] = analog2;
+    } else {
+      ap1[even] = analog1;
+      ap1[odd] = analog2;
+    }
+  }
+
+  if (DualTrace && nWords > 0) {
+    // Even positions of probe 2 repeat the previous word's first sample, as
+    // the per-sample decoder did. A separate loop keeps both branch-free
+    ap2[0] = 0;
+#pragma omp simd
+    for (size_t i = 1; i < nWords; ++i) {
+      ap2[i * Waveform::kSamplesPerWord] =
+          Load32(data, i - 1) & Waveform::kAnalogSampleMask;
+    }
+  }
+
+  // Samples past the decoded words, and probe 2 without dual trace, are empty
+  const size_t decoded = nWords * Waveform::kSamplesPerWord;
+  if (!DualTrace) std::fill(ap2, ap2 + decoded, 0);
+  if (decoded < nSamples) {
+    std::fill(ap1 + decoded, ap1 + nSamples, 0);
+    std::fill(ap2 + decoded, ap2 + nSamples, 0);
+    std::fill(dp1 + decoded, dp1 + nSamples, 0);
+    std::fill(dp2 + decoded, dp2 + nSamples, 0);
+  }
+}
+
+inline void WaveformUnpack::UnpackDig1(const uint8_t *data, size_t nWords,
+                                       size_t nSamples, bool dualTrace,
+                                       const Output &out)
+{
+  if (dualTrace) {
+    UnpackDig1<true>(data, nWords, nSamples, out);
+  } else {
+    UnpackDig1<false>(data, nWords, nSamples, out);
+  }
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // WAVEFORMUNPACK_HPP
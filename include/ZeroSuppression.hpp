@@ -0,0 +1,74 @@
+#ifndef ZEROSUPPRESSION_HPP
+#define ZEROSUPPRESSION_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "ConfigurationManager.hpp"
+#include "DigitizerStatistics.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+/**
+ * @brief Energy window and flag veto of one channel
+ *
+ * A hit passes if energyMin <= energy <= energyMax and it has none of the
+ * EventData flags in rejectFlags. The defaults let every hit pass.
+ */
+struct ChannelSuppression {
+  uint16_t energyMin = 0;
+  uint16_t energyMax = UINT16_MAX;
+  uint64_t rejectFlags = 0;
+};
+
+struct ZeroSuppressionConfig {
+  static constexpr size_t kMaxChannels = DecoderStatistics::kMaxChannels;
+  std::array<ChannelSuppression, kMaxChannels> channels{};
+};
+
+/**
+ * @brief Software threshold applied by the decoders to each hit
+ *
+ * Decoders look at the energy and flag words of a hit before anything else
+ * is decoded and skip the whole hit if Reject() is true, so rejected hits
+ * cost no EventData, no waveform unpack and no sort. Channels at or above
+ * kMaxChannels always pass. Reject() has no mutable state and may be called
+ * from several decode threads at once.
+ */
+class ZeroSuppression
+{
+ public:
+  static constexpr size_t kMaxChannels = ZeroSuppressionConfig::kMaxChannels;
+
+  void Configure(const ZeroSuppressionConfig &config);
+  const ZeroSuppressionConfig &GetConfig() const { return fConfig; }
+  bool IsEnabled() const { return fEnabled; }
+
+  /**
+   * @brief Parse the ZeroSuppress* parameters of a digitizer configuration
+   *
+   * Invalid values are reported and leave the default in place.
+   */
+  static ZeroSuppressionConfig ParseConfig(const ConfigurationManager &config);
+
+  bool Reject(uint8_t channel, uint16_t energy, uint64_t flags) const
+  {
+    if (channel >= kMaxChannels) return false;
+    const auto &window = fConfig.channels[channel];
+    return energy < window.energyMin || energy > window.energyMax ||
+           (flags & window.rejectFlags) != 0;
+  }
+
+ private:
+  ZeroSuppressionConfig fConfig;
+  bool fEnabled = false;  // Any channel differs from the defaults
+};
+
+}  // namespace Digitizer
+}  // namespace DELILA
+
+#endif  // ZEROSUPPRESSION_HPP
@@ -129,15 +129,14 @@ int main(int argc, char **argv)
     char key = getKey();
     if (key == 'q' || key == 'Q') break;
 
-    auto eventData = digitizer.GetEventData();
+    // Sleeps until the decoder has events, waking at least every 10 ms
+    auto eventData = digitizer.GetEventData(std::chrono::milliseconds(10));
     if (eventData->size() > 0) {
       eventCounter += eventData->size();
       std::cout << eventData->back()->timeStampNs << " Received "
                 << eventData->size()
                 << " events (Total: " << (size_t)eventCounter << ")"
                 << std::endl;
-    } else {
-      std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
   }
 
@@ -155,5 +154,25 @@ int main(int argc, char **argv)
             << eventCounter / duration * 1000 << " Hz" << std::endl;
 
   digitizer.StopAcquisition();
+
+  auto stats = digitizer.GetStatistics();
+  std::cout << "Read: " << stats.aggregatesRead << " aggregates, "
+            << stats.bytesRead << " bytes (" << stats.readTimeouts
+            << " timeouts, " << stats.readErrors << " errors)" << std::endl;
+  std::cout << "Reader: " << stats.readWaitNs / 1.0e6 << " ms in FELib, "
+            << stats.handoffNs / 1.0e6 << " ms handing off" << std::endl;
+  std::cout << "Decoded: " << stats.decoder.eventsDecoded << " events from "
+            << stats.decoder.aggregatesDecoded << " aggregates, mean "
+            << std::setprecision(1)
+            << stats.decoder.decodeLatency.GetMeanNs() / 1000.0
+            << " us per aggregate" << std::endl;
+  std::cout << "Sorted: " << stats.decoder.sortSkipped << " in order, "
+            << stats.decoder.sortMerged << " merged, "
+            << stats.decoder.sortRadix << " radix, "
+            << stats.decoder.sortTimeNs / 1000.0 << " us total" << std::endl;
+  std::cout << "Discarded buffers: " << stats.decoder.discardedBuffers
+            << ", decode errors: " << stats.decoder.decodeErrors
+            << ", counter discontinuities: "
+            << stats.decoder.counterDiscontinuities << std::endl;
   return 0;
 }
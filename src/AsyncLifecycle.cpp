@@ -0,0 +1,197 @@
+#include "AsyncLifecycle.hpp"
+
+#include <exception>
+#include <iostream>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+namespace
+{
+// The request is repeated while the call runs, since every lifecycle call
+// clears it when it starts
+constexpr auto kCancelRepeat = std::chrono::milliseconds(10);
+}  // namespace
+
+AsyncLifecycle::AsyncLifecycle(IDigitizer &digitizer) : fDigitizer(digitizer)
+{
+  fWorker = std::thread(&AsyncLifecycle::WorkerLoop, this);
+}
+
+AsyncLifecycle::~AsyncLifecycle()
+{
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fStopping = true;
+    fCancelGeneration++;
+  }
+  fCondition.notify_all();
+  if (fWorker.joinable()) {
+    fWorker.join();
+  }
+}
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+std::shared_future<LifecycleResult> AsyncLifecycle::Initialize(
+    const ConfigurationManager &config, std::chrono::milliseconds timeout)
+{
+  return Submit([this, config]() { return fDigitizer.Initialize(config); },
+                timeout);
+}
+
+std::shared_future<LifecycleResult> AsyncLifecycle::Configure(
+    std::chrono::milliseconds timeout)
+{
+  return Submit([this]() { return fDigitizer.Configure(); }, timeout);
+}
+
+std::shared_future<LifecycleResult> AsyncLifecycle::StartAcquisition(
+    std::chrono::milliseconds timeout)
+{
+  return Submit([this]() { return fDigitizer.StartAcquisition(); }, timeout);
+}
+
+std::shared_future<LifecycleResult> AsyncLifecycle::ArmAcquisition(
+    std::chrono::milliseconds timeout)
+{
+  return Submit([this]() { return fDigitizer.ArmAcquisition(); }, timeout);
+}
+
+std::shared_future<LifecycleResult> AsyncLifecycle::SendSWStart(
+    std::chrono::milliseconds timeout)
+{
+  return Submit([this]() { return fDigitizer.SendSWStart(); }, timeout);
+}
+
+std::shared_future<LifecycleResult> AsyncLifecycle::StopAcquisition(
+    std::chrono::milliseconds timeout)
+{
+  return Submit([this]() { return fDigitizer.StopAcquisition(); }, timeout);
+}
+
+void AsyncLifecycle::Cancel()
+{
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fCancelGeneration++;
+  }
+  fCondition.notify_all();
+}
+
+bool AsyncLifecycle::IsIdle() const
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  return !fRunning && fQueue.empty();
+}
+
+// ============================================================================
+// Worker
+// ============================================================================
+
+std::shared_future<LifecycleResult> AsyncLifecycle::Submit(
+    std::function<bool()> call, std::chrono::milliseconds timeout)
+{
+  Operation operation;
+  operation.call = std::move(call);
+  operation.submitted = Clock::now();
+  operation.deadline = timeout > kNoTimeout ? operation.submitted + timeout
+                                            : Clock::time_point::max();
+  auto future = operation.promise.get_future().share();
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    operation.cancelGeneration = fCancelGeneration;
+    fQueue.push_back(std::move(operation));
+  }
+  fCondition.notify_all();
+  return future;
+}
+
+void AsyncLifecycle::WorkerLoop()
+{
+  std::unique_lock<std::mutex> lock(fMutex);
+  while (true) {
+    fCondition.wait(lock, [this] { return fStopping || !fQueue.empty(); });
+    // When stopping, the queued calls are still resolved (as cancelled)
+    if (fQueue.empty()) return;
+
+    auto operation = std::move(fQueue.front());
+    fQueue.pop_front();
+    fRunning = true;
+
+    LifecycleResult result;
+    if (operation.cancelGeneration != fCancelGeneration) {
+      result.status = LifecycleStatus::Cancelled;
+    } else {
+      fCallDone = false;
+      lock.unlock();
+      result = Run(operation);
+      lock.lock();
+    }
+    lock.unlock();
+
+    result.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        Clock::now() - operation.submitted);
+    operation.promise.set_value(result);
+
+    lock.lock();
+    fRunning = false;
+  }
+}
+
+LifecycleResult AsyncLifecycle::Run(Operation &operation)
+{
+  bool status = false;
+  std::thread call([this, &operation, &status]() {
+    try {
+      status = operation.call();
+    } catch (const std::exception &e) {
+      std::cerr << "Digitizer "
+                << static_cast<int>(fDigitizer.GetModuleNumber()) << ": "
+                << e.what() << std::endl;
+    }
+    std::lock_guard<std::mutex> lock(fMutex);
+    fCallDone = true;
+    fCondition.notify_all();
+  });
+
+  // The call runs on its own thread so this one can act on the deadline
+  // and on Cancel() while it is blocked
+  bool cancelled = false;
+  bool timedOut = false;
+  {
+    std::unique_lock<std::mutex> lock(fMutex);
+    while (!fCallDone) {
+      cancelled |= operation.cancelGeneration != fCancelGeneration;
+      timedOut |= Clock::now() >= operation.deadline;
+      if (cancelled || timedOut) {
+        lock.unlock();
+        fDigitizer.CancelLifecycle();
+        lock.lock();
+        fCondition.wait_for(lock, kCancelRepeat);
+      } else if (operation.deadline == Clock::time_point::max()) {
+        fCondition.wait(lock);
+      } else {
+        fCondition.wait_until(lock, operation.deadline);
+      }
+    }
+  }
+  call.join();
+
+  LifecycleResult result;
+  if (status) {
+    result.status = LifecycleStatus::Ok;
+  } else if (cancelled) {
+    result.status = LifecycleStatus::Cancelled;
+  } else if (timedOut) {
+    result.status = LifecycleStatus::TimedOut;
+  }
+  return result;
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
@@ -0,0 +1,27 @@
+#include "Backpressure.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+void Backpressure::Configure(const BackpressureConfig &config)
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  fConfig = config;
+  fClosed = false;
+}
+
+void Backpressure::NotifyDrained() { fDrainedCV.notify_all(); }
+
+void Backpressure::Close()
+{
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fClosed = true;
+  }
+  fDrainedCV.notify_all();
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
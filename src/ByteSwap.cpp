@@ -0,0 +1,145 @@
+#include "ByteSwap.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <iterator>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DELILA_BYTESWAP_X86 1
+#endif
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+namespace
+{
+
+using SwapKernel = void (*)(uint8_t *, size_t);
+
+void SwapWords64Scalar(uint8_t *data, size_t nWords)
+{
+  for (size_t i = 0; i < nWords; ++i) {
+    uint64_t word = 0;
+    std::memcpy(&word, data + i * sizeof(uint64_t), sizeof(uint64_t));
+    word = ByteSwap::Swap64(word);
+    std::memcpy(data + i * sizeof(uint64_t), &word, sizeof(uint64_t));
+  }
+}
+
+#ifdef DELILA_BYTESWAP_X86
+
+__attribute__((target("ssse3"))) void SwapWords64SSSE3(uint8_t *data,
+                                                        size_t nWords)
+{
+  // Reverse the bytes of each 64-bit lane
+  const __m128i mask =
+      _mm_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
+
+  size_t i = 0;
+  for (; i + 2 <= nWords; i += 2) {
+    auto *p = reinterpret_cast<__m128i *>(data + i * sizeof(uint64_t));
+    _mm_storeu_si128(p, _mm_shuffle_epi8(_mm_loadu_si128(p), mask));
+  }
+  SwapWords64Scalar(data + i * sizeof(uint64_t), nWords - i);
+}
+
+__attribute__((target("avx2"))) void SwapWords64AVX2(uint8_t *data,
+                                                      size_t nWords)
+{
+  // vpshufb shuffles within each 128-bit half, so the mask repeats
+  const __m256i mask = _mm256_set_epi8(
+      8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12,
+      13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
+
+  size_t i = 0;
+  for (; i + 8 <= nWords; i += 8) {
+    auto *p0 = reinterpret_cast<__m256i *>(data + i * sizeof(uint64_t));
+    auto *p1 = p0 + 1;
+    __m256i v0 = _mm256_loadu_si256(p0);
+    __m256i v1 = _mm256_loadu_si256(p1);
+    _mm256_storeu_si256(p0, _mm256_shuffle_epi8(v0, mask));
+    _mm256_storeu_si256(p1, _mm256_shuffle_epi8(v1, mask));
+  }
+  for (; i + 4 <= nWords; i += 4) {
+    auto *p = reinterpret_cast<__m256i *>(data + i * sizeof(uint64_t));
+    _mm256_storeu_si256(p, _mm256_shuffle_epi8(_mm256_loadu_si256(p), mask));
+  }
+  SwapWords64Scalar(data + i * sizeof(uint64_t), nWords - i);
+}
+
+#endif  // DELILA_BYTESWAP_X86
+
+struct KernelChoice {
+  SwapKernel kernel;
+  const char *name;
+};
+
+// Widest first
+const KernelChoice kKernels[] = {
+#ifdef DELILA_BYTESWAP_X86
+    {SwapWords64AVX2, "avx2"},
+    {SwapWords64SSSE3, "ssse3"},
+#endif
+    {SwapWords64Scalar, "scalar"},
+};
+
+bool IsSupported(const KernelChoice &choice)
+{
+#ifdef DELILA_BYTESWAP_X86
+  __builtin_cpu_init();
+  if (choice.kernel == SwapWords64AVX2) return __builtin_cpu_supports("avx2");
+  if (choice.kernel == SwapWords64SSSE3) {
+    return __builtin_cpu_supports("ssse3");
+  }
+#endif
+  return true;
+}
+
+const KernelChoice *SelectBestKernel()
+{
+  for (const auto &choice : kKernels) {
+    if (IsSupported(choice)) return &choice;
+  }
+  return std::end(kKernels) - 1;  // Scalar
+}
+
+std::atomic<const KernelChoice *> &GetKernelSlot()
+{
+  static std::atomic<const KernelChoice *> slot{SelectBestKernel()};
+  return slot;
+}
+
+const KernelChoice &GetKernel()
+{
+  return *GetKernelSlot().load(std::memory_order_relaxed);
+}
+
+}  // namespace
+
+// ============================================================================
+// Public Interface
+// ============================================================================
+
+void ByteSwap::SwapWords64(uint8_t *data, size_t nWords)
+{
+  GetKernel().kernel(data, nWords);
+}
+
+const char *ByteSwap::GetKernelName() { return GetKernel().name; }
+
+bool ByteSwap::SelectKernel(const char *name)
+{
+  for (const auto &choice : kKernels) {
+    if (std::strcmp(choice.name, name) == 0 && IsSupported(choice)) {
+      GetKernelSlot().store(&choice, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
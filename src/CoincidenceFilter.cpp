@@ -0,0 +1,164 @@
+#include "CoincidenceFilter.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+// ============================================================================
+// Configuration
+// ============================================================================
+
+CoincidenceConfig CoincidenceFilter::ParseConfig(
+    const ConfigurationManager &config)
+{
+  CoincidenceConfig result;
+
+  auto modeStr = config.GetParameter("CoincidenceMode");
+  if (!modeStr.empty()) {
+    if (modeStr == "Off") {
+      result.mode = CoincidenceMode::Off;
+    } else if (modeStr == "Coincidence") {
+      result.mode = CoincidenceMode::Coincidence;
+    } else if (modeStr == "Anticoincidence") {
+      result.mode = CoincidenceMode::Anticoincidence;
+    } else {
+      std::cout << "Invalid CoincidenceMode \"" << modeStr
+                << "\", using default: Off" << std::endl;
+    }
+  }
+
+  // Masks are read as decimal, 0x hexadecimal or 0 octal
+  auto parseMask = [&config](const std::string &key, uint64_t &mask) {
+    auto maskStr = config.GetParameter(key);
+    if (maskStr.empty()) return;
+    try {
+      mask = std::stoull(maskStr, nullptr, 0);
+    } catch (...) {
+      std::cout << "Invalid " << key << " format, using default: " << mask
+                << std::endl;
+    }
+  };
+  parseMask("CoincidenceTriggerMask", result.triggerMask);
+  parseMask("CoincidencePartnerMask", result.partnerMask);
+
+  auto windowStr = config.GetParameter("CoincidenceWindowNs");
+  if (!windowStr.empty()) {
+    try {
+      auto window = std::stod(windowStr);
+      if (window >= 0.0) result.windowNs = window;
+    } catch (...) {
+      std::cout << "Invalid CoincidenceWindowNs format, using default: "
+                << result.windowNs << std::endl;
+    }
+  }
+
+  return result;
+}
+
+// ============================================================================
+// Selection
+// ============================================================================
+
+void CoincidenceFilter::Select(const std::vector<Hit> &hits, size_t begin,
+                               size_t end, std::vector<uint8_t> &keep) const
+{
+  keep.resize(end - begin);
+  for (size_t i = begin; i < end; ++i) {
+    keep[i - begin] = Keep(hits, i) ? 1 : 0;
+  }
+}
+
+bool CoincidenceFilter::Keep(const std::vector<Hit> &hits, size_t index) const
+{
+  const auto &hit = hits[index];
+  bool trigger = IsTrigger(hit.channel);
+  bool partner = IsPartner(hit.channel);
+  if (!trigger && !partner) return true;
+
+  bool veto = fConfig.mode == CoincidenceMode::Anticoincidence;
+  if (veto && !trigger) return false;
+
+  auto matches = [&](const Hit &other) {
+    if (other.module == hit.module && other.channel == hit.channel) {
+      return false;
+    }
+    if (veto) return IsPartner(other.channel);
+    return (trigger && IsPartner(other.channel)) ||
+           (partner && IsTrigger(other.channel));
+  };
+
+  // hits is sorted, so only the neighbours within the window are looked at
+  bool found = false;
+  for (size_t j = index; j-- > 0 && !found;) {
+    if (hit.timeStampNs - hits[j].timeStampNs > fConfig.windowNs) break;
+    found = matches(hits[j]);
+  }
+  for (size_t j = index + 1; j < hits.size() && !found; ++j) {
+    if (hits[j].timeStampNs - hit.timeStampNs > fConfig.windowNs) break;
+    found = matches(hits[j]);
+  }
+  return veto ? !found : found;
+}
+
+// ============================================================================
+// Decoder Output
+// ============================================================================
+
+size_t CoincidenceFilter::Apply(
+    std::vector<std::unique_ptr<EventData>> &events) const
+{
+  if (events.empty()) return 0;
+
+  std::vector<Hit> hits;
+  hits.reserve(events.size());
+  for (const auto &event : events) {
+    hits.push_back({event->timeStampNs, event->module, event->channel});
+  }
+  std::vector<uint8_t> keep;
+  Select(hits, 0, hits.size(), keep);
+
+  size_t kept = 0;
+  for (size_t i = 0; i < events.size(); ++i) {
+    if (keep[i]) events[kept++] = std::move(events[i]);
+  }
+  size_t removed = events.size() - kept;
+  events.resize(kept);
+  return removed;
+}
+
+size_t CoincidenceFilter::Apply(std::unique_ptr<EventBatch> &batch,
+                                EventBatchPool &pool) const
+{
+  if (batch->Empty()) return 0;
+
+  std::vector<Hit> hits;
+  hits.reserve(batch->Size());
+  for (size_t i = 0; i < batch->Size(); ++i) {
+    hits.push_back(
+        {batch->timeStampNs[i], batch->module[i], batch->channel[i]});
+  }
+  std::vector<uint8_t> keep;
+  Select(hits, 0, hits.size(), keep);
+
+  auto kept = static_cast<size_t>(std::count(keep.begin(), keep.end(), 1));
+  if (kept == batch->Size()) return 0;
+
+  // Gather the survivors into a pooled batch so the waveform arena is
+  // compacted as well
+  auto filtered = pool.Acquire();
+  filtered->Reserve(kept);
+  for (size_t i = 0; i < keep.size(); ++i) {
+    if (keep[i]) filtered->Append(*batch, i);
+  }
+  std::swap(batch, filtered);
+  pool.Release(std::move(filtered));
+  return hits.size() - kept;
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
@@ -0,0 +1,262 @@
+#include "ConfigurationPlanner.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <unordered_map>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+namespace
+{
+constexpr int kMaxChannel = 1000;  // Same sanity bound as ParameterValidator
+
+// One parameter of one channel (or of the board, channel < 0)
+struct Entry {
+  std::string path;
+  std::string value;
+  int channel = -1;
+  std::string suffix;  // Part after /ch/N for channel parameters
+  bool alive = true;
+};
+
+std::string ToLower(std::string str)
+{
+  std::transform(str.begin(), str.end(), str.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return str;
+}
+
+bool ParseChannel(const std::string &str, int &channel)
+{
+  if (str.empty() ||
+      !std::all_of(str.begin(), str.end(),
+                   [](unsigned char c) { return std::isdigit(c); })) {
+    return false;
+  }
+  channel = std::atoi(str.c_str());
+  return channel <= kMaxChannel;
+}
+
+// Expand /ch/A..B/... into one entry per channel, note /ch/N/... channels
+void Expand(const std::string &path, const std::string &value,
+            std::vector<Entry> &entries)
+{
+  static const std::string kChannelPrefix = "/ch/";
+  Entry entry;
+  entry.path = path;
+  entry.value = value;
+
+  if (ToLower(path.substr(0, kChannelPrefix.size())) != kChannelPrefix) {
+    entries.push_back(entry);
+    return;
+  }
+  auto specEnd = path.find('/', kChannelPrefix.size());
+  if (specEnd == std::string::npos) {
+    entries.push_back(entry);
+    return;
+  }
+  auto spec = path.substr(kChannelPrefix.size(),
+                          specEnd - kChannelPrefix.size());
+  entry.suffix = path.substr(specEnd);
+
+  int first = 0;
+  int last = 0;
+  auto dots = spec.find("..");
+  bool parsed = dots == std::string::npos
+                    ? ParseChannel(spec, first) && ParseChannel(spec, last)
+                    : ParseChannel(spec.substr(0, dots), first) &&
+                          ParseChannel(spec.substr(dots + 2), last);
+  if (!parsed || first > last) {
+    // Unusual channel syntax: pass it through untouched
+    entry.suffix.clear();
+    entries.push_back(entry);
+    return;
+  }
+
+  for (int ch = first; ch <= last; ++ch) {
+    entry.channel = ch;
+    entry.path = kChannelPrefix + std::to_string(ch) + entry.suffix;
+    entries.push_back(entry);
+  }
+}
+
+std::string ChannelSpec(int first, int last)
+{
+  if (first == last) return std::to_string(first);
+  return std::to_string(first) + ".." + std::to_string(last);
+}
+}  // namespace
+
+// ============================================================================
+// Planning
+// ============================================================================
+
+ConfigurationPlan ConfigurationPlanner::Plan(
+    const std::vector<std::array<std::string, 2>> &config,
+    const nlohmann::json *deviceTree)
+{
+  ConfigurationPlan plan;
+
+  std::vector<Entry> entries;
+  for (const auto &line : config) {
+    // Only use parameters that start with '/' (CAEN digitizer paths)
+    if (!line[0].empty() && line[0][0] == '/') {
+      Expand(line[0], line[1], entries);
+    }
+  }
+  plan.requested = entries.size();
+
+  // A parameter set more than once keeps its last value
+  std::unordered_map<std::string, size_t> lastIndex;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    auto key = ToLower(entries[i].path);
+    auto it = lastIndex.find(key);
+    if (it != lastIndex.end()) {
+      entries[it->second].alive = false;
+      plan.overridden++;
+    }
+    lastIndex[key] = i;
+  }
+
+  if (deviceTree && !deviceTree->is_null()) {
+    for (auto &entry : entries) {
+      if (!entry.alive) continue;
+      auto current = LookupValue(*deviceTree, entry.path, "defaultvalue");
+      if (current && SameValue(*current, entry.value)) {
+        entry.alive = false;
+        plan.unchanged++;
+      }
+    }
+  }
+
+  // Group channel writes of the same parameter and value. A write joins a
+  // group only if neither the board nor its own channel was written since
+  // the group's first member, so emitting the group there keeps the order
+  // of every channel's writes and of the board-level writes around them
+  constexpr size_t kNoGroup = std::numeric_limits<size_t>::max();
+  std::vector<std::vector<size_t>> groups;
+  std::vector<size_t> leaderOf(entries.size(), kNoGroup);
+  std::unordered_map<std::string, size_t> openGroups;
+  std::unordered_map<int, size_t> lastWrite;  // Channel -> entry index
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const auto &entry = entries[i];
+    if (!entry.alive) continue;
+    if (entry.channel < 0) {
+      openGroups.clear();
+      continue;
+    }
+
+    auto key = ToLower(entry.suffix) + '\n' + entry.value;
+    auto open = openGroups.find(key);
+    auto last = lastWrite.find(entry.channel);
+    if (open != openGroups.end() &&
+        (last == lastWrite.end() ||
+         last->second < groups[open->second].front())) {
+      groups[open->second].push_back(i);
+    } else {
+      leaderOf[i] = groups.size();
+      openGroups[key] = groups.size();
+      groups.push_back({i});
+    }
+    lastWrite[entry.channel] = i;
+  }
+
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const auto &entry = entries[i];
+    if (!entry.alive) continue;
+    if (entry.channel < 0) {
+      plan.writes.push_back({entry.path, entry.value});
+      continue;
+    }
+
+    // Emit the whole group at its first member, skip the others
+    if (leaderOf[i] == kNoGroup) continue;
+    const auto &group = groups[leaderOf[i]];
+
+    std::vector<int> channels;
+    channels.reserve(group.size());
+    for (auto index : group) {
+      channels.push_back(entries[index].channel);
+    }
+    std::sort(channels.begin(), channels.end());
+
+    size_t runStart = 0;
+    for (size_t k = 1; k <= channels.size(); ++k) {
+      if (k < channels.size() && channels[k] == channels[k - 1] + 1) continue;
+      plan.writes.push_back(
+          {"/ch/" + ChannelSpec(channels[runStart], channels[k - 1]) +
+               entry.suffix,
+           entry.value});
+      runStart = k;
+    }
+  }
+
+  return plan;
+}
+
+// ============================================================================
+// Device Tree Helpers
+// ============================================================================
+
+std::optional<std::string> ConfigurationPlanner::LookupValue(
+    const nlohmann::json &deviceTree, const std::string &path,
+    const std::string &field)
+{
+  const nlohmann::json *node = &deviceTree;
+  size_t pos = 0;
+  while (pos < path.size()) {
+    if (path[pos] == '/') {
+      ++pos;
+      continue;
+    }
+    auto end = path.find('/', pos);
+    if (end == std::string::npos) end = path.size();
+    auto name = ToLower(path.substr(pos, end - pos));
+    if (!node->is_object()) return std::nullopt;
+    auto it = node->find(name);
+    if (it == node->end()) return std::nullopt;
+    node = &(*it);
+    pos = end;
+  }
+
+  if (!node->is_object()) return std::nullopt;
+  auto value = node->find(field);
+  if (value == node->end()) return std::nullopt;
+  // "value" is a plain string, attributes such as "defaultvalue" are nodes
+  if (value->is_object()) {
+    auto inner = value->find("value");
+    if (inner == value->end()) return std::nullopt;
+    value = inner;
+  }
+  if (!value->is_string()) return std::nullopt;
+  return value->get<std::string>();
+}
+
+bool ConfigurationPlanner::SameValue(const std::string &a, const std::string &b)
+{
+  if (a.size() == b.size() &&
+      std::equal(a.begin(), a.end(), b.begin(),
+                 [](unsigned char x, unsigned char y) {
+                   return std::tolower(x) == std::tolower(y);
+                 })) {
+    return true;
+  }
+
+  // Numbers may be read back in another format
+  char *endA = nullptr;
+  char *endB = nullptr;
+  double numA = std::strtod(a.c_str(), &endA);
+  double numB = std::strtod(b.c_str(), &endB);
+  if (a.empty() || b.empty() || *endA != '\0' || *endB != '\0') return false;
+  return std::fabs(numA - numB) <=
+         1e-9 * std::max(1.0, std::max(std::fabs(numA), std::fabs(numB)));
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
@@ -8,8 +8,7 @@ namespace Digitizer
 DecoderResult DataValidator::ValidateBoardHeader(const uint32_t *headerWords)
 {
   if (headerWords == nullptr) {
-    DecoderLogger::LogError("DataValidator",
-                            "Board header words pointer is null");
+    DECODER_LOG_ERROR("DataValidator", "Board header words pointer is null");
     return DecoderResult::CorruptedData;
   }
 
@@ -18,8 +17,8 @@ DecoderResult DataValidator::ValidateBoardHeader(const uint32_t *headerWords)
       (headerWords[0] >> PSD1Constants::BoardHeader::kTypeShift) &
       PSD1Constants::BoardHeader::kTypeMask;
   if (headerType != PSD1Constants::BoardHeader::kTypeData) {
-    DecoderLogger::LogError("DataValidator", "Invalid board header type: 0x" +
-                                                 std::to_string(headerType));
+    DECODER_LOG_ERROR("DataValidator",
+                      "Invalid board header type: 0x" << std::hex << headerType);
     return DecoderResult::InvalidHeader;
   }
 
@@ -27,9 +26,8 @@ DecoderResult DataValidator::ValidateBoardHeader(const uint32_t *headerWords)
   uint32_t aggregateSize =
       headerWords[0] & PSD1Constants::BoardHeader::kAggregateSizeMask;
   if (aggregateSize < PSD1Constants::BoardHeader::kHeaderSizeWords) {
-    DecoderLogger::LogError(
-        "DataValidator",
-        "Board aggregate size too small: " + std::to_string(aggregateSize));
+    DECODER_LOG_ERROR("DataValidator",
+                      "Board aggregate size too small: " << aggregateSize);
     return DecoderResult::CorruptedData;
   }
 
@@ -38,8 +36,7 @@ DecoderResult DataValidator::ValidateBoardHeader(const uint32_t *headerWords)
       (headerWords[1] >> PSD1Constants::BoardHeader::kBoardIdShift) &
       PSD1Constants::BoardHeader::kBoardIdMask;
   if (boardId > PSD1Constants::Validation::kMaxBoardId) {
-    DecoderLogger::LogError("DataValidator",
-                            "Invalid board ID: " + std::to_string(boardId));
+    DECODER_LOG_ERROR("DataValidator", "Invalid board ID: " << boardId);
     return DecoderResult::CorruptedData;
   }
 
@@ -48,8 +45,8 @@ DecoderResult DataValidator::ValidateBoardHeader(const uint32_t *headerWords)
       (headerWords[1] >> PSD1Constants::BoardHeader::kDualChannelMaskShift) &
       PSD1Constants::BoardHeader::kDualChannelMaskMask;
   if (dualChannelMask == 0) {
-    DecoderLogger::LogWarning("DataValidator",
-                              "No active channels in dual channel mask");
+    DECODER_LOG_WARNING("DataValidator",
+                        "No active channels in dual channel mask");
   }
 
   return DecoderResult::Success;
@@ -59,8 +56,8 @@ DecoderResult DataValidator::ValidateDualChannelHeader(
     const uint32_t *headerWords)
 {
   if (headerWords == nullptr) {
-    DecoderLogger::LogError("DataValidator",
-                            "Dual channel header words pointer is null");
+    DECODER_LOG_ERROR("DataValidator",
+                      "Dual channel header words pointer is null");
     return DecoderResult::CorruptedData;
   }
 
@@ -69,8 +66,7 @@ DecoderResult DataValidator::ValidateDualChannelHeader(
                      PSD1Constants::ChannelHeader::kDualChannelHeaderShift) &
                     0x1;
   if (!headerFlag) {
-    DecoderLogger::LogError("DataValidator",
-                            "Invalid dual channel header flag");
+    DECODER_LOG_ERROR("DataValidator", "Invalid dual channel header flag");
     return DecoderResult::InvalidHeader;
   }
 
@@ -78,9 +74,9 @@ DecoderResult DataValidator::ValidateDualChannelHeader(
   uint32_t aggregateSize =
       headerWords[0] & PSD1Constants::ChannelHeader::kDualChannelSizeMask;
   if (aggregateSize < PSD1Constants::ChannelHeader::kHeaderSizeWords) {
-    DecoderLogger::LogError("DataValidator",
-                            "Dual channel aggregate size too small: " +
-                                std::to_string(aggregateSize));
+    DECODER_LOG_ERROR("DataValidator",
+                      "Dual channel aggregate size too small: "
+                          << aggregateSize);
     return DecoderResult::CorruptedData;
   }
 
@@ -90,8 +86,8 @@ DecoderResult DataValidator::ValidateDualChannelHeader(
   size_t totalSamples =
       numSamplesWave * PSD1Constants::Waveform::kSamplesPerGroup;
   if (totalSamples > PSD1Constants::Validation::kMaxWaveformSamples) {
-    DecoderLogger::LogError("DataValidator", "Waveform samples too large: " +
-                                                 std::to_string(totalSamples));
+    DECODER_LOG_ERROR("DataValidator",
+                      "Waveform samples too large: " << totalSamples);
     return DecoderResult::InvalidWaveformSize;
   }
 
@@ -137,7 +133,7 @@ DecoderResult DataValidator::ValidateEventData(
   uint32_t triggerTimeTag =
       eventWord & PSD1Constants::Event::kTriggerTimeTagMask;
   if (triggerTimeTag == 0) {
-    DecoderLogger::LogWarning("DataValidator", "Zero trigger time tag");
+    DECODER_LOG_WARNING("DataValidator", "Zero trigger time tag");
   }
 
   return DecoderResult::Success;
@@ -151,9 +147,8 @@ DecoderResult DataValidator::ValidateWaveformData(size_t numSamples,
   }
 
   if (numSamples > PSD1Constants::Validation::kMaxWaveformSamples) {
-    DecoderLogger::LogError(
-        "DataValidator",
-        "Waveform samples exceed maximum: " + std::to_string(numSamples));
+    DECODER_LOG_ERROR("DataValidator",
+                      "Waveform samples exceed maximum: " << numSamples);
     return DecoderResult::InvalidWaveformSize;
   }
 
@@ -174,15 +169,15 @@ DecoderResult DataValidator::ValidateTimestamp(uint32_t triggerTimeTag,
 {
   // Validate trigger time tag (should not be all bits set)
   if (triggerTimeTag == PSD1Constants::Event::kTriggerTimeTagMask) {
-    DecoderLogger::LogWarning(
+    DECODER_LOG_WARNING(
         "DataValidator",
         "Trigger time tag has all bits set (potentially invalid)");
   }
 
   // Validate fine time (should be within 10-bit range)
   if (fineTime > PSD1Constants::Event::kFineTimeStampMask) {
-    DecoderLogger::LogError("DataValidator", "Fine time stamp out of range: " +
-                                                 std::to_string(fineTime));
+    DECODER_LOG_ERROR("DataValidator",
+                      "Fine time stamp out of range: " << fineTime);
     return DecoderResult::TimestampError;
   }
 
@@ -200,13 +195,12 @@ DecoderResult DataValidator::ValidateChargeData(uint32_t chargeWord)
 
   // Validate charge values (should be reasonable, not all zeros or all ones)
   if (chargeShort == 0 && chargeLong == 0) {
-    DecoderLogger::LogWarning("DataValidator", "Both charge values are zero");
+    DECODER_LOG_WARNING("DataValidator", "Both charge values are zero");
   }
 
   if (chargeShort == PSD1Constants::Event::kChargeShortMask &&
       chargeLong == PSD1Constants::Event::kChargeLongMask) {
-    DecoderLogger::LogWarning("DataValidator",
-                              "Both charge values are at maximum");
+    DECODER_LOG_WARNING("DataValidator", "Both charge values are at maximum");
   }
 
   return DecoderResult::Success;
@@ -218,18 +212,16 @@ DecoderResult DataValidator::ValidateBlockBounds(size_t blockStart,
                                                  const std::string &blockName)
 {
   if (blockStart > blockEnd) {
-    DecoderLogger::LogError(
-        "DataValidator",
-        blockName + " block start > end: " + std::to_string(blockStart) +
-            " > " + std::to_string(blockEnd));
+    DECODER_LOG_ERROR("DataValidator",
+                      blockName << " block start > end: " << blockStart << " > "
+                          << blockEnd);
     return DecoderResult::CorruptedData;
   }
 
   if (blockEnd > totalSize) {
-    DecoderLogger::LogError(
-        "DataValidator",
-        blockName + " block extends beyond data: " + std::to_string(blockEnd) +
-            " > " + std::to_string(totalSize));
+    DECODER_LOG_ERROR("DataValidator",
+                      blockName << " block extends beyond data: " << blockEnd
+                          << " > " << totalSize);
     return DecoderResult::OutOfBounds;
   }
 
@@ -0,0 +1,180 @@
+#include "DecoderLogger.hpp"
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "BlockingQueue.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+namespace
+{
+struct LogRecord {
+  LogLevel level;
+  std::string text;
+};
+
+const char *LevelTag(LogLevel level)
+{
+  switch (level) {
+    case LogLevel::Error:
+      return "[ERROR] ";
+    case LogLevel::Warning:
+      return "[WARNING] ";
+    case LogLevel::Info:
+      return "[INFO] ";
+    case LogLevel::Debug:
+      return "[DEBUG] ";
+  }
+  return "";
+}
+
+/**
+ * Writes queued records from its own thread. Created on first use and
+ * destroyed at exit, after writing whatever is still queued.
+ */
+class LogSink
+{
+ public:
+  LogSink() : fQueue(DecoderLogger::kQueueCapacity)
+  {
+    fThread = std::thread(&LogSink::SinkThread, this);
+  }
+
+  ~LogSink()
+  {
+    fQueue.Close();
+    if (fThread.joinable()) fThread.join();
+  }
+
+  void Push(LogRecord &&record)
+  {
+    // Debug dumps wait for room so they stay complete; the rest never
+    // blocks the caller
+    fQueued.fetch_add(1, std::memory_order_relaxed);
+    bool debug = record.level == LogLevel::Debug;
+    if (!(debug ? fQueue.Push(std::move(record))
+                : fQueue.TryPush(std::move(record)))) {
+      fQueued.fetch_sub(1, std::memory_order_relaxed);
+      fDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  void Flush()
+  {
+    auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(1000);
+    while (fWritten.load() < fQueued.load() &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  uint64_t GetDropped() const { return fDropped.load(); }
+
+ private:
+  void SinkThread()
+  {
+    std::vector<LogRecord> records;
+    while (true) {
+      records.clear();
+      fQueue.PopBatch(records, 256, std::chrono::milliseconds(100));
+      if (records.empty()) {
+        if (fQueue.IsClosed()) break;
+        continue;
+      }
+
+      bool toCerr = false;
+      bool toCout = false;
+      for (const auto &record : records) {
+        if (record.level <= LogLevel::Warning) {
+          std::cerr << record.text << '\n';
+          toCerr = true;
+        } else {
+          std::cout << record.text << '\n';
+          toCout = true;
+        }
+      }
+      if (toCerr) std::cerr.flush();
+      if (toCout) std::cout.flush();
+      fWritten.fetch_add(records.size());
+    }
+  }
+
+  BlockingQueue<LogRecord> fQueue;
+  std::atomic<uint64_t> fQueued{0};
+  std::atomic<uint64_t> fWritten{0};
+  std::atomic<uint64_t> fDropped{0};
+  std::thread fThread;
+};
+
+LogSink &GetSink()
+{
+  static LogSink sink;
+  return sink;
+}
+
+int64_t NowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+}  // namespace
+
+// ============================================================================
+// Rate Limit
+// ============================================================================
+
+bool DecoderLogger::Admit(LogSite &site)
+{
+  site.count.fetch_add(1, std::memory_order_relaxed);
+  // Debug output was asked for explicitly (dump flag), so none is held back
+  if (site.level == LogLevel::Debug) return true;
+
+  auto now = NowNs();
+  auto start = site.windowStartNs.load(std::memory_order_relaxed);
+  if (now - start >= 1000000000 &&
+      site.windowStartNs.compare_exchange_strong(start, now)) {
+    // This thread opened the new window and reports the old one
+    site.windowCount.store(0, std::memory_order_relaxed);
+    auto suppressed = site.suppressed.exchange(0);
+    if (suppressed > 0) {
+      Write(site.level, site.context,
+            std::to_string(suppressed) + " similar messages suppressed");
+    }
+  }
+
+  if (site.windowCount.fetch_add(1, std::memory_order_relaxed) <
+      kMaxPerSecond) {
+    return true;
+  }
+  site.suppressed.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+// ============================================================================
+// Sink
+// ============================================================================
+
+void DecoderLogger::Write(LogLevel level, const char *context,
+                          std::string message)
+{
+  std::string text = LevelTag(level);
+  text += context;
+  text += ": ";
+  text += message;
+  GetSink().Push({level, std::move(text)});
+}
+
+void DecoderLogger::Flush() { GetSink().Flush(); }
+
+uint64_t DecoderLogger::GetDroppedCount() { return GetSink().GetDropped(); }
+
+}  // namespace Digitizer
+}  // namespace DELILA
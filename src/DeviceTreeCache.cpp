@@ -0,0 +1,171 @@
+#include "DeviceTreeCache.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+namespace
+{
+constexpr char kMagic[8] = {'D', 'L', 'D', 'T', 'C', 'B', 'R', '1'};
+
+struct CacheHeader {
+  char magic[8];
+  uint64_t payloadSize;
+  uint64_t checksum;
+};
+
+uint64_t Checksum(const uint8_t *data, size_t size)
+{
+  // FNV-1a, 64 bit
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= data[i];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+}  // namespace
+
+DeviceTreeCache::DeviceTreeCache(std::string directory)
+    : fDirectory(std::move(directory))
+{
+}
+
+std::string DeviceTreeCache::GetDefaultDirectory()
+{
+  const char *xdg = std::getenv("XDG_CACHE_HOME");
+  if (xdg && *xdg) return std::string(xdg) + "/delila-digitizer";
+  const char *home = std::getenv("HOME");
+  if (home && *home) return std::string(home) + "/.cache/delila-digitizer";
+  return "";
+}
+
+std::string DeviceTreeCache::MakeKey(const std::vector<std::string> &identity)
+{
+  std::string key;
+  for (const auto &part : identity) {
+    if (!key.empty()) key += '_';
+    for (unsigned char c : part) {
+      key += (std::isalnum(c) || c == '.' || c == '-') ? static_cast<char>(c)
+                                                       : '_';
+    }
+  }
+  return key;
+}
+
+std::string DeviceTreeCache::GetPath(const std::string &key) const
+{
+  return fDirectory + "/" + key + ".devtree";
+}
+
+// ============================================================================
+// Load / Store
+// ============================================================================
+
+bool DeviceTreeCache::Load(const std::string &key,
+                           nlohmann::json &deviceTree) const
+{
+  if (fDirectory.empty() || key.empty()) return false;
+
+  int fd = open(GetPath(key).c_str(), O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) != 0 ||
+      static_cast<size_t>(fileStat.st_size) < sizeof(CacheHeader)) {
+    close(fd);
+    return false;
+  }
+
+  size_t fileSize = fileStat.st_size;
+  void *mapped = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) return false;
+
+  bool loaded = false;
+  const auto *bytes = static_cast<const uint8_t *>(mapped);
+  CacheHeader header;
+  std::memcpy(&header, bytes, sizeof(header));
+  const uint8_t *payload = bytes + sizeof(header);
+
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+      header.payloadSize == fileSize - sizeof(header) &&
+      header.checksum == Checksum(payload, header.payloadSize)) {
+    try {
+      deviceTree =
+          nlohmann::json::from_cbor(payload, payload + header.payloadSize);
+      loaded = true;
+    } catch (const nlohmann::json::exception &e) {
+      std::cerr << "Failed to decode cached device tree: " << e.what()
+                << std::endl;
+    }
+  } else {
+    std::cerr << "Ignoring corrupt device tree cache " << GetPath(key)
+              << std::endl;
+  }
+
+  munmap(mapped, fileSize);
+  return loaded;
+}
+
+bool DeviceTreeCache::Store(const std::string &key,
+                            const nlohmann::json &deviceTree) const
+{
+  if (fDirectory.empty() || key.empty()) return false;
+
+  std::error_code ec;
+  std::filesystem::create_directories(fDirectory, ec);
+  if (ec) {
+    std::cerr << "Failed to create device tree cache directory " << fDirectory
+              << ": " << ec.message() << std::endl;
+    return false;
+  }
+
+  auto payload = nlohmann::json::to_cbor(deviceTree);
+  CacheHeader header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.payloadSize = payload.size();
+  header.checksum = Checksum(payload.data(), payload.size());
+
+  // Write beside the target and rename, so readers never see a partial file
+  auto path = GetPath(key);
+  auto tmpPath = path + ".tmp" + std::to_string(getpid());
+  {
+    std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+    if (!file) {
+      std::cerr << "Failed to write device tree cache " << tmpPath
+                << std::endl;
+      return false;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(payload.data()), payload.size());
+    if (!file) {
+      std::remove(tmpPath.c_str());
+      return false;
+    }
+  }
+
+  if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+    std::remove(tmpPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
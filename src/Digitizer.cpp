@@ -64,6 +64,44 @@ Digitizer::GetEventData()
   return fDigitizerImpl->GetEventData();
 }
 
+std::unique_ptr<EventBatch> Digitizer::GetEventBatch()
+{
+  if (!fDigitizerImpl) return nullptr;
+  return fDigitizerImpl->GetEventBatch();
+}
+
+std::unique_ptr<std::vector<std::unique_ptr<EventData>>>
+Digitizer::GetEventData(std::chrono::milliseconds timeout)
+{
+  if (!fDigitizerImpl) return nullptr;
+  return fDigitizerImpl->GetEventData(timeout);
+}
+
+std::unique_ptr<EventBatch> Digitizer::GetEventBatch(
+    std::chrono::milliseconds timeout)
+{
+  if (!fDigitizerImpl) return nullptr;
+  return fDigitizerImpl->GetEventBatch(timeout);
+}
+
+void Digitizer::ReleaseEventBatch(std::unique_ptr<EventBatch> batch)
+{
+  if (!fDigitizerImpl) return;
+  fDigitizerImpl->ReleaseEventBatch(std::move(batch));
+}
+
+DigitizerStatistics Digitizer::GetStatistics() const
+{
+  if (!fDigitizerImpl) return DigitizerStatistics();
+  return fDigitizerImpl->GetStatistics();
+}
+
+std::shared_ptr<OnlineHistograms> Digitizer::GetHistograms() const
+{
+  if (!fDigitizerImpl) return nullptr;
+  return fDigitizerImpl->GetHistograms();
+}
+
 // ============================================================================
 // Device Information
 // ============================================================================
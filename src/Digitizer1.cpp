@@ -4,14 +4,42 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <iostream>
 #include <thread>
 
+#include "PSD1Constants.hpp"
+#include "RunMarker.hpp"
+
 namespace DELILA
 {
 namespace Digitizer
 {
 
+namespace
+{
+// Aggregate counter and board time tag of a board aggregate; PSD1 and PHA1
+// share the board header layout
+bool PeekBoardAggregate(const RawData_t &rawData, uint32_t &aggregateCounter,
+                        uint64_t &firstTimeStamp)
+{
+  using namespace PSD1Constants::BoardHeader;
+  uint32_t words[kHeaderSizeWords];
+  if (rawData.size < sizeof(words)) {
+    return false;
+  }
+
+  std::memcpy(words, rawData.data.data(), sizeof(words));
+  if (((words[0] >> kTypeShift) & kTypeMask) != kTypeData) {
+    return false;
+  }
+
+  aggregateCounter = words[2] & kBoardCounterMask;
+  firstTimeStamp = words[3];
+  return true;
+}
+}  // namespace
+
 Digitizer1::Digitizer1() {}
 
 Digitizer1::~Digitizer1()
@@ -22,6 +50,8 @@ Digitizer1::~Digitizer1()
 
 bool Digitizer1::Initialize(const ConfigurationManager &config)
 {
+  fCancelRequested = false;
+
   // Get URL from configuration
   fURL = config.GetParameter("URL");
   if (fURL.empty()) {
@@ -48,6 +78,238 @@ bool Digitizer1::Initialize(const ConfigurationManager &config)
     }
   }
 
+  // Get number of raw data buffers if available
+  auto poolSizeStr = config.GetParameter("RawDataPoolSize");
+  if (!poolSizeStr.empty()) {
+    try {
+      auto poolSize = std::stoi(poolSizeStr);
+      if (poolSize >= 1) fRawDataPoolSize = poolSize;
+    } catch (...) {
+      std::cout << "Invalid RawDataPoolSize format, using default: "
+                << fRawDataPoolSize << std::endl;
+    }
+  }
+
+  // Get raw data queue capacity if available
+  auto queueSizeStr = config.GetParameter("RawDataQueueSize");
+  if (!queueSizeStr.empty()) {
+    try {
+      auto queueSize = std::stoi(queueSizeStr);
+      if (queueSize >= 0) fRawDataQueueSize = queueSize;
+    } catch (...) {
+      std::cout << "Invalid RawDataQueueSize format, using default: "
+                << fRawDataQueueSize << std::endl;
+    }
+  }
+
+  // Get backpressure limits and policy if available
+  auto queueMBStr = config.GetParameter("RawDataQueueMB");
+  if (!queueMBStr.empty()) {
+    try {
+      auto queueMB = std::stoi(queueMBStr);
+      if (queueMB >= 0) {
+        fBackpressure.maxQueuedBytes = static_cast<size_t>(queueMB) << 20;
+      }
+    } catch (...) {
+      std::cout << "Invalid RawDataQueueMB format, using default: "
+                << (fBackpressure.maxQueuedBytes >> 20) << std::endl;
+    }
+  }
+
+  auto maxPendingStr = config.GetParameter("MaxPendingEvents");
+  if (!maxPendingStr.empty()) {
+    try {
+      auto maxPending = std::stoi(maxPendingStr);
+      if (maxPending >= 0) fBackpressure.maxPendingEvents = maxPending;
+    } catch (...) {
+      std::cout << "Invalid MaxPendingEvents format, using default: "
+                << fBackpressure.maxPendingEvents << std::endl;
+    }
+  }
+
+  auto policyStr = config.GetParameter("BackpressurePolicy");
+  if (!policyStr.empty()) {
+    if (policyStr == "Block") {
+      fBackpressure.policy = BackpressurePolicy::Block;
+    } else if (policyStr == "DropOldest") {
+      fBackpressure.policy = BackpressurePolicy::DropOldest;
+    } else if (policyStr == "DropNewest") {
+      fBackpressure.policy = BackpressurePolicy::DropNewest;
+    } else {
+      std::cout << "Invalid BackpressurePolicy \"" << policyStr
+                << "\", using default: Block" << std::endl;
+    }
+  }
+
+  // Get coincidence filter settings if available
+  fCoincidence = CoincidenceFilter::ParseConfig(config);
+
+  // Get zero suppression thresholds if available
+  fZeroSuppression = ZeroSuppression::ParseConfig(config);
+
+  // Get pulse processing settings if available
+  fPulseProcessing = PulseProcessor::ParseConfig(config);
+
+  // Get read timeout and aggregate size control settings if available
+  fReadoutControl = ReadoutController::ParseConfig(config);
+
+  // Get online histogram settings if available
+  fHistogramConfig = OnlineHistograms::ParseConfig(config);
+  fEventWriterConfig = EventWriter::ParseConfig(config);
+  fEventStreamerConfig = EventStreamer::ParseConfig(config);
+  fEventRingConfig = EventRingPublisher::ParseConfig(config);
+  fTraceConfig = PipelineTracer::ParseConfig(config);
+
+  // Get reader/decoder thread placement if available
+  fPlacement = ThreadPlacement::ParseConfig(config);
+
+  // Get number of channel-pair decode threads if available
+  auto pairThreadsStr = config.GetParameter("ChannelPairThreads");
+  if (!pairThreadsStr.empty()) {
+    try {
+      auto pairThreads = std::stoi(pairThreadsStr);
+      if (pairThreads >= 1) fChannelPairThreads = pairThreads;
+    } catch (...) {
+      std::cout << "Invalid ChannelPairThreads format, using default: "
+                << fChannelPairThreads << std::endl;
+    }
+  }
+
+  // Get decoder output format if available
+  auto outputFormatStr = config.GetParameter("OutputFormat");
+  if (!outputFormatStr.empty()) {
+    if (outputFormatStr == "EventBatch") {
+      fOutputFormat = OutputFormat::EventBatch;
+    } else if (outputFormatStr == "EventData") {
+      fOutputFormat = OutputFormat::EventData;
+    } else {
+      std::cout << "Invalid OutputFormat \"" << outputFormatStr
+                << "\", using default: EventData" << std::endl;
+    }
+  }
+
+  // Get decoder output ordering if available
+  auto outputOrderStr = config.GetParameter("OutputOrder");
+  if (!outputOrderStr.empty()) {
+    if (outputOrderStr == "None") {
+      fOrdering.order = OutputOrder::None;
+    } else if (outputOrderStr == "Sequence") {
+      fOrdering.order = OutputOrder::Sequence;
+    } else if (outputOrderStr == "TimeStamp") {
+      fOrdering.order = OutputOrder::TimeStamp;
+    } else {
+      std::cout << "Invalid OutputOrder \"" << outputOrderStr
+                << "\", using default: None" << std::endl;
+    }
+  }
+
+  // Get reorder buffer bounds if available
+  auto reorderWindowStr = config.GetParameter("ReorderWindow");
+  if (!reorderWindowStr.empty()) {
+    try {
+      auto reorderWindow = std::stoi(reorderWindowStr);
+      if (reorderWindow >= 0) fOrdering.maxPendingAggregates = reorderWindow;
+    } catch (...) {
+      std::cout << "Invalid ReorderWindow format, using default: "
+                << fOrdering.maxPendingAggregates << std::endl;
+    }
+  }
+
+  auto reorderLatencyStr = config.GetParameter("ReorderLatencyMs");
+  if (!reorderLatencyStr.empty()) {
+    try {
+      auto reorderLatency = std::stoi(reorderLatencyStr);
+      if (reorderLatency >= 0) {
+        fOrdering.maxLatency = std::chrono::milliseconds(reorderLatency);
+      }
+    } catch (...) {
+      std::cout << "Invalid ReorderLatencyMs format, using default: "
+                << fOrdering.maxLatency.count() << std::endl;
+    }
+  }
+
+  auto mergeWindowStr = config.GetParameter("MergeWindowNs");
+  if (!mergeWindowStr.empty()) {
+    try {
+      auto mergeWindow = std::stod(mergeWindowStr);
+      if (mergeWindow >= 0.0) fOrdering.mergeWindowNs = mergeWindow;
+    } catch (...) {
+      std::cout << "Invalid MergeWindowNs format, using default: "
+                << fOrdering.mergeWindowNs << std::endl;
+    }
+  }
+
+  // Get waveform decoding mode if available
+  auto decodeWaveformsStr = config.GetParameter("DecodeWaveforms");
+  if (!decodeWaveformsStr.empty()) {
+    std::transform(decodeWaveformsStr.begin(), decodeWaveformsStr.end(),
+                   decodeWaveformsStr.begin(), ::tolower);
+    if (decodeWaveformsStr == "true" || decodeWaveformsStr == "1" ||
+        decodeWaveformsStr == "yes") {
+      fWaveformMode = WaveformMode::Decode;
+    } else if (decodeWaveformsStr == "false" || decodeWaveformsStr == "0" ||
+               decodeWaveformsStr == "no") {
+      fWaveformMode = WaveformMode::Skip;
+    } else if (decodeWaveformsStr == "lazy") {
+      fWaveformMode = WaveformMode::Lazy;
+    } else if (decodeWaveformsStr == "compact") {
+      fWaveformMode = WaveformMode::Compact;
+    } else if (decodeWaveformsStr == "compact-delta") {
+      fWaveformMode = WaveformMode::CompactDelta;
+    } else {
+      std::cout << "Invalid DecodeWaveforms \"" << decodeWaveformsStr
+                << "\", using default: true" << std::endl;
+    }
+  }
+
+  // Get configuration diffing if available
+  auto diffConfigStr = config.GetParameter("DiffConfiguration");
+  if (!diffConfigStr.empty()) {
+    std::transform(diffConfigStr.begin(), diffConfigStr.end(),
+                   diffConfigStr.begin(), ::tolower);
+    fDiffConfiguration = (diffConfigStr == "true" || diffConfigStr == "1" ||
+                          diffConfigStr == "yes");
+  }
+
+  // Get device tree cache directory if available
+  fDeviceTreeCacheDir = DeviceTreeCache::GetDefaultDirectory();
+  auto treeCacheStr = config.GetParameter("DeviceTreeCache");
+  if (!treeCacheStr.empty()) {
+    auto treeCacheLower = treeCacheStr;
+    std::transform(treeCacheLower.begin(), treeCacheLower.end(),
+                   treeCacheLower.begin(), ::tolower);
+    if (treeCacheLower == "false" || treeCacheLower == "0" ||
+        treeCacheLower == "no" || treeCacheLower == "none") {
+      fDeviceTreeCacheDir.clear();
+    } else if (treeCacheLower != "true" && treeCacheLower != "1" &&
+               treeCacheLower != "yes") {
+      fDeviceTreeCacheDir = treeCacheStr;
+    }
+  }
+
+  // Get raw data recording settings if available
+  fRawRecorderConfig.pathPrefix = config.GetParameter("RawRecordPath");
+  auto recordFileSizeStr = config.GetParameter("RawRecordFileSizeMB");
+  if (!recordFileSizeStr.empty()) {
+    try {
+      auto fileSizeMB = std::stoll(recordFileSizeStr);
+      if (fileSizeMB >= 1) {
+        fRawRecorderConfig.maxFileSize = static_cast<uint64_t>(fileSizeMB)
+                                         << 20;
+      }
+    } catch (...) {
+      std::cout << "Invalid RawRecordFileSizeMB format, using default: "
+                << (fRawRecorderConfig.maxFileSize >> 20) << std::endl;
+    }
+  }
+  auto recordOnlyStr = config.GetParameter("RawRecordOnly");
+  if (!recordOnlyStr.empty()) {
+    std::transform(recordOnlyStr.begin(), recordOnlyStr.end(),
+                   recordOnlyStr.begin(), ::tolower);
+    fRawRecordOnly = (recordOnlyStr == "true" || recordOnlyStr == "1" ||
+                      recordOnlyStr == "yes");
+  }
+
   // Get module ID if available
   auto modIdStr = config.GetParameter("ModID");
   if (!modIdStr.empty()) {
@@ -71,7 +333,7 @@ bool Digitizer1::Initialize(const ConfigurationManager &config)
 
   // Open the digitizer
   if (Open(fURL)) {
-    GetDeviceTree();
+    LoadDeviceTree();
     // std::cout << fDeviceTree.dump(2) << std::endl;
     return true;
   }
@@ -80,6 +342,8 @@ bool Digitizer1::Initialize(const ConfigurationManager &config)
 
 bool Digitizer1::Configure()
 {
+  fCancelRequested = false;
+
   // Reset the digitizer to a known state
   if (!ResetDigitizer()) {
     return false;
@@ -130,6 +394,23 @@ bool Digitizer1::StartAcquisition()
 {
   std::cout << "Start acquisition" << std::endl;
 
+  if (!ArmAcquisition()) {
+    return false;
+  }
+  return SendSWStart();
+}
+
+bool Digitizer1::ArmAcquisition()
+{
+  fCancelRequested = false;
+
+  // The reader of the previous arm must be stopped first
+  if (fReadDataThread.joinable()) {
+    std::cerr << "Acquisition already armed, call StopAcquisition() first"
+              << std::endl;
+    return false;
+  }
+
   // Decoder should already be created in ConfigureSampleRate()
   if (!fDecoder) {
     std::cerr << "Decoder not initialized - this should not happen!"
@@ -137,61 +418,122 @@ bool Digitizer1::StartAcquisition()
     return false;
   }
 
+  if (fTracer) fTracer->Reset();
+  if (fEventWriter && !fEventWriter->Start()) {
+    return false;
+  }
+  if (fEventStreamer && !fEventStreamer->Start()) {
+    return false;
+  }
+  if (fEventRing && !fEventRing->Start()) {
+    return false;
+  }
+  if (!StartRawRecorder()) {
+    return false;
+  }
+  // Without the start marker the decoder would discard the whole run
+  if (!AddRunMarker(RunMarker::kKindStart)) {
+    std::cerr << "Cannot start the run: no buffer for the start marker"
+              << std::endl;
+    return false;
+  }
+  if (fReadoutController.IsAdaptive()) {
+    AdaptEventsPerAggregate();
+  }
+  fReadoutController.BeginRun();
+
   // Start data acquisition threads
   fDataTakingFlag = true;
-  for (uint32_t i = 0; i < fNThreads; i++) {
-    fReadDataThreads.emplace_back(&Digitizer1::ReadDataThread, this);
-  }
+  fReadDataThread = std::thread(&Digitizer1::ReadDataThread, this);
+  ThreadPlacement::PlaceReader(fReadDataThread, 0, fPlacement);
+  fArmed = true;
 
   // Note: Decoder handles data conversion internally in its threads
 
-  bool status = true;
-  // Only send software start command if startmode is set to START_MODE_SW
+  // With START_MODE_SW, /cmd/ArmAcquisition starts the run immediately, so
+  // it is left to SendSWStart()
   std::string startMode;
-  if (GetParameter("/par/startmode", startMode) &&
-      startMode == "START_MODE_SW") {
-    std::cout
-        << "startmode is START_MODE_SW - waiting before sending software start "
-           "command"
-        << std::endl;
-    // Short sleep to allow other digitizers to prepare
-    std::this_thread::sleep_for(std::chrono::milliseconds(500));
-    std::cout << "Sending software start command" << std::endl;
-    status &= SendCommand("/cmd/ArmAcquisition");
-  } else {
-    std::cout << "startmode is not START_MODE_SW (" << startMode
-              << ") - skipping software start command" << std::endl;
-    // Arm the acquisition
-    status &= SendCommand("/cmd/ArmAcquisition");
+  fSWStartMode = GetParameter("/par/startmode", startMode) &&
+                 startMode == "START_MODE_SW";
+  if (fSWStartMode) {
+    std::cout << "startmode is START_MODE_SW - waiting for software start "
+                 "command"
+              << std::endl;
+    return true;
   }
 
-  return status;
+  std::cout << "startmode is not START_MODE_SW (" << startMode
+            << ") - skipping software start command" << std::endl;
+  // Arm the acquisition
+  if (!SendCommand("/cmd/ArmAcquisition")) {
+    StopReadDataThread();
+    fArmed = false;
+    return false;
+  }
+  return true;
+}
+
+bool Digitizer1::SendSWStart()
+{
+  if (!fSWStartMode) {
+    return true;
+  }
+
+  std::cout << "Sending software start command" << std::endl;
+  return SendCommand("/cmd/ArmAcquisition");
 }
 
 bool Digitizer1::StopAcquisition()
 {
+  fCancelRequested = false;
+
   std::cout << "Stop acquisition" << std::endl;
 
   auto status = SendCommand("/cmd/DisarmAcquisition");
 
-  // Wait for any remaining data
-  while (true) {
-    if (CAEN_FELib_HasData(fReadDataHandle, 100) == CAEN_FELib_Timeout) {
-      break;
-    } else {
-      std::this_thread::sleep_for(std::chrono::milliseconds(1));
-    }
-  }
+  // The reader keeps reading until the board has nothing left and then
+  // exits on its first read timeout
+  StopReadDataThread();
 
-  fDataTakingFlag = false;
+  // Close the run and wait until everything read has been decoded, so the
+  // sinks receive the last events and the statistics are final. Nothing to
+  // close if the run never started (Configure() or Arm failed)
+  if (fArmed) {
+    AddRunMarker(RunMarker::kKindStop);
+  }
+  if (fRawRecorder) {
+    fRawRecorder->Stop();
+  }
+  constexpr auto kDrainTimeout = std::chrono::seconds(5);
+  if (fArmed && fDecoder && !fDecoder->Drain(kDrainTimeout)) {
+    std::cerr << "Warning: decoder not drained within "
+              << kDrainTimeout.count() << " s" << std::endl;
+  }
+  fArmed = false;
+  if (fEventWriter) {
+    fEventWriter->Stop();
+  }
+  if (fEventStreamer) {
+    fEventStreamer->Stop();
+  }
+  if (fEventRing) {
+    fEventRing->Stop();
+  }
+  if (fTracer) {
+    fTracer->WriteRunTrace();
+  }
 
-  // Stop data acquisition threads
-  for (auto &thread : fReadDataThreads) {
-    if (thread.joinable()) {
-      thread.join();
-    }
+  if (fRawDataPool && fRawDataPool->GetExhaustedCount() > 0) {
+    std::cerr << "Warning: raw data pool was exhausted "
+              << fRawDataPool->GetExhaustedCount()
+              << " times (decoding slower than readout)" << std::endl;
+  }
+  if (fDebugFlag && fDecoder) {
+    auto queueStats = fDecoder->GetRawDataQueueStatistics();
+    std::cout << "Raw data queue high-water mark: " << queueStats.highWaterMark
+              << " (" << queueStats.pushed << " aggregates queued)"
+              << std::endl;
   }
-  fReadDataThreads.clear();
 
   // Stop EventData conversion thread
   // Decoder will stop automatically when threads join
@@ -217,6 +559,77 @@ Digitizer1::GetEventData()
   return data;
 }
 
+std::unique_ptr<EventBatch> Digitizer1::GetEventBatch()
+{
+  if (!fDecoder) {
+    std::cerr << "Warning: Decoder not initialized in GetEventBatch()"
+              << std::endl;
+    return std::make_unique<EventBatch>();
+  }
+
+  auto batch = fDecoder->GetEventBatch();
+  if (fDebugFlag && batch && !batch->Empty()) {
+    std::cout << "Retrieved " << batch->Size() << " events from Decoder"
+              << std::endl;
+  }
+  return batch;
+}
+
+std::unique_ptr<std::vector<std::unique_ptr<EventData>>>
+Digitizer1::GetEventData(std::chrono::milliseconds timeout)
+{
+  if (!fDecoder) {
+    std::this_thread::sleep_for(timeout);
+    return GetEventData();
+  }
+  return fDecoder->GetEventData(timeout);
+}
+
+std::unique_ptr<EventBatch> Digitizer1::GetEventBatch(
+    std::chrono::milliseconds timeout)
+{
+  if (!fDecoder) {
+    std::this_thread::sleep_for(timeout);
+    return GetEventBatch();
+  }
+  return fDecoder->GetEventBatch(timeout);
+}
+
+void Digitizer1::ReleaseEventBatch(std::unique_ptr<EventBatch> batch)
+{
+  if (fDecoder) fDecoder->ReleaseEventBatch(std::move(batch));
+}
+
+DigitizerStatistics Digitizer1::GetStatistics() const
+{
+  DigitizerStatistics stats;
+  fReadoutCounters.Fill(stats);
+  fReadoutController.Fill(stats);
+  if (fRawDataPool) {
+    stats.rawDataPoolExhausted = fRawDataPool->GetExhaustedCount();
+  }
+  if (fDecoder) {
+    stats.rawDataQueue = fDecoder->GetRawDataQueueStatistics();
+    stats.decoder = fDecoder->GetStatistics();
+  }
+  if (fRawRecorder) {
+    fRawRecorder->Fill(stats);
+  }
+  if (fEventWriter) {
+    fEventWriter->Fill(stats);
+  }
+  if (fEventStreamer) {
+    fEventStreamer->Fill(stats);
+  }
+  if (fEventRing) {
+    fEventRing->Fill(stats);
+  }
+  if (fTracer) {
+    fTracer->Fill(stats);
+  }
+  return stats;
+}
+
 void Digitizer1::PrintDeviceInfo()
 {
   if (fDeviceTree.empty()) {
@@ -315,6 +728,10 @@ bool Digitizer1::Open(const std::string &url)
   int err = static_cast<int>(CAEN_FELib_InternalError);
 
   for (int attempt = 1; attempt <= maxRetries; ++attempt) {
+    if (fCancelRequested) {
+      std::cout << "Open cancelled" << std::endl;
+      return false;
+    }
     std::cout << "Attempt " << attempt << " of " << maxRetries << std::endl;
 
     err = CAEN_FELib_Open(url.c_str(), &fHandle);
@@ -332,7 +749,12 @@ bool Digitizer1::Open(const std::string &url)
     // Wait before retry (except on last attempt)
     if (attempt < maxRetries) {
       std::cout << "Waiting 1 second before retry..." << std::endl;
-      std::this_thread::sleep_for(std::chrono::seconds(1));
+      auto retryTime =
+          std::chrono::steady_clock::now() + std::chrono::seconds(1);
+      while (!fCancelRequested &&
+             std::chrono::steady_clock::now() < retryTime) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
     }
   }
 
@@ -427,6 +849,52 @@ std::string Digitizer1::GetDeviceTree()
   return jsonStr;
 }
 
+bool Digitizer1::LoadDeviceTree()
+{
+  // The tree only depends on the board identity, so a cached copy can stand
+  // in for the full download
+  std::string key;
+  if (!fDeviceTreeCacheDir.empty()) {
+    key = GetDeviceTreeCacheKey();
+  }
+
+  DeviceTreeCache cache(fDeviceTreeCacheDir);
+  nlohmann::json cachedTree;
+  if (!key.empty() && cache.Load(key, cachedTree)) {
+    fDeviceTree = std::move(cachedTree);
+    DetermineFirmwareType();
+    fParameterValidator = std::make_unique<ParameterValidator>(fDeviceTree);
+    std::cout << "Device tree loaded from cache: " << cache.GetPath(key)
+              << std::endl;
+    return true;
+  }
+
+  GetDeviceTree();
+  if (fDeviceTree.is_null()) {
+    return false;
+  }
+  if (!key.empty() && !cache.Store(key, fDeviceTree)) {
+    std::cerr << "Failed to store device tree cache: " << cache.GetPath(key)
+              << std::endl;
+  }
+  return true;
+}
+
+std::string Digitizer1::GetDeviceTreeCacheKey()
+{
+  std::vector<std::string> identity;
+  for (const char *path : {"/par/modelname", "/par/serialnum",
+                           "/par/fwtype", "/par/roc_fwver",
+                           "/par/amc_fwver"}) {
+    std::string value;
+    if (!GetParameter(path, value) || value.empty()) {
+      return "";
+    }
+    identity.push_back(value);
+  }
+  return DeviceTreeCache::MakeKey(identity);
+}
+
 void Digitizer1::DetermineFirmwareType()
 {
   fFirmwareType = FirmwareType::UNKNOWN;      // Default
@@ -575,14 +1043,26 @@ bool Digitizer1::ResetDigitizer() { return SendCommand("/cmd/Reset"); }
 
 bool Digitizer1::ApplyConfiguration()
 {
-  bool status = true;
+  auto startTime = std::chrono::steady_clock::now();
+
+  // The board was just reset, so parameters left at their default are skipped
+  auto plan = ConfigurationPlanner::Plan(
+      fConfig, fDiffConfiguration ? &fDeviceTree : nullptr);
 
-  for (const auto &config : fConfig) {
-    // Only use parameters that start with '/' (CAEN digitizer paths)
-    if (!config[0].empty() && config[0][0] == '/') {
-      status &= SetParameter(config[0], config[1]);
+  bool status = true;
+  for (const auto &write : plan.writes) {
+    if (fCancelRequested) {
+      std::cout << "Configuration cancelled" << std::endl;
+      return false;
     }
+    status &= SetParameter(write[0], write[1]);
   }
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - startTime);
+  std::cout << "Applied " << plan.requested << " parameters with "
+            << plan.writes.size() << " writes (" << plan.unchanged
+            << " unchanged) in " << elapsed.count() << " ms" << std::endl;
   return status;
 }
 
@@ -615,6 +1095,13 @@ bool Digitizer1::ConfigureMaxRawDataSize()
 
   fMaxRawDataSize = std::stoi(buf);
   std::cout << "Max raw data size: " << fMaxRawDataSize << std::endl;
+
+  // Readout buffers are recycled through the pool instead of reallocated
+  fRawDataPool =
+      std::make_shared<RawDataPool>(fMaxRawDataSize, fRawDataPoolSize);
+  fReadoutController.Configure(fReadoutControl, fMaxRawDataSize);
+  std::cout << "Raw data pool: " << fRawDataPoolSize << " buffers"
+            << std::endl;
   return true;
 }
 
@@ -635,6 +1122,7 @@ bool Digitizer1::ConfigureSampleRate()
 
   // Calculate time per sample in nanoseconds: (1000 ns) / (rate in MHz)
   uint32_t timeStepNs = 1000 / adcSamplRateMHz;
+  fTimeStepNs = timeStepNs;
 
   // Create appropriate decoder based on firmware type
   if (!fDecoder) {
@@ -655,6 +1143,54 @@ bool Digitizer1::ConfigureSampleRate()
   fDecoder->SetTimeStep(timeStepNs);
   fDecoder->SetDumpFlag(fDebugFlag);
   fDecoder->SetModuleNumber(fModuleNumber);
+  fDecoder->SetRawDataPool(fRawDataPool);
+  fDecoder->SetRawDataQueueCapacity(fRawDataQueueSize);
+  fDecoder->SetBackpressure(fBackpressure);
+  fDecoder->SetCoincidence(fCoincidence);
+  fDecoder->SetZeroSuppression(fZeroSuppression);
+  fDecoder->SetPulseProcessing(fPulseProcessing);
+
+  // Online histograms are created once and survive reconfiguration
+  if (fHistogramConfig.enabled && !fHistograms) {
+    fHistograms =
+        std::make_shared<OnlineHistograms>(fHistogramConfig, fModuleNumber);
+    if (fHistogramConfig.httpPort > 0) {
+      fHistogramServer = std::make_unique<HistogramServer>();
+      fHistogramServer->Add(fHistograms);
+      fHistogramServer->Start(
+          fHistogramConfig.httpPort,
+          std::chrono::milliseconds(fHistogramConfig.updateIntervalMs));
+    }
+  }
+  fDecoder->SetHistograms(fHistograms);
+
+  // Like the histograms, the event sinks survive reconfiguration
+  if (!fEventWriterConfig.pathPrefix.empty() && !fEventWriter) {
+    fEventWriter =
+        std::make_shared<EventWriter>(fEventWriterConfig, fModuleNumber);
+  }
+  if (fEventStreamerConfig.port > 0 && !fEventStreamer) {
+    fEventStreamer =
+        std::make_shared<EventStreamer>(fEventStreamerConfig, fModuleNumber);
+  }
+  if (!fEventRingConfig.name.empty() && !fEventRing) {
+    fEventRing =
+        std::make_shared<EventRingPublisher>(fEventRingConfig, fModuleNumber);
+  }
+  EventSinks sinks;
+  if (fEventWriter) sinks.push_back(fEventWriter);
+  if (fEventStreamer) sinks.push_back(fEventStreamer);
+  if (fEventRing) sinks.push_back(fEventRing);
+  fDecoder->SetEventSinks(std::move(sinks));
+  if (fTraceConfig.enabled && !fTracer) {
+    fTracer = std::make_shared<PipelineTracer>(fTraceConfig, fModuleNumber);
+  }
+  fDecoder->SetTracer(fTracer);
+  fDecoder->SetThreadPlacement(fPlacement);
+  fDecoder->SetOutputFormat(fOutputFormat);
+  fDecoder->SetOrdering(fOrdering);
+  fDecoder->SetWaveformMode(fWaveformMode);
+  fDecoder->SetChannelPairThreads(fChannelPairThreads);
 
   std::cout << "ADC Sample Rate: " << adcSamplRateMHz << " MHz" << std::endl;
   std::cout << "Time step: " << timeStepNs << " ns per sample" << std::endl;
@@ -750,14 +1286,35 @@ nlohmann::json Digitizer1::GetReadDataFormatRAW()
 
 void Digitizer1::ReadDataThread()
 {
-  auto rawData = std::make_unique<RawData_t>(fMaxRawDataSize);
-  while (fDataTakingFlag) {
-    constexpr auto timeOut = 10;
-    auto err = ReadDataWithLock(rawData, timeOut);
+  auto handoffStart = std::chrono::steady_clock::now();
+  auto rawData = fRawDataPool->Acquire();
+  fReadoutCounters.RecordHandoff(std::chrono::steady_clock::now() -
+                                 handoffStart);
+  while (true) {
+    if (!rawData) {
+      // Pool exhausted: wait for the decoder to hand a buffer back. After
+      // StopAcquisition() the decoder may never do so (a blocked consumer),
+      // and what is left on the board is dropped
+      if (!fDataTakingFlag) break;
+      handoffStart = std::chrono::steady_clock::now();
+      rawData = fRawDataPool->Acquire();
+      fReadoutCounters.RecordHandoff(std::chrono::steady_clock::now() -
+                                     handoffStart);
+      continue;
+    }
+
+    // A read that times out after StopAcquisition() means the board is
+    // empty; the timeout is fixed or follows the read rate
+    auto readStart = std::chrono::steady_clock::now();
+    auto err = ReadData(rawData, fReadoutController.GetReadTimeoutMs());
+    handoffStart = std::chrono::steady_clock::now();
+    fReadoutCounters.RecordReadWait(handoffStart - readStart);
 
     if (err == CAEN_FELib_Success) {
       // Add data through Decoder converter ONLY
-      if (fDecoder) {
+      if (fRawRecorder) {
+        fRawRecorder->Push(std::move(rawData));
+      } else if (fDecoder) {
         auto dataType = fDecoder->AddData(std::move(rawData));
         if (fDebugFlag) {
           std::cout << "Added data to Decoder, type: "
@@ -767,27 +1324,123 @@ void Digitizer1::ReadDataThread()
         std::cerr << "Error: Decoder not available in ReadDataThread"
                   << std::endl;
       }
-      rawData = std::make_unique<RawData_t>(fMaxRawDataSize);
-    } else if (err == CAEN_FELib_Timeout) {
+      rawData = fRawDataPool->Acquire();
+      fReadoutCounters.RecordHandoff(std::chrono::steady_clock::now() -
+                                     handoffStart);
+    } else if (!fDataTakingFlag) {
+      break;  // Stopped and nothing left to read
+    } else if (err != CAEN_FELib_Timeout) {
+      // Do not spin on a failing endpoint
       std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
   }
+  fRawDataPool->Release(std::move(rawData));
+}
+
+void Digitizer1::StopReadDataThread()
+{
+  fDataTakingFlag = false;
+  if (fReadDataThread.joinable()) {
+    fReadDataThread.join();
+  }
 }
 
-int Digitizer1::ReadDataWithLock(std::unique_ptr<RawData_t> &rawData,
-                                 int timeOut)
+bool Digitizer1::AddRunMarker(uint32_t kind)
 {
-  int retCode = CAEN_FELib_Timeout;
+  if (!fRawDataPool || !fDecoder) return false;
 
-  if (fReadDataMutex.try_lock()) {
-    if (CAEN_FELib_HasData(fReadDataHandle, timeOut) == CAEN_FELib_Success) {
-      retCode =
-          CAEN_FELib_ReadData(fReadDataHandle, timeOut, rawData->data.data(),
-                              &(rawData->size), &(rawData->nEvents));
+  // Takes the next read sequence so the orderer sees no gap
+  auto marker = fRawDataPool->Acquire(std::chrono::seconds(1));
+  if (!marker) {
+    std::cerr << "Warning: no buffer for the run marker (pool exhausted)"
+              << std::endl;
+    return false;
+  }
+  RunMarker::Fill(*marker, kind, fReadSequence);
+  marker->sequence = fReadSequence++;
+
+  // Recorded like an aggregate, so a replay sees the same run boundaries
+  if (fRawRecorder) {
+    fRawRecorder->Push(std::move(marker));
+  } else {
+    fDecoder->AddData(std::move(marker));
+  }
+  return true;
+}
+
+void Digitizer1::AdaptEventsPerAggregate()
+{
+  // Board parameters only change between runs, so the rates seen in the
+  // last run size the aggregates of this one
+  std::string buf;
+  if (!GetParameter("/par/EventAggr", buf)) return;
+  uint32_t current = 0;
+  try {
+    current = std::stoul(buf);
+  } catch (...) {
+    return;
+  }
+
+  auto next = fReadoutController.RecommendEventsPerAggregate(current);
+  if (next != current &&
+      SetParameter("/par/EventAggr", std::to_string(next))) {
+    std::cout << "Events per aggregate: " << current << " -> " << next
+              << std::endl;
+    current = next;
+  }
+  fReadoutController.RecordEventsPerAggregate(current);
+}
+
+bool Digitizer1::StartRawRecorder()
+{
+  if (fRawRecorderConfig.pathPrefix.empty()) {
+    return true;
+  }
+
+  if (!fRawRecorder) {
+    fRawRecorder = std::make_unique<RawRecorder>(
+        fRawRecorderConfig, fFirmwareType, fModuleNumber);
+    fRawRecorder->SetTimeStep(fTimeStepNs);
+    fRawRecorder->SetPeekFunction(PeekBoardAggregate);
+    fRawRecorder->SetSink([this](std::unique_ptr<RawData_t> rawData) {
+      if (fRawRecordOnly) {
+        fRawDataPool->Release(std::move(rawData));
+      } else {
+        fDecoder->AddData(std::move(rawData));
+      }
+    });
+  }
+  return fRawRecorder->Start();
+}
+
+int Digitizer1::ReadData(std::unique_ptr<RawData_t> &rawData, int timeOut)
+{
+  // HasData blocks until an aggregate is ready, so no polling is needed
+  int status = CAEN_FELib_HasData(fReadDataHandle, timeOut);
+  if (status == CAEN_FELib_Success) {
+    auto readTicks = fTracer ? PipelineTracer::Now() : 0;
+    status =
+        CAEN_FELib_ReadData(fReadDataHandle, timeOut, rawData->data.data(),
+                            &(rawData->size), &(rawData->nEvents));
+    // Numbered in read order so the decoder can restore it
+    if (status == CAEN_FELib_Success) {
+      rawData->sequence = fReadSequence++;
+      if (fTracer) {
+        fTracer->Record(TraceStage::Read, rawData->sequence, readTicks,
+                        PipelineTracer::Now());
+      }
     }
-    fReadDataMutex.unlock();
   }
-  return retCode;
+
+  if (status == CAEN_FELib_Success) {
+    fReadoutCounters.RecordRead(rawData->size);
+    fReadoutController.RecordRead(rawData->size, rawData->nEvents);
+  } else if (status == CAEN_FELib_Timeout) {
+    fReadoutCounters.RecordTimeout();
+  } else {
+    fReadoutCounters.RecordError();
+  }
+  return status;
 }
 
 // EventConversionThread removed - Decoder handles conversion internally
@@ -11,11 +11,39 @@
 #include <iterator>
 #include <thread>
 
+#include "ByteSwap.hpp"
+
 namespace DELILA
 {
 namespace Digitizer
 {
 
+namespace
+{
+// Aggregate counter and first hit timestamp of a raw (big endian) aggregate
+bool PeekAggregate(const RawData_t &rawData, uint32_t &aggregateCounter,
+                   uint64_t &firstTimeStamp)
+{
+  using namespace PSD2Constants;
+  if (rawData.size < 2 * kWordSize) {
+    return false;
+  }
+
+  uint64_t words[2];
+  std::memcpy(words, rawData.data.data(), sizeof(words));
+  uint64_t header = ByteSwap::Swap64(words[0]);
+  if (((header >> Header::kTypeShift) & Header::kTypeMask) !=
+      Header::kTypeData) {
+    return false;
+  }
+
+  aggregateCounter = (header >> Header::kAggregateCounterShift) &
+                     Header::kAggregateCounterMask;
+  firstTimeStamp = ByteSwap::Swap64(words[1]) & Event::kTimeStampMask;
+  return true;
+}
+}  // namespace
+
 // ============================================================================
 // Constructor/Destructor
 // ============================================================================
@@ -34,6 +62,8 @@ Digitizer2::~Digitizer2()
 
 bool Digitizer2::Initialize(const ConfigurationManager &config)
 {
+  fCancelRequested = false;
+
   // Get URL from configuration
   fURL = config.GetParameter("URL");
   if (fURL.empty()) {
@@ -60,6 +90,235 @@ bool Digitizer2::Initialize(const ConfigurationManager &config)
     }
   }
 
+  // Get number of raw data buffers if available
+  auto poolSizeStr = config.GetParameter("RawDataPoolSize");
+  if (!poolSizeStr.empty()) {
+    try {
+      auto poolSize = std::stoi(poolSizeStr);
+      if (poolSize >= 1) fRawDataPoolSize = poolSize;
+    } catch (...) {
+      std::cout << "Invalid RawDataPoolSize format, using default: "
+                << fRawDataPoolSize << std::endl;
+    }
+  }
+
+  // Get raw data queue capacity if available
+  auto queueSizeStr = config.GetParameter("RawDataQueueSize");
+  if (!queueSizeStr.empty()) {
+    try {
+      auto queueSize = std::stoi(queueSizeStr);
+      if (queueSize >= 0) fRawDataQueueSize = queueSize;
+    } catch (...) {
+      std::cout << "Invalid RawDataQueueSize format, using default: "
+                << fRawDataQueueSize << std::endl;
+    }
+  }
+
+  // Get backpressure limits and policy if available
+  auto queueMBStr = config.GetParameter("RawDataQueueMB");
+  if (!queueMBStr.empty()) {
+    try {
+      auto queueMB = std::stoi(queueMBStr);
+      if (queueMB >= 0) {
+        fBackpressure.maxQueuedBytes = static_cast<size_t>(queueMB) << 20;
+      }
+    } catch (...) {
+      std::cout << "Invalid RawDataQueueMB format, using default: "
+                << (fBackpressure.maxQueuedBytes >> 20) << std::endl;
+    }
+  }
+
+  auto maxPendingStr = config.GetParameter("MaxPendingEvents");
+  if (!maxPendingStr.empty()) {
+    try {
+      auto maxPending = std::stoi(maxPendingStr);
+      if (maxPending >= 0) fBackpressure.maxPendingEvents = maxPending;
+    } catch (...) {
+      std::cout << "Invalid MaxPendingEvents format, using default: "
+                << fBackpressure.maxPendingEvents << std::endl;
+    }
+  }
+
+  auto policyStr = config.GetParameter("BackpressurePolicy");
+  if (!policyStr.empty()) {
+    if (policyStr == "Block") {
+      fBackpressure.policy = BackpressurePolicy::Block;
+    } else if (policyStr == "DropOldest") {
+      fBackpressure.policy = BackpressurePolicy::DropOldest;
+    } else if (policyStr == "DropNewest") {
+      fBackpressure.policy = BackpressurePolicy::DropNewest;
+    } else {
+      std::cout << "Invalid BackpressurePolicy \"" << policyStr
+                << "\", using default: Block" << std::endl;
+    }
+  }
+
+  // Get coincidence filter settings if available
+  fCoincidence = CoincidenceFilter::ParseConfig(config);
+
+  // Get zero suppression thresholds if available
+  fZeroSuppression = ZeroSuppression::ParseConfig(config);
+
+  // Get pulse processing settings if available
+  fPulseProcessing = PulseProcessor::ParseConfig(config);
+
+  // Get read timeout and aggregate size control settings if available
+  fReadoutControl = ReadoutController::ParseConfig(config);
+
+  // Get online histogram settings if available
+  fHistogramConfig = OnlineHistograms::ParseConfig(config);
+  fEventWriterConfig = EventWriter::ParseConfig(config);
+  fEventStreamerConfig = EventStreamer::ParseConfig(config);
+  fEventRingConfig = EventRingPublisher::ParseConfig(config);
+  fTraceConfig = PipelineTracer::ParseConfig(config);
+
+  // Get reader/decoder thread placement if available
+  fPlacement = ThreadPlacement::ParseConfig(config);
+
+  // Get decoder output format if available
+  auto outputFormatStr = config.GetParameter("OutputFormat");
+  if (!outputFormatStr.empty()) {
+    if (outputFormatStr == "EventBatch") {
+      fOutputFormat = OutputFormat::EventBatch;
+    } else if (outputFormatStr == "EventData") {
+      fOutputFormat = OutputFormat::EventData;
+    } else {
+      std::cout << "Invalid OutputFormat \"" << outputFormatStr
+                << "\", using default: EventData" << std::endl;
+    }
+  }
+
+  // Get byte-swap placement if available
+  auto swapOnDecodeStr = config.GetParameter("SwapOnDecode");
+  if (!swapOnDecodeStr.empty()) {
+    std::transform(swapOnDecodeStr.begin(), swapOnDecodeStr.end(),
+                   swapOnDecodeStr.begin(), ::tolower);
+    fSwapOnDecode = (swapOnDecodeStr == "true" || swapOnDecodeStr == "1" ||
+                     swapOnDecodeStr == "yes");
+  }
+
+  // Get decoder output ordering if available
+  auto outputOrderStr = config.GetParameter("OutputOrder");
+  if (!outputOrderStr.empty()) {
+    if (outputOrderStr == "None") {
+      fOrdering.order = OutputOrder::None;
+    } else if (outputOrderStr == "Sequence") {
+      fOrdering.order = OutputOrder::Sequence;
+    } else if (outputOrderStr == "TimeStamp") {
+      fOrdering.order = OutputOrder::TimeStamp;
+    } else {
+      std::cout << "Invalid OutputOrder \"" << outputOrderStr
+                << "\", using default: None" << std::endl;
+    }
+  }
+
+  // Get reorder buffer bounds if available
+  auto reorderWindowStr = config.GetParameter("ReorderWindow");
+  if (!reorderWindowStr.empty()) {
+    try {
+      auto reorderWindow = std::stoi(reorderWindowStr);
+      if (reorderWindow >= 0) fOrdering.maxPendingAggregates = reorderWindow;
+    } catch (...) {
+      std::cout << "Invalid ReorderWindow format, using default: "
+                << fOrdering.maxPendingAggregates << std::endl;
+    }
+  }
+
+  auto reorderLatencyStr = config.GetParameter("ReorderLatencyMs");
+  if (!reorderLatencyStr.empty()) {
+    try {
+      auto reorderLatency = std::stoi(reorderLatencyStr);
+      if (reorderLatency >= 0) {
+        fOrdering.maxLatency = std::chrono::milliseconds(reorderLatency);
+      }
+    } catch (...) {
+      std::cout << "Invalid ReorderLatencyMs format, using default: "
+                << fOrdering.maxLatency.count() << std::endl;
+    }
+  }
+
+  auto mergeWindowStr = config.GetParameter("MergeWindowNs");
+  if (!mergeWindowStr.empty()) {
+    try {
+      auto mergeWindow = std::stod(mergeWindowStr);
+      if (mergeWindow >= 0.0) fOrdering.mergeWindowNs = mergeWindow;
+    } catch (...) {
+      std::cout << "Invalid MergeWindowNs format, using default: "
+                << fOrdering.mergeWindowNs << std::endl;
+    }
+  }
+
+  // Get waveform decoding mode if available
+  auto decodeWaveformsStr = config.GetParameter("DecodeWaveforms");
+  if (!decodeWaveformsStr.empty()) {
+    std::transform(decodeWaveformsStr.begin(), decodeWaveformsStr.end(),
+                   decodeWaveformsStr.begin(), ::tolower);
+    if (decodeWaveformsStr == "true" || decodeWaveformsStr == "1" ||
+        decodeWaveformsStr == "yes") {
+      fWaveformMode = WaveformMode::Decode;
+    } else if (decodeWaveformsStr == "false" || decodeWaveformsStr == "0" ||
+               decodeWaveformsStr == "no") {
+      fWaveformMode = WaveformMode::Skip;
+    } else if (decodeWaveformsStr == "lazy") {
+      fWaveformMode = WaveformMode::Lazy;
+    } else if (decodeWaveformsStr == "compact") {
+      fWaveformMode = WaveformMode::Compact;
+    } else if (decodeWaveformsStr == "compact-delta") {
+      fWaveformMode = WaveformMode::CompactDelta;
+    } else {
+      std::cout << "Invalid DecodeWaveforms \"" << decodeWaveformsStr
+                << "\", using default: true" << std::endl;
+    }
+  }
+
+  // Get configuration diffing if available
+  auto diffConfigStr = config.GetParameter("DiffConfiguration");
+  if (!diffConfigStr.empty()) {
+    std::transform(diffConfigStr.begin(), diffConfigStr.end(),
+                   diffConfigStr.begin(), ::tolower);
+    fDiffConfiguration = (diffConfigStr == "true" || diffConfigStr == "1" ||
+                          diffConfigStr == "yes");
+  }
+
+  // Get device tree cache directory if available
+  fDeviceTreeCacheDir = DeviceTreeCache::GetDefaultDirectory();
+  auto treeCacheStr = config.GetParameter("DeviceTreeCache");
+  if (!treeCacheStr.empty()) {
+    auto treeCacheLower = treeCacheStr;
+    std::transform(treeCacheLower.begin(), treeCacheLower.end(),
+                   treeCacheLower.begin(), ::tolower);
+    if (treeCacheLower == "false" || treeCacheLower == "0" ||
+        treeCacheLower == "no" || treeCacheLower == "none") {
+      fDeviceTreeCacheDir.clear();
+    } else if (treeCacheLower != "true" && treeCacheLower != "1" &&
+               treeCacheLower != "yes") {
+      fDeviceTreeCacheDir = treeCacheStr;
+    }
+  }
+
+  // Get raw data recording settings if available
+  fRawRecorderConfig.pathPrefix = config.GetParameter("RawRecordPath");
+  auto recordFileSizeStr = config.GetParameter("RawRecordFileSizeMB");
+  if (!recordFileSizeStr.empty()) {
+    try {
+      auto fileSizeMB = std::stoll(recordFileSizeStr);
+      if (fileSizeMB >= 1) {
+        fRawRecorderConfig.maxFileSize = static_cast<uint64_t>(fileSizeMB)
+                                         << 20;
+      }
+    } catch (...) {
+      std::cout << "Invalid RawRecordFileSizeMB format, using default: "
+                << (fRawRecorderConfig.maxFileSize >> 20) << std::endl;
+    }
+  }
+  auto recordOnlyStr = config.GetParameter("RawRecordOnly");
+  if (!recordOnlyStr.empty()) {
+    std::transform(recordOnlyStr.begin(), recordOnlyStr.end(),
+                   recordOnlyStr.begin(), ::tolower);
+    fRawRecordOnly = (recordOnlyStr == "true" || recordOnlyStr == "1" ||
+                      recordOnlyStr == "yes");
+  }
+
   // Get module ID if available
   auto modIdStr = config.GetParameter("ModID");
   if (!modIdStr.empty()) {
@@ -83,7 +342,7 @@ bool Digitizer2::Initialize(const ConfigurationManager &config)
 
   // Open the digitizer
   if (Open(fURL)) {
-    GetDeviceTree();
+    LoadDeviceTree();
     // std::cout << fDeviceTree.dump(2) << std::endl;
     return true;
   }
@@ -92,6 +351,8 @@ bool Digitizer2::Initialize(const ConfigurationManager &config)
 
 bool Digitizer2::Configure()
 {
+  fCancelRequested = false;
+
   // Reset the digitizer to a known state
   if (!ResetDigitizer()) {
     return false;
@@ -145,13 +406,26 @@ bool Digitizer2::ResetDigitizer() { return SendCommand("/cmd/Reset"); }
 
 bool Digitizer2::ApplyConfiguration()
 {
+  auto startTime = std::chrono::steady_clock::now();
+
+  // The board was just reset, so parameters left at their default are skipped
+  auto plan = ConfigurationPlanner::Plan(
+      fConfig, fDiffConfiguration ? &fDeviceTree : nullptr);
+
   bool status = true;
-  for (const auto &config : fConfig) {
-    // Only use parameters that start with '/' (CAEN digitizer paths)
-    if (!config[0].empty() && config[0][0] == '/') {
-      status &= SetParameter(config[0], config[1]);
+  for (const auto &write : plan.writes) {
+    if (fCancelRequested) {
+      std::cout << "Configuration cancelled" << std::endl;
+      return false;
     }
+    status &= SetParameter(write[0], write[1]);
   }
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - startTime);
+  std::cout << "Applied " << plan.requested << " parameters with "
+            << plan.writes.size() << " writes (" << plan.unchanged
+            << " unchanged) in " << elapsed.count() << " ms" << std::endl;
   return status;
 }
 
@@ -184,6 +458,13 @@ bool Digitizer2::ConfigureMaxRawDataSize()
 
   fMaxRawDataSize = std::stoi(buf);
   std::cout << "Max raw data size: " << fMaxRawDataSize << std::endl;
+
+  // Readout buffers are recycled through the pool instead of reallocated
+  fRawDataPool =
+      std::make_shared<RawDataPool>(fMaxRawDataSize, fRawDataPoolSize);
+  fReadoutController.Configure(fReadoutControl, fMaxRawDataSize);
+  std::cout << "Raw data pool: " << fRawDataPoolSize << " buffers"
+            << std::endl;
   return true;
 }
 
@@ -196,6 +477,59 @@ bool Digitizer2::InitializeDataConverter()
 
   fPSD2Decoder->SetDumpFlag(fDebugFlag);
   fPSD2Decoder->SetModuleNumber(fModuleNumber);
+  fPSD2Decoder->SetRawDataPool(fRawDataPool);
+  fPSD2Decoder->SetRawDataQueueCapacity(fRawDataQueueSize);
+  fPSD2Decoder->SetBackpressure(fBackpressure);
+  fPSD2Decoder->SetCoincidence(fCoincidence);
+  fPSD2Decoder->SetZeroSuppression(fZeroSuppression);
+  fPSD2Decoder->SetPulseProcessing(fPulseProcessing);
+
+  // Online histograms are created once and survive reconfiguration
+  if (fHistogramConfig.enabled && !fHistograms) {
+    fHistograms =
+        std::make_shared<OnlineHistograms>(fHistogramConfig, fModuleNumber);
+    if (fHistogramConfig.httpPort > 0) {
+      fHistogramServer = std::make_unique<HistogramServer>();
+      fHistogramServer->Add(fHistograms);
+      fHistogramServer->Start(
+          fHistogramConfig.httpPort,
+          std::chrono::milliseconds(fHistogramConfig.updateIntervalMs));
+    }
+  }
+  fPSD2Decoder->SetHistograms(fHistograms);
+
+  // Like the histograms, the event sinks survive reconfiguration
+  if (!fEventWriterConfig.pathPrefix.empty() && !fEventWriter) {
+    fEventWriter =
+        std::make_shared<EventWriter>(fEventWriterConfig, fModuleNumber);
+  }
+  if (fEventStreamerConfig.port > 0 && !fEventStreamer) {
+    fEventStreamer =
+        std::make_shared<EventStreamer>(fEventStreamerConfig, fModuleNumber);
+  }
+  if (!fEventRingConfig.name.empty() && !fEventRing) {
+    fEventRing =
+        std::make_shared<EventRingPublisher>(fEventRingConfig, fModuleNumber);
+  }
+  EventSinks sinks;
+  if (fEventWriter) sinks.push_back(fEventWriter);
+  if (fEventStreamer) sinks.push_back(fEventStreamer);
+  if (fEventRing) sinks.push_back(fEventRing);
+  fPSD2Decoder->SetEventSinks(std::move(sinks));
+  if (fTraceConfig.enabled && !fTracer) {
+    fTracer = std::make_shared<PipelineTracer>(fTraceConfig, fModuleNumber);
+  }
+  fPSD2Decoder->SetTracer(fTracer);
+  fPSD2Decoder->SetThreadPlacement(fPlacement);
+  fPSD2Decoder->SetOutputFormat(fOutputFormat);
+  fPSD2Decoder->SetOrdering(fOrdering);
+  fPSD2Decoder->SetWaveformMode(fWaveformMode);
+  fPSD2Decoder->SetSwapOnDecode(fSwapOnDecode);
+  if (fDebugFlag) {
+    std::cout << "Byte swap kernel: " << ByteSwap::GetKernelName()
+              << (fSwapOnDecode ? " (decode threads)" : " (readout thread)")
+              << std::endl;
+  }
   return true;
 }
 
@@ -216,6 +550,7 @@ bool Digitizer2::ConfigureSampleRate()
 
   // Calculate time per sample in nanoseconds: (1000 ns) / (rate in MHz)
   uint32_t timeStepNs = 1000 / adcSamplRateMHz;
+  fTimeStepNs = timeStepNs;
   fPSD2Decoder->SetTimeStep(timeStepNs);
 
   std::cout << "ADC Sample Rate: " << adcSamplRateMHz << " MHz" << std::endl;
@@ -228,41 +563,78 @@ bool Digitizer2::StartAcquisition()
 {
   std::cout << "Start acquisition" << std::endl;
 
-  // Arm the acquisition
+  if (!ArmAcquisition()) {
+    return false;
+  }
+  return SendSWStart();
+}
 
-  // Initialize EventData storage if not already created
+bool Digitizer2::ArmAcquisition()
+{
+  fCancelRequested = false;
 
-  // Start data acquisition threads
-  fDataTakingFlag = true;
-  for (uint32_t i = 0; i < fNThreads; i++) {
-    fReadDataThreads.emplace_back(&Digitizer2::ReadDataThread, this);
+  // The reader of the previous arm must be stopped first
+  if (fReadDataThread.joinable()) {
+    std::cerr << "Acquisition already armed, call StopAcquisition() first"
+              << std::endl;
+    return false;
   }
 
-  // Start single EventData conversion thread
+  if (fTracer) fTracer->Reset();
+  if (fEventWriter && !fEventWriter->Start()) {
+    return false;
+  }
+  if (fEventStreamer && !fEventStreamer->Start()) {
+    return false;
+  }
+  if (fEventRing && !fEventRing->Start()) {
+    return false;
+  }
+  if (!StartRawRecorder()) {
+    return false;
+  }
 
-  SendCommand("/cmd/ArmAcquisition");
+  // Start data acquisition threads
+  fReadoutController.BeginRun();
+  fDataTakingFlag = true;
+  fReadDataThread = std::thread(&Digitizer2::ReadDataThread, this);
+  ThreadPlacement::PlaceReader(fReadDataThread, 0, fPlacement);
+
+  // Arm the acquisition
+  if (!SendCommand("/cmd/ArmAcquisition")) {
+    StopReadDataThread();
+    return false;
+  }
 
-  auto status = true;
   // Only send software start command if StartSource is set to SWcmd
   std::string startSource;
-  if (GetParameter("/par/StartSource", startSource) && startSource == "SWcmd") {
-    std::cout << "StartSource is SWcmd - waiting before sending software start "
-                 "command"
+  fSWStartMode =
+      GetParameter("/par/StartSource", startSource) && startSource == "SWcmd";
+  if (fSWStartMode) {
+    std::cout << "StartSource is SWcmd - waiting for software start command"
               << std::endl;
-    // Short sleep to allow other digitizers to prepare
-    std::this_thread::sleep_for(std::chrono::milliseconds(500));
-    std::cout << "Sending software start command" << std::endl;
-    status &= SendCommand("/cmd/SwStartAcquisition");
   } else {
     std::cout << "StartSource is not SWcmd (" << startSource
               << ") - skipping software start command" << std::endl;
   }
 
-  return status;
+  return true;
+}
+
+bool Digitizer2::SendSWStart()
+{
+  if (!fSWStartMode) {
+    return true;
+  }
+
+  std::cout << "Sending software start command" << std::endl;
+  return SendCommand("/cmd/SwStartAcquisition");
 }
 
 bool Digitizer2::StopAcquisition()
 {
+  fCancelRequested = false;
+
   std::cout << "Stop acquisition" << std::endl;
 
   auto status = SendCommand("/cmd/SwStopAcquisition");
@@ -271,18 +643,52 @@ bool Digitizer2::StopAcquisition()
   while (true) {
     if (CAEN_FELib_HasData(fReadDataHandle, 100) == CAEN_FELib_Timeout) {
       break;
+    } else if (fCancelRequested) {
+      // Whatever the board still holds is dropped
+      std::cout << "Drain cancelled" << std::endl;
+      status = false;
+      break;
     } else {
       std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
   }
 
-  fDataTakingFlag = false;
-
   // Stop data acquisition threads
-  for (auto &thread : fReadDataThreads) {
-    if (thread.joinable()) {
-      thread.join();
-    }
+  StopReadDataThread();
+
+  // Everything read has been queued; write it and pass it on to decoding
+  if (fRawRecorder) {
+    fRawRecorder->Stop();
+  }
+  // The sinks receive the last events and the statistics are final
+  constexpr auto kDrainTimeout = std::chrono::seconds(5);
+  if (fPSD2Decoder && !fPSD2Decoder->Drain(kDrainTimeout)) {
+    std::cerr << "Warning: decoder not drained within "
+              << kDrainTimeout.count() << " s" << std::endl;
+  }
+  if (fEventWriter) {
+    fEventWriter->Stop();
+  }
+  if (fEventStreamer) {
+    fEventStreamer->Stop();
+  }
+  if (fEventRing) {
+    fEventRing->Stop();
+  }
+  if (fTracer) {
+    fTracer->WriteRunTrace();
+  }
+
+  if (fRawDataPool && fRawDataPool->GetExhaustedCount() > 0) {
+    std::cerr << "Warning: raw data pool was exhausted "
+              << fRawDataPool->GetExhaustedCount()
+              << " times (decoding slower than readout)" << std::endl;
+  }
+  if (fDebugFlag && fPSD2Decoder) {
+    auto queueStats = fPSD2Decoder->GetRawDataQueueStatistics();
+    std::cout << "Raw data queue high-water mark: " << queueStats.highWaterMark
+              << " (" << queueStats.pushed << " aggregates queued)"
+              << std::endl;
   }
 
   // Stop EventData conversion thread
@@ -323,6 +729,67 @@ Digitizer2::GetEventData()
              : std::make_unique<std::vector<std::unique_ptr<EventData>>>();
 }
 
+std::unique_ptr<EventBatch> Digitizer2::GetEventBatch()
+{
+  return fPSD2Decoder ? fPSD2Decoder->GetEventBatch()
+                      : std::make_unique<EventBatch>();
+}
+
+std::unique_ptr<std::vector<std::unique_ptr<EventData>>>
+Digitizer2::GetEventData(std::chrono::milliseconds timeout)
+{
+  if (!fPSD2Decoder) {
+    std::this_thread::sleep_for(timeout);
+    return GetEventData();
+  }
+  return fPSD2Decoder->GetEventData(timeout);
+}
+
+std::unique_ptr<EventBatch> Digitizer2::GetEventBatch(
+    std::chrono::milliseconds timeout)
+{
+  if (!fPSD2Decoder) {
+    std::this_thread::sleep_for(timeout);
+    return GetEventBatch();
+  }
+  return fPSD2Decoder->GetEventBatch(timeout);
+}
+
+void Digitizer2::ReleaseEventBatch(std::unique_ptr<EventBatch> batch)
+{
+  if (fPSD2Decoder) fPSD2Decoder->ReleaseEventBatch(std::move(batch));
+}
+
+DigitizerStatistics Digitizer2::GetStatistics() const
+{
+  DigitizerStatistics stats;
+  fReadoutCounters.Fill(stats);
+  fReadoutController.Fill(stats);
+  if (fRawDataPool) {
+    stats.rawDataPoolExhausted = fRawDataPool->GetExhaustedCount();
+  }
+  if (fPSD2Decoder) {
+    stats.rawDataQueue = fPSD2Decoder->GetRawDataQueueStatistics();
+    stats.decoder = fPSD2Decoder->GetStatistics();
+  }
+  if (fRawRecorder) {
+    fRawRecorder->Fill(stats);
+  }
+  if (fEventWriter) {
+    fEventWriter->Fill(stats);
+  }
+  if (fEventStreamer) {
+    fEventStreamer->Fill(stats);
+  }
+  if (fEventRing) {
+    fEventRing->Fill(stats);
+  }
+  if (fTracer) {
+    fTracer->Fill(stats);
+  }
+  return stats;
+}
+
 // ============================================================================
 // Hardware Communication
 // ============================================================================
@@ -351,40 +818,106 @@ bool Digitizer2::EndpointConfigure()
   return status;
 }
 
-int Digitizer2::ReadDataWithLock(std::unique_ptr<RawData_t> &rawData,
-                                 int timeOut)
+int Digitizer2::ReadData(std::unique_ptr<RawData_t> &rawData, int timeOut)
 {
-  int retCode = CAEN_FELib_Timeout;
-
-  if (fReadDataMutex.try_lock()) {
-    if (CAEN_FELib_HasData(fReadDataHandle, timeOut) == CAEN_FELib_Success) {
-      retCode =
-          CAEN_FELib_ReadData(fReadDataHandle, timeOut, rawData->data.data(),
-                              &(rawData->size), &(rawData->nEvents));
+  // HasData blocks until an aggregate is ready, so no polling is needed
+  int status = CAEN_FELib_HasData(fReadDataHandle, timeOut);
+  if (status == CAEN_FELib_Success) {
+    auto readTicks = fTracer ? PipelineTracer::Now() : 0;
+    status =
+        CAEN_FELib_ReadData(fReadDataHandle, timeOut, rawData->data.data(),
+                            &(rawData->size), &(rawData->nEvents));
+    // Numbered in read order so the decoder can restore it
+    if (status == CAEN_FELib_Success) {
+      rawData->sequence = fReadSequence++;
+      if (fTracer) {
+        fTracer->Record(TraceStage::Read, rawData->sequence, readTicks,
+                        PipelineTracer::Now());
+      }
     }
-    fReadDataMutex.unlock();
   }
-  return retCode;
+
+  if (status == CAEN_FELib_Success) {
+    fReadoutCounters.RecordRead(rawData->size);
+    fReadoutController.RecordRead(rawData->size, rawData->nEvents);
+  } else if (status == CAEN_FELib_Timeout) {
+    fReadoutCounters.RecordTimeout();
+  } else {
+    fReadoutCounters.RecordError();
+  }
+  return status;
 }
 
 void Digitizer2::ReadDataThread()
 {
-  auto rawData = std::make_unique<RawData_t>(fMaxRawDataSize);
+  auto handoffStart = std::chrono::steady_clock::now();
+  auto rawData = fRawDataPool->Acquire();
+  fReadoutCounters.RecordHandoff(std::chrono::steady_clock::now() -
+                                 handoffStart);
   while (fDataTakingFlag) {
-    constexpr auto timeOut = 10;
-    auto err = ReadDataWithLock(rawData, timeOut);
+    if (!rawData) {
+      // Pool exhausted: wait for the decoder to hand a buffer back
+      handoffStart = std::chrono::steady_clock::now();
+      rawData = fRawDataPool->Acquire();
+      fReadoutCounters.RecordHandoff(std::chrono::steady_clock::now() -
+                                     handoffStart);
+      continue;
+    }
+
+    // The timeout bounds how long StopAcquisition() waits for the reader
+    // to notice; it is fixed or follows the read rate
+    auto readStart = std::chrono::steady_clock::now();
+    auto err = ReadData(rawData, fReadoutController.GetReadTimeoutMs());
+    handoffStart = std::chrono::steady_clock::now();
+    fReadoutCounters.RecordReadWait(handoffStart - readStart);
 
     if (err == CAEN_FELib_Success) {
       // Add data through PSD2Decoder converter ONLY
       // Data will be converted directly by PSD2Decoder
-      if (fPSD2Decoder) {
+      if (fRawRecorder) {
+        fRawRecorder->Push(std::move(rawData));
+      } else if (fPSD2Decoder) {
         fPSD2Decoder->AddData(std::move(rawData));
       }
-      rawData = std::make_unique<RawData_t>(fMaxRawDataSize);
-    } else if (err == CAEN_FELib_Timeout) {
+      rawData = fRawDataPool->Acquire();
+      fReadoutCounters.RecordHandoff(std::chrono::steady_clock::now() -
+                                     handoffStart);
+    } else if (err != CAEN_FELib_Timeout) {
+      // Do not spin on a failing endpoint
       std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
   }
+  fRawDataPool->Release(std::move(rawData));
+}
+
+void Digitizer2::StopReadDataThread()
+{
+  fDataTakingFlag = false;
+  if (fReadDataThread.joinable()) {
+    fReadDataThread.join();
+  }
+}
+
+bool Digitizer2::StartRawRecorder()
+{
+  if (fRawRecorderConfig.pathPrefix.empty()) {
+    return true;
+  }
+
+  if (!fRawRecorder) {
+    fRawRecorder = std::make_unique<RawRecorder>(
+        fRawRecorderConfig, fFirmwareType, fModuleNumber);
+    fRawRecorder->SetTimeStep(fTimeStepNs);
+    fRawRecorder->SetPeekFunction(PeekAggregate);
+    fRawRecorder->SetSink([this](std::unique_ptr<RawData_t> rawData) {
+      if (fRawRecordOnly || !fPSD2Decoder) {
+        fRawDataPool->Release(std::move(rawData));
+      } else {
+        fPSD2Decoder->AddData(std::move(rawData));
+      }
+    });
+  }
+  return fRawRecorder->Start();
 }
 
 // ============================================================================
@@ -480,6 +1013,10 @@ bool Digitizer2::Open(const std::string &url)
   int err = static_cast<int>(CAEN_FELib_InternalError);
   
   for (int attempt = 1; attempt <= maxRetries; ++attempt) {
+    if (fCancelRequested) {
+      std::cout << "Open cancelled" << std::endl;
+      return false;
+    }
     std::cout << "Attempt " << attempt << " of " << maxRetries << std::endl;
     
     err = CAEN_FELib_Open(url.c_str(), &fHandle);
@@ -496,7 +1033,12 @@ bool Digitizer2::Open(const std::string &url)
     // Wait before retry (except on last attempt)
     if (attempt < maxRetries) {
       std::cout << "Waiting 1 second before retry..." << std::endl;
-      std::this_thread::sleep_for(std::chrono::seconds(1));
+      auto retryTime =
+          std::chrono::steady_clock::now() + std::chrono::seconds(1);
+      while (!fCancelRequested &&
+             std::chrono::steady_clock::now() < retryTime) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
     }
   }
   
@@ -545,6 +1087,52 @@ std::string Digitizer2::GetDeviceTree()
   return jsonStr;
 }
 
+bool Digitizer2::LoadDeviceTree()
+{
+  // The tree only depends on the board identity, so a cached copy can stand
+  // in for the full download
+  std::string key;
+  if (!fDeviceTreeCacheDir.empty()) {
+    key = GetDeviceTreeCacheKey();
+  }
+
+  DeviceTreeCache cache(fDeviceTreeCacheDir);
+  nlohmann::json cachedTree;
+  if (!key.empty() && cache.Load(key, cachedTree)) {
+    fDeviceTree = std::move(cachedTree);
+    DetermineFirmwareType();
+    fParameterValidator = std::make_unique<ParameterValidator>(fDeviceTree);
+    std::cout << "Device tree loaded from cache: " << cache.GetPath(key)
+              << std::endl;
+    return true;
+  }
+
+  GetDeviceTree();
+  if (fDeviceTree.is_null()) {
+    return false;
+  }
+  if (!key.empty() && !cache.Store(key, fDeviceTree)) {
+    std::cerr << "Failed to store device tree cache: " << cache.GetPath(key)
+              << std::endl;
+  }
+  return true;
+}
+
+std::string Digitizer2::GetDeviceTreeCacheKey()
+{
+  std::vector<std::string> identity;
+  for (const char *path : {"/par/ModelName", "/par/SerialNum",
+                           "/par/FwType", "/par/FPGA_FwVer",
+                           "/par/CupVer"}) {
+    std::string value;
+    if (!GetParameter(path, value) || value.empty()) {
+      return "";
+    }
+    identity.push_back(value);
+  }
+  return DeviceTreeCache::MakeKey(identity);
+}
+
 void Digitizer2::DetermineFirmwareType()
 {
   fFirmwareType = FirmwareType::UNKNOWN;  // Default
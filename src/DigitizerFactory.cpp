@@ -7,6 +7,7 @@
 // Include the concrete digitizer implementations
 #include "Digitizer1.hpp"  // Dig1 implementation
 #include "Digitizer2.hpp"  // Renamed from original Digitizer class
+#include "FileReplayDigitizer.hpp"  // Replay of recorded raw data
 
 namespace DELILA
 {
@@ -21,6 +22,13 @@ std::unique_ptr<IDigitizer> DigitizerFactory::CreateDigitizer(
     throw std::runtime_error("URL parameter is required in configuration");
   }
 
+  // Recorded raw data; the firmware type comes from the file header
+  std::string lowerUrl = url;
+  std::transform(lowerUrl.begin(), lowerUrl.end(), lowerUrl.begin(), ::tolower);
+  if (lowerUrl.find("file://") == 0) {
+    return std::make_unique<FileReplayDigitizer>();
+  }
+
   // Try to get explicit type from configuration first
   std::string typeStr = config.GetParameter("Type");
   FirmwareType type = FirmwareType::UNKNOWN;
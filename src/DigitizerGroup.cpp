@@ -0,0 +1,402 @@
+#include "DigitizerGroup.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <set>
+
+#include "DigitizerFactory.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+namespace
+{
+bool EarlierEvent(const std::unique_ptr<EventData> &a,
+                  const std::unique_ptr<EventData> &b)
+{
+  return a->timeStampPs < b->timeStampPs;
+}
+}  // namespace
+
+DigitizerGroup::~DigitizerGroup()
+{
+  if (fRunning) {
+    StopAcquisition();
+  }
+}
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+bool DigitizerGroup::Initialize(const std::vector<ConfigurationManager> &configs)
+{
+  {
+    // CancelLifecycle() may look at the boards from another thread
+    std::lock_guard<std::mutex> lock(fMutex);
+    fBoards.clear();
+  }
+
+  std::vector<Board> boards;
+  boards.reserve(configs.size());
+  for (const auto &config : configs) {
+    Board board;
+    try {
+      board.digitizer = DigitizerFactory::CreateDigitizer(config);
+    } catch (const std::exception &e) {
+      std::cerr << "Failed to create digitizer: " << e.what() << std::endl;
+      return false;
+    }
+    if (!board.digitizer) {
+      std::cerr << "Failed to create digitizer for "
+                << config.GetParameter("URL") << std::endl;
+      return false;
+    }
+    board.lifecycle = std::make_unique<AsyncLifecycle>(*board.digitizer);
+    boards.push_back(std::move(board));
+  }
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fBoards = std::move(boards);
+  }
+
+  auto status = ForEachBoard("initialize", [this, &configs](size_t index) {
+    return fBoards[index].lifecycle->Initialize(configs[index],
+                                                fLifecycleTimeout);
+  });
+  if (!status) {
+    std::cerr << "Failed to initialize digitizer group" << std::endl;
+    return false;
+  }
+
+  // Merged events are told apart by module number only
+  std::set<uint8_t> modules;
+  for (const auto &board : fBoards) {
+    if (!modules.insert(board.digitizer->GetModuleNumber()).second) {
+      std::cerr << "Warning: module number "
+                << static_cast<int>(board.digitizer->GetModuleNumber())
+                << " is used by more than one digitizer (set ModID)"
+                << std::endl;
+    }
+  }
+
+  return true;
+}
+
+bool DigitizerGroup::Configure()
+{
+  auto startTime = std::chrono::steady_clock::now();
+  auto status = ForEachBoard("configure", [this](size_t index) {
+    return fBoards[index].lifecycle->Configure(fLifecycleTimeout);
+  });
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - startTime);
+  std::cout << "Configured " << fBoards.size() << " digitizers in "
+            << elapsed.count() << " ms" << std::endl;
+  return status;
+}
+
+bool DigitizerGroup::StartAcquisition()
+{
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fHeldEvents.clear();
+    fCoincidenceContext.clear();
+    fHasReleased = false;
+    fReleasedTimeStampPs = 0;
+    auto now = std::chrono::steady_clock::now();
+    for (auto &board : fBoards) {
+      board.hasData = false;
+      board.newestTimeStampPs = 0;
+      board.lastData = now;
+    }
+    fRunning = true;
+  }
+
+  // Arm everything first so no board starts before the others are ready
+  if (!ForEachBoard("arm", [this](size_t index) {
+        return fBoards[index].lifecycle->ArmAcquisition(fLifecycleTimeout);
+      })) {
+    std::cerr << "Failed to arm digitizer group" << std::endl;
+    return false;
+  }
+
+  return ForEachBoard("start", [this](size_t index) {
+    return fBoards[index].lifecycle->SendSWStart(fLifecycleTimeout);
+  });
+}
+
+bool DigitizerGroup::StopAcquisition()
+{
+  auto status = ForEachBoard("stop", [this](size_t index) {
+    return fBoards[index].lifecycle->StopAcquisition(fLifecycleTimeout);
+  });
+
+  std::lock_guard<std::mutex> lock(fMutex);
+  fRunning = false;
+  return status;
+}
+
+std::future<bool> DigitizerGroup::InitializeAsync(
+    std::vector<ConfigurationManager> configs)
+{
+  return std::async(std::launch::async,
+                    [this, configs = std::move(configs)]() {
+                      return Initialize(configs);
+                    });
+}
+
+std::future<bool> DigitizerGroup::ConfigureAsync()
+{
+  return std::async(std::launch::async, [this]() { return Configure(); });
+}
+
+std::future<bool> DigitizerGroup::StartAcquisitionAsync()
+{
+  return std::async(std::launch::async,
+                    [this]() { return StartAcquisition(); });
+}
+
+std::future<bool> DigitizerGroup::StopAcquisitionAsync()
+{
+  return std::async(std::launch::async, [this]() { return StopAcquisition(); });
+}
+
+void DigitizerGroup::SetLifecycleTimeout(std::chrono::milliseconds timeout)
+{
+  fLifecycleTimeout = timeout;
+}
+
+void DigitizerGroup::CancelLifecycle()
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  for (auto &board : fBoards) {
+    board.lifecycle->Cancel();
+  }
+}
+
+bool DigitizerGroup::ForEachBoard(
+    const char *step,
+    const std::function<std::shared_future<LifecycleResult>(size_t)> &submit)
+{
+  std::vector<std::shared_future<LifecycleResult>> results;
+  results.reserve(fBoards.size());
+  for (size_t i = 0; i < fBoards.size(); ++i) {
+    results.push_back(submit(i));
+  }
+
+  bool status = true;
+  for (size_t i = 0; i < results.size(); ++i) {
+    auto result = results[i].get();
+    if (!result.Ok()) {
+      std::cerr << "Digitizer " << i << ": " << step << " "
+                << GetLifecycleStatusName(result.status) << " after "
+                << result.elapsed.count() << " ms" << std::endl;
+      status = false;
+    }
+  }
+  return status;
+}
+
+// ============================================================================
+// Merge Configuration
+// ============================================================================
+
+void DigitizerGroup::SetMergeConfig(const GroupMergeConfig &config)
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  fConfig = config;
+}
+
+void DigitizerGroup::SetCoincidenceConfig(const CoincidenceConfig &config)
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  fCoincidence.Configure(config);
+  fCoincidenceContext.clear();
+}
+
+// ============================================================================
+// Data Access
+// ============================================================================
+
+std::unique_ptr<std::vector<std::unique_ptr<EventData>>>
+DigitizerGroup::GetEventData()
+{
+  auto data = std::make_unique<std::vector<std::unique_ptr<EventData>>>();
+
+  std::lock_guard<std::mutex> lock(fMutex);
+  PollBoardsLocked();
+  ReleaseLocked(*data);
+  return data;
+}
+
+void DigitizerGroup::PollBoardsLocked()
+{
+  auto now = std::chrono::steady_clock::now();
+  fIncoming.clear();
+
+  for (auto &board : fBoards) {
+    auto events = board.digitizer->GetEventData();
+    if (!events || events->empty()) continue;
+
+    board.hasData = true;
+    board.lastData = now;
+    for (auto &event : *events) {
+      board.newestTimeStampPs =
+          std::max(board.newestTimeStampPs, event->timeStampPs);
+      // Behind what was already released: it sorts to the front of the
+      // held events and is released out of order
+      if (fHasReleased && event->timeStampPs < fReleasedTimeStampPs) {
+        fLateCount++;
+      }
+      fIncoming.push_back(std::move(event));
+    }
+  }
+
+  if (fIncoming.empty()) return;
+
+  // Boards deliver per-aggregate sorted runs; sort the poll, then merge it
+  std::sort(fIncoming.begin(), fIncoming.end(), EarlierEvent);
+  auto middle = fHeldEvents.size();
+  fHeldEvents.insert(fHeldEvents.end(),
+                     std::make_move_iterator(fIncoming.begin()),
+                     std::make_move_iterator(fIncoming.end()));
+  std::inplace_merge(fHeldEvents.begin(), fHeldEvents.begin() + middle,
+                     fHeldEvents.end(), EarlierEvent);
+  fIncoming.clear();
+}
+
+void DigitizerGroup::ReleaseLocked(std::vector<std::unique_ptr<EventData>> &out)
+{
+  if (fHeldEvents.empty()) return;
+
+  // Watermark: the slowest active board bounds what can be released
+  auto now = std::chrono::steady_clock::now();
+  auto watermark = std::numeric_limits<uint64_t>::max();
+  bool anyActive = false;
+  bool waitingForBoard = false;
+  for (const auto &board : fBoards) {
+    if (now - board.lastData > fConfig.idleTimeout) continue;
+    anyActive = true;
+    if (!board.hasData) {
+      // Still waiting for the first data of this board
+      waitingForBoard = true;
+      break;
+    }
+    watermark = std::min(watermark, board.newestTimeStampPs);
+  }
+
+  // Hold back events newer than the watermark unless stopped or every
+  // board has gone quiet, when nothing more is expected to arrive
+  auto end = fHeldEvents.end();
+  if (fRunning && anyActive) {
+    if (waitingForBoard) return;
+    auto windowNs = fConfig.mergeWindowNs;
+    // The coincidence filter needs the hits up to windowNs past a release
+    if (fCoincidence.IsEnabled()) windowNs += fCoincidence.GetConfig().windowNs;
+    auto windowPs = static_cast<uint64_t>(windowNs * EventData::kPsPerNs);
+    if (watermark < windowPs) return;
+    auto cutoff = watermark - windowPs;
+    end = std::partition_point(
+        fHeldEvents.begin(), fHeldEvents.end(),
+        [cutoff](const std::unique_ptr<EventData> &event) {
+          return event->timeStampPs <= cutoff;
+        });
+  }
+  if (end == fHeldEvents.begin()) return;
+
+  auto newest = (*(end - 1))->timeStampPs;
+  if (fCoincidence.IsEnabled()) {
+    FilterReleaseLocked(end - fHeldEvents.begin(), out);
+  } else {
+    out.reserve(out.size() + (end - fHeldEvents.begin()));
+    out.insert(out.end(), std::make_move_iterator(fHeldEvents.begin()),
+               std::make_move_iterator(end));
+  }
+  fHeldEvents.erase(fHeldEvents.begin(), end);
+
+  fReleasedTimeStampPs = std::max(fReleasedTimeStampPs, newest);
+  fHasReleased = true;
+}
+
+void DigitizerGroup::FilterReleaseLocked(
+    size_t count, std::vector<std::unique_ptr<EventData>> &out)
+{
+  auto windowNs = fCoincidence.GetConfig().windowNs;
+
+  // Partners: the previous release's tail, the events released now and the
+  // held events within windowNs after them. A late event can break the time
+  // order here and is then only judged against its nearest neighbours.
+  auto &hits = fCoincidenceHits;
+  hits.assign(fCoincidenceContext.begin(), fCoincidenceContext.end());
+  auto first = hits.size();
+  auto limit = fHeldEvents[count - 1]->timeStampNs + windowNs;
+  for (size_t i = 0; i < fHeldEvents.size(); ++i) {
+    const auto &event = *fHeldEvents[i];
+    if (i >= count && event.timeStampNs > limit) break;
+    hits.push_back({event.timeStampNs, event.module, event.channel});
+  }
+  fCoincidence.Select(hits, first, first + count, fCoincidenceKeep);
+
+  for (size_t i = 0; i < count; ++i) {
+    if (fCoincidenceKeep[i]) {
+      out.push_back(std::move(fHeldEvents[i]));
+    } else {
+      fCoincidenceRejected++;
+    }
+  }
+
+  auto newest = hits[first + count - 1].timeStampNs;
+  fCoincidenceContext.clear();
+  for (size_t i = 0; i < first + count; ++i) {
+    if (newest - hits[i].timeStampNs <= windowNs) {
+      fCoincidenceContext.push_back(hits[i]);
+    }
+  }
+}
+
+// ============================================================================
+// Board Access and Information
+// ============================================================================
+
+IDigitizer *DigitizerGroup::GetDigitizer(size_t index)
+{
+  if (index >= fBoards.size()) return nullptr;
+  return fBoards[index].digitizer.get();
+}
+
+IDigitizer *DigitizerGroup::FindModule(uint8_t moduleNumber)
+{
+  for (auto &board : fBoards) {
+    if (board.digitizer->GetModuleNumber() == moduleNumber) {
+      return board.digitizer.get();
+    }
+  }
+  return nullptr;
+}
+
+uint64_t DigitizerGroup::GetLateCount() const
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  return fLateCount;
+}
+
+uint64_t DigitizerGroup::GetCoincidenceRejectedCount() const
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  return fCoincidenceRejected;
+}
+
+size_t DigitizerGroup::GetHeldCount() const
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  return fHeldEvents.size();
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
@@ -0,0 +1,185 @@
+#include "DigitizerStatistics.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+// ============================================================================
+// LatencyHistogram
+// ============================================================================
+
+size_t LatencyHistogram::GetBucket(uint64_t ns)
+{
+  uint64_t us = ns / 1000;
+  size_t bucket = 0;
+  while (us > 0 && bucket < kNumBuckets - 1) {
+    us >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+// ============================================================================
+// ReadoutCounters
+// ============================================================================
+
+void ReadoutCounters::Fill(DigitizerStatistics &stats) const
+{
+  stats.bytesRead = fBytesRead.load(std::memory_order_relaxed);
+  stats.aggregatesRead = fAggregatesRead.load(std::memory_order_relaxed);
+  stats.readTimeouts = fReadTimeouts.load(std::memory_order_relaxed);
+  stats.readErrors = fReadErrors.load(std::memory_order_relaxed);
+  stats.readWaitNs = fReadWaitNs.load(std::memory_order_relaxed);
+  stats.handoffNs = fHandoffNs.load(std::memory_order_relaxed);
+}
+
+// ============================================================================
+// DecoderCounters
+// ============================================================================
+
+DecoderCounters::DecoderCounters()
+    : fAggregatesDecoded(0),
+      fEventsDecoded(0),
+      fDiscardedBuffers(0),
+      fDecodeErrors(0),
+      fCounterDiscontinuities(0),
+      fDroppedAggregates(0),
+      fDroppedBytes(0),
+      fDroppedEvents(0),
+      fBackpressureWaits(0),
+      fCoincidenceRejected(0),
+      fEventsSuppressed(0),
+      fSortTimeNs(0),
+      fLatencyTotalNs(0),
+      fLatencyMaxNs(0)
+{
+  for (auto &count : fEventsPerChannel) count.store(0);
+  for (auto &count : fSuppressedPerChannel) count.store(0);
+  for (auto &count : fLatencyCounts) count.store(0);
+  for (auto &count : fSortCounts) count.store(0);
+}
+
+void DecoderCounters::RecordAggregate(
+    std::chrono::steady_clock::duration decodeTime)
+{
+  auto ns = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(decodeTime)
+          .count());
+
+  fAggregatesDecoded.fetch_add(1, std::memory_order_relaxed);
+  fLatencyCounts[LatencyHistogram::GetBucket(ns)].fetch_add(
+      1, std::memory_order_relaxed);
+  fLatencyTotalNs.fetch_add(ns, std::memory_order_relaxed);
+
+  auto max = fLatencyMaxNs.load(std::memory_order_relaxed);
+  while (ns > max && !fLatencyMaxNs.compare_exchange_weak(
+                         max, ns, std::memory_order_relaxed)) {
+  }
+}
+
+void DecoderCounters::RecordSort(SortMethod method,
+                                 std::chrono::steady_clock::duration sortTime)
+{
+  fSortCounts[static_cast<size_t>(method)].fetch_add(
+      1, std::memory_order_relaxed);
+  fSortTimeNs.fetch_add(
+      static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(sortTime)
+              .count()),
+      std::memory_order_relaxed);
+}
+
+void DecoderCounters::RecordEvents(
+    const std::vector<std::unique_ptr<EventData>> &events)
+{
+  std::array<uint64_t, DecoderStatistics::kMaxChannels> counts{};
+  for (const auto &event : events) {
+    if (event->channel < DecoderStatistics::kMaxChannels) {
+      counts[event->channel]++;
+    }
+  }
+  AddChannelCounts(counts, events.size());
+}
+
+void DecoderCounters::RecordEvents(const EventBatch &batch)
+{
+  std::array<uint64_t, DecoderStatistics::kMaxChannels> counts{};
+  for (auto channel : batch.channel) {
+    if (channel < DecoderStatistics::kMaxChannels) counts[channel]++;
+  }
+  AddChannelCounts(counts, batch.Size());
+}
+
+void DecoderCounters::AddChannelCounts(
+    const std::array<uint64_t, DecoderStatistics::kMaxChannels> &counts,
+    uint64_t total)
+{
+  if (total == 0) return;
+  fEventsDecoded.fetch_add(total, std::memory_order_relaxed);
+  for (size_t ch = 0; ch < counts.size(); ++ch) {
+    if (counts[ch] > 0) {
+      fEventsPerChannel[ch].fetch_add(counts[ch], std::memory_order_relaxed);
+    }
+  }
+}
+
+void DecoderCounters::RecordSuppressed(
+    const std::array<uint64_t, DecoderStatistics::kMaxChannels> &counts)
+{
+  uint64_t total = 0;
+  for (size_t ch = 0; ch < counts.size(); ++ch) {
+    if (counts[ch] > 0) {
+      fSuppressedPerChannel[ch].fetch_add(counts[ch],
+                                          std::memory_order_relaxed);
+      total += counts[ch];
+    }
+  }
+  if (total > 0) fEventsSuppressed.fetch_add(total, std::memory_order_relaxed);
+}
+
+DecoderStatistics DecoderCounters::Snapshot() const
+{
+  DecoderStatistics stats;
+  stats.aggregatesDecoded = fAggregatesDecoded.load(std::memory_order_relaxed);
+  stats.eventsDecoded = fEventsDecoded.load(std::memory_order_relaxed);
+  for (size_t ch = 0; ch < stats.eventsPerChannel.size(); ++ch) {
+    stats.eventsPerChannel[ch] =
+        fEventsPerChannel[ch].load(std::memory_order_relaxed);
+  }
+  stats.discardedBuffers = fDiscardedBuffers.load(std::memory_order_relaxed);
+  stats.decodeErrors = fDecodeErrors.load(std::memory_order_relaxed);
+  stats.counterDiscontinuities =
+      fCounterDiscontinuities.load(std::memory_order_relaxed);
+  stats.droppedAggregates = fDroppedAggregates.load(std::memory_order_relaxed);
+  stats.droppedBytes = fDroppedBytes.load(std::memory_order_relaxed);
+  stats.droppedEvents = fDroppedEvents.load(std::memory_order_relaxed);
+  stats.backpressureWaits = fBackpressureWaits.load(std::memory_order_relaxed);
+  stats.coincidenceRejected =
+      fCoincidenceRejected.load(std::memory_order_relaxed);
+  stats.eventsSuppressed = fEventsSuppressed.load(std::memory_order_relaxed);
+  for (size_t ch = 0; ch < stats.suppressedPerChannel.size(); ++ch) {
+    stats.suppressedPerChannel[ch] =
+        fSuppressedPerChannel[ch].load(std::memory_order_relaxed);
+  }
+  stats.sortSkipped =
+      fSortCounts[static_cast<size_t>(SortMethod::None)].load(
+          std::memory_order_relaxed);
+  stats.sortMerged = fSortCounts[static_cast<size_t>(SortMethod::Merge)].load(
+      std::memory_order_relaxed);
+  stats.sortRadix = fSortCounts[static_cast<size_t>(SortMethod::Radix)].load(
+      std::memory_order_relaxed);
+  stats.sortTimeNs = fSortTimeNs.load(std::memory_order_relaxed);
+
+  auto &latency = stats.decodeLatency;
+  for (size_t i = 0; i < latency.counts.size(); ++i) {
+    latency.counts[i] = fLatencyCounts[i].load(std::memory_order_relaxed);
+    latency.entries += latency.counts[i];
+  }
+  latency.totalNs = fLatencyTotalNs.load(std::memory_order_relaxed);
+  latency.maxNs = fLatencyMaxNs.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
@@ -0,0 +1,313 @@
+#include "EventBatch.hpp"
+
+#include <algorithm>
+
+#include "EventSorter.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+// ============================================================================
+// Size Management
+// ============================================================================
+
+void EventBatch::Clear()
+{
+  timeStampNs.clear();
+  timeStampPs.clear();
+  energy.clear();
+  energyShort.clear();
+  module.clear();
+  channel.clear();
+  flags.clear();
+  pulseFeatures.clear();
+
+  waveformOffset.clear();
+  waveformSize.clear();
+  waveformInfo.clear();
+  analogProbe1.clear();
+  analogProbe2.clear();
+  digitalProbe1.clear();
+  digitalProbe2.clear();
+  digitalProbe3.clear();
+  digitalProbe4.clear();
+
+  packedWaveformOffset.clear();
+  packedWaveformSize.clear();
+  packedWaveformInfo.clear();
+  packedWaveform.clear();
+}
+
+void EventBatch::Reserve(size_t nEvents, size_t nSamples)
+{
+  timeStampNs.reserve(nEvents);
+  timeStampPs.reserve(nEvents);
+  energy.reserve(nEvents);
+  energyShort.reserve(nEvents);
+  module.reserve(nEvents);
+  channel.reserve(nEvents);
+  flags.reserve(nEvents);
+  pulseFeatures.reserve(nEvents);
+
+  waveformOffset.reserve(nEvents);
+  waveformSize.reserve(nEvents);
+  waveformInfo.reserve(nEvents);
+  packedWaveformOffset.reserve(nEvents);
+  packedWaveformSize.reserve(nEvents);
+  packedWaveformInfo.reserve(nEvents);
+  if (nSamples > 0) {
+    analogProbe1.reserve(nSamples);
+    analogProbe2.reserve(nSamples);
+    digitalProbe1.reserve(nSamples);
+    digitalProbe2.reserve(nSamples);
+    digitalProbe3.reserve(nSamples);
+    digitalProbe4.reserve(nSamples);
+  }
+}
+
+// ============================================================================
+// Filling
+// ============================================================================
+
+void EventBatch::Append(const EventData &event)
+{
+  timeStampNs.push_back(event.timeStampNs);
+  timeStampPs.push_back(event.timeStampPs);
+  energy.push_back(event.energy);
+  energyShort.push_back(event.energyShort);
+  module.push_back(event.module);
+  channel.push_back(event.channel);
+  flags.push_back(event.flags);
+  pulseFeatures.push_back(event.pulseFeatures);
+
+  WaveformInfo info;
+  info.timeResolution = event.timeResolution;
+  info.analogProbe1Type = event.analogProbe1Type;
+  info.analogProbe2Type = event.analogProbe2Type;
+  info.digitalProbe1Type = event.digitalProbe1Type;
+  info.digitalProbe2Type = event.digitalProbe2Type;
+  info.digitalProbe3Type = event.digitalProbe3Type;
+  info.digitalProbe4Type = event.digitalProbe4Type;
+  info.downSampleFactor = event.downSampleFactor;
+  waveformInfo.push_back(info);
+
+  packedWaveformOffset.push_back(packedWaveform.size());
+  packedWaveformSize.push_back(
+      static_cast<uint32_t>(event.packedWaveform.size()));
+  packedWaveformInfo.push_back(event.packedWaveformInfo);
+  packedWaveform.insert(packedWaveform.end(), event.packedWaveform.begin(),
+                        event.packedWaveform.end());
+
+  const size_t nSamples = event.waveformSize;
+  waveformOffset.push_back(analogProbe1.size());
+  waveformSize.push_back(static_cast<uint32_t>(nSamples));
+  if (nSamples == 0) return;
+
+  analogProbe1.insert(analogProbe1.end(), event.analogProbe1.begin(),
+                      event.analogProbe1.begin() + nSamples);
+  analogProbe2.insert(analogProbe2.end(), event.analogProbe2.begin(),
+                      event.analogProbe2.begin() + nSamples);
+  digitalProbe1.insert(digitalProbe1.end(), event.digitalProbe1.begin(),
+                       event.digitalProbe1.begin() + nSamples);
+  digitalProbe2.insert(digitalProbe2.end(), event.digitalProbe2.begin(),
+                       event.digitalProbe2.begin() + nSamples);
+  digitalProbe3.insert(digitalProbe3.end(), event.digitalProbe3.begin(),
+                       event.digitalProbe3.begin() + nSamples);
+  digitalProbe4.insert(digitalProbe4.end(), event.digitalProbe4.begin(),
+                       event.digitalProbe4.begin() + nSamples);
+}
+
+void EventBatch::Append(const EventBatch &other, size_t index)
+{
+  timeStampNs.push_back(other.timeStampNs[index]);
+  timeStampPs.push_back(other.timeStampPs[index]);
+  energy.push_back(other.energy[index]);
+  energyShort.push_back(other.energyShort[index]);
+  module.push_back(other.module[index]);
+  channel.push_back(other.channel[index]);
+  flags.push_back(other.flags[index]);
+  pulseFeatures.push_back(other.pulseFeatures[index]);
+  waveformInfo.push_back(other.waveformInfo[index]);
+
+  const size_t packedBegin = other.packedWaveformOffset[index];
+  const size_t packedSize = other.packedWaveformSize[index];
+  packedWaveformOffset.push_back(packedWaveform.size());
+  packedWaveformSize.push_back(static_cast<uint32_t>(packedSize));
+  packedWaveformInfo.push_back(other.packedWaveformInfo[index]);
+  packedWaveform.insert(packedWaveform.end(),
+                        other.packedWaveform.begin() + packedBegin,
+                        other.packedWaveform.begin() + packedBegin + packedSize);
+
+  const size_t nSamples = other.waveformSize[index];
+  waveformOffset.push_back(analogProbe1.size());
+  waveformSize.push_back(static_cast<uint32_t>(nSamples));
+  if (nSamples == 0) return;
+
+  const size_t begin = other.waveformOffset[index];
+  const size_t end = begin + nSamples;
+  analogProbe1.insert(analogProbe1.end(), other.analogProbe1.begin() + begin,
+                      other.analogProbe1.begin() + end);
+  analogProbe2.insert(analogProbe2.end(), other.analogProbe2.begin() + begin,
+                      other.analogProbe2.begin() + end);
+  digitalProbe1.insert(digitalProbe1.end(), other.digitalProbe1.begin() + begin,
+                       other.digitalProbe1.begin() + end);
+  digitalProbe2.insert(digitalProbe2.end(), other.digitalProbe2.begin() + begin,
+                       other.digitalProbe2.begin() + end);
+  digitalProbe3.insert(digitalProbe3.end(), other.digitalProbe3.begin() + begin,
+                       other.digitalProbe3.begin() + end);
+  digitalProbe4.insert(digitalProbe4.end(), other.digitalProbe4.begin() + begin,
+                       other.digitalProbe4.begin() + end);
+}
+
+void EventBatch::Append(const EventBatch &other)
+{
+  if (other.Empty()) return;
+
+  // Whole-column appends, only the waveform offsets need rebasing
+  const size_t sampleBase = analogProbe1.size();
+  const size_t packedBase = packedWaveform.size();
+  const size_t eventBase = Size();
+
+  timeStampNs.insert(timeStampNs.end(), other.timeStampNs.begin(),
+                     other.timeStampNs.end());
+  timeStampPs.insert(timeStampPs.end(), other.timeStampPs.begin(),
+                     other.timeStampPs.end());
+  energy.insert(energy.end(), other.energy.begin(), other.energy.end());
+  energyShort.insert(energyShort.end(), other.energyShort.begin(),
+                     other.energyShort.end());
+  module.insert(module.end(), other.module.begin(), other.module.end());
+  channel.insert(channel.end(), other.channel.begin(), other.channel.end());
+  flags.insert(flags.end(), other.flags.begin(), other.flags.end());
+  pulseFeatures.insert(pulseFeatures.end(), other.pulseFeatures.begin(),
+                       other.pulseFeatures.end());
+
+  waveformSize.insert(waveformSize.end(), other.waveformSize.begin(),
+                      other.waveformSize.end());
+  waveformInfo.insert(waveformInfo.end(), other.waveformInfo.begin(),
+                      other.waveformInfo.end());
+  waveformOffset.insert(waveformOffset.end(), other.waveformOffset.begin(),
+                        other.waveformOffset.end());
+  if (sampleBase > 0) {
+    for (size_t i = eventBase; i < waveformOffset.size(); ++i) {
+      waveformOffset[i] += sampleBase;
+    }
+  }
+
+  analogProbe1.insert(analogProbe1.end(), other.analogProbe1.begin(),
+                      other.analogProbe1.end());
+  analogProbe2.insert(analogProbe2.end(), other.analogProbe2.begin(),
+                      other.analogProbe2.end());
+  digitalProbe1.insert(digitalProbe1.end(), other.digitalProbe1.begin(),
+                       other.digitalProbe1.end());
+  digitalProbe2.insert(digitalProbe2.end(), other.digitalProbe2.begin(),
+                       other.digitalProbe2.end());
+  digitalProbe3.insert(digitalProbe3.end(), other.digitalProbe3.begin(),
+                       other.digitalProbe3.end());
+  digitalProbe4.insert(digitalProbe4.end(), other.digitalProbe4.begin(),
+                       other.digitalProbe4.end());
+
+  packedWaveformSize.insert(packedWaveformSize.end(),
+                            other.packedWaveformSize.begin(),
+                            other.packedWaveformSize.end());
+  packedWaveformInfo.insert(packedWaveformInfo.end(),
+                            other.packedWaveformInfo.begin(),
+                            other.packedWaveformInfo.end());
+  packedWaveformOffset.insert(packedWaveformOffset.end(),
+                              other.packedWaveformOffset.begin(),
+                              other.packedWaveformOffset.end());
+  if (packedBase > 0) {
+    for (size_t i = eventBase; i < packedWaveformOffset.size(); ++i) {
+      packedWaveformOffset[i] += packedBase;
+    }
+  }
+  packedWaveform.insert(packedWaveform.end(), other.packedWaveform.begin(),
+                        other.packedWaveform.end());
+}
+
+void EventBatch::SortByTimeStamp()
+{
+  EventBatch scratch;
+  SortByTimeStamp(scratch);
+}
+
+void EventBatch::SortByTimeStamp(EventBatch &scratch)
+{
+  EventSorter::Sort(*this, scratch);
+}
+
+// ============================================================================
+// Conversion
+// ============================================================================
+
+EventData EventBatch::GetEvent(size_t index) const
+{
+  const size_t nSamples = waveformSize[index];
+  EventData event(nSamples);
+
+  event.timeStampNs = timeStampNs[index];
+  event.timeStampPs = timeStampPs[index];
+  event.energy = energy[index];
+  event.energyShort = energyShort[index];
+  event.module = module[index];
+  event.channel = channel[index];
+  event.flags = flags[index];
+  event.pulseFeatures = pulseFeatures[index];
+
+  const auto &info = waveformInfo[index];
+  event.timeResolution = info.timeResolution;
+  event.analogProbe1Type = info.analogProbe1Type;
+  event.analogProbe2Type = info.analogProbe2Type;
+  event.digitalProbe1Type = info.digitalProbe1Type;
+  event.digitalProbe2Type = info.digitalProbe2Type;
+  event.digitalProbe3Type = info.digitalProbe3Type;
+  event.digitalProbe4Type = info.digitalProbe4Type;
+  event.downSampleFactor = info.downSampleFactor;
+
+  if (nSamples > 0) {
+    const size_t begin = waveformOffset[index];
+    std::copy_n(analogProbe1.begin() + begin, nSamples,
+                event.analogProbe1.begin());
+    std::copy_n(analogProbe2.begin() + begin, nSamples,
+                event.analogProbe2.begin());
+    std::copy_n(digitalProbe1.begin() + begin, nSamples,
+                event.digitalProbe1.begin());
+    std::copy_n(digitalProbe2.begin() + begin, nSamples,
+                event.digitalProbe2.begin());
+    std::copy_n(digitalProbe3.begin() + begin, nSamples,
+                event.digitalProbe3.begin());
+    std::copy_n(digitalProbe4.begin() + begin, nSamples,
+                event.digitalProbe4.begin());
+  }
+
+  const size_t packedSize = packedWaveformSize[index];
+  if (packedSize > 0) {
+    const size_t begin = packedWaveformOffset[index];
+    event.packedWaveform.assign(packedWaveform.begin() + begin,
+                                packedWaveform.begin() + begin + packedSize);
+    event.packedWaveformInfo = packedWaveformInfo[index];
+  }
+
+  return event;
+}
+
+WaveformView EventBatch::GetWaveform(size_t index) const
+{
+  WaveformView view;
+  const size_t nSamples = waveformSize[index];
+  if (nSamples == 0) return view;
+
+  const size_t begin = waveformOffset[index];
+  view.size = nSamples;
+  view.analogProbe1 = analogProbe1.data() + begin;
+  view.analogProbe2 = analogProbe2.data() + begin;
+  view.digitalProbe1 = digitalProbe1.data() + begin;
+  view.digitalProbe2 = digitalProbe2.data() + begin;
+  view.digitalProbe3 = digitalProbe3.data() + begin;
+  view.digitalProbe4 = digitalProbe4.data() + begin;
+  return view;
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
@@ -0,0 +1,51 @@
+#include "EventBatchPool.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+EventBatchPool::EventBatchPool(size_t maxFreeBatches)
+    : fMaxFreeBatches(maxFreeBatches)
+{
+  fFreeBatches.reserve(fMaxFreeBatches);
+}
+
+std::unique_ptr<EventBatch> EventBatchPool::Acquire()
+{
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    if (!fFreeBatches.empty()) {
+      auto batch = std::move(fFreeBatches.back());
+      fFreeBatches.pop_back();
+      return batch;
+    }
+  }
+  return std::make_unique<EventBatch>();
+}
+
+void EventBatchPool::Release(std::unique_ptr<EventBatch> batch)
+{
+  if (!batch) return;
+
+  // Clear outside the lock, it only resets sizes
+  batch->Clear();
+
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    if (fFreeBatches.size() < fMaxFreeBatches) {
+      fFreeBatches.push_back(std::move(batch));
+      return;
+    }
+  }
+  // Free list is full, the batch is destroyed here outside the lock
+}
+
+size_t EventBatchPool::GetFreeCount() const
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  return fFreeBatches.size();
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
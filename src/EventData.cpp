@@ -3,6 +3,9 @@
 #include <algorithm>
 #include <iostream>
 
+#include "WaveformCodec.hpp"
+#include "WaveformUnpack.hpp"
+
 namespace DELILA
 {
 namespace Digitizer
@@ -11,6 +14,7 @@ namespace Digitizer
 // Constructor
 EventData::EventData(size_t waveformSize)
     : timeStampNs(0.0),
+      timeStampPs(0),
       waveformSize(0),
       energy(0),
       energyShort(0),
@@ -46,6 +50,7 @@ EventData &EventData::operator=(const EventData &other)
 // Move constructor
 EventData::EventData(EventData &&other) noexcept
     : timeStampNs(other.timeStampNs),
+      timeStampPs(other.timeStampPs),
       waveformSize(other.waveformSize),
       analogProbe1(std::move(other.analogProbe1)),
       analogProbe2(std::move(other.analogProbe2)),
@@ -65,10 +70,14 @@ EventData::EventData(EventData &&other) noexcept
       digitalProbe3Type(other.digitalProbe3Type),
       digitalProbe4Type(other.digitalProbe4Type),
       downSampleFactor(other.downSampleFactor),
-      flags(other.flags)
+      flags(other.flags),
+      packedWaveform(std::move(other.packedWaveform)),
+      packedWaveformInfo(other.packedWaveformInfo),
+      pulseFeatures(other.pulseFeatures)
 {
   // Reset other object
   other.timeStampNs = 0.0;
+  other.timeStampPs = 0;
   other.waveformSize = 0;
   other.energy = 0;
   other.energyShort = 0;
@@ -83,6 +92,8 @@ EventData::EventData(EventData &&other) noexcept
   other.digitalProbe4Type = 0;
   other.downSampleFactor = 0;
   other.flags = 0;
+  other.packedWaveformInfo = PackedWaveformInfo();
+  other.pulseFeatures = PulseFeatures();
 }
 
 // Move assignment operator
@@ -91,6 +102,7 @@ EventData &EventData::operator=(EventData &&other) noexcept
   if (this != &other) {
     // Move public members
     timeStampNs = other.timeStampNs;
+    timeStampPs = other.timeStampPs;
     waveformSize = other.waveformSize;
     analogProbe1 = std::move(other.analogProbe1);
     analogProbe2 = std::move(other.analogProbe2);
@@ -111,9 +123,13 @@ EventData &EventData::operator=(EventData &&other) noexcept
     digitalProbe4Type = other.digitalProbe4Type;
     downSampleFactor = other.downSampleFactor;
     flags = other.flags;
+    packedWaveform = std::move(other.packedWaveform);
+    packedWaveformInfo = other.packedWaveformInfo;
+    pulseFeatures = other.pulseFeatures;
 
     // Reset other object
     other.timeStampNs = 0.0;
+    other.timeStampPs = 0;
     other.waveformSize = 0;
     other.energy = 0;
     other.energyShort = 0;
@@ -128,6 +144,8 @@ EventData &EventData::operator=(EventData &&other) noexcept
     other.digitalProbe4Type = 0;
     other.downSampleFactor = 0;
     other.flags = 0;
+    other.packedWaveformInfo = PackedWaveformInfo();
+    other.pulseFeatures = PulseFeatures();
   }
   return *this;
 }
@@ -147,6 +165,56 @@ void EventData::ResizeWaveform(size_t size)
 
 void EventData::ClearWaveform() { ResizeWaveform(0); }
 
+bool EventData::UnpackWaveform()
+{
+  if (packedWaveform.empty()) return false;
+
+  const auto &info = packedWaveformInfo;
+  ResizeWaveform(info.nSamples);
+  const auto out = WaveformUnpack::ForEvent(*this);
+  const size_t nWords = packedWaveform.size() / sizeof(uint32_t);
+
+  if (info.format == PackedWaveformInfo::Format::PSD2) {
+    // One 32-bit point per half 64-bit word
+    WaveformUnpack::UnpackPSD2(
+        packedWaveform.data(), std::min<size_t>(nWords, info.nSamples),
+        info.ap1Signed, info.ap2Signed, info.ap1MulFactor, info.ap2MulFactor,
+        out);
+  } else if (info.format == PackedWaveformInfo::Format::Dig1) {
+    WaveformUnpack::UnpackDig1(packedWaveform.data(), nWords, info.nSamples,
+                               info.dualTrace, out);
+  } else if (info.format == PackedWaveformInfo::Format::Compact) {
+    if (!WaveformCodec::Decode(packedWaveform.data(), packedWaveform.size(),
+                               info.nSamples, out)) {
+      ClearWaveform();
+    }
+  }
+
+  packedWaveform.clear();
+  packedWaveformInfo = PackedWaveformInfo();
+  return true;
+}
+
+bool EventData::PackWaveform(bool delta)
+{
+  if (waveformSize == 0 || HasPackedWaveform()) return false;
+
+  WaveformCodec::Encode(*this, delta, packedWaveform);
+  packedWaveformInfo = PackedWaveformInfo();
+  packedWaveformInfo.format = PackedWaveformInfo::Format::Compact;
+  packedWaveformInfo.nSamples = static_cast<uint32_t>(waveformSize);
+
+  // Give the memory back rather than just the size
+  waveformSize = 0;
+  std::vector<int32_t>().swap(analogProbe1);
+  std::vector<int32_t>().swap(analogProbe2);
+  std::vector<uint8_t>().swap(digitalProbe1);
+  std::vector<uint8_t>().swap(digitalProbe2);
+  std::vector<uint8_t>().swap(digitalProbe3);
+  std::vector<uint8_t>().swap(digitalProbe4);
+  return true;
+}
+
 // ============================================================================
 // Display Methods
 // ============================================================================
@@ -155,6 +223,7 @@ void EventData::Print() const
 {
   std::cout << "\n=== Event Data ===" << std::endl;
   std::cout << "Timestamp (ns): " << timeStampNs << std::endl;
+  std::cout << "Timestamp (ps): " << timeStampPs << std::endl;
   std::cout << "Module: " << static_cast<int>(module) << std::endl;
   std::cout << "Channel: " << static_cast<int>(channel) << std::endl;
   std::cout << "Energy: " << energy << std::endl;
@@ -319,6 +388,7 @@ void EventData::CopyFrom(const EventData &other)
 {
   // Copy all public members
   timeStampNs = other.timeStampNs;
+  timeStampPs = other.timeStampPs;
   waveformSize = other.waveformSize;
   analogProbe1 = other.analogProbe1;
   analogProbe2 = other.analogProbe2;
@@ -339,6 +409,9 @@ void EventData::CopyFrom(const EventData &other)
   digitalProbe4Type = other.digitalProbe4Type;
   downSampleFactor = other.downSampleFactor;
   flags = other.flags;
+  packedWaveform = other.packedWaveform;
+  packedWaveformInfo = other.packedWaveformInfo;
+  pulseFeatures = other.pulseFeatures;
 }
 
 }  // namespace Digitizer
@@ -0,0 +1,361 @@
+#include "EventOrderer.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+// ============================================================================
+// Constructor and Configuration
+// ============================================================================
+
+EventOrderer::EventOrderer(EventBatchPool &batchPool) : fBatchPool(batchPool)
+{
+  fReadyEvents = std::make_unique<std::vector<std::unique_ptr<EventData>>>();
+  fReadyBatch = fBatchPool.Acquire();
+  fHeldBatch = fBatchPool.Acquire();
+}
+
+void EventOrderer::Configure(const OrderingConfig &config)
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  fConfig = config;
+  fOrder = config.order;
+  fBlocked = false;
+}
+
+// ============================================================================
+// Producer Side
+// ============================================================================
+
+void EventOrderer::Push(uint64_t sequence,
+                        std::vector<std::unique_ptr<EventData>> &&events)
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+
+  if (sequence < fNextSequence) {
+    // Already skipped, pass it straight through
+    Pending late;
+    late.events = std::move(events);
+    EmitLocked(late);
+    ReleaseHeldLocked(false);
+    return;
+  }
+
+  auto &pending = fPending[sequence];
+  if (pending.events.empty()) {
+    pending.events = std::move(events);
+  } else {
+    pending.events.insert(pending.events.end(),
+                          std::make_move_iterator(events.begin()),
+                          std::make_move_iterator(events.end()));
+  }
+}
+
+void EventOrderer::Push(uint64_t sequence, std::unique_ptr<EventBatch> batch)
+{
+  if (!batch) return;
+  std::lock_guard<std::mutex> lock(fMutex);
+
+  if (sequence < fNextSequence) {
+    // Already skipped, pass it straight through
+    Pending late;
+    late.batch = std::move(batch);
+    EmitLocked(late);
+    ReleaseHeldLocked(false);
+    return;
+  }
+
+  auto &pending = fPending[sequence];
+  if (!pending.batch) {
+    pending.batch = std::move(batch);
+  } else {
+    pending.batch->Append(*batch);
+    fBatchPool.Release(std::move(batch));
+  }
+}
+
+void EventOrderer::Finish(uint64_t sequence)
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+
+  auto it = fPending.find(sequence);
+  if (sequence < fNextSequence) {
+    // The gap was skipped while this aggregate was still decoding
+    fLateCount++;
+    if (it != fPending.end()) {
+      EmitLocked(it->second);
+      fPending.erase(it);
+    }
+    ReleaseHeldLocked(false);
+    return;
+  }
+
+  if (it == fPending.end()) {
+    it = fPending.emplace(sequence, Pending()).first;
+  }
+  if (!it->second.finished) {
+    it->second.finished = true;
+    fFinishedCount++;
+  }
+  ReleaseLocked(false);
+}
+
+// ============================================================================
+// Consumer Side
+// ============================================================================
+
+std::unique_ptr<std::vector<std::unique_ptr<EventData>>>
+EventOrderer::TakeEventData()
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  ReleaseLocked(false);
+
+  auto data = std::move(fReadyEvents);
+  fReadyEvents = std::make_unique<std::vector<std::unique_ptr<EventData>>>();
+  return data;
+}
+
+std::unique_ptr<EventBatch> EventOrderer::TakeEventBatch()
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  ReleaseLocked(false);
+
+  auto batch = std::move(fReadyBatch);
+  fReadyBatch = fBatchPool.Acquire();
+  return batch;
+}
+
+void EventOrderer::Flush()
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  ReleaseLocked(true);
+}
+
+uint64_t EventOrderer::GetSkippedCount() const
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  return fSkippedCount;
+}
+
+uint64_t EventOrderer::GetLateCount() const
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  return fLateCount;
+}
+
+size_t EventOrderer::GetPendingCount() const
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  return fPending.size();
+}
+
+size_t EventOrderer::GetReadyCount() const
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  return fReadyEvents->size() + fReadyBatch->Size();
+}
+
+size_t EventOrderer::DiscardReady()
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  size_t count = fReadyEvents->size() + fReadyBatch->Size();
+  fReadyEvents->clear();
+  fReadyBatch->Clear();
+  return count;
+}
+
+// ============================================================================
+// Reorder Buffer
+// ============================================================================
+
+void EventOrderer::ReleaseLocked(bool force)
+{
+  const auto now = std::chrono::steady_clock::now();
+
+  while (true) {
+    auto head = fPending.lower_bound(fNextSequence);
+    if (head == fPending.end()) break;
+
+    if (head->first == fNextSequence && head->second.finished) {
+      EmitLocked(head->second);
+      fPending.erase(head);
+      fFinishedCount--;
+      fNextSequence++;
+      fBlocked = false;
+      continue;
+    }
+
+    // Waiting for an aggregate that is missing or still decoding
+    if (fFinishedCount == 0) break;
+    bool windowExceeded = fFinishedCount > fConfig.maxPendingAggregates;
+    bool latencyExceeded =
+        fBlocked && now - fBlockedSince > fConfig.maxLatency;
+    if (!force && !windowExceeded && !latencyExceeded) break;
+
+    // Stop waiting and resume at the oldest finished aggregate
+    auto oldest = head;
+    while (oldest != fPending.end() && !oldest->second.finished) {
+      ++oldest;
+    }
+    if (oldest == fPending.end()) break;
+    fSkippedCount += oldest->first - fNextSequence;
+    fNextSequence = oldest->first;
+  }
+
+  if (fFinishedCount > 0 && !fBlocked) {
+    fBlocked = true;
+    fBlockedSince = now;
+  }
+
+  ReleaseHeldLocked(force);
+}
+
+void EventOrderer::EmitLocked(Pending &pending)
+{
+  if (fOrder != OutputOrder::TimeStamp) {
+    EmitReadyLocked(pending);
+    return;
+  }
+
+  // Merge the (sorted) aggregate into the time-ordered holding buffer
+  if (!pending.events.empty()) {
+    fNewestTimeStampPs =
+        std::max(fNewestTimeStampPs, pending.events.back()->timeStampPs);
+    auto middle = fHeldEvents.size();
+    fHeldEvents.insert(fHeldEvents.end(),
+                       std::make_move_iterator(pending.events.begin()),
+                       std::make_move_iterator(pending.events.end()));
+    std::inplace_merge(fHeldEvents.begin(), fHeldEvents.begin() + middle,
+                       fHeldEvents.end(),
+                       [](const std::unique_ptr<EventData> &a,
+                          const std::unique_ptr<EventData> &b) {
+                         return a->timeStampPs < b->timeStampPs;
+                       });
+    pending.events.clear();
+  }
+  if (pending.batch) {
+    if (!pending.batch->Empty()) {
+      fNewestTimeStampPs =
+          std::max(fNewestTimeStampPs, pending.batch->timeStampPs.back());
+    }
+    MergeBatchLocked(fHeldBatch, std::move(pending.batch));
+  }
+  fLastHeldInput = std::chrono::steady_clock::now();
+}
+
+void EventOrderer::EmitReadyLocked(Pending &pending)
+{
+  if (!pending.events.empty()) {
+    fReadyEvents->insert(fReadyEvents->end(),
+                         std::make_move_iterator(pending.events.begin()),
+                         std::make_move_iterator(pending.events.end()));
+    pending.events.clear();
+  }
+  if (pending.batch) {
+    if (fReadyBatch->Empty()) {
+      std::swap(fReadyBatch, pending.batch);
+    } else {
+      fReadyBatch->Append(*pending.batch);
+    }
+    fBatchPool.Release(std::move(pending.batch));
+  }
+}
+
+// ============================================================================
+// Watermark Merge
+// ============================================================================
+
+void EventOrderer::ReleaseHeldLocked(bool force)
+{
+  if (fOrder != OutputOrder::TimeStamp) return;
+
+  // Everything goes once input has stopped for longer than the latency bound
+  const bool releaseAll =
+      force || std::chrono::steady_clock::now() - fLastHeldInput >
+                   fConfig.maxLatency;
+  const auto windowPs = static_cast<uint64_t>(fConfig.mergeWindowNs *
+                                              EventData::kPsPerNs);
+  // Nothing is old enough until the newest timestamp exceeds the window
+  if (!releaseAll && fNewestTimeStampPs < windowPs) return;
+  const uint64_t watermark = fNewestTimeStampPs - windowPs;
+
+  if (!fHeldEvents.empty()) {
+    auto end = releaseAll
+                   ? fHeldEvents.end()
+                   : std::partition_point(
+                         fHeldEvents.begin(), fHeldEvents.end(),
+                         [watermark](const std::unique_ptr<EventData> &e) {
+                           return e->timeStampPs <= watermark;
+                         });
+    fReadyEvents->insert(fReadyEvents->end(),
+                         std::make_move_iterator(fHeldEvents.begin()),
+                         std::make_move_iterator(end));
+    fHeldEvents.erase(fHeldEvents.begin(), end);
+  }
+
+  if (!fHeldBatch->Empty()) {
+    const auto &times = fHeldBatch->timeStampPs;
+    size_t nReady =
+        releaseAll ? times.size()
+                   : std::upper_bound(times.begin(), times.end(), watermark) -
+                         times.begin();
+    if (nReady == times.size()) {
+      Pending all;
+      all.batch = std::move(fHeldBatch);
+      fHeldBatch = fBatchPool.Acquire();
+      EmitReadyLocked(all);
+    } else if (nReady > 0) {
+      auto rest = fBatchPool.Acquire();
+      for (size_t i = 0; i < times.size(); ++i) {
+        if (i < nReady) {
+          fReadyBatch->Append(*fHeldBatch, i);
+        } else {
+          rest->Append(*fHeldBatch, i);
+        }
+      }
+      std::swap(rest, fHeldBatch);
+      fBatchPool.Release(std::move(rest));
+    }
+  }
+}
+
+void EventOrderer::MergeBatchLocked(std::unique_ptr<EventBatch> &held,
+                                    std::unique_ptr<EventBatch> incoming)
+{
+  if (incoming->Empty()) {
+    fBatchPool.Release(std::move(incoming));
+    return;
+  }
+  if (held->Empty()) {
+    std::swap(held, incoming);
+    fBatchPool.Release(std::move(incoming));
+    return;
+  }
+
+  // Two-way merge of sorted batches into a pooled scratch batch
+  auto merged = fBatchPool.Acquire();
+  merged->Reserve(held->Size() + incoming->Size(),
+                  held->GetTotalSamples() + incoming->GetTotalSamples());
+  size_t i = 0;
+  size_t j = 0;
+  while (i < held->Size() && j < incoming->Size()) {
+    if (incoming->timeStampPs[j] < held->timeStampPs[i]) {
+      merged->Append(*incoming, j++);
+    } else {
+      merged->Append(*held, i++);
+    }
+  }
+  for (; i < held->Size(); ++i) merged->Append(*held, i);
+  for (; j < incoming->Size(); ++j) merged->Append(*incoming, j);
+
+  std::swap(held, merged);
+  fBatchPool.Release(std::move(merged));
+  fBatchPool.Release(std::move(incoming));
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
@@ -0,0 +1,427 @@
+#include "EventRing.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <type_traits>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+namespace
+{
+// Value of a true/false parameter, or fallback if it is neither
+bool ParseBool(const std::string &key, std::string value, bool fallback)
+{
+  std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+  if (value == "true" || value == "1" || value == "yes") return true;
+  if (value == "false" || value == "0" || value == "no") return false;
+  std::cout << "Invalid " << key << " \"" << value
+            << "\", using default: " << (fallback ? "true" : "false")
+            << std::endl;
+  return fallback;
+}
+
+uint64_t RoundUpToPowerOfTwo(uint64_t value)
+{
+  uint64_t result = 1;
+  while (result < value) result <<= 1;
+  return result;
+}
+
+size_t GetMappingSize(uint64_t capacity, uint64_t waveformBytes)
+{
+  return sizeof(EventRing::Header) + capacity * sizeof(EventRing::Record) +
+         waveformBytes;
+}
+}  // namespace
+
+// ============================================================================
+// EventRingPublisher: Constructor/Destructor and Configuration
+// ============================================================================
+
+EventRingPublisher::EventRingPublisher(EventRingConfig config,
+                                       uint8_t moduleNumber)
+    : fConfig(std::move(config)),
+      fModuleNumber(moduleNumber),
+      fObjectName(GetObjectName(fConfig.name, moduleNumber))
+{
+}
+
+EventRingPublisher::~EventRingPublisher()
+{
+  Stop();
+  if (fMapping) {
+    munmap(fMapping, fMappingSize);
+    // Readers still attached keep their mapping until they close it
+    shm_unlink(fObjectName.c_str());
+  }
+}
+
+EventRingConfig EventRingPublisher::ParseConfig(
+    const ConfigurationManager &config)
+{
+  EventRingConfig result;
+
+  result.name = config.GetParameter("EventRingName");
+  if (!result.name.empty() && result.name[0] != '/') {
+    result.name = "/" + result.name;
+  }
+
+  auto parseCount = [&config](const std::string &key, long long minimum,
+                              auto &value) {
+    auto str = config.GetParameter(key);
+    if (str.empty()) return;
+    try {
+      auto parsed = std::stoll(str);
+      if (parsed >= minimum) {
+        value = static_cast<std::decay_t<decltype(value)>>(parsed);
+      }
+    } catch (...) {
+      std::cout << "Invalid " << key << " format, using default: " << value
+                << std::endl;
+    }
+  };
+  parseCount("EventRingEvents", 1, result.capacityEvents);
+  size_t waveformMB = 0;
+  parseCount("EventRingWaveformMB", 0, waveformMB);
+  result.waveformBytes = waveformMB << 20;
+
+  auto onlyStr = config.GetParameter("EventRingOnly");
+  if (!onlyStr.empty()) {
+    result.ringOnly = ParseBool("EventRingOnly", onlyStr, result.ringOnly);
+  }
+
+  return result;
+}
+
+std::string EventRingPublisher::GetObjectName(const std::string &prefix,
+                                              uint8_t moduleNumber)
+{
+  char suffix[16];
+  std::snprintf(suffix, sizeof(suffix), "_mod%02u",
+                static_cast<unsigned>(moduleNumber));
+  return prefix + suffix;
+}
+
+// ============================================================================
+// EventRingPublisher: Lifecycle
+// ============================================================================
+
+bool EventRingPublisher::Start()
+{
+  if (fConfig.name.empty()) {
+    return false;
+  }
+  if (!fMapping && !Create()) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(fMutex);
+  fRunning = true;
+  return true;
+}
+
+void EventRingPublisher::Stop()
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  fRunning = false;
+}
+
+bool EventRingPublisher::Create()
+{
+  fCapacity = RoundUpToPowerOfTwo(fConfig.capacityEvents);
+  fWaveformBytes =
+      fConfig.waveformBytes > 0 ? RoundUpToPowerOfTwo(fConfig.waveformBytes)
+                                : 0;
+  fMappingSize = GetMappingSize(fCapacity, fWaveformBytes);
+
+  // A ring left behind by a crashed process is simply reinitialized
+  int fd = shm_open(fObjectName.c_str(), O_CREAT | O_RDWR, 0644);
+  if (fd < 0) {
+    std::cerr << "Error: cannot create shared memory " << fObjectName << ": "
+              << std::strerror(errno) << std::endl;
+    return false;
+  }
+  if (ftruncate(fd, static_cast<off_t>(fMappingSize)) != 0) {
+    std::cerr << "Error: cannot size shared memory " << fObjectName << ": "
+              << std::strerror(errno) << std::endl;
+    close(fd);
+    shm_unlink(fObjectName.c_str());
+    return false;
+  }
+  void *mapping =
+      mmap(nullptr, fMappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    std::cerr << "Error: cannot map shared memory " << fObjectName << ": "
+              << std::strerror(errno) << std::endl;
+    shm_unlink(fObjectName.c_str());
+    return false;
+  }
+
+  fMapping = mapping;
+  auto *base = static_cast<uint8_t *>(mapping);
+  fHeader = reinterpret_cast<EventRing::Header *>(base);
+  fRecords = reinterpret_cast<EventRing::Record *>(
+      base + sizeof(EventRing::Header));
+  fWaveforms = fWaveformBytes > 0 ? reinterpret_cast<uint8_t *>(
+                                        fRecords + fCapacity)
+                                  : nullptr;
+
+  // Readers reject the ring until the magic is in place
+  std::memset(fHeader->magic, 0, sizeof(fHeader->magic));
+  std::atomic_thread_fence(std::memory_order_release);
+  fHeader->version = EventRing::kVersion;
+  fHeader->headerSize = sizeof(EventRing::Header);
+  fHeader->moduleNumber = fModuleNumber;
+  fHeader->recordSize = sizeof(EventRing::Record);
+  fHeader->capacity = fCapacity;
+  fHeader->waveformBytes = fWaveformBytes;
+  fHeader->writeIndex.store(0, std::memory_order_relaxed);
+  fHeader->waveformHead.store(0, std::memory_order_relaxed);
+  for (uint64_t i = 0; i < fCapacity; ++i) {
+    fRecords[i].sequence.store(EventRing::kBusy, std::memory_order_relaxed);
+  }
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(fHeader->magic, EventRing::kMagic, sizeof(EventRing::kMagic));
+
+  std::cout << "Event ring " << fObjectName << ": " << fCapacity
+            << " events, " << fWaveformBytes << " waveform bytes"
+            << std::endl;
+  return true;
+}
+
+void EventRingPublisher::Fill(DigitizerStatistics &stats) const
+{
+  stats.eventsRingPublished = fEventsPublished.load(std::memory_order_relaxed);
+  stats.ringWaveformsSkipped =
+      fWaveformsSkipped.load(std::memory_order_relaxed);
+}
+
+// ============================================================================
+// EventRingPublisher: Publishing (decode threads)
+// ============================================================================
+
+void EventRingPublisher::Write(
+    const std::vector<std::unique_ptr<EventData>> &events)
+{
+  if (events.empty()) return;
+
+  std::lock_guard<std::mutex> lock(fMutex);
+  if (!fRunning) return;
+  for (const auto &event : events) {
+    PublishLocked(event->timeStampPs, event->flags, event->energy,
+                  event->energyShort, event->module, event->channel,
+                  event->analogProbe1.data(), event->waveformSize);
+  }
+  fHeader->writeIndex.store(fNextIndex, std::memory_order_release);
+  fEventsPublished.fetch_add(events.size(), std::memory_order_relaxed);
+}
+
+void EventRingPublisher::Write(const EventBatch &batch)
+{
+  if (batch.Empty()) return;
+
+  std::lock_guard<std::mutex> lock(fMutex);
+  if (!fRunning) return;
+  for (size_t i = 0; i < batch.Size(); ++i) {
+    PublishLocked(batch.timeStampPs[i], batch.flags[i], batch.energy[i],
+                  batch.energyShort[i], batch.module[i], batch.channel[i],
+                  batch.analogProbe1.data() + batch.waveformOffset[i],
+                  batch.waveformSize[i]);
+  }
+  fHeader->writeIndex.store(fNextIndex, std::memory_order_release);
+  fEventsPublished.fetch_add(batch.Size(), std::memory_order_relaxed);
+}
+
+void EventRingPublisher::PublishLocked(uint64_t timeStampPs, uint64_t flags,
+                                       uint16_t energy, uint16_t energyShort,
+                                       uint8_t module, uint8_t channel,
+                                       const int32_t *samples,
+                                       size_t nSamples)
+{
+  const uint64_t index = fNextIndex++;
+  auto &record = fRecords[index & (fCapacity - 1)];
+
+  // Claim waveform bytes first, so readers of the old contents notice
+  uint64_t position = 0;
+  size_t bytes = nSamples * sizeof(int32_t);
+  if (bytes > 0 && fWaveformBytes > 0 && bytes <= fWaveformBytes / 2) {
+    position = fHeader->waveformHead.load(std::memory_order_relaxed);
+    uint64_t offset = position & (fWaveformBytes - 1);
+    if (offset + bytes > fWaveformBytes) {
+      position += fWaveformBytes - offset;  // Start over at the region start
+    }
+    fHeader->waveformHead.store(position + bytes, std::memory_order_relaxed);
+  } else {
+    if (bytes > 0 && fWaveformBytes > 0) {
+      fWaveformsSkipped.fetch_add(1, std::memory_order_relaxed);
+    }
+    bytes = 0;
+  }
+
+  record.sequence.store(EventRing::kBusy, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  record.timeStampPs = timeStampPs;
+  record.flags = flags;
+  record.waveformPosition = position;
+  record.waveformSize = static_cast<uint32_t>(bytes / sizeof(int32_t));
+  record.energy = energy;
+  record.energyShort = energyShort;
+  record.module = module;
+  record.channel = channel;
+  if (bytes > 0) {
+    std::memcpy(fWaveforms + (position & (fWaveformBytes - 1)), samples,
+                bytes);
+  }
+
+  record.sequence.store(index, std::memory_order_release);
+}
+
+// ============================================================================
+// EventRingReader
+// ============================================================================
+
+EventRingReader::~EventRingReader() { Close(); }
+
+bool EventRingReader::Open(const std::string &objectName)
+{
+  Close();
+
+  int fd = shm_open(objectName.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 ||
+      static_cast<size_t>(info.st_size) < sizeof(EventRing::Header)) {
+    close(fd);
+    return false;
+  }
+  size_t size = static_cast<size_t>(info.st_size);
+  void *mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+
+  const auto *header = static_cast<const EventRing::Header *>(mapping);
+  bool valid =
+      std::memcmp(header->magic, EventRing::kMagic,
+                  sizeof(EventRing::kMagic)) == 0;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  valid = valid && header->version == EventRing::kVersion &&
+          header->headerSize == sizeof(EventRing::Header) &&
+          header->recordSize == sizeof(EventRing::Record) &&
+          GetMappingSize(header->capacity, header->waveformBytes) <= size;
+  if (!valid) {
+    munmap(mapping, size);
+    return false;
+  }
+
+  fMapping = mapping;
+  fMappingSize = size;
+  fHeader = header;
+  fCapacity = header->capacity;
+  fWaveformBytes = header->waveformBytes;
+  fRecords = reinterpret_cast<const EventRing::Record *>(
+      static_cast<const uint8_t *>(mapping) + sizeof(EventRing::Header));
+  fWaveforms = fWaveformBytes > 0
+                   ? reinterpret_cast<const uint8_t *>(fRecords + fCapacity)
+                   : nullptr;
+  fNextIndex = header->writeIndex.load(std::memory_order_acquire);
+  fLostEvents = 0;
+  fLostWaveforms = 0;
+  return true;
+}
+
+void EventRingReader::Close()
+{
+  if (fMapping) {
+    munmap(const_cast<void *>(fMapping), fMappingSize);
+  }
+  fMapping = nullptr;
+  fMappingSize = 0;
+  fHeader = nullptr;
+  fRecords = nullptr;
+  fWaveforms = nullptr;
+}
+
+uint32_t EventRingReader::GetModuleNumber() const
+{
+  return fHeader ? fHeader->moduleNumber : 0;
+}
+
+size_t EventRingReader::Read(EventBatch &batch, size_t maxEvents)
+{
+  if (!fHeader) return 0;
+
+  uint64_t writeIndex = fHeader->writeIndex.load(std::memory_order_acquire);
+  if (writeIndex < fNextIndex) {
+    fNextIndex = writeIndex;  // The publisher recreated the ring
+  }
+  if (writeIndex - fNextIndex > fCapacity) {
+    fLostEvents += writeIndex - fCapacity - fNextIndex;
+    fNextIndex = writeIndex - fCapacity;
+  }
+
+  size_t appended = 0;
+  while (fNextIndex < writeIndex && appended < maxEvents) {
+    const uint64_t index = fNextIndex++;
+    const auto &record = fRecords[index & (fCapacity - 1)];
+    if (record.sequence.load(std::memory_order_acquire) != index) {
+      ++fLostEvents;  // Already overwritten
+      continue;
+    }
+
+    auto &event = fScratch;
+    event.timeStampPs = record.timeStampPs;
+    event.timeStampNs =
+        static_cast<double>(record.timeStampPs) / EventData::kPsPerNs;
+    event.flags = record.flags;
+    event.energy = record.energy;
+    event.energyShort = record.energyShort;
+    event.module = record.module;
+    event.channel = record.channel;
+    const uint64_t position = record.waveformPosition;
+    const size_t nSamples = record.waveformSize;
+    event.ResizeWaveform(nSamples);
+    if (nSamples > 0) {
+      std::memcpy(event.analogProbe1.data(),
+                  fWaveforms + (position & (fWaveformBytes - 1)),
+                  nSamples * sizeof(int32_t));
+    }
+
+    // Anything torn by the publisher shows up as a changed sequence or a
+    // waveform head that moved a whole region past the samples
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (record.sequence.load(std::memory_order_relaxed) != index) {
+      ++fLostEvents;
+      continue;
+    }
+    if (nSamples > 0 &&
+        fHeader->waveformHead.load(std::memory_order_relaxed) - position >
+            fWaveformBytes) {
+      event.ClearWaveform();
+      ++fLostWaveforms;
+    }
+
+    batch.Append(event);
+    ++appended;
+  }
+  return appended;
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
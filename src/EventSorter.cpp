@@ -0,0 +1,161 @@
+#include "EventSorter.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+namespace
+{
+struct SortScratch {
+  std::vector<EventSorter::SortKey> keys;
+  std::vector<EventSorter::SortKey> temp;
+  std::vector<std::unique_ptr<EventData>> events;
+};
+
+SortScratch &GetScratch()
+{
+  thread_local SortScratch scratch;
+  return scratch;
+}
+
+bool KeyLess(const EventSorter::SortKey &a, const EventSorter::SortKey &b)
+{
+  return a.key < b.key;
+}
+}  // namespace
+
+// ============================================================================
+// Decoder Output
+// ============================================================================
+
+SortMethod EventSorter::Sort(std::vector<std::unique_ptr<EventData>> &events)
+{
+  if (events.size() < 2) return SortMethod::None;
+
+  auto &scratch = GetScratch();
+  auto &keys = scratch.keys;
+  keys.resize(events.size());
+  for (size_t i = 0; i < events.size(); ++i) {
+    keys[i] = {events[i]->timeStampPs, static_cast<uint32_t>(i)};
+  }
+
+  auto method = SortKeys(keys, scratch.temp);
+  if (method == SortMethod::None) return method;
+
+  auto &sorted = scratch.events;
+  sorted.clear();
+  sorted.reserve(events.size());
+  for (const auto &key : keys) {
+    sorted.push_back(std::move(events[key.index]));
+  }
+  events.swap(sorted);
+  sorted.clear();
+  return method;
+}
+
+SortMethod EventSorter::Sort(EventBatch &batch, EventBatch &scratch)
+{
+  if (batch.Size() < 2) return SortMethod::None;
+
+  auto &sortScratch = GetScratch();
+  auto &keys = sortScratch.keys;
+  keys.resize(batch.Size());
+  for (size_t i = 0; i < batch.Size(); ++i) {
+    keys[i] = {batch.timeStampPs[i], static_cast<uint32_t>(i)};
+  }
+
+  auto method = SortKeys(keys, sortScratch.temp);
+  if (method == SortMethod::None) return method;
+
+  scratch.Clear();
+  scratch.Reserve(batch.Size(), batch.GetTotalSamples());
+  for (const auto &key : keys) {
+    scratch.Append(batch, key.index);
+  }
+  std::swap(batch, scratch);
+  return method;
+}
+
+// ============================================================================
+// Key Sorting
+// ============================================================================
+
+SortMethod EventSorter::SortKeys(std::vector<SortKey> &keys,
+                                 std::vector<SortKey> &temp)
+{
+  // Find the ascending runs, giving up on merging once there are too many
+  thread_local std::vector<size_t> runStarts;
+  runStarts.clear();
+  runStarts.push_back(0);
+  for (size_t i = 1; i < keys.size(); ++i) {
+    if (keys[i].key < keys[i - 1].key) {
+      if (runStarts.size() == kMaxMergeRuns) {
+        RadixSort(keys, temp);
+        return SortMethod::Radix;
+      }
+      runStarts.push_back(i);
+    }
+  }
+  if (runStarts.size() == 1) return SortMethod::None;
+
+  MergeRuns(keys, temp, runStarts);
+  return SortMethod::Merge;
+}
+
+void EventSorter::MergeRuns(std::vector<SortKey> &keys,
+                            std::vector<SortKey> &temp,
+                            std::vector<size_t> &runStarts)
+{
+  temp.resize(keys.size());
+  runStarts.push_back(keys.size());
+
+  // Merge neighbouring runs pairwise until one is left
+  while (runStarts.size() > 2) {
+    size_t nRuns = runStarts.size() - 1;
+    size_t kept = 0;
+    for (size_t r = 0; r < nRuns; r += 2) {
+      auto begin = keys.begin() + runStarts[r];
+      auto middle = keys.begin() + runStarts[r + 1];
+      auto end = r + 2 <= nRuns ? keys.begin() + runStarts[r + 2] : middle;
+      std::merge(begin, middle, middle, end, temp.begin() + runStarts[r],
+                 KeyLess);
+      runStarts[kept++] = runStarts[r];
+    }
+    runStarts[kept++] = keys.size();
+    runStarts.resize(kept);
+    keys.swap(temp);
+  }
+}
+
+void EventSorter::RadixSort(std::vector<SortKey> &keys,
+                            std::vector<SortKey> &temp)
+{
+  auto range = std::minmax_element(keys.begin(), keys.end(), KeyLess);
+  const uint64_t base = range.first->key;
+  const uint64_t span = range.second->key - base;
+
+  temp.resize(keys.size());
+  for (unsigned shift = 0; shift < 64 && (span >> shift) != 0; shift += 8) {
+    std::array<size_t, 256> offsets{};
+    for (const auto &key : keys) {
+      offsets[((key.key - base) >> shift) & 0xFF]++;
+    }
+    size_t total = 0;
+    for (auto &offset : offsets) {
+      auto count = offset;
+      offset = total;
+      total += count;
+    }
+    for (const auto &key : keys) {
+      temp[offsets[((key.key - base) >> shift) & 0xFF]++] = key;
+    }
+    keys.swap(temp);
+  }
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
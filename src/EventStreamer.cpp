@@ -0,0 +1,383 @@
+#include "EventStreamer.hpp"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <type_traits>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+namespace
+{
+// Value of a true/false parameter, or fallback if it is neither
+bool ParseBool(const std::string &key, std::string value, bool fallback)
+{
+  std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+  if (value == "true" || value == "1" || value == "yes") return true;
+  if (value == "false" || value == "0" || value == "no") return false;
+  std::cout << "Invalid " << key << " \"" << value
+            << "\", using default: " << (fallback ? "true" : "false")
+            << std::endl;
+  return fallback;
+}
+
+// Sends every byte of iov; false on error or send timeout
+bool SendAll(int fd, iovec *iov, size_t count)
+{
+  size_t first = 0;
+  while (first < count) {
+    msghdr message{};
+    message.msg_iov = &iov[first];
+    message.msg_iovlen = count - first;
+    ssize_t sent = sendmsg(fd, &message, MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+
+    auto remaining = static_cast<size_t>(sent);
+    while (first < count && remaining >= iov[first].iov_len) {
+      remaining -= iov[first].iov_len;
+      ++first;
+    }
+    if (remaining > 0) {
+      iov[first].iov_base =
+          static_cast<char *>(iov[first].iov_base) + remaining;
+      iov[first].iov_len -= remaining;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+// ============================================================================
+// Constructor/Destructor and Configuration
+// ============================================================================
+
+EventStreamer::EventStreamer(EventStreamerConfig config, uint8_t moduleNumber)
+    : fConfig(std::move(config)), fModuleNumber(moduleNumber)
+{
+}
+
+EventStreamer::~EventStreamer()
+{
+  Stop();
+  for (auto fd : fClients) close(fd);
+  if (fListenFd >= 0) close(fListenFd);
+}
+
+EventStreamerConfig EventStreamer::ParseConfig(
+    const ConfigurationManager &config)
+{
+  EventStreamerConfig result;
+
+  auto parseCount = [&config](const std::string &key, long long minimum,
+                              auto &value) {
+    auto str = config.GetParameter(key);
+    if (str.empty()) return;
+    try {
+      auto parsed = std::stoll(str);
+      if (parsed >= minimum) {
+        value = static_cast<std::decay_t<decltype(value)>>(parsed);
+      }
+    } catch (...) {
+      std::cout << "Invalid " << key << " format, using default: " << value
+                << std::endl;
+    }
+  };
+  parseCount("EventStreamPort", 0, result.port);
+  parseCount("EventStreamMaxEvents", 1, result.maxMessageEvents);
+  parseCount("EventStreamIntervalMs", 1, result.flushIntervalMs);
+  parseCount("EventStreamBufferEvents", 1, result.bufferEvents);
+  parseCount("EventStreamTimeoutMs", 1, result.sendTimeoutMs);
+  if (result.port > 65535) {
+    std::cout << "Invalid EventStreamPort " << result.port
+              << ", streaming disabled" << std::endl;
+    result.port = 0;
+  }
+
+  auto bindStr = config.GetParameter("EventStreamBind");
+  if (!bindStr.empty()) result.bindAddress = bindStr;
+
+  auto onlyStr = config.GetParameter("EventStreamOnly");
+  if (!onlyStr.empty()) {
+    result.streamOnly =
+        ParseBool("EventStreamOnly", onlyStr, result.streamOnly);
+  }
+
+  return result;
+}
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+bool EventStreamer::Start()
+{
+  if (fSenderThread.joinable() || fConfig.port <= 0) {
+    return false;
+  }
+  if (fListenFd < 0 && !Listen()) {
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fFront.Clear();
+    fRunning = true;
+  }
+  fSenderThread = std::thread(&EventStreamer::SenderThread, this);
+  return true;
+}
+
+void EventStreamer::Stop()
+{
+  if (!fSenderThread.joinable()) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fRunning = false;
+  }
+  fCondition.notify_one();
+  fSenderThread.join();
+}
+
+void EventStreamer::Fill(DigitizerStatistics &stats) const
+{
+  stats.eventsStreamed = fEventsStreamed.load(std::memory_order_relaxed);
+  stats.eventsStreamDropped = fEventsDropped.load(std::memory_order_relaxed);
+  stats.streamMessages = fMessagesSent.load(std::memory_order_relaxed);
+  stats.streamBytes = fBytesSent.load(std::memory_order_relaxed);
+  stats.streamSubscribers = fSubscribers.load(std::memory_order_relaxed);
+  stats.streamDisconnects = fDisconnects.load(std::memory_order_relaxed);
+}
+
+// ============================================================================
+// Streaming (decode threads)
+// ============================================================================
+
+void EventStreamer::Write(
+    const std::vector<std::unique_ptr<EventData>> &events)
+{
+  if (events.empty()) return;
+
+  bool wake = false;
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    if (!AdmitLocked(events.size())) return;
+    for (const auto &event : events) {
+      fFront.timeStampPs.push_back(event->timeStampPs);
+      fFront.flags.push_back(event->flags);
+      fFront.energy.push_back(event->energy);
+      fFront.energyShort.push_back(event->energyShort);
+      fFront.channel.push_back(event->channel);
+    }
+    wake = FrontSizeLocked() >= fConfig.maxMessageEvents;
+  }
+  if (wake) fCondition.notify_one();
+}
+
+void EventStreamer::Write(const EventBatch &batch)
+{
+  if (batch.Empty()) return;
+
+  bool wake = false;
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    if (!AdmitLocked(batch.Size())) return;
+    auto append = [](auto &to, const auto &from) {
+      to.insert(to.end(), from.begin(), from.end());
+    };
+    append(fFront.timeStampPs, batch.timeStampPs);
+    append(fFront.flags, batch.flags);
+    append(fFront.energy, batch.energy);
+    append(fFront.energyShort, batch.energyShort);
+    append(fFront.channel, batch.channel);
+    wake = FrontSizeLocked() >= fConfig.maxMessageEvents;
+  }
+  if (wake) fCondition.notify_one();
+}
+
+bool EventStreamer::AdmitLocked(size_t nEvents)
+{
+  if (fRunning && FrontSizeLocked() + nEvents <= fConfig.bufferEvents) {
+    return true;
+  }
+  fEventsDropped.fetch_add(nEvents, std::memory_order_relaxed);
+  return false;
+}
+
+// ============================================================================
+// Sender Thread
+// ============================================================================
+
+void EventStreamer::SenderThread()
+{
+  const auto interval = std::chrono::milliseconds(fConfig.flushIntervalMs);
+
+  std::unique_lock<std::mutex> lock(fMutex);
+  while (true) {
+    fCondition.wait_for(lock, interval, [this]() {
+      return !fRunning || FrontSizeLocked() >= fConfig.maxMessageEvents;
+    });
+    // Nothing is admitted once stopped, so this is the last swap
+    bool stopping = !fRunning;
+
+    std::swap(fFront, fBack);
+    lock.unlock();
+    AcceptSubscribers();
+    SendBack();
+    fBack.Clear();
+    lock.lock();
+
+    if (stopping) break;
+  }
+}
+
+void EventStreamer::SendBack()
+{
+  const size_t nEvents = fBack.timeStampPs.size();
+  if (nEvents == 0 || fClients.empty()) return;
+
+  for (size_t first = 0; first < nEvents; first += fConfig.maxMessageEvents) {
+    SendMessage(first, std::min(fConfig.maxMessageEvents, nEvents - first));
+  }
+}
+
+void EventStreamer::SendMessage(size_t first, size_t count)
+{
+  // Serialize once, column by column, for all subscribers
+  fPayload.resize(count * EventStream::kBytesPerEvent);
+  auto *out = fPayload.data();
+  auto put = [&out, first, count](const auto &column) {
+    auto bytes = count * sizeof(column[0]);
+    std::memcpy(out, &column[first], bytes);
+    out += bytes;
+  };
+  put(fBack.timeStampPs);
+  put(fBack.flags);
+  put(fBack.energy);
+  put(fBack.energyShort);
+  put(fBack.channel);
+
+  EventStream::MessageHeader header{};
+  std::memcpy(header.magic, EventStream::kMagic, sizeof(header.magic));
+  header.version = EventStream::kVersion;
+  header.headerSize = sizeof(header);
+  header.moduleNumber = fModuleNumber;
+  header.nEvents = static_cast<uint32_t>(count);
+  header.sequence = fSequence++;
+  header.payloadSize = fPayload.size();
+  header.sendTimeNs =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count();
+  header.droppedEvents = fEventsDropped.load(std::memory_order_relaxed);
+
+  for (size_t client = fClients.size(); client-- > 0;) {
+    iovec iov[2] = {{&header, sizeof(header)},
+                    {fPayload.data(), fPayload.size()}};
+    if (!SendAll(fClients[client], iov, 2)) {
+      Disconnect(client, errno == EAGAIN || errno == EWOULDBLOCK
+                             ? "too slow"
+                             : std::strerror(errno));
+      continue;
+    }
+    fBytesSent.fetch_add(sizeof(header) + fPayload.size(),
+                         std::memory_order_relaxed);
+  }
+  fEventsStreamed.fetch_add(count, std::memory_order_relaxed);
+  fMessagesSent.fetch_add(1, std::memory_order_relaxed);
+}
+
+// ============================================================================
+// Connections
+// ============================================================================
+
+bool EventStreamer::Listen()
+{
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(static_cast<uint16_t>(fConfig.port));
+  if (inet_pton(AF_INET, fConfig.bindAddress.c_str(), &address.sin_addr) !=
+      1) {
+    std::cerr << "Invalid EventStreamBind address " << fConfig.bindAddress
+              << std::endl;
+    return false;
+  }
+
+  // Non-blocking, so the sender thread only picks up waiting subscribers
+  fListenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fListenFd < 0) {
+    std::cerr << "Failed to create event stream socket: "
+              << std::strerror(errno) << std::endl;
+    return false;
+  }
+  int reuse = 1;
+  setsockopt(fListenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  if (bind(fListenFd, reinterpret_cast<sockaddr *>(&address),
+           sizeof(address)) < 0 ||
+      listen(fListenFd, 16) < 0) {
+    std::cerr << "Failed to listen for event stream subscribers on "
+              << fConfig.bindAddress << ":" << fConfig.port << ": "
+              << std::strerror(errno) << std::endl;
+    close(fListenFd);
+    fListenFd = -1;
+    return false;
+  }
+
+  std::cout << "Streaming events on " << fConfig.bindAddress << ":"
+            << fConfig.port << std::endl;
+  return true;
+}
+
+void EventStreamer::AcceptSubscribers()
+{
+  while (true) {
+    int fd = accept4(fListenFd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EINTR) continue;
+      break;  // EAGAIN: nobody waiting
+    }
+
+    timeval timeout{};
+    timeout.tv_sec = fConfig.sendTimeoutMs / 1000;
+    timeout.tv_usec = (fConfig.sendTimeoutMs % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+    fClients.push_back(fd);
+    fSubscribers.store(fClients.size(), std::memory_order_relaxed);
+    std::cout << "Event stream subscriber connected ("
+              << fClients.size() << " total)" << std::endl;
+  }
+}
+
+void EventStreamer::Disconnect(size_t client, const char *reason)
+{
+  std::cerr << "Event stream subscriber disconnected: " << reason
+            << std::endl;
+  close(fClients[client]);
+  fClients.erase(fClients.begin() + client);
+  fSubscribers.store(fClients.size(), std::memory_order_relaxed);
+  fDisconnects.fetch_add(1, std::memory_order_relaxed);
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
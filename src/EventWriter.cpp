@@ -0,0 +1,543 @@
+#include "EventWriter.hpp"
+
+#include <TDirectory.h>
+#include <TFile.h>
+#include <TROOT.h>
+#include <TTree.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+namespace
+{
+// Longest time buffered events wait for the writer thread
+constexpr auto kFlushInterval = std::chrono::milliseconds(100);
+
+// Value of a true/false parameter, or fallback if it is neither
+bool ParseBool(const std::string &key, std::string value, bool fallback)
+{
+  std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+  if (value == "true" || value == "1" || value == "yes") return true;
+  if (value == "false" || value == "0" || value == "no") return false;
+  std::cout << "Invalid " << key << " \"" << value
+            << "\", using default: " << (fallback ? "true" : "false")
+            << std::endl;
+  return fallback;
+}
+
+bool WriteAll(int fd, const void *data, size_t size)
+{
+  auto bytes = static_cast<const char *>(data);
+  while (size > 0) {
+    ssize_t written = write(fd, bytes, size);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    bytes += written;
+    size -= static_cast<size_t>(written);
+  }
+  return true;
+}
+}  // namespace
+
+/**
+ * @brief Open ROOT file with the tree and the buffers its branches read
+ */
+struct EventWriter::RootOutput {
+  std::unique_ptr<TFile> file;
+  TTree *tree = nullptr;  // Owned by file
+  uint64_t writtenSize = 0;
+
+  ULong64_t timeStampPs = 0;
+  Double_t timeStampNs = 0.0;
+  UShort_t energy = 0;
+  UShort_t energyShort = 0;
+  UChar_t module = 0;
+  UChar_t channel = 0;
+  ULong64_t flags = 0;
+  std::vector<Int_t> analogProbe1;
+  std::vector<Int_t> analogProbe2;
+};
+
+// ============================================================================
+// Constructor/Destructor and Configuration
+// ============================================================================
+
+EventWriter::EventWriter(EventWriterConfig config, uint8_t moduleNumber)
+    : fConfig(std::move(config)),
+      fModuleNumber(moduleNumber),
+      fWakeEvents(std::max<size_t>(fConfig.bufferEvents / 2, 1))
+{
+}
+
+EventWriter::~EventWriter() { Stop(); }
+
+EventWriterConfig EventWriter::ParseConfig(const ConfigurationManager &config)
+{
+  EventWriterConfig result;
+  result.pathPrefix = config.GetParameter("EventWritePath");
+
+  auto formatStr = config.GetParameter("EventWriteFormat");
+  if (!formatStr.empty()) {
+    std::transform(formatStr.begin(), formatStr.end(), formatStr.begin(),
+                   ::tolower);
+    if (formatStr == "root") {
+      result.format = EventFileFormat::Root;
+    } else if (formatStr == "binary") {
+      result.format = EventFileFormat::Binary;
+    } else {
+      std::cout << "Invalid EventWriteFormat \"" << formatStr
+                << "\", using default: ROOT" << std::endl;
+    }
+  }
+
+  auto compressionStr = config.GetParameter("EventWriteCompression");
+  if (!compressionStr.empty()) {
+    try {
+      auto level = std::stoi(compressionStr);
+      if (level >= 0 && level <= 9) result.compressionLevel = level;
+    } catch (...) {
+      std::cout << "Invalid EventWriteCompression format, using default: "
+                << result.compressionLevel << std::endl;
+    }
+  }
+
+  auto fileSizeStr = config.GetParameter("EventWriteFileSizeMB");
+  if (!fileSizeStr.empty()) {
+    try {
+      auto fileSizeMB = std::stoll(fileSizeStr);
+      if (fileSizeMB >= 1) {
+        result.maxFileSize = static_cast<uint64_t>(fileSizeMB) << 20;
+      }
+    } catch (...) {
+      std::cout << "Invalid EventWriteFileSizeMB format, using default: "
+                << (result.maxFileSize >> 20) << std::endl;
+    }
+  }
+
+  auto bufferStr = config.GetParameter("EventWriteBufferEvents");
+  if (!bufferStr.empty()) {
+    try {
+      auto bufferEvents = std::stoll(bufferStr);
+      if (bufferEvents >= 1) {
+        result.bufferEvents = static_cast<size_t>(bufferEvents);
+      }
+    } catch (...) {
+      std::cout << "Invalid EventWriteBufferEvents format, using default: "
+                << result.bufferEvents << std::endl;
+    }
+  }
+
+  auto waveformsStr = config.GetParameter("EventWriteWaveforms");
+  if (!waveformsStr.empty()) {
+    result.writeWaveforms =
+        ParseBool("EventWriteWaveforms", waveformsStr, result.writeWaveforms);
+  }
+  auto onlyStr = config.GetParameter("EventWriteOnly");
+  if (!onlyStr.empty()) {
+    result.writeOnly = ParseBool("EventWriteOnly", onlyStr, result.writeOnly);
+  }
+  // Binary records have no room for traces
+  if (result.format == EventFileFormat::Binary) result.writeWaveforms = false;
+
+  return result;
+}
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+bool EventWriter::Start()
+{
+  if (fWriterThread.joinable() || fConfig.pathPrefix.empty()) {
+    return false;
+  }
+
+  // The file is created here and written and closed by other threads
+  if (fConfig.format == EventFileFormat::Root) {
+    ROOT::EnableThreadSafety();
+  }
+
+  fFailed = false;
+  if (!OpenFile()) {
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fFront.Clear();
+    fRunning = true;
+  }
+  fWriterThread = std::thread(&EventWriter::WriterThread, this);
+  return true;
+}
+
+void EventWriter::Stop()
+{
+  if (!fWriterThread.joinable()) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fRunning = false;
+  }
+  fCondition.notify_one();
+  fWriterThread.join();
+  CloseFile();
+}
+
+void EventWriter::Fill(DigitizerStatistics &stats) const
+{
+  stats.eventsWritten = fEventsWritten.load(std::memory_order_relaxed);
+  stats.eventsWriteDropped = fEventsDropped.load(std::memory_order_relaxed);
+  stats.eventBytesWritten = fBytesWritten.load(std::memory_order_relaxed);
+  stats.eventFilesWritten = fFilesWritten.load(std::memory_order_relaxed);
+  stats.eventWriteErrors = fWriteErrors.load(std::memory_order_relaxed);
+}
+
+// ============================================================================
+// Writing (decode threads)
+// ============================================================================
+
+void EventWriter::Write(const std::vector<std::unique_ptr<EventData>> &events)
+{
+  if (events.empty()) return;
+
+  bool wake = false;
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    if (!AdmitLocked(events.size())) return;
+    for (const auto &event : events) {
+      AppendLocked(*event);
+    }
+    wake = fFront.Size() >= fWakeEvents;
+  }
+  if (wake) fCondition.notify_one();
+}
+
+void EventWriter::Write(const EventBatch &batch)
+{
+  if (batch.Empty()) return;
+
+  bool wake = false;
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    if (!AdmitLocked(batch.Size())) return;
+    AppendLocked(batch);
+    wake = fFront.Size() >= fWakeEvents;
+  }
+  if (wake) fCondition.notify_one();
+}
+
+bool EventWriter::AdmitLocked(size_t nEvents)
+{
+  if (fRunning && fFront.Size() + nEvents <= fConfig.bufferEvents) {
+    return true;
+  }
+  fEventsDropped.fetch_add(nEvents, std::memory_order_relaxed);
+  return false;
+}
+
+void EventWriter::AppendLocked(const EventBatch &batch)
+{
+  if (fConfig.writeWaveforms) {
+    fFront.Append(batch);
+    return;
+  }
+
+  // Only the columns that are written
+  auto append = [](auto &to, const auto &from) {
+    to.insert(to.end(), from.begin(), from.end());
+  };
+  append(fFront.timeStampNs, batch.timeStampNs);
+  append(fFront.timeStampPs, batch.timeStampPs);
+  append(fFront.energy, batch.energy);
+  append(fFront.energyShort, batch.energyShort);
+  append(fFront.module, batch.module);
+  append(fFront.channel, batch.channel);
+  append(fFront.flags, batch.flags);
+}
+
+void EventWriter::AppendLocked(const EventData &event)
+{
+  if (fConfig.writeWaveforms) {
+    fFront.Append(event);
+    return;
+  }
+
+  fFront.timeStampNs.push_back(event.timeStampNs);
+  fFront.timeStampPs.push_back(event.timeStampPs);
+  fFront.energy.push_back(event.energy);
+  fFront.energyShort.push_back(event.energyShort);
+  fFront.module.push_back(event.module);
+  fFront.channel.push_back(event.channel);
+  fFront.flags.push_back(event.flags);
+}
+
+// ============================================================================
+// Writer Thread
+// ============================================================================
+
+void EventWriter::WriterThread()
+{
+  std::unique_lock<std::mutex> lock(fMutex);
+  while (true) {
+    fCondition.wait_for(lock, kFlushInterval, [this]() {
+      return !fRunning || fFront.Size() >= fWakeEvents;
+    });
+    // Nothing is admitted once stopped, so this is the last swap
+    bool stopping = !fRunning;
+
+    std::swap(fFront, fBack);
+    lock.unlock();
+    if (!fBack.Empty()) WriteBack();
+    fBack.Clear();
+    lock.lock();
+
+    if (stopping) break;
+  }
+}
+
+void EventWriter::WriteBack()
+{
+  if (fFailed) {
+    fEventsDropped.fetch_add(fBack.Size(), std::memory_order_relaxed);
+    return;
+  }
+
+  if (fConfig.format == EventFileFormat::Root) {
+    WriteRoot();
+  } else {
+    WriteBinary();
+  }
+}
+
+void EventWriter::WriteBinary()
+{
+  constexpr uint64_t kRecordSize = sizeof(EventFile::Record);
+  const size_t nEvents = fBack.Size();
+
+  size_t next = 0;
+  while (next < nEvents) {
+    // Rotate before the file would grow past the limit, but never leave a
+    // file without records
+    if (fFileSize > sizeof(EventFile::FileHeader) &&
+        fFileSize + kRecordSize > fConfig.maxFileSize) {
+      CloseFile();
+      if (!OpenFile()) {
+        Fail("rotate files");
+        break;
+      }
+    }
+
+    uint64_t room = fFileSize + kRecordSize > fConfig.maxFileSize
+                        ? 1
+                        : (fConfig.maxFileSize - fFileSize) / kRecordSize;
+    auto count = static_cast<size_t>(
+        std::min<uint64_t>(room, nEvents - next));
+
+    fRecords.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+      auto &record = fRecords[i];
+      record.timeStampPs = fBack.timeStampPs[next + i];
+      record.flags = fBack.flags[next + i];
+      record.energy = fBack.energy[next + i];
+      record.energyShort = fBack.energyShort[next + i];
+      record.module = fBack.module[next + i];
+      record.channel = fBack.channel[next + i];
+      record.reserved = 0;
+    }
+
+    auto bytes = count * kRecordSize;
+    if (!WriteAll(fBinaryFd, fRecords.data(), bytes)) {
+      Fail("write event file");
+      break;
+    }
+    fFileSize += bytes;
+    fBytesWritten.fetch_add(bytes, std::memory_order_relaxed);
+    fEventsWritten.fetch_add(count, std::memory_order_relaxed);
+    next += count;
+  }
+
+  if (next < nEvents) {
+    fEventsDropped.fetch_add(nEvents - next, std::memory_order_relaxed);
+  }
+}
+
+void EventWriter::WriteRoot()
+{
+  auto &root = *fRoot;
+  const size_t nEvents = fBack.Size();
+
+  for (size_t i = 0; i < nEvents; ++i) {
+    root.timeStampPs = fBack.timeStampPs[i];
+    root.timeStampNs = fBack.timeStampNs[i];
+    root.energy = fBack.energy[i];
+    root.energyShort = fBack.energyShort[i];
+    root.module = fBack.module[i];
+    root.channel = fBack.channel[i];
+    root.flags = fBack.flags[i];
+
+    if (fConfig.writeWaveforms) {
+      auto view = fBack.GetWaveform(i);
+      if (view.size == 0 && fBack.packedWaveformSize[i] > 0) {
+        // Kept packed by WaveformMode::Lazy or Compact
+        auto event = fBack.GetEvent(i);
+        event.UnpackWaveform();
+        root.analogProbe1.assign(event.analogProbe1.begin(),
+                                 event.analogProbe1.end());
+        root.analogProbe2.assign(event.analogProbe2.begin(),
+                                 event.analogProbe2.end());
+      } else {
+        root.analogProbe1.assign(view.analogProbe1,
+                                 view.analogProbe1 + view.size);
+        root.analogProbe2.assign(view.analogProbe2,
+                                 view.analogProbe2 + view.size);
+      }
+    }
+
+    if (root.tree->Fill() < 0) {
+      Fail("fill event tree");
+      fEventsDropped.fetch_add(nEvents - i, std::memory_order_relaxed);
+      return;
+    }
+  }
+  fEventsWritten.fetch_add(nEvents, std::memory_order_relaxed);
+
+  // Baskets reach the file as they fill, so its end tracks the size
+  auto size = static_cast<uint64_t>(root.file->GetEND());
+  if (size > root.writtenSize) {
+    fBytesWritten.fetch_add(size - root.writtenSize,
+                            std::memory_order_relaxed);
+    root.writtenSize = size;
+  }
+
+  if (size > fConfig.maxFileSize) {
+    CloseFile();
+    if (!OpenFile()) Fail("rotate files");
+  }
+}
+
+// ============================================================================
+// Files
+// ============================================================================
+
+bool EventWriter::OpenFile()
+{
+  auto path = MakePath();
+
+  if (fConfig.format == EventFileFormat::Root) {
+    // TFile makes itself the current directory; keep the caller's
+    TDirectory::TContext context;
+    // CREATE never overwrites an existing file
+    auto root = std::make_unique<RootOutput>();
+    root->file = std::make_unique<TFile>(path.c_str(), "CREATE");
+    if (root->file->IsZombie() || !root->file->IsOpen()) {
+      std::cerr << "Failed to create event file " << path << std::endl;
+      return false;
+    }
+    root->file->SetCompressionLevel(fConfig.compressionLevel);
+
+    root->tree = new TTree("events", "Decoded events");
+    root->tree->SetDirectory(root->file.get());
+    root->tree->Branch("timeStampPs", &root->timeStampPs, "timeStampPs/l");
+    root->tree->Branch("timeStampNs", &root->timeStampNs, "timeStampNs/D");
+    root->tree->Branch("energy", &root->energy, "energy/s");
+    root->tree->Branch("energyShort", &root->energyShort, "energyShort/s");
+    root->tree->Branch("module", &root->module, "module/b");
+    root->tree->Branch("channel", &root->channel, "channel/b");
+    root->tree->Branch("flags", &root->flags, "flags/l");
+    if (fConfig.writeWaveforms) {
+      root->tree->Branch("analogProbe1", &root->analogProbe1);
+      root->tree->Branch("analogProbe2", &root->analogProbe2);
+    }
+    fRoot = std::move(root);
+  } else {
+    // Existing files are never overwritten
+    constexpr int kFlags = O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC;
+    fBinaryFd = open(path.c_str(), kFlags, 0644);
+    if (fBinaryFd < 0) {
+      std::cerr << "Failed to create event file " << path << ": "
+                << std::strerror(errno) << std::endl;
+      return false;
+    }
+
+    EventFile::FileHeader header{};
+    std::memcpy(header.magic, EventFile::kMagic, sizeof(header.magic));
+    header.version = EventFile::kVersion;
+    header.headerSize = sizeof(header);
+    header.recordSize = sizeof(EventFile::Record);
+    header.moduleNumber = fModuleNumber;
+    header.fileIndex = fFileIndex;
+    header.creationTimeNs =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    if (!WriteAll(fBinaryFd, &header, sizeof(header))) {
+      std::cerr << "Failed to write event file header " << path << std::endl;
+      CloseFile();
+      return false;
+    }
+    fFileSize = sizeof(header);
+    fBytesWritten.fetch_add(sizeof(header), std::memory_order_relaxed);
+  }
+
+  std::cout << "Writing events to " << path << std::endl;
+  fFileIndex++;
+  fFilesWritten.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void EventWriter::CloseFile()
+{
+  if (fBinaryFd >= 0) {
+    close(fBinaryFd);
+    fBinaryFd = -1;
+  }
+  if (fRoot) {
+    TDirectory::TContext context(fRoot->file.get());
+    fRoot->tree->Write();
+    fRoot->file->Close();  // Deletes the tree
+    auto size = static_cast<uint64_t>(fRoot->file->GetEND());
+    if (size > fRoot->writtenSize) {
+      fBytesWritten.fetch_add(size - fRoot->writtenSize,
+                              std::memory_order_relaxed);
+    }
+    fRoot.reset();
+  }
+}
+
+void EventWriter::Fail(const std::string &what)
+{
+  std::cerr << "Event output stopped, failed to " << what << ": "
+            << std::strerror(errno) << std::endl;
+  fWriteErrors.fetch_add(1, std::memory_order_relaxed);
+  fFailed = true;
+  CloseFile();
+}
+
+std::string EventWriter::MakePath() const
+{
+  char suffix[32];
+  std::snprintf(suffix, sizeof(suffix), "_mod%02u_%04u",
+                static_cast<unsigned>(fModuleNumber),
+                static_cast<unsigned>(fFileIndex));
+  return fConfig.pathPrefix + suffix +
+         (fConfig.format == EventFileFormat::Root ? ".root" : ".evt");
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
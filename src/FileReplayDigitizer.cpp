@@ -0,0 +1,831 @@
+#include "FileReplayDigitizer.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "PHA1Decoder.hpp"
+#include "PSD1Decoder.hpp"
+#include "PSD2Decoder.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+namespace
+{
+// Read-only mapping of a whole run file
+struct MappedFile {
+  const uint8_t *data = nullptr;
+  size_t size = 0;
+
+  MappedFile() = default;
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile()
+  {
+    if (data) munmap(const_cast<uint8_t *>(data), size);
+  }
+
+  bool Open(const std::string &path, bool sequential)
+  {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      std::cerr << "Failed to open raw data file " << path << ": "
+                << std::strerror(errno) << std::endl;
+      return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 ||
+        static_cast<size_t>(fileStat.st_size) < sizeof(RawFile::FileHeader)) {
+      std::cerr << "Raw data file " << path << " is too short" << std::endl;
+      close(fd);
+      return false;
+    }
+
+    size = fileStat.st_size;
+    void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+      std::cerr << "Failed to map raw data file " << path << ": "
+                << std::strerror(errno) << std::endl;
+      return false;
+    }
+    if (sequential) madvise(mapped, size, MADV_SEQUENTIAL);
+    data = static_cast<const uint8_t *>(mapped);
+    return true;
+  }
+
+  RawFile::FileHeader Header() const
+  {
+    RawFile::FileHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    return header;
+  }
+};
+
+const char *FirmwareTypeName(FirmwareType type)
+{
+  switch (type) {
+    case FirmwareType::PSD1:
+      return "PSD1";
+    case FirmwareType::PSD2:
+      return "PSD2";
+    case FirmwareType::PHA1:
+      return "PHA1";
+    case FirmwareType::PHA2:
+      return "PHA2";
+    case FirmwareType::QDC1:
+      return "QDC1";
+    case FirmwareType::SCOPE1:
+      return "SCOPE1";
+    case FirmwareType::SCOPE2:
+      return "SCOPE2";
+    case FirmwareType::UNKNOWN:
+      break;
+  }
+  return "UNKNOWN";
+}
+}  // namespace
+
+FileReplayDigitizer::FileReplayDigitizer() {}
+
+FileReplayDigitizer::~FileReplayDigitizer()
+{
+  if (fReplayThread.joinable()) {
+    StopAcquisition();
+  }
+}
+
+bool FileReplayDigitizer::Initialize(const ConfigurationManager &config)
+{
+  fCancelRequested = false;
+
+  // Get URL from configuration, file://<path>
+  fURL = config.GetParameter("URL");
+  std::string lowerUrl = fURL;
+  std::transform(lowerUrl.begin(), lowerUrl.end(), lowerUrl.begin(),
+                 ::tolower);
+  if (lowerUrl.find("file://") != 0 || fURL.size() <= 7) {
+    std::cerr << "URL must be file://<run file>, got '" << fURL << "'"
+              << std::endl;
+    return false;
+  }
+
+  // Get debug flag if available
+  auto debugStr = config.GetParameter("Debug");
+  if (!debugStr.empty()) {
+    std::transform(debugStr.begin(), debugStr.end(), debugStr.begin(),
+                   ::tolower);
+    fDebugFlag = (debugStr == "true" || debugStr == "1" || debugStr == "yes");
+  }
+
+  // Get number of threads if available
+  auto threadsStr = config.GetParameter("Threads");
+  if (!threadsStr.empty()) {
+    try {
+      fNThreads = std::stoi(threadsStr);
+      if (fNThreads < 1) fNThreads = 1;
+    } catch (...) {
+      fNThreads = 1;
+    }
+  }
+
+  // Get number of raw data buffers if available
+  auto poolSizeStr = config.GetParameter("RawDataPoolSize");
+  if (!poolSizeStr.empty()) {
+    try {
+      auto poolSize = std::stoi(poolSizeStr);
+      if (poolSize >= 1) fRawDataPoolSize = poolSize;
+    } catch (...) {
+      std::cout << "Invalid RawDataPoolSize format, using default: "
+                << fRawDataPoolSize << std::endl;
+    }
+  }
+
+  // Get raw data queue capacity if available
+  auto queueSizeStr = config.GetParameter("RawDataQueueSize");
+  if (!queueSizeStr.empty()) {
+    try {
+      auto queueSize = std::stoi(queueSizeStr);
+      if (queueSize >= 0) fRawDataQueueSize = queueSize;
+    } catch (...) {
+      std::cout << "Invalid RawDataQueueSize format, using default: "
+                << fRawDataQueueSize << std::endl;
+    }
+  }
+
+  // Get backpressure limits and policy if available
+  auto queueMBStr = config.GetParameter("RawDataQueueMB");
+  if (!queueMBStr.empty()) {
+    try {
+      auto queueMB = std::stoi(queueMBStr);
+      if (queueMB >= 0) {
+        fBackpressure.maxQueuedBytes = static_cast<size_t>(queueMB) << 20;
+      }
+    } catch (...) {
+      std::cout << "Invalid RawDataQueueMB format, using default: "
+                << (fBackpressure.maxQueuedBytes >> 20) << std::endl;
+    }
+  }
+
+  auto maxPendingStr = config.GetParameter("MaxPendingEvents");
+  if (!maxPendingStr.empty()) {
+    try {
+      auto maxPending = std::stoi(maxPendingStr);
+      if (maxPending >= 0) fBackpressure.maxPendingEvents = maxPending;
+    } catch (...) {
+      std::cout << "Invalid MaxPendingEvents format, using default: "
+                << fBackpressure.maxPendingEvents << std::endl;
+    }
+  }
+
+  auto policyStr = config.GetParameter("BackpressurePolicy");
+  if (!policyStr.empty()) {
+    if (policyStr == "Block") {
+      fBackpressure.policy = BackpressurePolicy::Block;
+    } else if (policyStr == "DropOldest") {
+      fBackpressure.policy = BackpressurePolicy::DropOldest;
+    } else if (policyStr == "DropNewest") {
+      fBackpressure.policy = BackpressurePolicy::DropNewest;
+    } else {
+      std::cout << "Invalid BackpressurePolicy \"" << policyStr
+                << "\", using default: Block" << std::endl;
+    }
+  }
+
+  // Get coincidence filter settings if available
+  fCoincidence = CoincidenceFilter::ParseConfig(config);
+
+  // Get zero suppression thresholds if available
+  fZeroSuppression = ZeroSuppression::ParseConfig(config);
+
+  // Get pulse processing settings if available
+  fPulseProcessing = PulseProcessor::ParseConfig(config);
+
+  // Get online histogram settings if available
+  fHistogramConfig = OnlineHistograms::ParseConfig(config);
+  fEventWriterConfig = EventWriter::ParseConfig(config);
+  fEventStreamerConfig = EventStreamer::ParseConfig(config);
+  fEventRingConfig = EventRingPublisher::ParseConfig(config);
+  fTraceConfig = PipelineTracer::ParseConfig(config);
+
+  // Get reader/decoder thread placement if available
+  fPlacement = ThreadPlacement::ParseConfig(config);
+
+  // Get number of channel-pair decode threads if available
+  auto pairThreadsStr = config.GetParameter("ChannelPairThreads");
+  if (!pairThreadsStr.empty()) {
+    try {
+      auto pairThreads = std::stoi(pairThreadsStr);
+      if (pairThreads >= 1) fChannelPairThreads = pairThreads;
+    } catch (...) {
+      std::cout << "Invalid ChannelPairThreads format, using default: "
+                << fChannelPairThreads << std::endl;
+    }
+  }
+
+  // Get decoder output format if available
+  auto outputFormatStr = config.GetParameter("OutputFormat");
+  if (!outputFormatStr.empty()) {
+    if (outputFormatStr == "EventBatch") {
+      fOutputFormat = OutputFormat::EventBatch;
+    } else if (outputFormatStr == "EventData") {
+      fOutputFormat = OutputFormat::EventData;
+    } else {
+      std::cout << "Invalid OutputFormat \"" << outputFormatStr
+                << "\", using default: EventData" << std::endl;
+    }
+  }
+
+  // Get byte-swap placement if available
+  auto swapOnDecodeStr = config.GetParameter("SwapOnDecode");
+  if (!swapOnDecodeStr.empty()) {
+    std::transform(swapOnDecodeStr.begin(), swapOnDecodeStr.end(),
+                   swapOnDecodeStr.begin(), ::tolower);
+    fSwapOnDecode = (swapOnDecodeStr == "true" || swapOnDecodeStr == "1" ||
+                     swapOnDecodeStr == "yes");
+  }
+
+  // Get decoder output ordering if available
+  auto outputOrderStr = config.GetParameter("OutputOrder");
+  if (!outputOrderStr.empty()) {
+    if (outputOrderStr == "None") {
+      fOrdering.order = OutputOrder::None;
+    } else if (outputOrderStr == "Sequence") {
+      fOrdering.order = OutputOrder::Sequence;
+    } else if (outputOrderStr == "TimeStamp") {
+      fOrdering.order = OutputOrder::TimeStamp;
+    } else {
+      std::cout << "Invalid OutputOrder \"" << outputOrderStr
+                << "\", using default: None" << std::endl;
+    }
+  }
+
+  // Get reorder buffer bounds if available
+  auto reorderWindowStr = config.GetParameter("ReorderWindow");
+  if (!reorderWindowStr.empty()) {
+    try {
+      auto reorderWindow = std::stoi(reorderWindowStr);
+      if (reorderWindow >= 0) fOrdering.maxPendingAggregates = reorderWindow;
+    } catch (...) {
+      std::cout << "Invalid ReorderWindow format, using default: "
+                << fOrdering.maxPendingAggregates << std::endl;
+    }
+  }
+
+  auto reorderLatencyStr = config.GetParameter("ReorderLatencyMs");
+  if (!reorderLatencyStr.empty()) {
+    try {
+      auto reorderLatency = std::stoi(reorderLatencyStr);
+      if (reorderLatency >= 0) {
+        fOrdering.maxLatency = std::chrono::milliseconds(reorderLatency);
+      }
+    } catch (...) {
+      std::cout << "Invalid ReorderLatencyMs format, using default: "
+                << fOrdering.maxLatency.count() << std::endl;
+    }
+  }
+
+  auto mergeWindowStr = config.GetParameter("MergeWindowNs");
+  if (!mergeWindowStr.empty()) {
+    try {
+      auto mergeWindow = std::stod(mergeWindowStr);
+      if (mergeWindow >= 0.0) fOrdering.mergeWindowNs = mergeWindow;
+    } catch (...) {
+      std::cout << "Invalid MergeWindowNs format, using default: "
+                << fOrdering.mergeWindowNs << std::endl;
+    }
+  }
+
+  // Get waveform decoding mode if available
+  auto decodeWaveformsStr = config.GetParameter("DecodeWaveforms");
+  if (!decodeWaveformsStr.empty()) {
+    std::transform(decodeWaveformsStr.begin(), decodeWaveformsStr.end(),
+                   decodeWaveformsStr.begin(), ::tolower);
+    if (decodeWaveformsStr == "true" || decodeWaveformsStr == "1" ||
+        decodeWaveformsStr == "yes") {
+      fWaveformMode = WaveformMode::Decode;
+    } else if (decodeWaveformsStr == "false" || decodeWaveformsStr == "0" ||
+               decodeWaveformsStr == "no") {
+      fWaveformMode = WaveformMode::Skip;
+    } else if (decodeWaveformsStr == "lazy") {
+      fWaveformMode = WaveformMode::Lazy;
+    } else if (decodeWaveformsStr == "compact") {
+      fWaveformMode = WaveformMode::Compact;
+    } else if (decodeWaveformsStr == "compact-delta") {
+      fWaveformMode = WaveformMode::CompactDelta;
+    } else {
+      std::cout << "Invalid DecodeWaveforms \"" << decodeWaveformsStr
+                << "\", using default: true" << std::endl;
+    }
+  }
+
+  // Get replay pacing if available
+  auto replaySpeedStr = config.GetParameter("ReplaySpeed");
+  if (!replaySpeedStr.empty()) {
+    try {
+      auto replaySpeed = std::stod(replaySpeedStr);
+      if (replaySpeed >= 0.0) fReplaySpeed = replaySpeed;
+    } catch (...) {
+      std::cout << "Invalid ReplaySpeed format, using default: "
+                << fReplaySpeed << std::endl;
+    }
+  }
+
+  // Find and check the run files
+  if (!FindFiles(fURL.substr(7))) {
+    return false;
+  }
+  std::cout << "Replaying " << fFiles.size() << " file(s), " << fTotalRecords
+            << " records, starting with " << fFiles.front() << std::endl;
+
+  fFirmwareType = static_cast<FirmwareType>(fFileHeader.firmwareType);
+  if (fFirmwareType != FirmwareType::PSD1 &&
+      fFirmwareType != FirmwareType::PHA1 &&
+      fFirmwareType != FirmwareType::PSD2) {
+    std::cerr << "Replay of " << FirmwareTypeName(fFirmwareType)
+              << " data is not supported" << std::endl;
+    return false;
+  }
+  fModuleNumber = static_cast<uint8_t>(fFileHeader.moduleNumber);
+  fTimeStepNs = fFileHeader.timeStepNs;
+
+  // Get module ID if available, overriding the recorded one
+  auto modIdStr = config.GetParameter("ModID");
+  if (!modIdStr.empty()) {
+    try {
+      int modId = std::stoi(modIdStr);
+      if (modId >= 0 && modId <= 255) {
+        fModuleNumber = static_cast<uint8_t>(modId);
+      }
+    } catch (...) {
+      std::cout << "Invalid ModID format, using recorded: "
+                << static_cast<int>(fModuleNumber) << std::endl;
+    }
+  }
+  std::cout << "Module ID set to: " << static_cast<int>(fModuleNumber)
+            << std::endl;
+
+  // Get time step if available; needed for files that do not record it
+  auto timeStepStr = config.GetParameter("TimeStep");
+  if (!timeStepStr.empty()) {
+    try {
+      auto timeStep = std::stoi(timeStepStr);
+      if (timeStep >= 1) fTimeStepNs = timeStep;
+    } catch (...) {
+      std::cout << "Invalid TimeStep format, using recorded: " << fTimeStepNs
+                << std::endl;
+    }
+  }
+
+  return true;
+}
+
+bool FileReplayDigitizer::Configure()
+{
+  fCancelRequested = false;
+
+  if (fTimeStepNs == 0) {
+    std::cerr << "The run file does not record the time step, set TimeStep"
+              << std::endl;
+    return false;
+  }
+
+  // Every record fits a pool buffer, so buffers are never resized
+  fRawDataPool = std::make_shared<RawDataPool>(
+      std::max<size_t>(fMaxRecordSize, 1), fRawDataPoolSize);
+  std::cout << "Raw data pool: " << fRawDataPoolSize << " buffers"
+            << std::endl;
+
+  // Create the decoder of the recorded firmware
+  if (!fDecoder) {
+    if (fFirmwareType == FirmwareType::PSD1) {
+      fDecoder = std::make_unique<PSD1Decoder>(fNThreads);
+    } else if (fFirmwareType == FirmwareType::PHA1) {
+      fDecoder = std::make_unique<PHA1Decoder>(fNThreads);
+    } else {
+      auto decoder = std::make_unique<PSD2Decoder>(fNThreads);
+      decoder->SetSwapOnDecode(fSwapOnDecode);
+      fDecoder = std::move(decoder);
+    }
+    std::cout << "Created " << FirmwareTypeName(fFirmwareType)
+              << " decoder for replay" << std::endl;
+  }
+
+  // Configure Decoder
+  fDecoder->SetTimeStep(fTimeStepNs);
+  fDecoder->SetDumpFlag(fDebugFlag);
+  fDecoder->SetModuleNumber(fModuleNumber);
+  fDecoder->SetRawDataPool(fRawDataPool);
+  fDecoder->SetRawDataQueueCapacity(fRawDataQueueSize);
+  fDecoder->SetBackpressure(fBackpressure);
+  fDecoder->SetCoincidence(fCoincidence);
+  fDecoder->SetZeroSuppression(fZeroSuppression);
+  fDecoder->SetPulseProcessing(fPulseProcessing);
+
+  // Online histograms are created once and survive reconfiguration
+  if (fHistogramConfig.enabled && !fHistograms) {
+    fHistograms =
+        std::make_shared<OnlineHistograms>(fHistogramConfig, fModuleNumber);
+    if (fHistogramConfig.httpPort > 0) {
+      fHistogramServer = std::make_unique<HistogramServer>();
+      fHistogramServer->Add(fHistograms);
+      fHistogramServer->Start(
+          fHistogramConfig.httpPort,
+          std::chrono::milliseconds(fHistogramConfig.updateIntervalMs));
+    }
+  }
+  fDecoder->SetHistograms(fHistograms);
+
+  // Like the histograms, the event sinks survive reconfiguration
+  if (!fEventWriterConfig.pathPrefix.empty() && !fEventWriter) {
+    fEventWriter =
+        std::make_shared<EventWriter>(fEventWriterConfig, fModuleNumber);
+  }
+  if (fEventStreamerConfig.port > 0 && !fEventStreamer) {
+    fEventStreamer =
+        std::make_shared<EventStreamer>(fEventStreamerConfig, fModuleNumber);
+  }
+  if (!fEventRingConfig.name.empty() && !fEventRing) {
+    fEventRing =
+        std::make_shared<EventRingPublisher>(fEventRingConfig, fModuleNumber);
+  }
+  EventSinks sinks;
+  if (fEventWriter) sinks.push_back(fEventWriter);
+  if (fEventStreamer) sinks.push_back(fEventStreamer);
+  if (fEventRing) sinks.push_back(fEventRing);
+  fDecoder->SetEventSinks(std::move(sinks));
+  if (fTraceConfig.enabled && !fTracer) {
+    fTracer = std::make_shared<PipelineTracer>(fTraceConfig, fModuleNumber);
+  }
+  fDecoder->SetTracer(fTracer);
+  fDecoder->SetThreadPlacement(fPlacement);
+  fDecoder->SetOutputFormat(fOutputFormat);
+  fDecoder->SetOrdering(fOrdering);
+  fDecoder->SetWaveformMode(fWaveformMode);
+  fDecoder->SetChannelPairThreads(fChannelPairThreads);
+
+  std::cout << "Time step: " << fTimeStepNs << " ns per sample" << std::endl;
+  return true;
+}
+
+bool FileReplayDigitizer::StartAcquisition()
+{
+  std::cout << "Start acquisition" << std::endl;
+
+  if (!ArmAcquisition()) {
+    return false;
+  }
+  return SendSWStart();
+}
+
+bool FileReplayDigitizer::ArmAcquisition()
+{
+  fCancelRequested = false;
+
+  if (!fDecoder) {
+    std::cerr << "Decoder not initialized, call Configure() first"
+              << std::endl;
+    return false;
+  }
+  if (fReplayThread.joinable()) {
+    std::cerr << "Replay is already running" << std::endl;
+    return false;
+  }
+
+  if (fTracer) fTracer->Reset();
+  if (fEventWriter && !fEventWriter->Start()) {
+    return false;
+  }
+  if (fEventStreamer && !fEventStreamer->Start()) {
+    return false;
+  }
+  if (fEventRing && !fEventRing->Start()) {
+    return false;
+  }
+
+  // Each start replays the files from the beginning
+  fDataTakingFlag = true;
+  fReplaying = true;
+  fReplayThread = std::thread(&FileReplayDigitizer::ReplayThread, this);
+  ThreadPlacement::PlaceReader(fReplayThread, 0, fPlacement);
+  return true;
+}
+
+bool FileReplayDigitizer::SendSWStart()
+{
+  // The replay starts with ArmAcquisition()
+  return true;
+}
+
+bool FileReplayDigitizer::StopAcquisition()
+{
+  fCancelRequested = false;
+
+  std::cout << "Stop acquisition" << std::endl;
+
+  fDataTakingFlag = false;
+  if (fReplayThread.joinable()) {
+    fReplayThread.join();
+  }
+  // The sinks receive the last events and the statistics are final
+  constexpr auto kDrainTimeout = std::chrono::seconds(5);
+  if (fDecoder && !fDecoder->Drain(kDrainTimeout)) {
+    std::cerr << "Warning: decoder not drained within "
+              << kDrainTimeout.count() << " s" << std::endl;
+  }
+  if (fEventWriter) {
+    fEventWriter->Stop();
+  }
+  if (fEventStreamer) {
+    fEventStreamer->Stop();
+  }
+  if (fEventRing) {
+    fEventRing->Stop();
+  }
+  if (fTracer) {
+    fTracer->WriteRunTrace();
+  }
+
+  if (fDebugFlag && fDecoder) {
+    auto queueStats = fDecoder->GetRawDataQueueStatistics();
+    std::cout << "Raw data queue high-water mark: " << queueStats.highWaterMark
+              << " (" << queueStats.pushed << " aggregates queued)"
+              << std::endl;
+  }
+  return true;
+}
+
+std::unique_ptr<std::vector<std::unique_ptr<EventData>>>
+FileReplayDigitizer::GetEventData()
+{
+  if (!fDecoder) {
+    return std::make_unique<std::vector<std::unique_ptr<EventData>>>();
+  }
+  return fDecoder->GetEventData();
+}
+
+std::unique_ptr<EventBatch> FileReplayDigitizer::GetEventBatch()
+{
+  if (!fDecoder) {
+    return std::make_unique<EventBatch>();
+  }
+  return fDecoder->GetEventBatch();
+}
+
+std::unique_ptr<std::vector<std::unique_ptr<EventData>>>
+FileReplayDigitizer::GetEventData(std::chrono::milliseconds timeout)
+{
+  if (!fDecoder) {
+    std::this_thread::sleep_for(timeout);
+    return GetEventData();
+  }
+  return fDecoder->GetEventData(timeout);
+}
+
+std::unique_ptr<EventBatch> FileReplayDigitizer::GetEventBatch(
+    std::chrono::milliseconds timeout)
+{
+  if (!fDecoder) {
+    std::this_thread::sleep_for(timeout);
+    return GetEventBatch();
+  }
+  return fDecoder->GetEventBatch(timeout);
+}
+
+void FileReplayDigitizer::ReleaseEventBatch(std::unique_ptr<EventBatch> batch)
+{
+  if (fDecoder) fDecoder->ReleaseEventBatch(std::move(batch));
+}
+
+DigitizerStatistics FileReplayDigitizer::GetStatistics() const
+{
+  DigitizerStatistics stats;
+  fReadoutCounters.Fill(stats);
+  if (fRawDataPool) {
+    stats.rawDataPoolExhausted = fRawDataPool->GetExhaustedCount();
+  }
+  if (fDecoder) {
+    stats.rawDataQueue = fDecoder->GetRawDataQueueStatistics();
+    stats.decoder = fDecoder->GetStatistics();
+  }
+  if (fEventWriter) {
+    fEventWriter->Fill(stats);
+  }
+  if (fEventStreamer) {
+    fEventStreamer->Fill(stats);
+  }
+  if (fEventRing) {
+    fEventRing->Fill(stats);
+  }
+  if (fTracer) {
+    fTracer->Fill(stats);
+  }
+  return stats;
+}
+
+void FileReplayDigitizer::PrintDeviceInfo()
+{
+  std::cout << "\n=== Replay Source ===" << std::endl;
+  std::cout << "First File: " << (fFiles.empty() ? "" : fFiles.front())
+            << std::endl;
+  std::cout << "Files: " << fFiles.size() << std::endl;
+  std::cout << "Records: " << fTotalRecords << std::endl;
+  std::cout << "Digitizer Type: " << FirmwareTypeName(fFirmwareType)
+            << std::endl;
+  std::cout << "Module ID: " << static_cast<int>(fModuleNumber) << std::endl;
+  std::cout << "Time step: " << fTimeStepNs << " ns" << std::endl;
+  if (fReplaySpeed > 0.0) {
+    std::cout << "Replay Speed: " << fReplaySpeed << "x" << std::endl;
+  } else {
+    std::cout << "Replay Speed: as fast as possible" << std::endl;
+  }
+  std::cout << "=========================" << std::endl;
+}
+
+// ============================================================================
+// File Handling
+// ============================================================================
+
+bool FileReplayDigitizer::FindFiles(const std::string &firstFile)
+{
+  fFiles.clear();
+  fMaxRecordSize = 0;
+  fTotalRecords = 0;
+  if (!ScanFile(firstFile, true)) {
+    return false;
+  }
+  fFiles.push_back(firstFile);
+
+  // A rotated recording continues in <prefix>_<NNNN+1>.raw, ...
+  constexpr size_t kSuffixSize = 9;  // "_NNNN.raw"
+  if (firstFile.size() <= kSuffixSize) {
+    return true;
+  }
+  auto suffixPos = firstFile.size() - kSuffixSize;
+  auto suffix = firstFile.substr(suffixPos);
+  if (suffix[0] != '_' || suffix.compare(5, 4, ".raw") != 0 ||
+      !std::all_of(suffix.begin() + 1, suffix.begin() + 5,
+                   [](unsigned char c) { return std::isdigit(c); })) {
+    return true;
+  }
+
+  auto prefix = firstFile.substr(0, suffixPos);
+  for (auto index = std::stoul(suffix.substr(1, 4)) + 1; index <= 9999;
+       ++index) {
+    char next[16];
+    std::snprintf(next, sizeof(next), "_%04lu.raw", index);
+    auto path = prefix + next;
+    if (fCancelRequested) {
+      std::cout << "File scan cancelled" << std::endl;
+      return false;
+    }
+    if (access(path.c_str(), F_OK) != 0 || !ScanFile(path, false)) {
+      break;
+    }
+    fFiles.push_back(path);
+  }
+  return true;
+}
+
+bool FileReplayDigitizer::ScanFile(const std::string &path, bool isFirst)
+{
+  MappedFile file;
+  if (!file.Open(path, false)) {
+    return false;
+  }
+
+  auto header = file.Header();
+  if (std::memcmp(header.magic, RawFile::kRunMagic, sizeof(header.magic)) !=
+          0 ||
+      header.version != RawFile::kVersion ||
+      header.headerSize < sizeof(header) || header.headerSize > file.size) {
+    std::cerr << path << " is not a raw data run file" << std::endl;
+    return false;
+  }
+
+  if (isFirst) {
+    fFileHeader = header;
+  } else if (header.firmwareType != fFileHeader.firmwareType ||
+             header.moduleNumber != fFileHeader.moduleNumber) {
+    std::cerr << path << " belongs to a different recording, not replayed"
+              << std::endl;
+    return false;
+  }
+
+  // Only the record headers are touched here
+  size_t offset = header.headerSize;
+  while (offset + sizeof(RawFile::RecordHeader) <= file.size) {
+    RawFile::RecordHeader record;
+    std::memcpy(&record, file.data + offset, sizeof(record));
+    offset += sizeof(record);
+    if (record.size > file.size - offset) {
+      std::cerr << "Warning: " << path << " ends with a truncated record"
+                << std::endl;
+      break;
+    }
+    fMaxRecordSize = std::max<size_t>(fMaxRecordSize, record.size);
+    fTotalRecords++;
+    offset += record.size;
+  }
+  return true;
+}
+
+// ============================================================================
+// Replay
+// ============================================================================
+
+void FileReplayDigitizer::ReplayThread()
+{
+  bool havePace = false;
+  uint64_t firstWriteTimeNs = 0;
+  std::chrono::steady_clock::time_point replayStart;
+
+  for (const auto &path : fFiles) {
+    if (!ReplayFile(path, havePace, firstWriteTimeNs, replayStart)) {
+      break;
+    }
+  }
+
+  if (fDebugFlag) {
+    std::cout << "Replay finished" << std::endl;
+  }
+  fReplaying = false;
+}
+
+bool FileReplayDigitizer::ReplayFile(
+    const std::string &path, bool &havePace, uint64_t &firstWriteTimeNs,
+    std::chrono::steady_clock::time_point &replayStart)
+{
+  MappedFile file;
+  if (!file.Open(path, true)) {
+    return false;
+  }
+
+  size_t offset = file.Header().headerSize;
+  while (offset + sizeof(RawFile::RecordHeader) <= file.size) {
+    RawFile::RecordHeader record;
+    std::memcpy(&record, file.data + offset, sizeof(record));
+    offset += sizeof(record);
+    if (record.size > file.size - offset) {
+      break;  // Truncated, reported by ScanFile()
+    }
+
+    // Pace by the recorded write times, waking up to notice a stop
+    if (fReplaySpeed > 0.0) {
+      if (!havePace) {
+        havePace = true;
+        firstWriteTimeNs = record.writeTimeNs;
+        replayStart = std::chrono::steady_clock::now();
+      }
+      auto elapsedNs = record.writeTimeNs > firstWriteTimeNs
+                           ? record.writeTimeNs - firstWriteTimeNs
+                           : 0;
+      auto due = replayStart + std::chrono::nanoseconds(static_cast<int64_t>(
+                                   elapsedNs / fReplaySpeed));
+      while (fDataTakingFlag && std::chrono::steady_clock::now() < due) {
+        std::this_thread::sleep_until(
+            std::min(due, std::chrono::steady_clock::now() +
+                              std::chrono::milliseconds(100)));
+      }
+    }
+
+    // Pool exhausted: wait for the decoder to hand a buffer back
+    std::unique_ptr<RawData_t> rawData;
+    while (fDataTakingFlag && !rawData) {
+      rawData = fRawDataPool->Acquire();
+    }
+    if (!rawData) {
+      return false;
+    }
+
+    auto readTicks = fTracer ? PipelineTracer::Now() : 0;
+    std::memcpy(rawData->data.data(), file.data + offset, record.size);
+    rawData->size = record.size;
+    rawData->nEvents = record.nEvents;
+    rawData->sequence = fReplaySequence++;
+    if (fTracer) {
+      fTracer->Record(TraceStage::Read, rawData->sequence, readTicks,
+                      PipelineTracer::Now());
+    }
+    offset += record.size;
+
+    fReadoutCounters.RecordRead(record.size);
+    fDecoder->AddData(std::move(rawData));
+  }
+  return fDataTakingFlag;
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
@@ -0,0 +1,145 @@
+#include "HistogramServer.hpp"
+
+#include <TH1D.h>
+#include <THttpServer.h>
+#include <TROOT.h>
+
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <string>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+namespace
+{
+struct ChannelHistograms {
+  std::unique_ptr<TH1D> energy;
+  std::unique_ptr<TH1D> psd;
+  std::unique_ptr<TH1D> timeDifference;
+};
+
+void CopyBins(TH1D &histogram, const uint64_t *bins, size_t nBins)
+{
+  double entries = 0.0;
+  for (size_t b = 0; b < nBins; ++b) {
+    histogram.SetBinContent(static_cast<int>(b) + 1,
+                            static_cast<double>(bins[b]));
+    entries += bins[b];
+  }
+  histogram.SetEntries(entries);
+}
+
+std::unique_ptr<TH1D> MakeHistogram(const std::string &name,
+                                    const std::string &title, size_t nBins,
+                                    double low, double high)
+{
+  auto histogram = std::make_unique<TH1D>(
+      name.c_str(), title.c_str(), static_cast<int>(nBins), low, high);
+  histogram->SetDirectory(nullptr);  // Owned here, not by gDirectory
+  return histogram;
+}
+}  // namespace
+
+HistogramServer::~HistogramServer() { Stop(); }
+
+void HistogramServer::Add(std::shared_ptr<OnlineHistograms> histograms)
+{
+  if (histograms) fSources.push_back(std::move(histograms));
+}
+
+bool HistogramServer::Start(int port, std::chrono::milliseconds updateInterval)
+{
+  if (fThread.joinable() || port <= 0 || port > 65535) {
+    return false;
+  }
+
+  fPort = port;
+  fUpdateInterval = updateInterval;
+  fRunning = true;
+  fThread = std::thread(&HistogramServer::ServerThread, this);
+  return true;
+}
+
+void HistogramServer::Stop()
+{
+  if (!fThread.joinable()) {
+    return;
+  }
+
+  fRunning = false;
+  fThread.join();
+}
+
+void HistogramServer::ServerThread()
+{
+  ROOT::EnableThreadSafety();
+
+  // Declared before the server so the server is destroyed first
+  std::map<std::pair<uint8_t, size_t>, ChannelHistograms> histograms;
+
+  THttpServer server(("http:" + std::to_string(fPort)).c_str());
+  if (!server.IsAnyEngine()) {
+    std::cerr << "Failed to start histogram server on port " << fPort
+              << std::endl;
+    return;
+  }
+  // Requests are served from this thread only, see ProcessRequests() below
+  server.SetTimer(0, kTRUE);
+  std::cout << "Histogram server listening on port " << fPort << std::endl;
+
+  auto nextUpdate = std::chrono::steady_clock::now();
+  while (fRunning) {
+    auto now = std::chrono::steady_clock::now();
+    if (now >= nextUpdate) {
+      nextUpdate = now + fUpdateInterval;
+
+      for (const auto &source : fSources) {
+        auto snapshot = source->Snapshot();
+        const auto &config = snapshot.config;
+        for (size_t ch = 0; ch < snapshot.entries.size(); ++ch) {
+          if (snapshot.entries[ch] == 0) continue;
+
+          auto &channel = histograms[{snapshot.module, ch}];
+          if (!channel.energy) {
+            char tag[32];
+            std::snprintf(tag, sizeof(tag), "mod%02u_ch%02zu",
+                          static_cast<unsigned>(snapshot.module), ch);
+            char folder[32];
+            std::snprintf(folder, sizeof(folder), "/mod%02u/ch%02zu",
+                          static_cast<unsigned>(snapshot.module), ch);
+            std::string suffix = tag;
+            channel.energy =
+                MakeHistogram("energy_" + suffix, "Energy " + suffix,
+                              config.energyBins, 0.0, 65536.0);
+            channel.psd = MakeHistogram("psd_" + suffix, "PSD " + suffix,
+                                        config.psdBins, 0.0, 1.0);
+            channel.timeDifference =
+                MakeHistogram("dt_" + suffix, "Time difference (ns) " + suffix,
+                              config.timeBins, 0.0, config.timeRangeNs);
+            server.Register(folder, channel.energy.get());
+            server.Register(folder, channel.psd.get());
+            server.Register(folder, channel.timeDifference.get());
+          }
+
+          CopyBins(*channel.energy, &snapshot.energy[ch * config.energyBins],
+                   config.energyBins);
+          CopyBins(*channel.psd, &snapshot.psd[ch * config.psdBins],
+                   config.psdBins);
+          CopyBins(*channel.timeDifference,
+                   &snapshot.timeDifference[ch * config.timeBins],
+                   config.timeBins);
+        }
+      }
+    }
+
+    server.ProcessRequests();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
@@ -0,0 +1,226 @@
+#include "OnlineHistograms.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+namespace
+{
+std::atomic<uint64_t> gNextHistogramsId{1};
+
+// Value of a true/false parameter, or fallback if it is neither
+bool ParseBool(const std::string &key, std::string value, bool fallback)
+{
+  std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+  if (value == "true" || value == "1" || value == "yes") return true;
+  if (value == "false" || value == "0" || value == "no") return false;
+  std::cout << "Invalid " << key << " \"" << value
+            << "\", using default: " << (fallback ? "true" : "false")
+            << std::endl;
+  return fallback;
+}
+}  // namespace
+
+// ============================================================================
+// Constructor and Configuration
+// ============================================================================
+
+OnlineHistograms::OnlineHistograms(const HistogramConfig &config,
+                                   uint8_t moduleNumber)
+    : fConfig(config),
+      fModuleNumber(moduleNumber),
+      fId(gNextHistogramsId.fetch_add(1)),
+      fPSDOffset(config.energyBins),
+      fTimeOffset(config.energyBins + config.psdBins),
+      fEntriesOffset(config.energyBins + config.psdBins + config.timeBins),
+      fChannelStride(config.energyBins + config.psdBins + config.timeBins + 1)
+{
+}
+
+HistogramConfig OnlineHistograms::ParseConfig(
+    const ConfigurationManager &config)
+{
+  HistogramConfig result;
+
+  auto enabledStr = config.GetParameter("Histograms");
+  if (!enabledStr.empty()) {
+    result.enabled = ParseBool("Histograms", enabledStr, result.enabled);
+  }
+  auto onlyStr = config.GetParameter("HistogramOnly");
+  if (!onlyStr.empty()) {
+    result.histogramOnly =
+        ParseBool("HistogramOnly", onlyStr, result.histogramOnly);
+  }
+
+  auto parseCount = [&config](const std::string &key, uint32_t minimum,
+                              auto &value) {
+    auto str = config.GetParameter(key);
+    if (str.empty()) return;
+    try {
+      auto parsed = std::stoi(str);
+      if (parsed >= static_cast<int>(minimum)) value = parsed;
+    } catch (...) {
+      std::cout << "Invalid " << key << " format, using default: " << value
+                << std::endl;
+    }
+  };
+  parseCount("HistogramEnergyBins", 1, result.energyBins);
+  parseCount("HistogramPSDBins", 1, result.psdBins);
+  parseCount("HistogramTimeBins", 1, result.timeBins);
+  parseCount("HistogramHttpPort", 0, result.httpPort);
+  parseCount("HistogramUpdateMs", 1, result.updateIntervalMs);
+
+  auto rangeStr = config.GetParameter("HistogramTimeRangeNs");
+  if (!rangeStr.empty()) {
+    try {
+      auto range = std::stod(rangeStr);
+      if (range > 0.0) result.timeRangeNs = range;
+    } catch (...) {
+      std::cout << "Invalid HistogramTimeRangeNs format, using default: "
+                << result.timeRangeNs << std::endl;
+    }
+  }
+
+  return result;
+}
+
+// ============================================================================
+// Filling
+// ============================================================================
+
+void OnlineHistograms::Fill(
+    const std::vector<std::unique_ptr<EventData>> &events)
+{
+  if (events.empty()) return;
+
+  auto &shard = GetLocalShard();
+  LastHit last;
+  for (const auto &event : events) {
+    FillHit(shard, last, event->channel, event->energy, event->energyShort,
+            event->timeStampNs);
+  }
+}
+
+void OnlineHistograms::Fill(const EventBatch &batch)
+{
+  if (batch.Empty()) return;
+
+  auto &shard = GetLocalShard();
+  LastHit last;
+  for (size_t i = 0; i < batch.Size(); ++i) {
+    FillHit(shard, last, batch.channel[i], batch.energy[i],
+            batch.energyShort[i], batch.timeStampNs[i]);
+  }
+}
+
+void OnlineHistograms::FillHit(Shard &shard, LastHit &last, uint8_t channel,
+                               uint16_t energy, uint16_t energyShort,
+                               double timeStampNs) const
+{
+  if (channel >= kMaxChannels) return;
+  auto *counts = &shard.counts[channel * fChannelStride];
+
+  Increment(counts[fEntriesOffset]);
+  Increment(counts[fEnergyOffset +
+                   ((static_cast<uint64_t>(energy) * fConfig.energyBins) >>
+                    16)]);
+
+  if (energy > 0) {
+    auto psd = static_cast<double>(energyShort) / energy;
+    if (psd < 1.0) {
+      Increment(counts[fPSDOffset + static_cast<size_t>(psd * fConfig.psdBins)]);
+    }
+  }
+
+  // Hits of one channel arrive in time order within an aggregate
+  if (last.valid[channel]) {
+    auto dt = timeStampNs - last.timeStampNs[channel];
+    if (dt >= 0.0 && dt < fConfig.timeRangeNs) {
+      Increment(counts[fTimeOffset + static_cast<size_t>(
+                                         dt * fConfig.timeBins /
+                                         fConfig.timeRangeNs)]);
+    }
+  }
+  last.timeStampNs[channel] = timeStampNs;
+  last.valid[channel] = true;
+}
+
+OnlineHistograms::Shard &OnlineHistograms::GetLocalShard()
+{
+  // Decode threads fill one instance for their whole life, so the lookup
+  // under the lock only happens once per thread
+  struct Cache {
+    uint64_t owner = 0;
+    Shard *shard = nullptr;
+  };
+  thread_local Cache cache;
+  if (cache.owner == fId) return *cache.shard;
+
+  std::lock_guard<std::mutex> lock(fShardMutex);
+  auto &shard = fShards[std::this_thread::get_id()];
+  if (!shard) {
+    auto size = kMaxChannels * fChannelStride;
+    shard = std::make_unique<Shard>(size);
+    for (size_t i = 0; i < size; ++i) shard->counts[i].store(0);
+  }
+  cache.owner = fId;
+  cache.shard = shard.get();
+  return *shard;
+}
+
+// ============================================================================
+// Access
+// ============================================================================
+
+HistogramSnapshot OnlineHistograms::Snapshot() const
+{
+  HistogramSnapshot snapshot;
+  snapshot.config = fConfig;
+  snapshot.module = fModuleNumber;
+  snapshot.energy.assign(kMaxChannels * fConfig.energyBins, 0);
+  snapshot.psd.assign(kMaxChannels * fConfig.psdBins, 0);
+  snapshot.timeDifference.assign(kMaxChannels * fConfig.timeBins, 0);
+
+  std::lock_guard<std::mutex> lock(fShardMutex);
+  for (const auto &entry : fShards) {
+    const auto *counts = entry.second->counts.get();
+    for (size_t ch = 0; ch < kMaxChannels; ++ch) {
+      const auto *channel = counts + ch * fChannelStride;
+      for (size_t b = 0; b < fConfig.energyBins; ++b) {
+        snapshot.energy[ch * fConfig.energyBins + b] +=
+            channel[fEnergyOffset + b].load(std::memory_order_relaxed);
+      }
+      for (size_t b = 0; b < fConfig.psdBins; ++b) {
+        snapshot.psd[ch * fConfig.psdBins + b] +=
+            channel[fPSDOffset + b].load(std::memory_order_relaxed);
+      }
+      for (size_t b = 0; b < fConfig.timeBins; ++b) {
+        snapshot.timeDifference[ch * fConfig.timeBins + b] +=
+            channel[fTimeOffset + b].load(std::memory_order_relaxed);
+      }
+      snapshot.entries[ch] +=
+          channel[fEntriesOffset].load(std::memory_order_relaxed);
+    }
+  }
+  return snapshot;
+}
+
+void OnlineHistograms::Reset()
+{
+  // Increments racing with the reset may survive it
+  std::lock_guard<std::mutex> lock(fShardMutex);
+  auto size = kMaxChannels * fChannelStride;
+  for (auto &entry : fShards) {
+    for (size_t i = 0; i < size; ++i) {
+      entry.second->counts[i].store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
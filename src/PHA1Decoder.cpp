@@ -1,5 +1,9 @@
 #include "PHA1Decoder.hpp"
 
+#include "EventSorter.hpp"
+#include "WaveformCodec.hpp"
+#include "WaveformUnpack.hpp"
+
 #include <algorithm>
 #include <bitset>
 #include <chrono>
@@ -32,6 +36,7 @@ PHA1Decoder::PHA1Decoder(uint32_t nThreads)
 
   // Initialize data storage
   fEventDataVec = std::make_unique<std::vector<std::unique_ptr<EventData>>>();
+  fEventBatch = fEventBatchPool.Acquire();
   fEventDataCache = std::make_unique<std::vector<std::unique_ptr<EventData>>>();
 
   // Pre-allocate with reasonable defaults
@@ -54,8 +59,10 @@ PHA1Decoder::PHA1Decoder(uint32_t nThreads)
 
 PHA1Decoder::~PHA1Decoder()
 {
-  // Signal threads to stop
+  // Signal threads to stop and wake any that are waiting for data
   fDecodeFlag = false;
+  fRawDataQueue.Close();
+  fBackpressure.Close();
 
   // Wait for all threads to finish
   for (auto &thread : fDecodeThreads) {
@@ -63,6 +70,7 @@ PHA1Decoder::~PHA1Decoder()
       thread.join();
     }
   }
+  DecoderLogger::Flush();
 }
 
 // ============================================================================
@@ -72,49 +80,138 @@ PHA1Decoder::~PHA1Decoder()
 std::unique_ptr<std::vector<std::unique_ptr<EventData>>>
 PHA1Decoder::GetEventData()
 {
+  if (fOrderer.IsEnabled()) {
+    auto data = fOrderer.TakeEventData();
+    if (fTracer && !data->empty()) fTracer->RecordPickup();
+    fBackpressure.NotifyDrained();
+    return data;
+  }
+
   auto data = std::make_unique<std::vector<std::unique_ptr<EventData>>>();
   {
     std::lock_guard<std::mutex> lock(fEventDataMutex);
     data->swap(*fEventDataVec);
     fEventDataVec->clear();
   }
+  if (fTracer && !data->empty()) fTracer->RecordPickup();
+  fBackpressure.NotifyDrained();
+  return data;
+}
+
+std::unique_ptr<EventBatch> PHA1Decoder::GetEventBatch()
+{
+  if (fOrderer.IsEnabled()) {
+    auto batch = fOrderer.TakeEventBatch();
+    if (fTracer && !batch->Empty()) fTracer->RecordPickup();
+    fBackpressure.NotifyDrained();
+    return batch;
+  }
+
+  // Swap in a recycled batch so decoding continues without allocating
+  auto batch = fEventBatchPool.Acquire();
+  {
+    std::lock_guard<std::mutex> lock(fEventBatchMutex);
+    std::swap(batch, fEventBatch);
+  }
+  if (fTracer && !batch->Empty()) fTracer->RecordPickup();
+  fBackpressure.NotifyDrained();
+  return batch;
+}
+
+std::unique_ptr<std::vector<std::unique_ptr<EventData>>>
+PHA1Decoder::GetEventData(std::chrono::milliseconds timeout)
+{
+  // Read the generation first so a batch stored after the check still wakes
+  auto generation = fEventNotifier.GetGeneration();
+  auto data = GetEventData();
+  if (data->empty() && fEventNotifier.WaitFor(generation, timeout)) {
+    data = GetEventData();
+  }
   return data;
 }
 
+std::unique_ptr<EventBatch> PHA1Decoder::GetEventBatch(
+    std::chrono::milliseconds timeout)
+{
+  auto generation = fEventNotifier.GetGeneration();
+  auto batch = GetEventBatch();
+  if (batch->Empty() && fEventNotifier.WaitFor(generation, timeout)) {
+    fEventBatchPool.Release(std::move(batch));
+    batch = GetEventBatch();
+  }
+  return batch;
+}
+
+DecoderStatistics PHA1Decoder::GetStatistics() const
+{
+  auto stats = fCounters.Snapshot();
+  stats.orderingSkipped = fOrderer.GetSkippedCount();
+  stats.orderingLate = fOrderer.GetLateCount();
+  return stats;
+}
+
+bool PHA1Decoder::Drain(std::chrono::milliseconds timeout)
+{
+  // Every buffer handed over so far has been decoded, dropped or ignored
+  bool drained = fInFlight.WaitIdle(timeout);
+
+  // Nothing older is coming: release what waits for gaps or the merge window
+  if (fOrderer.IsEnabled()) fOrderer.Flush();
+  fEventNotifier.Notify();
+  return drained;
+}
+
 // ============================================================================
 // Threading and Data Processing
 // ============================================================================
 
 void PHA1Decoder::DecodeThread()
 {
+  std::vector<std::unique_ptr<RawData_t>> batch;
+  batch.reserve(kDecodeBatchSize);
+
   while (fDecodeFlag) {
-    std::unique_ptr<RawData_t> rawData = nullptr;
-
-    // Get data from queue
-    {
-      std::lock_guard<std::mutex> lock(fRawDataMutex);
-      if (fRawDataQueue.empty()) {
-        // Release lock before sleeping to avoid deadlock
-      } else {
-        rawData = std::move(fRawDataQueue.front());
-        fRawDataQueue.pop_front();
-      }
+    // Sleeps until data is pushed or the queue is closed
+    if (fRawDataQueue.PopBatch(batch, kDecodeBatchSize,
+                               std::chrono::milliseconds(10)) == 0) {
+      continue;
     }
-    
-    // Sleep outside the lock if no data was available
-    if (!rawData) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    // DropNewest at the event limit: these buffers are not decoded at all
+    if (!MakeRoomForEvents()) {
+      for (auto &rawData : batch) {
+        fCounters.RecordDroppedAggregate(rawData->size);
+        FinishSequence(*rawData);
+        RecycleRawData(std::move(rawData));
+      }
+      batch.clear();
       continue;
     }
 
-    // Process data if available
-    if (rawData) {
-      DecodeData(std::move(rawData));
+    // Decode each buffer, then hand it back to the pool
+    for (auto &rawData : batch) {
+      uint64_t decodeTicks = 0;
+      if (fTracer) {
+        decodeTicks = PipelineTracer::Now();
+        fTracer->Record(TraceStage::Queue, rawData->sequence,
+                        rawData->queuedTicks, decodeTicks);
+      }
+      auto decodeStart = std::chrono::steady_clock::now();
+      DecodeData(rawData);
+      fCounters.RecordAggregate(std::chrono::steady_clock::now() - decodeStart);
+      if (fTracer) {
+        fTracer->Record(TraceStage::Decode, rawData->sequence, decodeTicks,
+                        PipelineTracer::Now());
+      }
+      FinishSequence(*rawData);
+      RecycleRawData(std::move(rawData));
     }
+    batch.clear();
+    fEventNotifier.Notify();
   }
 }
 
-void PHA1Decoder::DecodeData(std::unique_ptr<RawData_t> rawData)
+void PHA1Decoder::DecodeData(std::unique_ptr<RawData_t> &rawData)
 {
   if (fDumpFlag) {
     DumpRawData(*rawData);
@@ -124,8 +221,8 @@ void PHA1Decoder::DecodeData(std::unique_ptr<RawData_t> rawData)
   DecoderResult result =
       DataValidator::ValidateRawData(rawData->data.data(), rawData->size);
   if (result != DecoderResult::Success) {
-    DecoderLogger::LogResult(result, "DecodeData",
-                             "Raw data validation failed");
+    DECODER_LOG_RESULT(result, "DecodeData", "Raw data validation failed");
+    fCounters.RecordDecodeError();
     return;
   }
 
@@ -134,20 +231,104 @@ void PHA1Decoder::DecodeData(std::unique_ptr<RawData_t> rawData)
 
   DecoderResult headerResult = ValidateDataHeader(firstWord, rawData->size);
   if (headerResult != DecoderResult::Success) {
-    DecoderLogger::LogResult(headerResult, "DecodeData",
-                             "Header validation failed");
+    DECODER_LOG_RESULT(headerResult, "DecodeData", "Header validation failed");
+    fCounters.RecordDecodeError();
     return;
   }
 
   // Process all events in the data (multiple board aggregate blocks)
   uint32_t totalDataSizeWords = rawData->size / kWordSize;
   DecoderResult processResult =
-      ProcessEventData(rawData->data.begin(), totalDataSizeWords);
+      ProcessEventData(rawData->data.begin(), totalDataSizeWords,
+                       rawData->sequence);
 
   if (processResult != DecoderResult::Success) {
-    DecoderLogger::LogResult(processResult, "DecodeData",
-                             "Event processing failed");
+    DECODER_LOG_RESULT(processResult, "DecodeData", "Event processing failed");
+    fCounters.RecordDecodeError();
+  }
+}
+
+void PHA1Decoder::RecycleRawData(std::unique_ptr<RawData_t> rawData)
+{
+  if (fRawDataPool) {
+    fRawDataPool->Release(std::move(rawData));
+  }
+}
+
+void PHA1Decoder::FinishSequence(const RawData_t &rawData)
+{
+  if (fOrderer.IsEnabled()) fOrderer.Finish(rawData.sequence);
+  fInFlight.Done();
+}
+
+bool PHA1Decoder::MakeRoomForEvents()
+{
+  // Decoded events not yet taken with GetEventData()/GetEventBatch()
+  auto pending = [this]() -> size_t {
+    if (fOrderer.IsEnabled()) return fOrderer.GetReadyCount();
+    if (fOutputFormat == OutputFormat::EventBatch) {
+      std::lock_guard<std::mutex> lock(fEventBatchMutex);
+      return fEventBatch->Size();
+    }
+    std::lock_guard<std::mutex> lock(fEventDataMutex);
+    return fEventDataVec->size();
+  };
+  auto discard = [this]() -> size_t {
+    if (fOrderer.IsEnabled()) return fOrderer.DiscardReady();
+    size_t count = 0;
+    if (fOutputFormat == OutputFormat::EventBatch) {
+      std::lock_guard<std::mutex> lock(fEventBatchMutex);
+      count = fEventBatch->Size();
+      fEventBatch->Clear();
+    } else {
+      std::lock_guard<std::mutex> lock(fEventDataMutex);
+      count = fEventDataVec->size();
+      fEventDataVec->clear();
+    }
+    return count;
+  };
+  return fBackpressure.MakeRoomForEvents(pending, discard, fCounters);
+}
+
+void PHA1Decoder::StoreEventBatch(std::unique_ptr<EventBatch> eventBatch,
+                                  uint64_t sequence)
+{
+  // Sort through a pooled scratch batch so neither side reallocates
+  auto sortScratch = fEventBatchPool.Acquire();
+  auto sortTicks = fTracer ? PipelineTracer::Now() : 0;
+  auto sortStart = std::chrono::steady_clock::now();
+  auto method = EventSorter::Sort(*eventBatch, *sortScratch);
+  fCounters.RecordSort(method, std::chrono::steady_clock::now() - sortStart);
+  if (fTracer) {
+    fTracer->Record(TraceStage::Sort, sequence, sortTicks,
+                    PipelineTracer::Now());
   }
+  fEventBatchPool.Release(std::move(sortScratch));
+  if (fCoincidence.IsEnabled()) {
+    fCounters.RecordCoincidenceRejected(
+        fCoincidence.Apply(eventBatch, fEventBatchPool));
+  }
+  if (fPulseProcessor.IsEnabled()) fPulseProcessor.Process(*eventBatch);
+  if (WriteToSinks(fEventSinks, *eventBatch)) {
+    fEventBatchPool.Release(std::move(eventBatch));
+    return;
+  }
+  if (fTracer) fTracer->MarkPending();
+
+  if (fOrderer.IsEnabled()) {
+    fOrderer.Push(sequence, std::move(eventBatch));
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(fEventBatchMutex);
+    if (fEventBatch->Empty()) {
+      std::swap(fEventBatch, eventBatch);
+    } else {
+      fEventBatch->Append(*eventBatch);
+    }
+  }
+  fEventBatchPool.Release(std::move(eventBatch));
 }
 
 void PHA1Decoder::DumpRawData(const RawData_t &rawData) const
@@ -167,11 +348,11 @@ DecoderResult PHA1Decoder::ValidateDataHeader(uint32_t headerWord,
   auto headerType = (headerWord >> PHA1Constants::BoardHeader::kTypeShift) &
                     PHA1Constants::BoardHeader::kTypeMask;
   if (headerType != PHA1Constants::BoardHeader::kTypeData) {
-    DecoderLogger::LogError(
-        "ValidateDataHeader",
-        "Invalid PHA1 header type: 0x" + std::to_string(headerType) +
-            " (expected 0x" +
-            std::to_string(PHA1Constants::BoardHeader::kTypeData) + ")");
+    DECODER_LOG_ERROR("ValidateDataHeader",
+                      "Invalid PHA1 header type: 0x" << std::hex << headerType
+                          << std::dec << " (expected 0x" << std::hex
+                          << PHA1Constants::BoardHeader::kTypeData << std::dec
+                          << ")");
     return DecoderResult::InvalidHeader;
   }
 
@@ -179,61 +360,113 @@ DecoderResult PHA1Decoder::ValidateDataHeader(uint32_t headerWord,
   auto totalSize = headerWord & PHA1Constants::BoardHeader::kAggregateSizeMask;
 
   if (fDumpFlag) {
-    DecoderLogger::LogDebug(
-        "ValidateDataHeader",
-        "Board aggregate size: " + std::to_string(totalSize * kWordSize) +
-            " bytes");
+    DECODER_LOG_DEBUG("ValidateDataHeader",
+                      "Board aggregate size: " << totalSize * kWordSize
+                          << " bytes");
   }
 
   return DecoderResult::Success;
 }
 
 DecoderResult PHA1Decoder::ProcessEventData(
-    const std::vector<uint8_t>::iterator &dataStart, uint32_t totalDataSize)
+    const std::vector<uint8_t>::iterator &dataStart, uint32_t totalDataSize,
+    uint64_t sequence)
 {
   // Direct EventData output with optimized pre-allocation
   std::vector<std::unique_ptr<EventData>> eventDataVec;
+  auto eventBatch = fEventBatchPool.Acquire();
   // Better estimation: assume average event size is 20 words
   size_t estimatedEvents =
       std::max(totalDataSize / 20, static_cast<uint32_t>(1));
-  eventDataVec.reserve(estimatedEvents);
+  if (fOutputFormat == OutputFormat::EventBatch) {
+    eventBatch->Reserve(estimatedEvents);
+  } else {
+    eventDataVec.reserve(estimatedEvents);
+  }
 
   MemoryReader reader(dataStart, totalDataSize);
-  size_t wordIndex = 0;
 
-  // Process multiple Board Aggregate Blocks in the data
-  while (wordIndex < totalDataSize) {
-    DecoderResult result =
-        ProcessBoardAggregateBlock(reader, wordIndex, eventDataVec);
-    if (result != DecoderResult::Success) {
-      DecoderLogger::LogResult(
-          result, "ProcessEventData",
-          "Failed to process board aggregate block at word " +
-              std::to_string(wordIndex));
-      // Continue to next block if possible
-      if (result == DecoderResult::CorruptedData) {
-        break;  // Stop processing on corrupted data
+  if (fChannelPairThreads > 1) {
+    // Locate every channel-pair block first, then decode them concurrently
+    ProcessChannelPairsParallel(reader, eventDataVec, *eventBatch);
+  } else {
+    size_t wordIndex = 0;
+
+    // Process multiple Board Aggregate Blocks in the data
+    while (wordIndex < totalDataSize) {
+      const size_t blockStart = wordIndex;
+      DecoderResult result =
+          ProcessBoardAggregateBlock(reader, wordIndex, eventDataVec,
+                                     *eventBatch);
+      if (result != DecoderResult::Success) {
+        DECODER_LOG_RESULT(result, "ProcessEventData",
+                           "Failed to process board aggregate block at word "
+                               << wordIndex);
+        // Continue to next block if possible; a failure that consumed no
+        // words (e.g. a few trailing words) would repeat forever
+        if (result == DecoderResult::CorruptedData ||
+            wordIndex == blockStart) {
+          break;  // Stop processing on corrupted data
+        }
       }
     }
   }
 
-  // Sort EventData by timeStampNs in ascending order
+  // Columnar output: sort the batch and append it to the shared one
+  if (fOutputFormat == OutputFormat::EventBatch) {
+    if (fDumpFlag) {
+      DECODER_LOG_DEBUG("ProcessEventData",
+                        "Decoded " << eventBatch->Size() << " events from "
+                            << totalDataSize << " words");
+    }
+    fCounters.RecordEvents(*eventBatch);
+    if (fHistograms) {
+      fHistograms->Fill(*eventBatch);
+      if (fHistograms->GetConfig().histogramOnly) {
+        fEventBatchPool.Release(std::move(eventBatch));
+        return DecoderResult::Success;
+      }
+    }
+    StoreEventBatch(std::move(eventBatch), sequence);
+    return DecoderResult::Success;
+  }
+  fEventBatchPool.Release(std::move(eventBatch));
+
+  // Sort EventData by timeStampPs in ascending order
   if (!eventDataVec.empty()) {
-    std::sort(eventDataVec.begin(), eventDataVec.end(),
-              [](const std::unique_ptr<EventData> &a,
-                 const std::unique_ptr<EventData> &b) {
-                return a->timeStampNs < b->timeStampNs;
-              });
+    auto sortTicks = fTracer ? PipelineTracer::Now() : 0;
+    auto sortStart = std::chrono::steady_clock::now();
+    auto method = EventSorter::Sort(eventDataVec);
+    fCounters.RecordSort(method, std::chrono::steady_clock::now() - sortStart);
+    if (fTracer) {
+      fTracer->Record(TraceStage::Sort, sequence, sortTicks,
+                      PipelineTracer::Now());
+    }
   }
 
   if (fDumpFlag) {
-    DecoderLogger::LogDebug("ProcessEventData",
-                            "Decoded " + std::to_string(eventDataVec.size()) +
-                                " events from " +
-                                std::to_string(totalDataSize) + " words");
+    DECODER_LOG_DEBUG("ProcessEventData",
+                      "Decoded " << eventDataVec.size() << " events from "
+                          << totalDataSize << " words");
+  }
+
+  fCounters.RecordEvents(eventDataVec);
+  if (fHistograms) {
+    fHistograms->Fill(eventDataVec);
+    if (fHistograms->GetConfig().histogramOnly) return DecoderResult::Success;
   }
+  if (fCoincidence.IsEnabled()) {
+    fCounters.RecordCoincidenceRejected(fCoincidence.Apply(eventDataVec));
+  }
+  if (fPulseProcessor.IsEnabled()) fPulseProcessor.Process(eventDataVec);
+  if (WriteToSinks(fEventSinks, eventDataVec)) return DecoderResult::Success;
 
   // Store converted data
+  if (fTracer) fTracer->MarkPending();
+  if (fOrderer.IsEnabled()) {
+    fOrderer.Push(sequence, std::move(eventDataVec));
+    return DecoderResult::Success;
+  }
   {
     std::lock_guard<std::mutex> lock(fEventDataMutex);
     fEventDataVec->insert(fEventDataVec->end(),
@@ -246,7 +479,8 @@ DecoderResult PHA1Decoder::ProcessEventData(
 
 DecoderResult PHA1Decoder::ProcessBoardAggregateBlock(
     MemoryReader &reader, size_t &wordIndex,
-    std::vector<std::unique_ptr<EventData>> &eventDataVec)
+    std::vector<std::unique_ptr<EventData>> &eventDataVec,
+    EventBatch &eventBatch)
 {
   // Decode board header (4 words)
   PHA1BoardHeaderInfo boardInfo;
@@ -256,11 +490,12 @@ DecoderResult PHA1Decoder::ProcessBoardAggregateBlock(
   }
 
   if (fDumpFlag) {
-    DecoderLogger::LogDebug(
-        "ProcessBoardAggregateBlock",
-        "Processing Board Aggregate Block: size=" +
-            std::to_string(boardInfo.aggregateSize) + " words, mask=0x" +
-            std::to_string(static_cast<int>(boardInfo.dualChannelMask)));
+    DECODER_LOG_DEBUG("ProcessBoardAggregateBlock",
+                      "Processing Board Aggregate Block: size="
+                          << boardInfo.aggregateSize << " words, mask=0x"
+                          << std::hex
+                          << static_cast<int>(boardInfo.dualChannelMask)
+                          << std::dec);
   }
 
   // Calculate the end of this board aggregate block
@@ -277,15 +512,19 @@ DecoderResult PHA1Decoder::ProcessBoardAggregateBlock(
 
   // Process channel pairs in this board aggregate
   return ProcessChannelPairs(reader, wordIndex, boardInfo, boardEndIndex,
-                             eventDataVec);
+                             eventDataVec, eventBatch);
 }
 
 DecoderResult PHA1Decoder::ProcessChannelPairs(
     MemoryReader &reader, size_t &wordIndex, const PHA1BoardHeaderInfo &boardInfo,
-    size_t boardEndIndex, std::vector<std::unique_ptr<EventData>> &eventDataVec)
+    size_t boardEndIndex, std::vector<std::unique_ptr<EventData>> &eventDataVec,
+    EventBatch &eventBatch)
 {
   uint8_t activeMask = boardInfo.dualChannelMask;
 
+  // Reused for every hit of the columnar path so it does not allocate per hit
+  EventData scratchEvent;
+
   for (int pair = 0; pair < PHA1Constants::Validation::kMaxChannelPairs;
        ++pair) {
     if (!(activeMask & (1 << pair))) {
@@ -293,8 +532,8 @@ DecoderResult PHA1Decoder::ProcessChannelPairs(
     }
 
     if (wordIndex >= boardEndIndex) {
-      DecoderLogger::LogError("ProcessChannelPairs",
-                              "Unexpected end of board aggregate block");
+      DECODER_LOG_ERROR("ProcessChannelPairs",
+                        "Unexpected end of board aggregate block");
       return DecoderResult::OutOfBounds;
     }
 
@@ -303,9 +542,9 @@ DecoderResult PHA1Decoder::ProcessChannelPairs(
     DecoderResult result =
         DecodeDualChannelHeader(reader, wordIndex, dualChInfo);
     if (result != DecoderResult::Success) {
-      DecoderLogger::LogError("ProcessChannelPairs",
-                              "Failed to decode dual channel header for pair " +
-                                  std::to_string(pair));
+      DECODER_LOG_ERROR("ProcessChannelPairs",
+                        "Failed to decode dual channel header for pair "
+                            << pair);
       return result;
     }
 
@@ -318,50 +557,249 @@ DecoderResult PHA1Decoder::ProcessChannelPairs(
     result = ValidateBlockBounds(channelEndIndex, boardEndIndex,
                                  reader.GetTotalSizeWords());
     if (result != DecoderResult::Success) {
-      DecoderLogger::LogError("ProcessChannelPairs",
-                              "Channel aggregate block extends beyond board");
+      DECODER_LOG_ERROR("ProcessChannelPairs",
+                        "Channel aggregate block extends beyond board");
       channelEndIndex = boardEndIndex;  // Clamp to board end
     }
 
     if (fDumpFlag) {
-      DecoderLogger::LogDebug(
-          "ProcessChannelPairs",
-          "Processing Channel Pair " + std::to_string(pair) +
-              ": size=" + std::to_string(dualChInfo.aggregateSize) +
-              " words, samples=" + std::to_string(dualChInfo.numSamplesWave));
+      DECODER_LOG_DEBUG("ProcessChannelPairs",
+                        "Processing Channel Pair " << pair << ": size="
+                            << dualChInfo.aggregateSize << " words, samples="
+                            << dualChInfo.numSamplesWave);
     }
 
     // Decode events in this dual channel block
-    while (wordIndex < channelEndIndex && wordIndex < boardEndIndex) {
-      auto eventData = DecodeEventDirect(reader, wordIndex, dualChInfo);
-      if (eventData) {
-        // Set the channel pair offset
-        eventData->channel += pair * 2;  // Each pair handles 2 channels
-        eventDataVec.push_back(std::move(eventData));
+    DecodeChannelPairEvents(reader, wordIndex,
+                            std::min(channelEndIndex, boardEndIndex), pair,
+                            dualChInfo, scratchEvent, eventDataVec,
+                            eventBatch);
+  }
+
+  return DecoderResult::Success;
+}
+
+void PHA1Decoder::DecodeChannelPairEvents(
+    MemoryReader &reader, size_t &wordIndex, size_t endIndex, int pair,
+    const PHA1DualChannelInfo &dualChInfo, EventData &scratchEvent,
+    std::vector<std::unique_ptr<EventData>> &eventDataVec,
+    EventBatch &eventBatch)
+{
+  std::array<uint64_t, ZeroSuppression::kMaxChannels> suppressed{};
+  const bool suppress = fZeroSuppression.IsEnabled();
+
+  // Every event of the block has the size the dual channel header gives, so
+  // one check per event covers all of its words and the decode functions
+  // read them unchecked. endIndex is within the reader (ValidateBlockBounds)
+  const size_t eventWords = GetEventSizeWords(dualChInfo);
+
+  // The options are fixed for the block: pick the specialized decoder once
+  const EventDecoder decodeEvent = SelectEventDecoder(dualChInfo);
+
+  while (wordIndex < endIndex) {
+    if (wordIndex + eventWords > endIndex) {
+      DECODER_LOG_ERROR("DecodeChannelPairEvents",
+                        "Truncated event at word " << wordIndex << ", need "
+                            << eventWords << " words");
+      fCounters.RecordDecodeError();
+      wordIndex = endIndex;
+      break;
+    }
+
+    if (suppress && SkipSuppressedEvent(reader, wordIndex, eventWords, pair,
+                                        dualChInfo, suppressed)) {
+      continue;
+    }
+
+    if (fOutputFormat == OutputFormat::EventBatch) {
+      (this->*decodeEvent)(reader, wordIndex, dualChInfo, scratchEvent);
+      scratchEvent.channel += pair * 2;
+      eventBatch.Append(scratchEvent);
+      continue;
+    }
+
+    auto eventData = std::make_unique<EventData>();
+    (this->*decodeEvent)(reader, wordIndex, dualChInfo, *eventData);
+    // Set the channel pair offset
+    eventData->channel += pair * 2;  // Each pair handles 2 channels
+    eventDataVec.push_back(std::move(eventData));
+  }
+
+  if (suppress) fCounters.RecordSuppressed(suppressed);
+}
+
+bool PHA1Decoder::SkipSuppressedEvent(
+    MemoryReader &reader, size_t &wordIndex, size_t eventWords, int pair,
+    const PHA1DualChannelInfo &dualChInfo,
+    std::array<uint64_t, ZeroSuppression::kMaxChannels> &suppressed) const
+{
+  // Event layout: time tag, [extras], [waveform], [energy]. The energy word
+  // comes last, so it is the last word of the event
+  uint32_t timeTagWord = reader.ReadWord32Unchecked(wordIndex);
+  uint8_t channel = static_cast<uint8_t>(
+      pair * 2 +
+      ((timeTagWord >> PHA1Constants::Event::kChannelFlagShift) & 0x1));
+
+  uint64_t flags = 0;
+  if (dualChInfo.extras2Enabled &&
+      dualChInfo.extraOption ==
+          PHA1Constants::ExtraFormats::kExtendedFlagsFineTT) {
+    flags = ConvertExtrasFlags((reader.ReadWord32Unchecked(wordIndex + 1) >>
+                                PHA1Constants::Event::kFlagsShift) &
+                               PHA1Constants::Event::kFlagsMask);
+  }
+  uint16_t energy = 0;
+  if (dualChInfo.energyEnabled) {
+    uint32_t energyWord = reader.ReadWord32Unchecked(wordIndex + eventWords - 1);
+    energy = energyWord & PHA1Constants::Event::kEnergyMask;
+    if ((energyWord >> PHA1Constants::Event::kPileupFlagShift) & 0x1) {
+      flags |= EventData::FLAG_PILEUP;
+    }
+  }
+
+  if (!fZeroSuppression.Reject(channel, energy, flags)) return false;
+  suppressed[channel]++;  // Reject() passes channels >= kMaxChannels
+  wordIndex += eventWords;
+  return true;
+}
+
+size_t PHA1Decoder::GetEventSizeWords(const PHA1DualChannelInfo &dualChInfo)
+{
+  // Time tag, [extras], [waveform], [energy], as DecodeEvent() reads them
+  size_t waveformWords =
+      dualChInfo.samplesEnabled
+          ? dualChInfo.numSamplesWave * PHA1Constants::Waveform::kSamplesPerWord
+          : 0;
+  return 1 + (dualChInfo.extras2Enabled ? 1 : 0) + waveformWords +
+         (dualChInfo.energyEnabled ? 1 : 0);
+}
+
+DecoderResult PHA1Decoder::LocateChannelPairBlocks(
+    MemoryReader &reader, std::vector<ChannelPairBlock> &blocks)
+{
+  const size_t totalSize = reader.GetTotalSizeWords();
+  size_t wordIndex = 0;
+
+  while (wordIndex < totalSize) {
+    PHA1BoardHeaderInfo boardInfo;
+    DecoderResult result = DecodeBoardHeader(reader, wordIndex, boardInfo);
+    if (result != DecoderResult::Success) {
+      return result;
+    }
+
+    size_t boardEndIndex = wordIndex -
+                           PHA1Constants::BoardHeader::kHeaderSizeWords +
+                           boardInfo.aggregateSize;
+    result = ValidateBlockBounds(wordIndex, boardEndIndex, totalSize);
+    if (result != DecoderResult::Success) {
+      return result;
+    }
+
+    for (size_t pair = 0; pair < PHA1Constants::Validation::kMaxChannelPairs;
+         ++pair) {
+      if (!(boardInfo.dualChannelMask & (1 << pair))) {
+        continue;  // This channel pair is not active
+      }
+
+      if (wordIndex >= boardEndIndex) {
+        DECODER_LOG_ERROR("LocateChannelPairBlocks",
+                          "Unexpected end of board aggregate block");
+        return DecoderResult::OutOfBounds;
       }
+
+      ChannelPairBlock block;
+      block.pair = static_cast<int>(pair);
+      result = DecodeDualChannelHeader(reader, wordIndex, block.dualChInfo);
+      if (result != DecoderResult::Success) {
+        DECODER_LOG_ERROR("LocateChannelPairBlocks",
+                          "Failed to decode dual channel header for pair "
+                              << pair);
+        return result;
+      }
+
+      size_t channelEndIndex = wordIndex -
+                               PHA1Constants::ChannelHeader::kHeaderSizeWords +
+                               block.dualChInfo.aggregateSize;
+      if (channelEndIndex < wordIndex) {
+        DECODER_LOG_ERROR("LocateChannelPairBlocks",
+                          "Channel aggregate size smaller than header");
+        return DecoderResult::CorruptedData;
+      }
+      if (ValidateBlockBounds(channelEndIndex, boardEndIndex, totalSize) !=
+          DecoderResult::Success) {
+        DECODER_LOG_ERROR("LocateChannelPairBlocks",
+                          "Channel aggregate block extends beyond board");
+        channelEndIndex = boardEndIndex;  // Clamp to board end
+      }
+
+      block.beginIndex = wordIndex;
+      block.endIndex = channelEndIndex;
+      blocks.push_back(block);
+
+      // The header carries the block size, so jump to the next pair
+      wordIndex = channelEndIndex;
     }
+
+    wordIndex = boardEndIndex;
   }
 
   return DecoderResult::Success;
 }
 
+void PHA1Decoder::ProcessChannelPairsParallel(
+    MemoryReader &reader, std::vector<std::unique_ptr<EventData>> &eventDataVec,
+    EventBatch &eventBatch)
+{
+  std::vector<ChannelPairBlock> blocks;
+  DecoderResult result = LocateChannelPairBlocks(reader, blocks);
+  if (result != DecoderResult::Success) {
+    DECODER_LOG_RESULT(result, "ProcessChannelPairsParallel",
+                       "Stopped locating blocks, decoding the " << blocks.size()
+                           << " found so far");
+  }
+
+  // One output per block so the workers never share a container
+  const int nBlocks = static_cast<int>(blocks.size());
+  std::vector<std::vector<std::unique_ptr<EventData>>> blockEvents(nBlocks);
+  std::vector<std::unique_ptr<EventBatch>> blockBatches(nBlocks);
+  for (auto &blockBatch : blockBatches) {
+    blockBatch = fEventBatchPool.Acquire();
+  }
+
+#pragma omp parallel for num_threads(fChannelPairThreads) schedule(dynamic)
+  for (int i = 0; i < nBlocks; ++i) {
+    EventData scratchEvent;
+    size_t wordIndex = blocks[i].beginIndex;
+    DecodeChannelPairEvents(reader, wordIndex, blocks[i].endIndex,
+                            blocks[i].pair, blocks[i].dualChInfo, scratchEvent,
+                            blockEvents[i], *blockBatches[i]);
+  }
+
+  // Merge in block order, ProcessEventData sorts the result by timestamp
+  for (int i = 0; i < nBlocks; ++i) {
+    eventDataVec.insert(eventDataVec.end(),
+                        std::make_move_iterator(blockEvents[i].begin()),
+                        std::make_move_iterator(blockEvents[i].end()));
+    eventBatch.Append(*blockBatches[i]);
+    fEventBatchPool.Release(std::move(blockBatches[i]));
+  }
+}
+
 DecoderResult PHA1Decoder::ValidateBlockBounds(size_t currentIndex,
                                                size_t endIndex,
                                                size_t totalSize)
 {
   if (endIndex > totalSize) {
-    DecoderLogger::LogError(
-        "ValidateBlockBounds",
-        "Block extends beyond data: " + std::to_string(endIndex) + " > " +
-            std::to_string(totalSize));
+    DECODER_LOG_ERROR("ValidateBlockBounds",
+                      "Block extends beyond data: " << endIndex << " > "
+                          << totalSize);
     return DecoderResult::OutOfBounds;
   }
 
   if (currentIndex > endIndex) {
-    DecoderLogger::LogError(
-        "ValidateBlockBounds",
-        "Invalid block bounds: current=" + std::to_string(currentIndex) +
-            " > end=" + std::to_string(endIndex));
+    DECODER_LOG_ERROR("ValidateBlockBounds",
+                      "Invalid block bounds: current=" << currentIndex
+                          << " > end=" << endIndex);
     return DecoderResult::CorruptedData;
   }
 
@@ -379,8 +817,8 @@ DecoderResult PHA1Decoder::DecodeBoardHeader(MemoryReader &reader,
   // Ensure we have enough data for the board header
   if (reader.GetRemainingWords(wordIndex) <
       PHA1Constants::BoardHeader::kHeaderSizeWords) {
-    DecoderLogger::LogError("DecodeBoardHeader",
-                            "Insufficient data for board header");
+    DECODER_LOG_ERROR("DecodeBoardHeader",
+                      "Insufficient data for board header");
     return DecoderResult::InsufficientData;
   }
 
@@ -388,7 +826,7 @@ DecoderResult PHA1Decoder::DecodeBoardHeader(MemoryReader &reader,
   // Read all header words
   uint32_t headerWords[4];
   for (int i = 0; i < 4; ++i) {
-    headerWords[i] = reader.ReadWord32(wordIndex++);
+    headerWords[i] = reader.ReadWord32Unchecked(wordIndex++);
   }
 
   // Validate header structure
@@ -416,15 +854,28 @@ DecoderResult PHA1Decoder::DecodeBoardHeader(MemoryReader &reader,
       headerWords[2] & PHA1Constants::BoardHeader::kBoardCounterMask;
   boardInfo.boardTimeTag = headerWords[3];
 
+  // Counter continuity is only meaningful when aggregates arrive in order
+  if (fDecodeThreads.size() == 1) {
+    uint64_t expected =
+        (fLastCounter + 1) & PHA1Constants::BoardHeader::kBoardCounterMask;
+    if (boardInfo.aggregateCounter != 0 &&
+        boardInfo.aggregateCounter != expected) {
+      fCounters.RecordCounterDiscontinuity();
+      DECODER_LOG_WARNING("DecodeBoardHeader",
+                          "Aggregate counter discontinuity: " << fLastCounter
+                              << " -> " << boardInfo.aggregateCounter);
+    }
+    fLastCounter = boardInfo.aggregateCounter;
+  }
+
   if (fDumpFlag) {
-    DecoderLogger::LogDebug(
-        "DecodeBoardHeader",
-        "Board Header - Aggregate Size: " +
-            std::to_string(boardInfo.aggregateSize) +
-            ", Dual Channel Mask: 0x" +
-            std::to_string(static_cast<int>(boardInfo.dualChannelMask)) +
-            ", Board ID: " +
-            std::to_string(static_cast<int>(boardInfo.boardId)));
+    DECODER_LOG_DEBUG("DecodeBoardHeader",
+                      "Board Header - Aggregate Size: "
+                          << boardInfo.aggregateSize
+                          << ", Dual Channel Mask: 0x" << std::hex
+                          << static_cast<int>(boardInfo.dualChannelMask)
+                          << std::dec << ", Board ID: "
+                          << static_cast<int>(boardInfo.boardId));
   }
 
   return DecoderResult::Success;
@@ -437,15 +888,15 @@ DecoderResult PHA1Decoder::DecodeDualChannelHeader(MemoryReader &reader,
   // Ensure we have enough data for the dual channel header
   if (reader.GetRemainingWords(wordIndex) <
       PHA1Constants::ChannelHeader::kHeaderSizeWords) {
-    DecoderLogger::LogError("DecodeDualChannelHeader",
-                            "Insufficient data for dual channel header");
+    DECODER_LOG_ERROR("DecodeDualChannelHeader",
+                      "Insufficient data for dual channel header");
     return DecoderResult::InsufficientData;
   }
 
   // Read header words
   uint32_t headerWords[2];
   for (int i = 0; i < 2; ++i) {
-    headerWords[i] = reader.ReadWord32(wordIndex++);
+    headerWords[i] = reader.ReadWord32Unchecked(wordIndex++);
   }
 
   // Validate header structure
@@ -486,104 +937,83 @@ DecoderResult PHA1Decoder::DecodeDualChannelHeader(MemoryReader &reader,
       (headerWords[1] >> PHA1Constants::ChannelHeader::kDualTraceShift) & 0x1;
 
   if (fDumpFlag) {
-    DecoderLogger::LogDebug(
-        "DecodeDualChannelHeader",
-        "Dual Channel Header - Aggregate Size: " +
-            std::to_string(dualChInfo.aggregateSize) +
-            ", Samples/8: " + std::to_string(dualChInfo.numSamplesWave) +
-            ", Samples Enabled: " + std::to_string(dualChInfo.samplesEnabled));
+    DECODER_LOG_DEBUG("DecodeDualChannelHeader",
+                      "Dual Channel Header - Aggregate Size: "
+                          << dualChInfo.aggregateSize << ", Samples/8: "
+                          << dualChInfo.numSamplesWave << ", Samples Enabled: "
+                          << dualChInfo.samplesEnabled);
   }
 
   return DecoderResult::Success;
 }
 
-std::unique_ptr<EventData> PHA1Decoder::DecodeEventDirect(
-    MemoryReader &reader, size_t &wordIndex, const PHA1DualChannelInfo &dualChInfo)
+template <bool kExtras, bool kFineTT, bool kWaveform, bool kEnergy>
+void PHA1Decoder::DecodeEvent(MemoryReader &reader, size_t &wordIndex,
+                              const PHA1DualChannelInfo &dualChInfo,
+                              EventData &eventData)
 {
   // Decode event header (time tag and channel flag)
   uint32_t triggerTimeTag;
   bool isOddChannel;
-  DecoderResult result =
-      DecodeEventHeader(reader, wordIndex, triggerTimeTag, isOddChannel);
-  if (result != DecoderResult::Success) {
-    DecoderLogger::LogResult(result, "DecodeEventDirect",
-                             "Failed to decode event header");
-    return nullptr;
-  }
+  DecodeEventHeader(reader, wordIndex, triggerTimeTag, isOddChannel);
 
-  // Calculate waveform size
+  // Calculate waveform size (nothing is unpacked unless decoding traces)
   size_t waveformSize =
-      dualChInfo.numSamplesWave * PHA1Constants::Waveform::kSamplesPerGroup;
-
-  // Create EventData with proper size
-  auto eventData = std::make_unique<EventData>(waveformSize);
+      kWaveform && fWaveformMode == WaveformMode::Decode
+          ? dualChInfo.numSamplesWave * PHA1Constants::Waveform::kSamplesPerGroup
+          : 0;
+
+  // Size the waveform and clear fields that are only written when the
+  // matching option is enabled, so a reused EventData starts clean
+  eventData.ResizeWaveform(waveformSize);
+  eventData.packedWaveform.clear();
+  eventData.energy = 0;
+  eventData.energyShort = 0;
+  eventData.flags = 0;
 
   // Set basic event information
-  eventData->channel =
+  eventData.channel =
       isOddChannel ? 1 : 0;  // Will be adjusted by caller for channel pair
-  eventData->module = fModuleNumber;
-  eventData->timeResolution = fTimeStep;
+  eventData.module = fModuleNumber;
+  eventData.timeResolution = fTimeStep;
 
   // Store probe type information
-  eventData->digitalProbe1Type = dualChInfo.digitalProbe;
-  eventData->digitalProbe2Type = 0;  // PHA1 has only one digital probe
-  eventData->analogProbe1Type = dualChInfo.analogProbe1;
-  eventData->analogProbe2Type = dualChInfo.analogProbe2;
-
-  // Decode timestamp
-  result = DecodeEventTimestamp(reader, wordIndex, dualChInfo, triggerTimeTag,
-                                *eventData);
-  if (result != DecoderResult::Success) {
-    DecoderLogger::LogResult(result, "DecodeEventDirect",
-                             "Failed to decode timestamp");
-    return nullptr;
-  }
-
-  // Decode other event data components
-  result = DecodeEventDataComponents(reader, wordIndex, dualChInfo, *eventData);
-  if (result != DecoderResult::Success) {
-    DecoderLogger::LogResult(result, "DecodeEventDirect",
-                             "Failed to decode event data components");
-    return nullptr;
-  }
-
-  return eventData;
+  eventData.digitalProbe1Type = dualChInfo.digitalProbe;
+  eventData.digitalProbe2Type = 0;  // PHA1 has only one digital probe
+  eventData.analogProbe1Type = dualChInfo.analogProbe1;
+  eventData.analogProbe2Type = dualChInfo.analogProbe2;
+
+  DecodeEventTimestamp<kExtras, kFineTT>(reader, wordIndex, dualChInfo,
+                                         triggerTimeTag, eventData);
+  DecodeEventDataComponents<kWaveform, kEnergy>(reader, wordIndex, dualChInfo,
+                                                eventData);
 }
 
-DecoderResult PHA1Decoder::DecodeEventHeader(MemoryReader &reader,
-                                             size_t &wordIndex,
-                                             uint32_t &triggerTimeTag,
-                                             bool &isOddChannel)
+void PHA1Decoder::DecodeEventHeader(MemoryReader &reader, size_t &wordIndex,
+                                    uint32_t &triggerTimeTag,
+                                    bool &isOddChannel)
 {
-  if (!reader.IsValidIndex(wordIndex)) {
-    return DecoderResult::InsufficientData;
-  }
-
   // Read trigger time tag (first word of event)
-  uint32_t timeTagWord = reader.ReadWord32(wordIndex++);
+  uint32_t timeTagWord = reader.ReadWord32Unchecked(wordIndex++);
   triggerTimeTag = timeTagWord & PHA1Constants::Event::kTriggerTimeTagMask;
   isOddChannel = (timeTagWord >> PHA1Constants::Event::kChannelFlagShift) & 0x1;
-
-  return DecoderResult::Success;
 }
 
-DecoderResult PHA1Decoder::DecodeEventTimestamp(
-    MemoryReader &reader, size_t &wordIndex, const PHA1DualChannelInfo &dualChInfo,
-    uint32_t triggerTimeTag, EventData &eventData)
+template <bool kExtras, bool kFineTT>
+void PHA1Decoder::DecodeEventTimestamp(MemoryReader &reader, size_t &wordIndex,
+                                       const PHA1DualChannelInfo &dualChInfo,
+                                       uint32_t triggerTimeTag,
+                                       EventData &eventData)
 {
-  if (dualChInfo.extras2Enabled) {
-    if (!reader.IsValidIndex(wordIndex)) {
-      return DecoderResult::InsufficientData;
-    }
-
-    uint32_t extrasWord = reader.ReadWord32(wordIndex++);
+  if constexpr (kExtras) {
+    uint32_t extrasWord = reader.ReadWord32Unchecked(wordIndex++);
 
     // Extract extended timestamp and fine timestamp based on extra option
     uint16_t extendedTime = 0;
     uint16_t fineTimeStamp = 0;
 
-    DecodeExtrasWord(extrasWord, dualChInfo.extraOption, eventData,
-                     extendedTime, fineTimeStamp);
+    DecodeExtrasWord<kFineTT>(extrasWord, dualChInfo.extraOption, eventData,
+                              extendedTime, fineTimeStamp);
 
     // Calculate final timestamp using extended timestamp (47-bit total)
     uint64_t extendedTimestamp = static_cast<uint64_t>(extendedTime) << 31;
@@ -595,51 +1025,79 @@ DecoderResult PHA1Decoder::DecodeEventTimestamp(
 
     // Add fine time correction only for option 010 (2)
     double fineTimeNs = 0.0;
-    if (dualChInfo.extraOption ==
-        PHA1Constants::ExtraFormats::kExtendedFlagsFineTT) {
+    uint64_t fineTimePs = 0;
+    if constexpr (kFineTT) {
       fineTimeNs = static_cast<double>(fineTimeStamp) * fFineTimeMultiplier;
+      fineTimePs = (fineTimeStamp * fTimeStepPs) >> 10;  // 1024 steps/sample
     }
 
     eventData.timeStampNs = static_cast<double>(finalTimestamp) + fineTimeNs;
+    eventData.timeStampPs = combinedTimeTag * fTimeStepPs + fineTimePs;
 
     if (fDumpFlag) {
-      DecoderLogger::LogDebug(
-          "DecodeEventTimestamp",
-          "Timestamp calc: trigger=" + std::to_string(triggerTimeTag) +
-              ", extended=" + std::to_string(extendedTime) +
-              ", combined=" + std::to_string(combinedTimeTag) +
-              ", fine=" + std::to_string(fineTimeStamp) +
-              ", final=" + std::to_string(eventData.timeStampNs) + " ns" +
-              ", extraOption=" + std::to_string(dualChInfo.extraOption));
+      DECODER_LOG_DEBUG("DecodeEventTimestamp",
+                        "Timestamp calc: trigger=" << triggerTimeTag
+                            << ", extended=" << extendedTime << ", combined="
+                            << combinedTimeTag << ", fine=" << fineTimeStamp
+                            << ", final=" << eventData.timeStampNs << " ns"
+                            << ", extraOption="
+                            << static_cast<int>(dualChInfo.extraOption));
     }
   } else {
     // No extended timestamp available - use only trigger time tag
     eventData.timeStampNs = static_cast<double>(triggerTimeTag) * fTimeStep;
+    eventData.timeStampPs = triggerTimeTag * fTimeStepPs;
   }
-
-  return DecoderResult::Success;
 }
 
-DecoderResult PHA1Decoder::DecodeEventDataComponents(
-    MemoryReader &reader, size_t &wordIndex, const PHA1DualChannelInfo &dualChInfo,
-    EventData &eventData)
+template <bool kWaveform, bool kEnergy>
+void PHA1Decoder::DecodeEventDataComponents(MemoryReader &reader,
+                                            size_t &wordIndex,
+                                            const PHA1DualChannelInfo &dualChInfo,
+                                            EventData &eventData)
 {
   // Decode waveform data if present
-  if (dualChInfo.samplesEnabled && eventData.waveformSize > 0) {
+  if constexpr (kWaveform) {
     DecodeWaveform(reader, wordIndex, dualChInfo, eventData);
   }
 
   // Decode energy word if present
-  if (dualChInfo.energyEnabled) {
-    if (!reader.IsValidIndex(wordIndex)) {
-      return DecoderResult::InsufficientData;
-    }
-
-    uint32_t energyWord = reader.ReadWord32(wordIndex++);
+  if constexpr (kEnergy) {
+    uint32_t energyWord = reader.ReadWord32Unchecked(wordIndex++);
     DecodeEnergyWord(energyWord, eventData);
   }
+}
 
-  return DecoderResult::Success;
+const PHA1Decoder::EventDecoder PHA1Decoder::kEventDecoders[16] = {
+    &PHA1Decoder::DecodeEvent<false, false, false, false>,
+    &PHA1Decoder::DecodeEvent<false, false, false, true>,
+    &PHA1Decoder::DecodeEvent<false, false, true, false>,
+    &PHA1Decoder::DecodeEvent<false, false, true, true>,
+    &PHA1Decoder::DecodeEvent<false, true, false, false>,
+    &PHA1Decoder::DecodeEvent<false, true, false, true>,
+    &PHA1Decoder::DecodeEvent<false, true, true, false>,
+    &PHA1Decoder::DecodeEvent<false, true, true, true>,
+    &PHA1Decoder::DecodeEvent<true, false, false, false>,
+    &PHA1Decoder::DecodeEvent<true, false, false, true>,
+    &PHA1Decoder::DecodeEvent<true, false, true, false>,
+    &PHA1Decoder::DecodeEvent<true, false, true, true>,
+    &PHA1Decoder::DecodeEvent<true, true, false, false>,
+    &PHA1Decoder::DecodeEvent<true, true, false, true>,
+    &PHA1Decoder::DecodeEvent<true, true, true, false>,
+    &PHA1Decoder::DecodeEvent<true, true, true, true>,
+};
+
+PHA1Decoder::EventDecoder PHA1Decoder::SelectEventDecoder(
+    const PHA1DualChannelInfo &dualChInfo)
+{
+  bool fineTT = dualChInfo.extras2Enabled &&
+                dualChInfo.extraOption ==
+                    PHA1Constants::ExtraFormats::kExtendedFlagsFineTT;
+  bool waveform = dualChInfo.samplesEnabled && dualChInfo.numSamplesWave > 0;
+  // Index bits as in kEventDecoders: extras, fine TT, waveform, energy
+  size_t index = (dualChInfo.extras2Enabled ? 8 : 0) | (fineTT ? 4 : 0) |
+                 (waveform ? 2 : 0) | (dualChInfo.energyEnabled ? 1 : 0);
+  return kEventDecoders[index];
 }
 
 void PHA1Decoder::DecodeWaveform(MemoryReader &reader, size_t &wordIndex,
@@ -651,139 +1109,94 @@ void PHA1Decoder::DecodeWaveform(MemoryReader &reader, size_t &wordIndex,
   size_t numWords =
       dualChInfo.numSamplesWave * PHA1Constants::Waveform::kSamplesPerWord;
 
-  // Check if we have enough data
-  if (reader.GetRemainingWords(wordIndex) < numWords) {
-    DecoderLogger::LogError("DecodeWaveform",
-                            "Insufficient data for waveform: need " +
-                                std::to_string(numWords) + " words");
-    return;
-  }
-
-  for (size_t i = 0; i < numWords; ++i) {
-    uint32_t waveformWord = reader.ReadWord32(wordIndex++);
-
-    // Each word contains two 16-bit samples
-    uint16_t sample1 = waveformWord & PHA1Constants::Waveform::kSampleMask;
-    uint16_t sample2 =
-        (waveformWord >> PHA1Constants::Waveform::kSecondSampleShift) &
-        PHA1Constants::Waveform::kSampleMask;
-
-    size_t sampleIndex1 = i * PHA1Constants::Waveform::kSamplesPerWord;
-    size_t sampleIndex2 = i * PHA1Constants::Waveform::kSamplesPerWord + 1;
-
-    if (sampleIndex1 < eventData.waveformSize) {
-      // Extract analog data (14 bits)
-      eventData.analogProbe1[sampleIndex1] =
-          sample1 & PHA1Constants::Waveform::kAnalogSampleMask;
-
-      // Extract digital probes
-      eventData.digitalProbe1[sampleIndex1] =
-          (sample1 >> PHA1Constants::Waveform::kDigitalProbeWaveShift) & 0x1;
-      eventData.digitalProbe2[sampleIndex1] =
-          (sample1 >> PHA1Constants::Waveform::kTriggerFlagShift) & 0x1;
-
-      // For dual trace mode, second analog probe data comes from odd samples
-      if (dualChInfo.dualTraceEnabled && sampleIndex1 > 0) {
-        eventData.analogProbe2[sampleIndex1] =
-            eventData.analogProbe1[sampleIndex1 - 1];
-      }
-    }
-
-    if (sampleIndex2 < eventData.waveformSize) {
-      // Extract analog data (14 bits)
-      eventData.analogProbe1[sampleIndex2] =
-          sample2 & PHA1Constants::Waveform::kAnalogSampleMask;
-
-      // Extract digital probes
-      eventData.digitalProbe1[sampleIndex2] =
-          (sample2 >> PHA1Constants::Waveform::kDigitalProbeWaveShift) & 0x1;
-      eventData.digitalProbe2[sampleIndex2] =
-          (sample2 >> PHA1Constants::Waveform::kTriggerFlagShift) & 0x1;
-
-      // For dual trace mode, odd samples contain second analog probe data
-      if (dualChInfo.dualTraceEnabled) {
-        eventData.analogProbe2[sampleIndex2] =
-            eventData.analogProbe1[sampleIndex2];
-        // Restore the correct first analog probe data (from even sample)
-        eventData.analogProbe1[sampleIndex2] =
-            eventData.analogProbe1[sampleIndex2 - 1];
-      }
+  if (fWaveformMode == WaveformMode::Decode) {
+    // Decode the whole trace in one vectorized pass
+    WaveformUnpack::UnpackDig1(reader.GetWordPointer(wordIndex), numWords,
+                               eventData.waveformSize,
+                               dualChInfo.dualTraceEnabled,
+                               WaveformUnpack::ForEvent(eventData));
+  } else if (IsPackedWaveformMode(fWaveformMode)) {
+    // EventData::UnpackWaveform() decodes the trace on demand
+    const uint8_t *words = reader.GetWordPointer(wordIndex);
+    PackedWaveformInfo info;
+    info.format = PackedWaveformInfo::Format::Dig1;
+    info.dualTrace = dualChInfo.dualTraceEnabled;
+    info.nSamples =
+        dualChInfo.numSamplesWave * PHA1Constants::Waveform::kSamplesPerGroup;
+    if (fWaveformMode == WaveformMode::Lazy) {
+      eventData.packedWaveform.assign(words, words + numWords * kWordSize);
+      eventData.packedWaveformInfo = info;
+    } else {
+      WaveformCodec::Compress(words, numWords * kWordSize, info,
+                              fWaveformMode == WaveformMode::CompactDelta,
+                              eventData);
     }
   }
+  wordIndex += numWords;
+}
+
+uint64_t PHA1Decoder::ConvertExtrasFlags(uint8_t flags)
+{
+  uint64_t result = 0;
+  if (flags & 0x20)
+    result |= ::DELILA::Digitizer::EventData::
+        FLAG_TRIGGER_LOST;  // bit[15] = bit[5] in 6-bit flags
+  if (flags & 0x10)
+    result |= ::DELILA::Digitizer::EventData::
+        FLAG_OVER_RANGE;  // bit[14] = bit[4] in 6-bit flags
+  if (flags & 0x08)
+    result |= ::DELILA::Digitizer::EventData::
+        FLAG_1024_TRIGGER;  // bit[13] = bit[3] in 6-bit flags
+  if (flags & 0x04)
+    result |= ::DELILA::Digitizer::EventData::
+        FLAG_N_LOST_TRIGGER;  // bit[12] = bit[2] in 6-bit flags
+  return result;
 }
 
+template <bool kFineTT>
 void PHA1Decoder::DecodeExtrasWord(uint32_t extrasWord, uint8_t extraOption,
                                    ::DELILA::Digitizer::EventData &eventData,
                                    uint16_t &extendedTime,
                                    uint16_t &fineTimeStamp)
 {
   // Initialize outputs
-  extendedTime = 0;
   fineTimeStamp = 0;
   eventData.flags = 0;
 
-  // Decode based on extra option format
-  switch (extraOption) {
-    case PHA1Constants::ExtraFormats::
-        kExtendedTimestampOnly:  // 0b000 - Extended timestamp only
-    case PHA1Constants::ExtraFormats::
-        kExtendedTimestampOnly1:  // 0b001 - Extended timestamp only
-      extendedTime = (extrasWord >> PHA1Constants::Event::kExtendedTimeShift) &
-                     PHA1Constants::Event::kExtendedTimeMask;
+  // Every option carries the extended timestamp in the same bits
+  extendedTime = (extrasWord >> PHA1Constants::Event::kExtendedTimeShift) &
+                 PHA1Constants::Event::kExtendedTimeMask;
 
-      if (fDumpFlag) {
-        DecoderLogger::LogDebug(
-            "DecodeExtrasWord",
-            "Extra option " + std::to_string(extraOption) +
-                " - Extended Time: " + std::to_string(extendedTime));
-      }
-      break;
-
-    case PHA1Constants::ExtraFormats::
-        kExtendedFlagsFineTT:  // 0b010 - Extended timestamp + flags + fine timestamp
-    {
-      fineTimeStamp = extrasWord & PHA1Constants::Event::kFineTimeStampMask;
-      uint8_t flags = (extrasWord >> PHA1Constants::Event::kFlagsShift) &
-                      PHA1Constants::Event::kFlagsMask;
-      extendedTime = (extrasWord >> PHA1Constants::Event::kExtendedTimeShift) &
-                     PHA1Constants::Event::kExtendedTimeMask;
-
-      // Store flags in EventData.flags field
-      if (flags & 0x20)
-        eventData.flags |= ::DELILA::Digitizer::EventData::
-            FLAG_TRIGGER_LOST;  // bit[15] = bit[5] in 6-bit flags
-      if (flags & 0x10)
-        eventData.flags |= ::DELILA::Digitizer::EventData::
-            FLAG_OVER_RANGE;  // bit[14] = bit[4] in 6-bit flags
-      if (flags & 0x08)
-        eventData.flags |= ::DELILA::Digitizer::EventData::
-            FLAG_1024_TRIGGER;  // bit[13] = bit[3] in 6-bit flags
-      if (flags & 0x04)
-        eventData.flags |= ::DELILA::Digitizer::EventData::
-            FLAG_N_LOST_TRIGGER;  // bit[12] = bit[2] in 6-bit flags
-
-      if (fDumpFlag) {
-        DecoderLogger::LogDebug(
-            "DecodeExtrasWord",
-            "Extra option 2 - Fine Time: " + std::to_string(fineTimeStamp) +
-                ", Flags: 0x" + std::to_string(static_cast<int>(flags)) +
-                ", Extended Time: " + std::to_string(extendedTime));
-      }
-    } break;
+  if constexpr (kFineTT) {
+    // 0b010 - Extended timestamp + flags + fine timestamp
+    fineTimeStamp = extrasWord & PHA1Constants::Event::kFineTimeStampMask;
+    uint8_t flags = (extrasWord >> PHA1Constants::Event::kFlagsShift) &
+                    PHA1Constants::Event::kFlagsMask;
 
-    default:
-      // For other options, assume extended timestamp format
-      extendedTime = (extrasWord >> PHA1Constants::Event::kExtendedTimeShift) &
-                     PHA1Constants::Event::kExtendedTimeMask;
+    // Store flags in EventData.flags field
+    eventData.flags |= ConvertExtrasFlags(flags);
 
-      if (fDumpFlag) {
-        DecoderLogger::LogWarning(
-            "DecodeExtrasWord",
-            "Unknown extra option " + std::to_string(extraOption) +
-                ", treating as extended timestamp only. Value: " +
-                std::to_string(extendedTime));
-      }
-      break;
+    if (fDumpFlag) {
+      DECODER_LOG_DEBUG("DecodeExtrasWord",
+                        "Extra option 2 - Fine Time: " << fineTimeStamp
+                            << ", Flags: 0x" << std::hex
+                            << static_cast<int>(flags) << std::dec
+                            << ", Extended Time: " << extendedTime);
+    }
+  } else if (fDumpFlag) {
+    if (extraOption == PHA1Constants::ExtraFormats::kExtendedTimestampOnly ||
+        extraOption == PHA1Constants::ExtraFormats::kExtendedTimestampOnly1) {
+      DECODER_LOG_DEBUG("DecodeExtrasWord",
+                        "Extra option " << static_cast<int>(extraOption)
+                            << " - Extended Time: " << extendedTime);
+    } else {
+      // Other options are treated as extended timestamp only
+      DECODER_LOG_WARNING(
+          "DecodeExtrasWord",
+          "Unknown extra option " << static_cast<int>(extraOption)
+              << ", treating as extended timestamp only. Value: "
+              << extendedTime);
+    }
   }
 }
 
@@ -809,11 +1222,9 @@ void PHA1Decoder::DecodeEnergyWord(uint32_t energyWord,
   eventData.energyShort = extraData;
 
   if (fDumpFlag) {
-    DecoderLogger::LogDebug(
-        "DecodeEnergyWord",
-        "Energy: " + std::to_string(eventData.energy) +
-            ", Pileup: " + std::to_string(pileupFlag) +
-            ", Extra: " + std::to_string(extraData));
+    DECODER_LOG_DEBUG("DecodeEnergyWord",
+                      "Energy: " << eventData.energy << ", Pileup: "
+                          << pileupFlag << ", Extra: " << extraData);
   }
 }
 
@@ -823,10 +1234,14 @@ void PHA1Decoder::DecodeEnergyWord(uint32_t energyWord,
 
 DataType PHA1Decoder::AddData(std::unique_ptr<RawData_t> rawData)
 {
+  fInFlight.Add();  // Balanced by the buffer's FinishSequence()
   if (rawData->size % kWordSize != 0) {
-    DecoderLogger::LogError("AddData", "PHA1 data size is not a multiple of " +
-                                           std::to_string(kWordSize) +
-                                           " bytes");
+    DECODER_LOG_ERROR("AddData",
+                      "PHA1 data size is not a multiple of " << kWordSize
+                          << " bytes");
+    fCounters.RecordDiscarded();
+    FinishSequence(*rawData);
+    RecycleRawData(std::move(rawData));
     return DataType::Unknown;
   }
 
@@ -834,41 +1249,57 @@ DataType PHA1Decoder::AddData(std::unique_ptr<RawData_t> rawData)
   auto dataType = CheckDataType(rawData);
 
   if (fDumpFlag) {
-    DecoderLogger::LogDebug(
-        "AddData", "PHA1 AddData: size=" + std::to_string(rawData->size) +
-                       ", type=" + std::to_string(static_cast<int>(dataType)));
+    DECODER_LOG_DEBUG("AddData",
+                      "PHA1 AddData: size=" << rawData->size << ", type="
+                          << static_cast<int>(dataType));
   }
 
   if (dataType == DataType::Event) {
     if (fIsRunning) {
-      std::lock_guard<std::mutex> lock(fRawDataMutex);
-      fRawDataQueue.push_back(std::move(rawData));
+      // Leaves rawData untouched if the queue has been closed; dropped
+      // buffers are counted and recycled right away
+      auto drop = [this](std::unique_ptr<RawData_t> dropped) {
+        FinishSequence(*dropped);
+        RecycleRawData(std::move(dropped));
+      };
+      if (fTracer) rawData->queuedTicks = PipelineTracer::Now();
+      if (!fBackpressure.PushRawData(fRawDataQueue, rawData, fCounters,
+                                     drop)) {
+        fCounters.RecordDiscarded();
+      }
       if (fDumpFlag) {
-        DecoderLogger::LogDebug("AddData",
-                                "Added PHA1 event data to queue, queue size: " +
-                                    std::to_string(fRawDataQueue.size()));
+        DECODER_LOG_DEBUG("AddData",
+                          "Added PHA1 event data to queue, queue size: "
+                              << fRawDataQueue.Size());
       }
     } else {
+      fCounters.RecordDiscarded();
       if (fDumpFlag) {
-        DecoderLogger::LogDebug(
-            "AddData", "PHA1 decoder not running, discarding event data");
+        DECODER_LOG_DEBUG("AddData",
+                          "PHA1 decoder not running, discarding event data");
       }
     }
   } else if (dataType == DataType::Start) {
     fIsRunning = true;
     if (fDumpFlag) {
-      DecoderLogger::LogDebug("AddData", "PHA1 decoder started");
+      DECODER_LOG_DEBUG("AddData", "PHA1 decoder started");
     }
   } else if (dataType == DataType::Stop) {
     fIsRunning = false;
     if (fDumpFlag) {
-      DecoderLogger::LogDebug("AddData", "PHA1 decoder stopped");
+      DECODER_LOG_DEBUG("AddData", "PHA1 decoder stopped");
     }
   } else if (dataType == DataType::Unknown) {
+    fCounters.RecordDiscarded();
     if (fDumpFlag) {
-      DecoderLogger::LogDebug("AddData", "Unknown PHA1 data type, discarding");
+      DECODER_LOG_DEBUG("AddData", "Unknown PHA1 data type, discarding");
     }
-    return DataType::Unknown;
+  }
+
+  // Anything not queued for decoding goes straight back to the pool
+  if (rawData) {
+    FinishSequence(*rawData);
+    RecycleRawData(std::move(rawData));
   }
 
   return dataType;
@@ -883,13 +1314,16 @@ DataType PHA1Decoder::CheckDataType(std::unique_ptr<RawData_t> &rawData)
   if (rawData->size <
       PHA1Constants::BoardHeader::kHeaderSizeWords * kWordSize) {
     if (fDumpFlag) {
-      DecoderLogger::LogDebug(
-          "CheckDataType",
-          "PHA1 data too small: " + std::to_string(rawData->size) + " bytes");
+      DECODER_LOG_DEBUG("CheckDataType",
+                        "PHA1 data too small: " << rawData->size << " bytes");
     }
     return DataType::Unknown;
   }
 
+  // Run markers added by Digitizer1 (see RunMarker.hpp)
+  if (CheckStart(rawData)) return DataType::Start;
+  if (CheckStop(rawData)) return DataType::Stop;
+
   // For PHA1, we primarily check the first word header type
   uint32_t firstWord = 0;
   std::memcpy(&firstWord, rawData->data.data(), sizeof(uint32_t));
@@ -898,9 +1332,10 @@ DataType PHA1Decoder::CheckDataType(std::unique_ptr<RawData_t> &rawData)
                     PHA1Constants::BoardHeader::kTypeMask;
 
   if (fDumpFlag) {
-    DecoderLogger::LogDebug(
-        "CheckDataType", "PHA1 first word: 0x" + std::to_string(firstWord) +
-                             ", header type: 0x" + std::to_string(headerType));
+    DECODER_LOG_DEBUG("CheckDataType",
+                      "PHA1 first word: 0x" << std::hex << firstWord
+                          << std::dec << ", header type: 0x" << std::hex
+                          << headerType << std::dec);
   }
 
   if (headerType == PHA1Constants::BoardHeader::kTypeData) {
@@ -911,28 +1346,26 @@ DataType PHA1Decoder::CheckDataType(std::unique_ptr<RawData_t> &rawData)
   // This is more permissive than the strict header check
   if (rawData->size >= PHA1Constants::Validation::kMinimumEventSize) {
     if (fDumpFlag) {
-      DecoderLogger::LogDebug("CheckDataType",
-                              "Treating as Event despite header type mismatch");
+      DECODER_LOG_DEBUG("CheckDataType",
+                        "Treating as Event despite header type mismatch");
     }
     return DataType::Event;
   }
 
   if (fDumpFlag) {
-    DecoderLogger::LogDebug("CheckDataType", "Unknown data type for PHA1");
+    DECODER_LOG_DEBUG("CheckDataType", "Unknown data type for PHA1");
   }
   return DataType::Unknown;
 }
 
 bool PHA1Decoder::CheckStop(std::unique_ptr<RawData_t> &rawData)
 {
-  // TODO: Implement PHA1-specific stop detection if needed
-  return false;
+  return RunMarker::Is(*rawData, RunMarker::kKindStop);
 }
 
 bool PHA1Decoder::CheckStart(std::unique_ptr<RawData_t> &rawData)
 {
-  // TODO: Implement PHA1-specific start detection if needed
-  return false;
+  return RunMarker::Is(*rawData, RunMarker::kKindStart);
 }
 
 // ============================================================================
@@ -950,6 +1383,7 @@ void PHA1Decoder::PreAllocateEventData(size_t expectedEvents)
 void PHA1Decoder::UpdateCachedValues()
 {
   fFineTimeMultiplier = static_cast<double>(fTimeStep) / 1024.0;
+  fTimeStepPs = static_cast<uint64_t>(fTimeStep) * EventData::kPsPerNs;
 }
 
 }  // namespace Digitizer
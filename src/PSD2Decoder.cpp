@@ -1,5 +1,10 @@
 #include "PSD2Decoder.hpp"
 
+#include "ByteSwap.hpp"
+#include "EventSorter.hpp"
+#include "WaveformCodec.hpp"
+#include "WaveformUnpack.hpp"
+
 #include <algorithm>
 #include <bitset>
 #include <chrono>
@@ -29,6 +34,7 @@ PSD2Decoder::PSD2Decoder(uint32_t nThreads)
 
   // Initialize data storage
   fEventDataVec = std::make_unique<std::vector<std::unique_ptr<EventData>>>();
+  fEventBatch = fEventBatchPool.Acquire();
 
   // Start decode threads
   fDecodeFlag = true;
@@ -40,8 +46,10 @@ PSD2Decoder::PSD2Decoder(uint32_t nThreads)
 
 PSD2Decoder::~PSD2Decoder()
 {
-  // Signal threads to stop
+  // Signal threads to stop and wake any that are waiting for data
   fDecodeFlag = false;
+  fRawDataQueue.Close();
+  fBackpressure.Close();
 
   // Wait for all threads to finish
   for (auto &thread : fDecodeThreads) {
@@ -58,49 +66,147 @@ PSD2Decoder::~PSD2Decoder()
 std::unique_ptr<std::vector<std::unique_ptr<EventData>>>
 PSD2Decoder::GetEventData()
 {
+  if (fOrderer.IsEnabled()) {
+    auto data = fOrderer.TakeEventData();
+    if (fTracer && !data->empty()) fTracer->RecordPickup();
+    fBackpressure.NotifyDrained();
+    return data;
+  }
+
   auto data = std::make_unique<std::vector<std::unique_ptr<EventData>>>();
   {
     std::lock_guard<std::mutex> lock(fEventDataMutex);
     data->swap(*fEventDataVec);
     fEventDataVec->clear();
   }
+  if (fTracer && !data->empty()) fTracer->RecordPickup();
+  fBackpressure.NotifyDrained();
   return data;
 }
 
+std::unique_ptr<EventBatch> PSD2Decoder::GetEventBatch()
+{
+  if (fOrderer.IsEnabled()) {
+    auto batch = fOrderer.TakeEventBatch();
+    if (fTracer && !batch->Empty()) fTracer->RecordPickup();
+    fBackpressure.NotifyDrained();
+    return batch;
+  }
+
+  // Swap in a recycled batch so decoding continues without allocating
+  auto batch = fEventBatchPool.Acquire();
+  {
+    std::lock_guard<std::mutex> lock(fEventBatchMutex);
+    std::swap(batch, fEventBatch);
+  }
+  if (fTracer && !batch->Empty()) fTracer->RecordPickup();
+  fBackpressure.NotifyDrained();
+  return batch;
+}
+
+std::unique_ptr<std::vector<std::unique_ptr<EventData>>>
+PSD2Decoder::GetEventData(std::chrono::milliseconds timeout)
+{
+  // Read the generation first so a batch stored after the check still wakes
+  auto generation = fEventNotifier.GetGeneration();
+  auto data = GetEventData();
+  if (data->empty() && fEventNotifier.WaitFor(generation, timeout)) {
+    data = GetEventData();
+  }
+  return data;
+}
+
+std::unique_ptr<EventBatch> PSD2Decoder::GetEventBatch(
+    std::chrono::milliseconds timeout)
+{
+  auto generation = fEventNotifier.GetGeneration();
+  auto batch = GetEventBatch();
+  if (batch->Empty() && fEventNotifier.WaitFor(generation, timeout)) {
+    fEventBatchPool.Release(std::move(batch));
+    batch = GetEventBatch();
+  }
+  return batch;
+}
+
+DecoderStatistics PSD2Decoder::GetStatistics() const
+{
+  auto stats = fCounters.Snapshot();
+  stats.orderingSkipped = fOrderer.GetSkippedCount();
+  stats.orderingLate = fOrderer.GetLateCount();
+  return stats;
+}
+
+bool PSD2Decoder::Drain(std::chrono::milliseconds timeout)
+{
+  // Every buffer handed over so far has been decoded, dropped or ignored
+  bool drained = fInFlight.WaitIdle(timeout);
+
+  // Nothing older is coming: release what waits for gaps or the merge window
+  if (fOrderer.IsEnabled()) fOrderer.Flush();
+  fEventNotifier.Notify();
+  return drained;
+}
+
 // ============================================================================
 // Threading and Data Processing
 // ============================================================================
 
 void PSD2Decoder::DecodeThread()
 {
+  std::vector<std::unique_ptr<RawData_t>> batch;
+  batch.reserve(kDecodeBatchSize);
+
   while (fDecodeFlag) {
-    std::unique_ptr<RawData_t> rawData = nullptr;
-
-    // Get data from queue
-    {
-      std::lock_guard<std::mutex> lock(fRawDataMutex);
-      if (fRawDataQueue.empty()) {
-        // Release lock before sleeping to avoid deadlock
-      } else {
-        rawData = std::move(fRawDataQueue.front());
-        fRawDataQueue.pop_front();
-      }
+    // Sleeps until data is pushed or the queue is closed
+    if (fRawDataQueue.PopBatch(batch, kDecodeBatchSize,
+                               std::chrono::milliseconds(10)) == 0) {
+      continue;
     }
-    
-    // Sleep outside the lock if no data was available
-    if (!rawData) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    // DropNewest at the event limit: these buffers are not decoded at all
+    if (!MakeRoomForEvents()) {
+      for (auto &rawData : batch) {
+        fCounters.RecordDroppedAggregate(rawData->size);
+        FinishSequence(*rawData);
+        RecycleRawData(std::move(rawData));
+      }
+      batch.clear();
       continue;
     }
 
-    // Process data if available
-    if (rawData) {
-      DecodeData(std::move(rawData));
+    // Decode each buffer, then hand it back to the pool
+    for (auto &rawData : batch) {
+      uint64_t decodeTicks = 0;
+      if (fTracer) {
+        decodeTicks = PipelineTracer::Now();
+        fTracer->Record(TraceStage::Queue, rawData->sequence,
+                        rawData->queuedTicks, decodeTicks);
+      }
+      if (fSwapOnDecode) {
+        ByteSwap::SwapWords64(rawData->data.data(), rawData->size / kWordSize);
+        if (fTracer) {
+          auto swapTicks = decodeTicks;
+          decodeTicks = PipelineTracer::Now();
+          fTracer->Record(TraceStage::Swap, rawData->sequence, swapTicks,
+                          decodeTicks);
+        }
+      }
+      auto decodeStart = std::chrono::steady_clock::now();
+      DecodeData(rawData);
+      fCounters.RecordAggregate(std::chrono::steady_clock::now() - decodeStart);
+      if (fTracer) {
+        fTracer->Record(TraceStage::Decode, rawData->sequence, decodeTicks,
+                        PipelineTracer::Now());
+      }
+      FinishSequence(*rawData);
+      RecycleRawData(std::move(rawData));
     }
+    batch.clear();
+    fEventNotifier.Notify();
   }
 }
 
-void PSD2Decoder::DecodeData(std::unique_ptr<RawData_t> rawData)
+void PSD2Decoder::DecodeData(std::unique_ptr<RawData_t> &rawData)
 {
   if (fDumpFlag) {
     DumpRawData(*rawData);
@@ -111,6 +217,7 @@ void PSD2Decoder::DecodeData(std::unique_ptr<RawData_t> rawData)
   std::memcpy(&headerWord, rawData->data.data(), sizeof(uint64_t));
 
   if (!ValidateDataHeader(headerWord, rawData->size)) {
+    fCounters.RecordDecodeError();
     return;
   }
 
@@ -118,7 +225,90 @@ void PSD2Decoder::DecodeData(std::unique_ptr<RawData_t> rawData)
   auto totalSize = static_cast<uint32_t>(headerWord & Header::kTotalSizeMask);
 
   // Process all events in the data
-  ProcessEventData(rawData->data.begin(), totalSize);
+  ProcessEventData(rawData->data.begin(), totalSize, rawData->sequence);
+}
+
+void PSD2Decoder::RecycleRawData(std::unique_ptr<RawData_t> rawData)
+{
+  if (fRawDataPool) {
+    fRawDataPool->Release(std::move(rawData));
+  }
+}
+
+void PSD2Decoder::FinishSequence(const RawData_t &rawData)
+{
+  if (fOrderer.IsEnabled()) fOrderer.Finish(rawData.sequence);
+  fInFlight.Done();
+}
+
+bool PSD2Decoder::MakeRoomForEvents()
+{
+  // Decoded events not yet taken with GetEventData()/GetEventBatch()
+  auto pending = [this]() -> size_t {
+    if (fOrderer.IsEnabled()) return fOrderer.GetReadyCount();
+    if (fOutputFormat == OutputFormat::EventBatch) {
+      std::lock_guard<std::mutex> lock(fEventBatchMutex);
+      return fEventBatch->Size();
+    }
+    std::lock_guard<std::mutex> lock(fEventDataMutex);
+    return fEventDataVec->size();
+  };
+  auto discard = [this]() -> size_t {
+    if (fOrderer.IsEnabled()) return fOrderer.DiscardReady();
+    size_t count = 0;
+    if (fOutputFormat == OutputFormat::EventBatch) {
+      std::lock_guard<std::mutex> lock(fEventBatchMutex);
+      count = fEventBatch->Size();
+      fEventBatch->Clear();
+    } else {
+      std::lock_guard<std::mutex> lock(fEventDataMutex);
+      count = fEventDataVec->size();
+      fEventDataVec->clear();
+    }
+    return count;
+  };
+  return fBackpressure.MakeRoomForEvents(pending, discard, fCounters);
+}
+
+void PSD2Decoder::StoreEventBatch(std::unique_ptr<EventBatch> eventBatch,
+                                  uint64_t sequence)
+{
+  // Sort through a pooled scratch batch so neither side reallocates
+  auto sortScratch = fEventBatchPool.Acquire();
+  auto sortTicks = fTracer ? PipelineTracer::Now() : 0;
+  auto sortStart = std::chrono::steady_clock::now();
+  auto method = EventSorter::Sort(*eventBatch, *sortScratch);
+  fCounters.RecordSort(method, std::chrono::steady_clock::now() - sortStart);
+  if (fTracer) {
+    fTracer->Record(TraceStage::Sort, sequence, sortTicks,
+                    PipelineTracer::Now());
+  }
+  fEventBatchPool.Release(std::move(sortScratch));
+  if (fCoincidence.IsEnabled()) {
+    fCounters.RecordCoincidenceRejected(
+        fCoincidence.Apply(eventBatch, fEventBatchPool));
+  }
+  if (fPulseProcessor.IsEnabled()) fPulseProcessor.Process(*eventBatch);
+  if (WriteToSinks(fEventSinks, *eventBatch)) {
+    fEventBatchPool.Release(std::move(eventBatch));
+    return;
+  }
+  if (fTracer) fTracer->MarkPending();
+
+  if (fOrderer.IsEnabled()) {
+    fOrderer.Push(sequence, std::move(eventBatch));
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(fEventBatchMutex);
+    if (fEventBatch->Empty()) {
+      std::swap(fEventBatch, eventBatch);
+    } else {
+      fEventBatch->Append(*eventBatch);
+    }
+  }
+  fEventBatchPool.Release(std::move(eventBatch));
 }
 
 void PSD2Decoder::DumpRawData(const RawData_t &rawData) const
@@ -152,46 +342,105 @@ bool PSD2Decoder::ValidateDataHeader(uint64_t headerWord, size_t dataSize)
       (headerWord >> Header::kAggregateCounterShift) & Header::kAggregateCounterMask;
   if (fDecodeThreads.size() == 1) {
     if (aggregateCounter != 0 && aggregateCounter != fLastCounter + 1) {
+      fCounters.RecordCounterDiscontinuity();
       std::cerr << "Aggregate counter discontinuity: " << fLastCounter << " -> "
                 << aggregateCounter << std::endl;
     }
     fLastCounter = aggregateCounter;
   }
 
-  // Validate total size
+  // Validate total size; events are only decoded within both sizes
   auto totalSize = static_cast<uint32_t>(headerWord & Header::kTotalSizeMask);
   if (totalSize * kWordSize != dataSize) {
     std::cerr << "Size mismatch: header=" << totalSize * kWordSize
               << " actual=" << dataSize << std::endl;
+    if (totalSize * kWordSize > dataSize) return false;
   }
 
   return true;
 }
 
 void PSD2Decoder::ProcessEventData(
-    const std::vector<uint8_t>::iterator &dataStart, uint32_t totalSize)
+    const std::vector<uint8_t>::iterator &dataStart, uint32_t totalSize,
+    uint64_t sequence)
 {
+  // Hits rejected by zero suppression are skipped before decoding
+  std::array<uint64_t, ZeroSuppression::kMaxChannels> suppressed{};
+  const bool suppress = fZeroSuppression.IsEnabled();
+
+  // Columnar output: decode every hit into one reused EventData
+  if (fOutputFormat == OutputFormat::EventBatch) {
+    auto eventBatch = fEventBatchPool.Acquire();
+    eventBatch->Reserve(totalSize / 2);
+    EventData scratchEvent;
+    for (size_t wordIndex = 1; wordIndex < totalSize;) {
+      if (!IsEventComplete(dataStart, wordIndex, totalSize)) break;
+      if (suppress && SkipSuppressedEvent(dataStart, wordIndex, totalSize,
+                                          suppressed)) {
+        continue;
+      }
+      DecodeEvent(dataStart, wordIndex, scratchEvent);
+      eventBatch->Append(scratchEvent);
+    }
+    if (suppress) fCounters.RecordSuppressed(suppressed);
+    fCounters.RecordEvents(*eventBatch);
+    if (fHistograms) {
+      fHistograms->Fill(*eventBatch);
+      if (fHistograms->GetConfig().histogramOnly) {
+        fEventBatchPool.Release(std::move(eventBatch));
+        return;
+      }
+    }
+    StoreEventBatch(std::move(eventBatch), sequence);
+    return;
+  }
+
   // Direct EventData output
   std::vector<std::unique_ptr<EventData>> eventDataVec;
   eventDataVec.reserve(totalSize / 2);
 
   for (size_t wordIndex = 1; wordIndex < totalSize;) {
+    if (!IsEventComplete(dataStart, wordIndex, totalSize)) break;
+    if (suppress && SkipSuppressedEvent(dataStart, wordIndex, totalSize,
+                                        suppressed)) {
+      continue;
+    }
     auto eventData = DecodeEventPair(dataStart, wordIndex);
     if (eventData) {
       eventDataVec.push_back(std::move(eventData));
     }
   }
+  if (suppress) fCounters.RecordSuppressed(suppressed);
 
-  // Sort EventData by timeStampNs in ascending order
+  // Sort EventData by timeStampPs in ascending order
   if (!eventDataVec.empty()) {
-    std::sort(eventDataVec.begin(), eventDataVec.end(),
-              [](const std::unique_ptr<EventData> &a,
-                 const std::unique_ptr<EventData> &b) {
-                return a->timeStampNs < b->timeStampNs;
-              });
+    auto sortTicks = fTracer ? PipelineTracer::Now() : 0;
+    auto sortStart = std::chrono::steady_clock::now();
+    auto method = EventSorter::Sort(eventDataVec);
+    fCounters.RecordSort(method, std::chrono::steady_clock::now() - sortStart);
+    if (fTracer) {
+      fTracer->Record(TraceStage::Sort, sequence, sortTicks,
+                      PipelineTracer::Now());
+    }
   }
 
+  fCounters.RecordEvents(eventDataVec);
+  if (fHistograms) {
+    fHistograms->Fill(eventDataVec);
+    if (fHistograms->GetConfig().histogramOnly) return;
+  }
+  if (fCoincidence.IsEnabled()) {
+    fCounters.RecordCoincidenceRejected(fCoincidence.Apply(eventDataVec));
+  }
+  if (fPulseProcessor.IsEnabled()) fPulseProcessor.Process(eventDataVec);
+  if (WriteToSinks(fEventSinks, eventDataVec)) return;
+
   // Store converted data
+  if (fTracer) fTracer->MarkPending();
+  if (fOrderer.IsEnabled()) {
+    fOrderer.Push(sequence, std::move(eventDataVec));
+    return;
+  }
   {
     std::lock_guard<std::mutex> lock(fEventDataMutex);
     fEventDataVec->insert(fEventDataVec->end(),
@@ -200,8 +449,46 @@ void PSD2Decoder::ProcessEventData(
   }
 }
 
+bool PSD2Decoder::IsEventComplete(
+    const std::vector<uint8_t>::iterator &dataStart, size_t wordIndex,
+    size_t totalSize)
+{
+  // Two event words, then optionally the waveform header, the word count
+  // and the samples; DecodeEvent() reads all of them unchecked
+  size_t eventEnd = wordIndex + 2;
+  if (eventEnd <= totalSize) {
+    uint64_t secondWord = 0;
+    std::memcpy(&secondWord, &(*(dataStart + (wordIndex + 1) * kWordSize)),
+                sizeof(uint64_t));
+    if ((secondWord >> Event::kWaveformFlagShift) & 0x1) {
+      eventEnd += 2;
+      if (eventEnd <= totalSize) {
+        uint64_t nWordsWaveform = 0;
+        std::memcpy(&nWordsWaveform,
+                    &(*(dataStart + (eventEnd - 1) * kWordSize)),
+                    sizeof(uint64_t));
+        eventEnd += nWordsWaveform & Waveform::kWaveformWordsMask;
+      }
+    }
+  }
+  if (eventEnd <= totalSize) return true;
+
+  std::cerr << "Truncated event at word " << wordIndex << ", needs "
+            << eventEnd - wordIndex << " words" << std::endl;
+  fCounters.RecordDecodeError();
+  return false;
+}
+
 std::unique_ptr<EventData> PSD2Decoder::DecodeEventPair(
     const std::vector<uint8_t>::iterator &dataStart, size_t &wordIndex)
+{
+  auto eventData = std::make_unique<EventData>();
+  DecodeEvent(dataStart, wordIndex, *eventData);
+  return eventData;
+}
+
+void PSD2Decoder::DecodeEvent(const std::vector<uint8_t>::iterator &dataStart,
+                              size_t &wordIndex, EventData &eventData)
 {
   // Read first word (channel and timestamp)
   uint64_t firstWord = 0;
@@ -218,39 +505,90 @@ std::unique_ptr<EventData> PSD2Decoder::DecodeEventPair(
   // Check for waveform data to determine size
   bool hasWaveform = (secondWord >> Event::kWaveformFlagShift) & 0x1;
   size_t waveformSize = 0;
-  if (hasWaveform) {
-    // Peek at waveform header to get size
-    uint64_t waveformHeader = 0;
-    std::memcpy(&waveformHeader, &(*(dataStart + (wordIndex + 1) * kWordSize)),
-                sizeof(uint64_t));
+  if (hasWaveform && fWaveformMode == WaveformMode::Decode) {
+    // Peek at the word count that follows the waveform header
     uint64_t nWordsWaveform = 0;
-    std::memcpy(&nWordsWaveform, &(*(dataStart + (wordIndex + 2) * kWordSize)),
+    std::memcpy(&nWordsWaveform, &(*(dataStart + (wordIndex + 1) * kWordSize)),
                 sizeof(uint64_t));
     nWordsWaveform &= Waveform::kWaveformWordsMask;
     waveformSize = nWordsWaveform * 2;  // 2 points per word
   }
 
-  // Create EventData with proper size
-  auto eventData = std::make_unique<EventData>(waveformSize);
+  // Size the waveform; probe types are only written when one is present,
+  // so clear them for a reused EventData
+  eventData.ResizeWaveform(waveformSize);
+  eventData.packedWaveform.clear();
+  if (!hasWaveform) {
+    eventData.analogProbe1Type = 0;
+    eventData.analogProbe2Type = 0;
+    eventData.digitalProbe1Type = 0;
+    eventData.digitalProbe2Type = 0;
+    eventData.digitalProbe3Type = 0;
+    eventData.digitalProbe4Type = 0;
+    eventData.downSampleFactor = 0;
+  }
 
   // Extract raw timestamp from first word
   uint64_t rawTimeStamp = firstWord & Event::kTimeStampMask;
 
   // Decode first word
-  DecodeFirstWord(firstWord, *eventData);
+  DecodeFirstWord(firstWord, eventData);
 
   // Decode second word (needs raw timestamp for time calculation)
-  DecodeSecondWord(secondWord, *eventData, rawTimeStamp);
+  DecodeSecondWord(secondWord, eventData, rawTimeStamp);
 
   // Check for waveform data
   if (hasWaveform) {
-    DecodeWaveformData(dataStart, wordIndex, *eventData);
+    DecodeWaveformData(dataStart, wordIndex, eventData);
   }
 
-  eventData->timeResolution = fTimeStep;
-  eventData->module = fModuleNumber;
+  eventData.timeResolution = fTimeStep;
+  eventData.module = fModuleNumber;
+}
 
-  return eventData;
+bool PSD2Decoder::SkipSuppressedEvent(
+    const std::vector<uint8_t>::iterator &dataStart, size_t &wordIndex,
+    size_t totalSize,
+    std::array<uint64_t, ZeroSuppression::kMaxChannels> &suppressed) const
+{
+  if (wordIndex + 2 > totalSize) return false;
+
+  // Channel, energy and flags are all in the two event words
+  uint64_t firstWord = 0;
+  uint64_t secondWord = 0;
+  std::memcpy(&firstWord, &(*(dataStart + wordIndex * kWordSize)),
+              sizeof(uint64_t));
+  std::memcpy(&secondWord, &(*(dataStart + (wordIndex + 1) * kWordSize)),
+              sizeof(uint64_t));
+  auto channel = static_cast<uint8_t>((firstWord >> Event::kChannelShift) &
+                                      Event::kChannelMask);
+  auto energy = static_cast<uint16_t>(secondWord & Event::kEnergyMask);
+  if (!fZeroSuppression.Reject(channel, energy, ConvertFlags(secondWord))) {
+    return false;
+  }
+
+  // Step over the waveform header, word count and samples as well
+  size_t eventEnd = wordIndex + 2;
+  if ((secondWord >> Event::kWaveformFlagShift) & 0x1) {
+    if (eventEnd + 2 > totalSize) return false;
+    uint64_t nWordsWaveform = 0;
+    std::memcpy(&nWordsWaveform, &(*(dataStart + (eventEnd + 1) * kWordSize)),
+                sizeof(uint64_t));
+    eventEnd += 2 + (nWordsWaveform & Waveform::kWaveformWordsMask);
+  }
+
+  suppressed[channel]++;  // Reject() passes channels >= kMaxChannels
+  wordIndex = eventEnd;
+  return true;
+}
+
+uint64_t PSD2Decoder::ConvertFlags(uint64_t secondWord)
+{
+  uint64_t flagsLowPriority = (secondWord >> Event::kFlagsLowPriorityShift) &
+                              Event::kFlagsLowPriorityMask;
+  uint64_t flagsHighPriority = (secondWord >> Event::kFlagsHighPriorityShift) &
+                               Event::kFlagsHighPriorityMask;
+  return (flagsHighPriority << 11) | flagsLowPriority;  // Single field
 }
 
 void PSD2Decoder::DecodeFirstWord(uint64_t word, EventData &eventData) const
@@ -272,12 +610,7 @@ void PSD2Decoder::DecodeSecondWord(uint64_t word, EventData &eventData,
                                    uint64_t rawTimeStamp) const
 {
   // Extract flags and store in 64-bit flags field
-  uint64_t flagsLowPriority =
-      (word >> Event::kFlagsLowPriorityShift) & Event::kFlagsLowPriorityMask;
-  uint64_t flagsHighPriority =
-      (word >> Event::kFlagsHighPriorityShift) & Event::kFlagsHighPriorityMask;
-  eventData.flags = (flagsHighPriority << 11) |
-                    flagsLowPriority;  // Combine into single field
+  eventData.flags = ConvertFlags(word);
 
   // Extract energies
   eventData.energyShort = (word >> Event::kEnergyShortShift) & Event::kEnergyShortMask;
@@ -289,6 +622,9 @@ void PSD2Decoder::DecodeSecondWord(uint64_t word, EventData &eventData,
   double fineTimeNs =
       (static_cast<double>(fineTime) / Event::kFineTimeScale) * fTimeStep;
   eventData.timeStampNs = coarseTimeNs + fineTimeNs;
+  eventData.timeStampPs =
+      rawTimeStamp * fTimeStepPs +
+      fineTime * fTimeStepPs / static_cast<uint64_t>(Event::kFineTimeScale);
 
   if (fDumpFlag) {
     std::cout << "Flags: " << eventData.flags << std::endl;
@@ -332,27 +668,42 @@ void PSD2Decoder::DecodeWaveformData(
   wordIndex++;
   nWordsWaveform &= Waveform::kWaveformWordsMask;
 
-  // EventData is already properly sized, verify it matches
   size_t expectedSize = nWordsWaveform * 2;
-  if (eventData.waveformSize != expectedSize) {
-    std::cerr << "Waveform size mismatch: expected " << expectedSize << ", got "
-              << eventData.waveformSize << std::endl;
-  }
+  const uint8_t *words = &(*(dataStart + wordIndex * kWordSize));
 
-  // Decode waveform data
-  for (size_t j = 0; j < nWordsWaveform; j++) {
-    uint64_t waveformWord = 0;
-    std::memcpy(&waveformWord, &(*(dataStart + wordIndex * kWordSize)),
-                sizeof(uint64_t));
-    wordIndex++;
-
-    // Each word contains two 32-bit samples
-    uint32_t sample1 = static_cast<uint32_t>(waveformWord & 0xFFFFFFFF);
-    uint32_t sample2 = static_cast<uint32_t>((waveformWord >> 32) & 0xFFFFFFFF);
+  if (fWaveformMode == WaveformMode::Decode) {
+    // EventData is already properly sized, verify it matches
+    if (eventData.waveformSize != expectedSize) {
+      std::cerr << "Waveform size mismatch: expected " << expectedSize
+                << ", got " << eventData.waveformSize << std::endl;
+    }
 
-    DecodeWaveformPoint(sample1, j * 2, config, eventData);
-    DecodeWaveformPoint(sample2, j * 2 + 1, config, eventData);
+    // Decode the whole trace in one vectorized pass, two points per word
+    size_t nSamples = std::min(expectedSize, eventData.waveformSize);
+    WaveformUnpack::UnpackPSD2(words, nSamples, config.ap1IsSigned,
+                               config.ap2IsSigned, config.ap1MulFactor,
+                               config.ap2MulFactor,
+                               WaveformUnpack::ForEvent(eventData));
+  } else if (IsPackedWaveformMode(fWaveformMode)) {
+    // EventData::UnpackWaveform() decodes the trace on demand
+    PackedWaveformInfo info;
+    info.format = PackedWaveformInfo::Format::PSD2;
+    info.ap1Signed = config.ap1IsSigned;
+    info.ap2Signed = config.ap2IsSigned;
+    info.ap1MulFactor = config.ap1MulFactor;
+    info.ap2MulFactor = config.ap2MulFactor;
+    info.nSamples = expectedSize;
+    if (fWaveformMode == WaveformMode::Lazy) {
+      eventData.packedWaveform.assign(words,
+                                      words + nWordsWaveform * kWordSize);
+      eventData.packedWaveformInfo = info;
+    } else {
+      WaveformCodec::Compress(words, nWordsWaveform * kWordSize, info,
+                              fWaveformMode == WaveformMode::CompactDelta,
+                              eventData);
+    }
   }
+  wordIndex += nWordsWaveform;
 }
 
 void PSD2Decoder::DecodeWaveformHeader(uint64_t header,
@@ -403,71 +754,65 @@ uint32_t PSD2Decoder::GetMultiplicationFactor(uint32_t encodedValue) const
   }
 }
 
-void PSD2Decoder::DecodeWaveformPoint(uint32_t point, size_t dataIndex,
-                                      const WaveformConfig &config,
-                                      EventData &eventData) const
-{
-  // Decode analog probes
-  uint32_t analog1Raw = point & Waveform::kAnalogProbeMask;
-  uint32_t analog2Raw = (point >> 16) & Waveform::kAnalogProbeMask;
-
-  if (config.ap1IsSigned) {
-    // Sign extend from 14-bit to 32-bit
-    if (analog1Raw & 0x2000) analog1Raw |= 0xFFFFC000;
-    eventData.analogProbe1[dataIndex] =
-        static_cast<int32_t>(analog1Raw) * config.ap1MulFactor;
-  } else {
-    eventData.analogProbe1[dataIndex] = analog1Raw * config.ap1MulFactor;
-  }
-
-  if (config.ap2IsSigned) {
-    // Sign extend from 14-bit to 32-bit
-    if (analog2Raw & 0x2000) analog2Raw |= 0xFFFFC000;
-    eventData.analogProbe2[dataIndex] =
-        static_cast<int32_t>(analog2Raw) * config.ap2MulFactor;
-  } else {
-    eventData.analogProbe2[dataIndex] = analog2Raw * config.ap2MulFactor;
-  }
-
-  // Decode digital probes
-  eventData.digitalProbe1[dataIndex] = (point >> 14) & Waveform::kDigitalProbeMask;
-  eventData.digitalProbe2[dataIndex] = (point >> 15) & Waveform::kDigitalProbeMask;
-  eventData.digitalProbe3[dataIndex] = (point >> 30) & Waveform::kDigitalProbeMask;
-  eventData.digitalProbe4[dataIndex] = (point >> 31) & Waveform::kDigitalProbeMask;
-}
-
 // ============================================================================
 // Data Input and Classification
 // ============================================================================
 
 DataType PSD2Decoder::AddData(std::unique_ptr<RawData_t> rawData)
 {
+  fInFlight.Add();  // Balanced by the buffer's FinishSequence()
   constexpr uint32_t oneWordSize = kWordSize;
   if (rawData->size % oneWordSize != 0) {
     std::cerr << "Data size is not a multiple of " << oneWordSize << " Bytes"
               << std::endl;
+    fCounters.RecordDiscarded();
+    FinishSequence(*rawData);
+    RecycleRawData(std::move(rawData));
     return DataType::Unknown;
   }
 
-  // change big endian to little endian
-  for (size_t i = 0; i < rawData->size; i += oneWordSize) {
-    std::reverse(rawData->data.begin() + i,
-                 rawData->data.begin() + i + oneWordSize);
+  // change big endian to little endian, unless left to the decode threads
+  if (!fSwapOnDecode) {
+    auto swapTicks = fTracer ? PipelineTracer::Now() : 0;
+    ByteSwap::SwapWords64(rawData->data.data(), rawData->size / oneWordSize);
+    if (fTracer) {
+      fTracer->Record(TraceStage::Swap, rawData->sequence, swapTicks,
+                      PipelineTracer::Now());
+    }
   }
 
   auto dataType = CheckDataType(rawData);
   if (dataType == DataType::Event) {
     if (fIsRunning) {
-      std::lock_guard<std::mutex> lock(fRawDataMutex);
-      fRawDataQueue.push_back(std::move(rawData));
+      // Leaves rawData untouched if the queue has been closed; dropped
+      // buffers are counted and recycled right away
+      auto drop = [this](std::unique_ptr<RawData_t> dropped) {
+        FinishSequence(*dropped);
+        RecycleRawData(std::move(dropped));
+      };
+      if (fTracer) rawData->queuedTicks = PipelineTracer::Now();
+      if (!fBackpressure.PushRawData(fRawDataQueue, rawData, fCounters,
+                                     drop)) {
+        fCounters.RecordDiscarded();
+      }
+    } else {
+      fCounters.RecordDiscarded();
     }
   } else if (dataType == DataType::Start) {
     fIsRunning = true;
   } else if (dataType == DataType::Stop) {
     fIsRunning = false;
   } else if (dataType == DataType::Unknown) {
-    std::cout << "Unknown data type" << std::endl;
-    exit(1);
+    // Too short for any record: drop it rather than the whole acquisition
+    fCounters.RecordDiscarded();
+    std::cerr << "Unknown data type, " << rawData->size << " bytes discarded"
+              << std::endl;
+  }
+
+  // Anything not queued for decoding goes straight back to the pool
+  if (rawData) {
+    FinishSequence(*rawData);
+    RecycleRawData(std::move(rawData));
   }
 
   return dataType;
@@ -498,21 +843,29 @@ DataType PSD2Decoder::CheckDataType(std::unique_ptr<RawData_t> &rawData)
 // Specific Data Type Checkers
 // ============================================================================
 
+uint64_t PSD2Decoder::LoadWord(const RawData_t &rawData, size_t index) const
+{
+  uint64_t word = 0;
+  std::memcpy(&word, rawData.data.data() + index * kWordSize, kWordSize);
+  // Still big endian if the swap is deferred to the decode threads
+  return fSwapOnDecode ? ByteSwap::Swap64(word) : word;
+}
+
 bool PSD2Decoder::CheckStop(std::unique_ptr<RawData_t> &rawData)
 {
   uint64_t buf = 0;
   // The first word bit[60:63] = 0x3
   // The first word bit[56:59] = 0x2
-  std::memcpy(&buf, &(*(rawData->data.begin())), sizeof(uint64_t));
+  buf = LoadWord(*rawData, 0);
   auto firstCondition =
       ((buf >> 60) & 0xF) == 0x3 && ((buf >> 56) & 0xF) == 0x2;
 
   // The second word bit[56:63] = 0x0
-  std::memcpy(&buf, &(*(rawData->data.begin() + 8)), sizeof(uint64_t));
+  buf = LoadWord(*rawData, 1);
   auto secondCondition = ((buf >> 56) & 0xF) == 0x0;
 
   // The third word bit[56:63] = 0x1
-  std::memcpy(&buf, &(*(rawData->data.begin() + 16)), sizeof(uint64_t));
+  buf = LoadWord(*rawData, 2);
   auto thirdCondition = ((buf >> 56) & 0xF) == 0x1;
 
   if (firstCondition && secondCondition && thirdCondition) {
@@ -530,20 +883,20 @@ bool PSD2Decoder::CheckStart(std::unique_ptr<RawData_t> &rawData)
   uint64_t buf = 0;
   // The first word bit[60:63] = 0x3
   // The first word bit[56:59] = 0x0
-  std::memcpy(&buf, &(*(rawData->data.begin())), sizeof(uint64_t));
+  buf = LoadWord(*rawData, 0);
   auto firstCondition =
       ((buf >> 60) & 0xF) == 0x3 && ((buf >> 56) & 0xF) == 0x0;
 
   // The second word bit[56:63] = 0x2
-  std::memcpy(&buf, &(*(rawData->data.begin() + 8)), sizeof(uint64_t));
+  buf = LoadWord(*rawData, 1);
   auto secondCondition = ((buf >> 56) & 0xF) == 0x2;
 
   // The third word bit[56:63] = 0x1
-  std::memcpy(&buf, &(*(rawData->data.begin() + 16)), sizeof(uint64_t));
+  buf = LoadWord(*rawData, 2);
   auto thirdCondition = ((buf >> 56) & 0xF) == 0x1;
 
   // The fourth word bit[56:63] = 0x1
-  std::memcpy(&buf, &(*(rawData->data.begin() + 24)), sizeof(uint64_t));
+  buf = LoadWord(*rawData, 3);
   auto fourthCondition = ((buf >> 56) & 0xF) == 0x1;
 
   if (firstCondition && secondCondition && thirdCondition && fourthCondition) {
@@ -20,6 +20,7 @@ namespace Digitizer
 ParameterValidator::ParameterValidator(const nlohmann::json &deviceTree)
     : deviceTree_(deviceTree)
 {
+  BuildIndex();
 }
 
 // ============================================================================
@@ -102,18 +103,18 @@ ParameterValidator::ValidationResult
 ParameterValidator::ValidateSingleParameter(const std::string &paramPath,
                                             const std::string &value)
 {
+  const IndexEntry *entry = FindEntry(paramPath);
+
   // Check custom validators first
-  for (const auto &[pattern, validator] : customValidators_) {
-    if (MatchesPattern(paramPath, pattern)) {
-      auto paramDef = GetParameterDefinition(paramPath);
-      return validator(paramPath, value, paramDef);
+  static const nlohmann::json kEmptyDefinition;
+  for (const auto &[pattern, compiled] : customValidators_) {
+    if (compiled.first.Matches(paramPath)) {
+      return compiled.second(paramPath, value,
+                             entry ? *entry->definition : kEmptyDefinition);
     }
   }
 
-  // Get parameter definition from device tree
-  nlohmann::json paramDef = GetParameterDefinition(paramPath);
-
-  if (paramDef.empty()) {
+  if (!entry) {
     if (allowUnknownParameters_) {
       return ValidationResult(true, paramPath, value, "",
                               "Parameter not found in device tree");
@@ -124,7 +125,7 @@ ParameterValidator::ValidateSingleParameter(const std::string &paramPath,
   }
 
   // Validate based on parameter definition
-  return ValidateParameterValue(paramDef, paramPath, value);
+  return ValidateParameterValue(parameterInfos_[entry->info], paramPath, value);
 }
 
 // ============================================================================
@@ -134,7 +135,10 @@ ParameterValidator::ValidateSingleParameter(const std::string &paramPath,
 void ParameterValidator::AddCustomValidator(const std::string &paramPattern,
                                             CustomValidator validator)
 {
-  customValidators_[paramPattern] = std::move(validator);
+  customValidators_.erase(paramPattern);
+  customValidators_.emplace(
+      paramPattern,
+      std::make_pair(CompiledPattern(paramPattern), std::move(validator)));
 }
 
 void ParameterValidator::RemoveCustomValidator(const std::string &paramPattern)
@@ -146,7 +150,7 @@ void ParameterValidator::ClearCustomValidators() { customValidators_.clear(); }
 
 void ParameterValidator::AddIgnorePattern(const std::string &pattern)
 {
-  ignorePatterns_.insert(pattern);
+  ignorePatterns_.emplace(pattern, CompiledPattern(pattern));
 }
 
 void ParameterValidator::RemoveIgnorePattern(const std::string &pattern)
@@ -156,8 +160,8 @@ void ParameterValidator::RemoveIgnorePattern(const std::string &pattern)
 
 bool ParameterValidator::IsIgnored(const std::string &paramPath) const
 {
-  for (const auto &pattern : ignorePatterns_) {
-    if (MatchesPattern(paramPath, pattern)) {
+  for (const auto &[pattern, compiled] : ignorePatterns_) {
+    if (compiled.Matches(paramPath)) {
       return true;
     }
   }
@@ -168,28 +172,64 @@ bool ParameterValidator::IsIgnored(const std::string &paramPath) const
 // Parameter Information
 // ============================================================================
 
+const ParameterValidator::ParameterInfo *ParameterValidator::GetParameterInfo(
+    const std::string &paramPath) const
+{
+  const IndexEntry *entry = FindEntry(paramPath);
+  return entry ? &parameterInfos_[entry->info] : nullptr;
+}
+
 ParameterValidator::ParameterType ParameterValidator::GetParameterType(
     const std::string &paramPath) const
 {
-  auto paramDef = GetParameterDefinition(paramPath);
-  return ParseParameterType(paramDef);
+  const ParameterInfo *info = GetParameterInfo(paramPath);
+  return info ? info->type : ParameterType::Unknown;
 }
 
 std::optional<std::string> ParameterValidator::GetParameterDescription(
     const std::string &paramPath) const
 {
-  auto paramDef = GetParameterDefinition(paramPath);
-  if (paramDef.contains("description") &&
-      paramDef["description"].contains("value")) {
-    return paramDef["description"]["value"].get<std::string>();
+  const ParameterInfo *info = GetParameterInfo(paramPath);
+  if (info && !info->description.empty()) {
+    return info->description;
   }
   return std::nullopt;
 }
 
+std::optional<std::pair<std::string, std::string>>
+ParameterValidator::GetParameterRange(const std::string &paramPath) const
+{
+  const ParameterInfo *info = GetParameterInfo(paramPath);
+  if (info && (!info->minText.empty() || !info->maxText.empty())) {
+    return std::make_pair(info->minText, info->maxText);
+  }
+  return std::nullopt;
+}
+
+std::vector<std::string> ParameterValidator::GetAllowedValues(
+    const std::string &paramPath) const
+{
+  const ParameterInfo *info = GetParameterInfo(paramPath);
+  return info ? info->allowedValues : std::vector<std::string>();
+}
+
 bool ParameterValidator::IsParameterSupported(
     const std::string &paramPath) const
 {
-  return !GetParameterDefinition(paramPath).empty();
+  return FindEntry(paramPath) != nullptr;
+}
+
+std::vector<std::string> ParameterValidator::GetSupportedParameters() const
+{
+  return supportedParameters_;
+}
+
+std::vector<std::string> ParameterValidator::GetChannelParameters(
+    const std::string &channel) const
+{
+  auto it = channelParameters_.find(channel);
+  return it != channelParameters_.end() ? it->second
+                                        : std::vector<std::string>();
 }
 
 // ============================================================================
@@ -267,38 +307,43 @@ std::string ParameterValidator::MapConfigToDeviceTree(
   return lowerParam;
 }
 
-bool ParameterValidator::MatchesPattern(const std::string &path,
-                                        const std::string &pattern) const
+ParameterValidator::CompiledPattern::CompiledPattern(const std::string &pat)
+    : pattern(pat)
 {
   try {
-    std::regex regex(pattern);
-    return std::regex_match(path, regex);
+    regex.emplace(pattern);
   } catch (const std::exception &) {
-    return path.find(pattern) != std::string::npos;
+    regex.reset();
   }
 }
 
+bool ParameterValidator::CompiledPattern::Matches(const std::string &path) const
+{
+  if (regex) {
+    return std::regex_match(path, *regex);
+  }
+  return path.find(pattern) != std::string::npos;
+}
+
 // ============================================================================
 // Validation Engine
 // ============================================================================
 
 ParameterValidator::ValidationResult ParameterValidator::ValidateParameterValue(
-    const nlohmann::json &paramDef, const std::string &paramPath,
+    const ParameterInfo &info, const std::string &paramPath,
     const std::string &value) const
 {
-  ParameterType type = ParseParameterType(paramDef);
-
-  switch (type) {
+  switch (info.type) {
     case ParameterType::Number:
-      return ValidateNumberParameter(paramDef, paramPath, value);
+      return ValidateNumberParameter(info, paramPath, value);
     case ParameterType::Integer:
-      return ValidateIntegerParameter(paramDef, paramPath, value);
+      return ValidateIntegerParameter(info, paramPath, value);
     case ParameterType::String:
-      return ValidateStringParameter(paramDef, paramPath, value);
+      return ValidateStringParameter(info, paramPath, value);
     case ParameterType::Boolean:
-      return ValidateBooleanParameter(paramDef, paramPath, value);
+      return ValidateBooleanParameter(info, paramPath, value);
     case ParameterType::Enum:
-      return ValidateEnumParameter(paramDef, paramPath, value);
+      return ValidateEnumParameter(info, paramPath, value);
     default:
       return ValidationResult(true, paramPath, value, "",
                               "Unknown parameter type");
@@ -306,35 +351,23 @@ ParameterValidator::ValidationResult ParameterValidator::ValidateParameterValue(
 }
 
 ParameterValidator::ValidationResult
-ParameterValidator::ValidateNumberParameter(const nlohmann::json &paramDef,
+ParameterValidator::ValidateNumberParameter(const ParameterInfo &info,
                                             const std::string &paramPath,
                                             const std::string &value) const
 {
   try {
     double numValue = std::stod(value);
 
-    if (paramDef.contains("minvalue") &&
-        paramDef["minvalue"].contains("value")) {
-      double minVal =
-          std::stod(paramDef["minvalue"]["value"].get<std::string>());
-      if (numValue < minVal) {
-        return ValidationResult(
-            false, paramPath, value,
-            "Value " + value + " below minimum: " +
-                paramDef["minvalue"]["value"].get<std::string>());
-      }
+    if (info.minValue && numValue < *info.minValue) {
+      return ValidationResult(false, paramPath, value,
+                              "Value " + value +
+                                  " below minimum: " + info.minText);
     }
 
-    if (paramDef.contains("maxvalue") &&
-        paramDef["maxvalue"].contains("value")) {
-      double maxVal =
-          std::stod(paramDef["maxvalue"]["value"].get<std::string>());
-      if (numValue > maxVal) {
-        return ValidationResult(
-            false, paramPath, value,
-            "Value " + value + " above maximum: " +
-                paramDef["maxvalue"]["value"].get<std::string>());
-      }
+    if (info.maxValue && numValue > *info.maxValue) {
+      return ValidationResult(false, paramPath, value,
+                              "Value " + value +
+                                  " above maximum: " + info.maxText);
     }
 
     return ValidationResult(true, paramPath, value);
@@ -344,33 +377,23 @@ ParameterValidator::ValidateNumberParameter(const nlohmann::json &paramDef,
 }
 
 ParameterValidator::ValidationResult
-ParameterValidator::ValidateIntegerParameter(const nlohmann::json &paramDef,
+ParameterValidator::ValidateIntegerParameter(const ParameterInfo &info,
                                              const std::string &paramPath,
                                              const std::string &value) const
 {
   try {
     int intValue = std::stoi(value);
 
-    if (paramDef.contains("minvalue") &&
-        paramDef["minvalue"].contains("value")) {
-      int minVal = std::stoi(paramDef["minvalue"]["value"].get<std::string>());
-      if (intValue < minVal) {
-        return ValidationResult(
-            false, paramPath, value,
-            "Value " + value + " below minimum: " +
-                paramDef["minvalue"]["value"].get<std::string>());
-      }
+    if (info.minValue && intValue < *info.minValue) {
+      return ValidationResult(false, paramPath, value,
+                              "Value " + value +
+                                  " below minimum: " + info.minText);
     }
 
-    if (paramDef.contains("maxvalue") &&
-        paramDef["maxvalue"].contains("value")) {
-      int maxVal = std::stoi(paramDef["maxvalue"]["value"].get<std::string>());
-      if (intValue > maxVal) {
-        return ValidationResult(
-            false, paramPath, value,
-            "Value " + value + " above maximum: " +
-                paramDef["maxvalue"]["value"].get<std::string>());
-      }
+    if (info.maxValue && intValue > *info.maxValue) {
+      return ValidationResult(false, paramPath, value,
+                              "Value " + value +
+                                  " above maximum: " + info.maxText);
     }
 
     return ValidationResult(true, paramPath, value);
@@ -380,7 +403,7 @@ ParameterValidator::ValidateIntegerParameter(const nlohmann::json &paramDef,
 }
 
 ParameterValidator::ValidationResult
-ParameterValidator::ValidateStringParameter(const nlohmann::json &paramDef,
+ParameterValidator::ValidateStringParameter(const ParameterInfo &info,
                                             const std::string &paramPath,
                                             const std::string &value) const
 {
@@ -389,7 +412,7 @@ ParameterValidator::ValidateStringParameter(const nlohmann::json &paramDef,
 }
 
 ParameterValidator::ValidationResult
-ParameterValidator::ValidateBooleanParameter(const nlohmann::json &paramDef,
+ParameterValidator::ValidateBooleanParameter(const ParameterInfo &info,
                                              const std::string &paramPath,
                                              const std::string &value) const
 {
@@ -406,7 +429,7 @@ ParameterValidator::ValidateBooleanParameter(const nlohmann::json &paramDef,
 }
 
 ParameterValidator::ValidationResult ParameterValidator::ValidateEnumParameter(
-    const nlohmann::json &paramDef, const std::string &paramPath,
+    const ParameterInfo &info, const std::string &paramPath,
     const std::string &value) const
 {
   // Enum validation would check against allowed values
@@ -417,45 +440,169 @@ ParameterValidator::ValidationResult ParameterValidator::ValidateEnumParameter(
 // Device Tree Navigation
 // ============================================================================
 
-nlohmann::json ParameterValidator::GetParameterDefinition(
-    const std::string &paramPath) const
+void ParameterValidator::BuildIndex()
 {
-  if (paramPath.find("/ch/") != std::string::npos) {
-    size_t chStart = paramPath.find("/ch/") + 4;
-    size_t chEnd = paramPath.find("/", chStart);
+  parameterInfos_.clear();
+  index_.clear();
+  supportedParameters_.clear();
+  channelParameters_.clear();
+
+  if (!deviceTree_.is_object()) return;
+
+  std::unordered_map<std::string, std::vector<size_t>> infosByName;
+
+  // Board parameters
+  auto par = deviceTree_.find("par");
+  if (par != deviceTree_.end() && par->is_object()) {
+    for (auto it = par->begin(); it != par->end(); ++it) {
+      if (!it->is_object()) continue;
+      auto info = InternParameterInfo(MakeParameterInfo(it.key(), *it),
+                                      infosByName);
+      auto path = "/par/" + it.key();
+      index_[MakeIndexKey(path)] = IndexEntry{info, &(*it)};
+      supportedParameters_.push_back(path);
+    }
+  }
 
-    if (chEnd == std::string::npos) return nlohmann::json();
+  // Channel parameters, with the channels of each name collected so that
+  // runs of channels can be listed as ranges
+  std::map<std::string, std::vector<int>> channelsByName;
+  auto ch = deviceTree_.find("ch");
+  if (ch != deviceTree_.end() && ch->is_object()) {
+    for (auto chIt = ch->begin(); chIt != ch->end(); ++chIt) {
+      const auto &channel = chIt.key();
+      auto channelPar = chIt->is_object() ? chIt->find("par") : chIt->end();
+      if (channelPar == chIt->end() || !channelPar->is_object()) continue;
+
+      int channelNumber = -1;
+      try {
+        channelNumber = std::stoi(channel);
+      } catch (const std::exception &) {
+      }
 
-    std::string channel = paramPath.substr(chStart, chEnd - chStart);
-    std::string paramName = MapConfigToDeviceTree(paramPath);
+      auto &paths = channelParameters_[channel];
+      for (auto it = channelPar->begin(); it != channelPar->end(); ++it) {
+        if (!it->is_object()) continue;
+        auto info = InternParameterInfo(MakeParameterInfo(it.key(), *it),
+                                        infosByName);
+        auto path = "/ch/" + channel + "/par/" + it.key();
+        index_[MakeIndexKey(path)] = IndexEntry{info, &(*it)};
+        paths.push_back(path);
+        if (channelNumber >= 0) {
+          channelsByName[it.key()].push_back(channelNumber);
+        } else {
+          supportedParameters_.push_back(path);
+        }
+      }
+    }
+  }
 
-    return GetChannelParameterDefinition(channel, paramName);
-  } else if (paramPath.find("/par/") != std::string::npos) {
-    std::string paramName = MapConfigToDeviceTree(paramPath);
-    return GetRootParameterDefinition(paramName);
+  for (auto &[name, channels] : channelsByName) {
+    std::sort(channels.begin(), channels.end());
+    size_t runStart = 0;
+    for (size_t k = 1; k <= channels.size(); ++k) {
+      if (k < channels.size() && channels[k] == channels[k - 1] + 1) continue;
+      auto spec = std::to_string(channels[runStart]);
+      if (channels[k - 1] != channels[runStart]) {
+        spec += ".." + std::to_string(channels[k - 1]);
+      }
+      supportedParameters_.push_back("/ch/" + spec + "/par/" + name);
+      runStart = k;
+    }
   }
+}
 
-  return nlohmann::json();
+size_t ParameterValidator::InternParameterInfo(
+    ParameterInfo info,
+    std::unordered_map<std::string, std::vector<size_t>> &infosByName)
+{
+  // Channels mostly share definitions; the variants of one name are few,
+  // so a linear scan over the interned entries of that name is enough
+  auto &candidates = infosByName[info.name];
+  for (auto index : candidates) {
+    if (parameterInfos_[index] == info) return index;
+  }
+  parameterInfos_.push_back(std::move(info));
+  candidates.push_back(parameterInfos_.size() - 1);
+  return candidates.back();
 }
 
-nlohmann::json ParameterValidator::GetChannelParameterDefinition(
-    const std::string &channel, const std::string &paramName) const
+std::string ParameterValidator::MakeIndexKey(const std::string &paramPath) const
 {
-  if (deviceTree_.contains("ch") && deviceTree_["ch"].contains(channel) &&
-      deviceTree_["ch"][channel].contains("par") &&
-      deviceTree_["ch"][channel]["par"].contains(paramName)) {
-    return deviceTree_["ch"][channel]["par"][paramName];
+  // Same resolution as the device tree layout: the channel between /ch/ and
+  // the next '/', and the lowercase last path element as parameter name
+  auto chPos = paramPath.find("/ch/");
+  if (chPos != std::string::npos) {
+    size_t chStart = chPos + 4;
+    size_t chEnd = paramPath.find('/', chStart);
+    if (chEnd == std::string::npos) return "";
+    return "/ch/" + paramPath.substr(chStart, chEnd - chStart) + "/par/" +
+           MapConfigToDeviceTree(paramPath);
   }
-  return nlohmann::json();
+  if (paramPath.find("/par/") != std::string::npos) {
+    return "/par/" + MapConfigToDeviceTree(paramPath);
+  }
+  return "";
 }
 
-nlohmann::json ParameterValidator::GetRootParameterDefinition(
-    const std::string &paramName) const
+const ParameterValidator::IndexEntry *ParameterValidator::FindEntry(
+    const std::string &paramPath) const
 {
-  if (deviceTree_.contains("par") && deviceTree_["par"].contains(paramName)) {
-    return deviceTree_["par"][paramName];
+  auto key = MakeIndexKey(paramPath);
+  if (key.empty()) return nullptr;
+  auto it = index_.find(key);
+  return it != index_.end() ? &it->second : nullptr;
+}
+
+ParameterValidator::ParameterInfo ParameterValidator::MakeParameterInfo(
+    const std::string &name, const nlohmann::json &paramDef) const
+{
+  auto attribute = [&paramDef](const char *key) -> std::string {
+    auto it = paramDef.find(key);
+    if (it == paramDef.end() || !it->is_object()) return "";
+    auto value = it->find("value");
+    return (value != it->end() && value->is_string()) ? value->get<std::string>()
+                                                      : "";
+  };
+  auto toNumber = [](const std::string &text) -> std::optional<double> {
+    if (text.empty()) return std::nullopt;
+    try {
+      return std::stod(text);
+    } catch (const std::exception &) {
+      return std::nullopt;
+    }
+  };
+
+  ParameterInfo info;
+  info.name = name;
+  info.type = ParseParameterType(paramDef);
+  info.description = attribute("description");
+  info.minText = attribute("minvalue");
+  info.maxText = attribute("maxvalue");
+  info.minValue = toNumber(info.minText);
+  info.maxValue = toNumber(info.maxText);
+
+  // allowedvalues holds the count as "value" and the entries under "0".."N-1"
+  auto allowed = paramDef.find("allowedvalues");
+  if (allowed != paramDef.end() && allowed->is_object()) {
+    for (size_t i = 0;; ++i) {
+      auto entry = allowed->find(std::to_string(i));
+      if (entry == allowed->end() || !entry->is_object()) break;
+      auto value = entry->find("value");
+      if (value == entry->end() || !value->is_string()) break;
+      info.allowedValues.push_back(value->get<std::string>());
+    }
   }
-  return nlohmann::json();
+
+  return info;
+}
+
+bool ParameterValidator::ParameterInfo::operator==(
+    const ParameterInfo &other) const
+{
+  return name == other.name && type == other.type &&
+         description == other.description && minText == other.minText &&
+         maxText == other.maxText && allowedValues == other.allowedValues;
 }
 
 // ============================================================================
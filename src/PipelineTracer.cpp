@@ -0,0 +1,312 @@
+#include "PipelineTracer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define DELILA_TRACE_TSC
+#endif
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+namespace
+{
+std::atomic<uint64_t> gNextTracerId{1};
+
+// Ring of the tracer this thread recorded into last
+struct RingCache {
+  uint64_t tracerId = 0;
+  void *ring = nullptr;
+};
+thread_local RingCache tRingCache;
+
+// Value at fraction q of sorted order, moving values around
+uint64_t Percentile(std::vector<uint64_t> &values, double q)
+{
+  auto index = static_cast<size_t>(q * (values.size() - 1));
+  std::nth_element(values.begin(), values.begin() + index, values.end());
+  return values[index];
+}
+}  // namespace
+
+// ============================================================================
+// Configuration
+// ============================================================================
+
+PipelineTracer::PipelineTracer(PipelineTraceConfig config,
+                               uint8_t moduleNumber)
+    : fConfig(std::move(config)),
+      fModuleNumber(moduleNumber),
+      fId(gNextTracerId.fetch_add(1, std::memory_order_relaxed)),
+      fTicks0(Now()),
+      fNs0(SteadyNs())
+{
+}
+
+PipelineTraceConfig PipelineTracer::ParseConfig(
+    const ConfigurationManager &config)
+{
+  PipelineTraceConfig result;
+
+  auto enabled = config.GetParameterAsBool("PipelineTrace");
+  if (enabled) {
+    result.enabled = *enabled;
+  } else if (!config.GetParameter("PipelineTrace").empty()) {
+    std::cout << "Invalid PipelineTrace format, using default: false"
+              << std::endl;
+  }
+
+  auto spansStr = config.GetParameter("PipelineTraceSpans");
+  if (!spansStr.empty()) {
+    try {
+      auto spans = std::stoll(spansStr);
+      if (spans >= 1) result.spansPerThread = static_cast<size_t>(spans);
+    } catch (...) {
+      std::cout << "Invalid PipelineTraceSpans format, using default: "
+                << result.spansPerThread << std::endl;
+    }
+  }
+
+  // A trace file is only useful with tracing on
+  result.path = config.GetParameter("PipelineTracePath");
+  if (!result.path.empty()) result.enabled = true;
+
+  return result;
+}
+
+// ============================================================================
+// Recording
+// ============================================================================
+
+uint64_t PipelineTracer::Now()
+{
+#ifdef DELILA_TRACE_TSC
+  return __rdtsc();
+#else
+  return SteadyNs();
+#endif
+}
+
+uint64_t PipelineTracer::SteadyNs()
+{
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+PipelineTracer::Ring &PipelineTracer::GetRing()
+{
+  if (tRingCache.tracerId == fId) {
+    return *static_cast<Ring *>(tRingCache.ring);
+  }
+
+  // First span of this thread, or it alternates between tracers
+  std::lock_guard<std::mutex> lock(fRingsMutex);
+  auto self = std::this_thread::get_id();
+  Ring *ring = nullptr;
+  for (auto &candidate : fRings) {
+    if (candidate->owner == self) ring = candidate.get();
+  }
+  if (!ring) {
+    fRings.push_back(std::make_unique<Ring>(fConfig.spansPerThread));
+    ring = fRings.back().get();
+    ring->owner = self;
+  }
+  tRingCache.tracerId = fId;
+  tRingCache.ring = ring;
+  return *ring;
+}
+
+void PipelineTracer::Record(TraceStage stage, uint64_t sequence,
+                            uint64_t begin, uint64_t end)
+{
+  auto &ring = GetRing();
+  auto index = ring.head.load(std::memory_order_relaxed);
+  auto &span = ring.spans[index % ring.spans.size()];
+
+  // Orders the head store of the previous span before these stores, so a
+  // reader that sees any of them also sees head >= index (see Snapshot())
+  std::atomic_thread_fence(std::memory_order_release);
+  span.begin.store(begin, std::memory_order_relaxed);
+  span.end.store(end, std::memory_order_relaxed);
+  span.sequence.store(sequence, std::memory_order_relaxed);
+  span.stage.store(static_cast<uint8_t>(stage), std::memory_order_relaxed);
+  ring.head.store(index + 1, std::memory_order_release);
+}
+
+void PipelineTracer::RecordPickup()
+{
+  auto since = fPendingSince.exchange(0, std::memory_order_relaxed);
+  if (since == 0) return;
+  Record(TraceStage::Pickup,
+         fPickups.fetch_add(1, std::memory_order_relaxed), since, Now());
+}
+
+void PipelineTracer::Reset()
+{
+  std::lock_guard<std::mutex> lock(fRingsMutex);
+  for (auto &ring : fRings) ring->head.store(0, std::memory_order_relaxed);
+  fPendingSince.store(0, std::memory_order_relaxed);
+  fPickups.store(0, std::memory_order_relaxed);
+}
+
+// ============================================================================
+// Access
+// ============================================================================
+
+double PipelineTracer::GetNsPerTick() const
+{
+#ifdef DELILA_TRACE_TSC
+  auto ticks = Now() - fTicks0;
+  auto ns = SteadyNs() - fNs0;
+  return ticks > 0 ? static_cast<double>(ns) / ticks : 1.0;
+#else
+  return 1.0;
+#endif
+}
+
+std::vector<PipelineTracer::SpanCopy> PipelineTracer::Snapshot(
+    const Ring &ring) const
+{
+  const uint64_t capacity = ring.spans.size();
+  auto head = ring.head.load(std::memory_order_acquire);
+  auto first = head > capacity ? head - capacity : 0;
+
+  std::vector<SpanCopy> spans;
+  spans.reserve(head - first);
+  for (auto index = first; index < head; ++index) {
+    const auto &span = ring.spans[index % capacity];
+    spans.push_back({span.begin.load(std::memory_order_relaxed),
+                     span.end.load(std::memory_order_relaxed),
+                     span.sequence.load(std::memory_order_relaxed),
+                     static_cast<TraceStage>(
+                         span.stage.load(std::memory_order_relaxed))});
+  }
+
+  // The owner may have been rewriting the slots of spans after
+  // after - capacity, including the one of span after, during the copy
+  std::atomic_thread_fence(std::memory_order_acquire);
+  auto after = ring.head.load(std::memory_order_relaxed);
+  if (after >= first + capacity) {
+    auto overwritten = std::min<uint64_t>(after - capacity + 1 - first,
+                                          spans.size());
+    spans.erase(spans.begin(), spans.begin() + overwritten);
+  }
+  return spans;
+}
+
+void PipelineTracer::Fill(DigitizerStatistics &stats) const
+{
+  auto nsPerTick = GetNsPerTick();
+  std::array<std::vector<uint64_t>, kNumTraceStages> durations;
+  {
+    std::lock_guard<std::mutex> lock(fRingsMutex);
+    for (const auto &ring : fRings) {
+      for (const auto &span : Snapshot(*ring)) {
+        auto ticks = span.end > span.begin ? span.end - span.begin : 0;
+        auto stage = static_cast<size_t>(span.stage);
+        if (stage >= kNumTraceStages) continue;
+        durations[stage].push_back(static_cast<uint64_t>(ticks * nsPerTick));
+      }
+    }
+  }
+
+  for (size_t stage = 0; stage < kNumTraceStages; ++stage) {
+    auto &values = durations[stage];
+    auto &latency = stats.traceStages[stage];
+    latency = StageLatency{};
+    if (values.empty()) continue;
+    latency.count = values.size();
+    latency.maxNs = *std::max_element(values.begin(), values.end());
+    latency.p50Ns = Percentile(values, 0.50);
+    latency.p90Ns = Percentile(values, 0.90);
+    latency.p99Ns = Percentile(values, 0.99);
+  }
+}
+
+bool PipelineTracer::WriteChromeTrace(const std::string &path) const
+{
+  std::ofstream file(path);
+  if (!file) {
+    std::cerr << "Cannot write pipeline trace " << path << std::endl;
+    return false;
+  }
+
+  auto nsPerTick = GetNsPerTick();
+  auto toUs = [this, nsPerTick](uint64_t ticks) {
+    return ticks > fTicks0 ? (ticks - fTicks0) * nsPerTick / 1000.0 : 0.0;
+  };
+  const unsigned pid = fModuleNumber;
+  char line[256];
+
+  file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+  std::snprintf(line, sizeof(line),
+                "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,"
+                "\"args\":{\"name\":\"Module %02u\"}}",
+                pid, pid);
+  file << line;
+
+  std::lock_guard<std::mutex> lock(fRingsMutex);
+  for (size_t tid = 0; tid < fRings.size(); ++tid) {
+    auto spans = Snapshot(*fRings[tid]);
+
+    // Name each thread after the stages it recorded, e.g. "Queue/Decode"
+    std::array<bool, kNumTraceStages> seen{};
+    for (const auto &span : spans) {
+      auto stage = static_cast<size_t>(span.stage);
+      if (stage < kNumTraceStages) seen[stage] = true;
+    }
+    std::string name;
+    for (size_t stage = 0; stage < kNumTraceStages; ++stage) {
+      if (!seen[stage]) continue;
+      if (!name.empty()) name += '/';
+      name += GetTraceStageName(static_cast<TraceStage>(stage));
+    }
+    std::snprintf(line, sizeof(line),
+                  ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,"
+                  "\"tid\":%zu,\"args\":{\"name\":\"%s\"}}",
+                  pid, tid, name.c_str());
+    file << line;
+
+    for (const auto &span : spans) {
+      auto begin = toUs(span.begin);
+      auto end = std::max(begin, toUs(span.end));
+      std::snprintf(line, sizeof(line),
+                    ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%u,\"tid\":%zu,"
+                    "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"sequence\":%llu}}",
+                    GetTraceStageName(span.stage), pid, tid, begin,
+                    end - begin,
+                    static_cast<unsigned long long>(span.sequence));
+      file << line;
+    }
+  }
+  file << "\n]}\n";
+
+  if (!file) {
+    std::cerr << "Cannot write pipeline trace " << path << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void PipelineTracer::WriteRunTrace()
+{
+  if (fConfig.path.empty()) return;
+  char suffix[32];
+  std::snprintf(suffix, sizeof(suffix), "_mod%02u_%04u.json",
+                static_cast<unsigned>(fModuleNumber),
+                static_cast<unsigned>(fRunIndex));
+  if (WriteChromeTrace(fConfig.path + suffix)) fRunIndex++;
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
@@ -0,0 +1,243 @@
+#include "PulseProcessor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+namespace
+{
+// Per-thread trace buffers, grown to the longest trace seen
+struct PulseScratch {
+  std::vector<float> pulse;  // Baseline-subtracted, positive pulse
+  std::vector<float> work;   // CFD signal, then trapezoid input
+};
+
+PulseScratch &GetScratch()
+{
+  thread_local PulseScratch scratch;
+  return scratch;
+}
+
+float SumRange(const float *pulse, size_t nSamples, size_t begin,
+               size_t length)
+{
+  size_t end = std::min(nSamples, begin + length);
+  float sum = 0.0f;
+#pragma omp simd reduction(+ : sum)
+  for (size_t i = begin; i < end; ++i) {
+    sum += pulse[i];
+  }
+  return sum;
+}
+}  // namespace
+
+// ============================================================================
+// Configuration
+// ============================================================================
+
+PulseProcessingConfig PulseProcessor::ParseConfig(
+    const ConfigurationManager &config)
+{
+  PulseProcessingConfig result;
+
+  auto enabledStr = config.GetParameter("PulseProcessing");
+  if (!enabledStr.empty()) {
+    if (enabledStr == "On") {
+      result.enabled = true;
+    } else if (enabledStr == "Off") {
+      result.enabled = false;
+    } else {
+      std::cout << "Invalid PulseProcessing \"" << enabledStr
+                << "\", using default: Off" << std::endl;
+    }
+  }
+
+  auto polarityStr = config.GetParameter("PulsePolarity");
+  if (!polarityStr.empty()) {
+    if (polarityStr == "Negative") {
+      result.polarity = PulsePolarity::Negative;
+    } else if (polarityStr == "Positive") {
+      result.polarity = PulsePolarity::Positive;
+    } else {
+      std::cout << "Invalid PulsePolarity \"" << polarityStr
+                << "\", using default: Negative" << std::endl;
+    }
+  }
+
+  // Sample counts and lengths
+  auto parseSamples = [&config](const std::string &key, uint32_t &value) {
+    auto str = config.GetParameter(key);
+    if (str.empty()) return;
+    try {
+      auto number = std::stoul(str);
+      if (number <= UINT32_MAX) value = static_cast<uint32_t>(number);
+    } catch (...) {
+      std::cout << "Invalid " << key << " format, using default: " << value
+                << std::endl;
+    }
+  };
+  parseSamples("PulseBaselineSamples", result.baselineSamples);
+  parseSamples("PulseGateStart", result.gateStart);
+  parseSamples("PulseShortGate", result.shortGate);
+  parseSamples("PulseLongGate", result.longGate);
+  parseSamples("PulseCfdDelay", result.cfdDelay);
+  parseSamples("PulseTrapRise", result.trapRise);
+  parseSamples("PulseTrapFlat", result.trapFlat);
+
+  auto parseReal = [&config](const std::string &key, double &value,
+                             double min, double max) {
+    auto str = config.GetParameter(key);
+    if (str.empty()) return;
+    try {
+      auto number = std::stod(str);
+      if (number >= min && number <= max) value = number;
+    } catch (...) {
+      std::cout << "Invalid " << key << " format, using default: " << value
+                << std::endl;
+    }
+  };
+  parseReal("PulseCfdFraction", result.cfdFraction, 0.0, 1.0);
+  parseReal("PulseTrapDecay", result.trapDecay, 0.0, 1e9);
+
+  return result;
+}
+
+// ============================================================================
+// Processing
+// ============================================================================
+
+void PulseProcessor::Process(
+    std::vector<std::unique_ptr<EventData>> &events) const
+{
+  for (auto &event : events) {
+    if (event->waveformSize == 0 || event->analogProbe1.empty()) {
+      event->pulseFeatures = PulseFeatures();
+      continue;
+    }
+    Compute(event->analogProbe1.data(), event->waveformSize,
+            event->pulseFeatures);
+  }
+}
+
+void PulseProcessor::Process(EventBatch &batch) const
+{
+  const size_t nEvents = batch.Size();
+  batch.pulseFeatures.resize(nEvents);
+  for (size_t i = 0; i < nEvents; ++i) {
+    const size_t nSamples = batch.waveformSize[i];
+    if (nSamples == 0) {
+      batch.pulseFeatures[i] = PulseFeatures();
+      continue;
+    }
+    Compute(batch.analogProbe1.data() + batch.waveformOffset[i], nSamples,
+            batch.pulseFeatures[i]);
+  }
+}
+
+void PulseProcessor::Compute(const int32_t *samples, size_t nSamples,
+                             PulseFeatures &features) const
+{
+  features = PulseFeatures();
+  if (nSamples == 0) return;
+
+  auto &scratch = GetScratch();
+  if (scratch.pulse.size() < nSamples) {
+    scratch.pulse.resize(nSamples);
+    scratch.work.resize(nSamples);
+  }
+  float *pulse = scratch.pulse.data();
+  float *work = scratch.work.data();
+
+  // Baseline from the pre-trigger samples
+  const size_t nBaseline = std::max<size_t>(
+      1, std::min<size_t>(fConfig.baselineSamples, nSamples));
+  int64_t baselineSum = 0;
+#pragma omp simd reduction(+ : baselineSum)
+  for (size_t i = 0; i < nBaseline; ++i) {
+    baselineSum += samples[i];
+  }
+  const float baseline = static_cast<float>(baselineSum) / nBaseline;
+
+  // Subtract the baseline and make the pulse positive
+  const float sign =
+      fConfig.polarity == PulsePolarity::Negative ? -1.0f : 1.0f;
+  float amplitude = 0.0f;
+#pragma omp simd reduction(max : amplitude)
+  for (size_t i = 0; i < nSamples; ++i) {
+    pulse[i] = sign * (static_cast<float>(samples[i]) - baseline);
+    amplitude = std::max(amplitude, pulse[i]);
+  }
+
+  features.valid = true;
+  features.baseline = baseline;
+  features.amplitude = amplitude;
+  features.chargeShort =
+      SumRange(pulse, nSamples, fConfig.gateStart, fConfig.shortGate);
+  features.chargeLong =
+      SumRange(pulse, nSamples, fConfig.gateStart, fConfig.longGate);
+
+  // CFD: delayed pulse minus a fraction of the pulse, negative on the
+  // leading edge; the crossing is the first rise through zero after the
+  // signal went below half of its ideal minimum
+  const size_t delay = fConfig.cfdDelay;
+  if (delay > 0 && delay < nSamples && amplitude > 0.0f) {
+    const float fraction = static_cast<float>(fConfig.cfdFraction);
+#pragma omp simd
+    for (size_t i = delay; i < nSamples; ++i) {
+      work[i] = pulse[i - delay] - fraction * pulse[i];
+    }
+    const float arm = -0.5f * fraction * amplitude;
+    bool armed = false;
+    for (size_t i = delay; i < nSamples; ++i) {
+      if (!armed) {
+        armed = work[i] < arm;
+      } else if (work[i] >= 0.0f) {
+        const float before = work[i - 1];
+        features.cfdSample =
+            static_cast<float>(i - 1) + before / (before - work[i]);
+        break;
+      }
+    }
+  }
+
+  // Trapezoid (Jordanov): double difference of the pulse, then two running
+  // sums with pole-zero correction M; the flat top height is A*k*(M + 1)
+  const size_t rise = fConfig.trapRise;
+  if (rise > 0) {
+    const size_t gap = rise + fConfig.trapFlat;
+    auto at = [pulse](size_t i, size_t back) {
+      return i >= back ? pulse[i - back] : 0.0f;
+    };
+    const size_t head = std::min(nSamples, rise + gap);
+    for (size_t i = 0; i < head; ++i) {
+      work[i] = at(i, 0) - at(i, rise) - at(i, gap) + at(i, rise + gap);
+    }
+#pragma omp simd
+    for (size_t i = head; i < nSamples; ++i) {
+      work[i] = pulse[i] - pulse[i - rise] - pulse[i - gap] +
+                pulse[i - rise - gap];
+    }
+    const double decayM = fConfig.trapDecay > 0.0
+                              ? 1.0 / std::expm1(1.0 / fConfig.trapDecay)
+                              : 0.0;
+    double accumulated = 0.0;
+    double trapezoid = 0.0;
+    double height = 0.0;
+    for (size_t i = 0; i < nSamples; ++i) {
+      accumulated += work[i];
+      trapezoid += accumulated + decayM * work[i];
+      height = std::max(height, trapezoid);
+    }
+    features.trapezoidHeight = static_cast<float>(
+        height / (static_cast<double>(rise) * (decayM + 1.0)));
+  }
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
@@ -27,6 +27,7 @@ void RawData::Clear()
 {
   Resize(0);
   nEvents = 0;
+  sequence = 0;
 }
 
 void RawData::Reserve(size_t capacity) { data.reserve(capacity); }
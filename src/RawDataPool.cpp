@@ -0,0 +1,73 @@
+#include "RawDataPool.hpp"
+
+#include <algorithm>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+RawDataPool::RawDataPool(size_t bufferSize, size_t maxBuffers)
+    : fBufferSize(bufferSize), fMaxBuffers(std::max<size_t>(maxBuffers, 1))
+{
+  fFreeBuffers.reserve(fMaxBuffers);
+}
+
+std::unique_ptr<RawData_t> RawDataPool::Acquire(
+    std::chrono::milliseconds timeout)
+{
+  std::unique_lock<std::mutex> lock(fMutex);
+
+  if (fFreeBuffers.empty() && fAllocatedCount >= fMaxBuffers) {
+    fExhaustedCount++;
+    if (!fReleasedCV.wait_for(lock, timeout, [this] {
+          return !fFreeBuffers.empty() || fAllocatedCount < fMaxBuffers;
+        })) {
+      return nullptr;
+    }
+  }
+
+  if (!fFreeBuffers.empty()) {
+    auto rawData = std::move(fFreeBuffers.back());
+    fFreeBuffers.pop_back();
+    return rawData;
+  }
+
+  // Allocate outside the lock, the slot is reserved by the counter
+  fAllocatedCount++;
+  lock.unlock();
+  return std::make_unique<RawData_t>(fBufferSize);
+}
+
+void RawDataPool::Release(std::unique_ptr<RawData_t> rawData)
+{
+  if (!rawData) return;
+
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    if (rawData->data.size() != fBufferSize) {
+      // Not one of ours (or resized by a consumer), drop it and free the slot
+      if (fAllocatedCount > 0) fAllocatedCount--;
+    } else {
+      rawData->size = 0;
+      rawData->nEvents = 0;
+      fFreeBuffers.push_back(std::move(rawData));
+    }
+  }
+  fReleasedCV.notify_one();
+}
+
+size_t RawDataPool::GetAllocatedCount() const
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  return fAllocatedCount;
+}
+
+size_t RawDataPool::GetFreeCount() const
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  return fFreeBuffers.size();
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
@@ -0,0 +1,312 @@
+#include "RawRecorder.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+namespace
+{
+constexpr size_t kMaxIovecs = 1024;  // Linux UIO_MAXIOV
+}  // namespace
+
+// ============================================================================
+// Constructor/Destructor
+// ============================================================================
+
+RawRecorder::RawRecorder(RawRecorderConfig config, FirmwareType firmwareType,
+                         uint8_t moduleNumber)
+    : fConfig(std::move(config)),
+      fFirmwareType(firmwareType),
+      fModuleNumber(moduleNumber)
+{
+  fConfig.maxBatch = std::max<size_t>(fConfig.maxBatch, 1);
+}
+
+RawRecorder::~RawRecorder() { Stop(); }
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+bool RawRecorder::Start()
+{
+  if (fWriterThread.joinable() || fConfig.pathPrefix.empty()) {
+    return false;
+  }
+
+  fFailed = false;
+  if (!OpenFiles()) {
+    return false;
+  }
+
+  fStopping = false;
+  fQueue.Reopen();
+  fWriterThread = std::thread(&RawRecorder::WriterThread, this);
+  return true;
+}
+
+void RawRecorder::Stop()
+{
+  if (!fWriterThread.joinable()) {
+    return;
+  }
+
+  fStopping = true;
+  fQueue.Close();
+  fWriterThread.join();
+  CloseFiles();
+}
+
+void RawRecorder::Push(std::unique_ptr<RawData_t> rawData)
+{
+  // Push() leaves rawData untouched once the queue has been closed
+  if (!fQueue.Push(std::move(rawData)) && rawData && fSink) {
+    fSink(std::move(rawData));
+  }
+}
+
+void RawRecorder::Fill(DigitizerStatistics &stats) const
+{
+  stats.recordedBytes = fBytesWritten.load(std::memory_order_relaxed);
+  stats.recordedAggregates = fRecordsWritten.load(std::memory_order_relaxed);
+  stats.recordedFiles = fFilesWritten.load(std::memory_order_relaxed);
+  stats.recordErrors = fWriteErrors.load(std::memory_order_relaxed);
+}
+
+// ============================================================================
+// Writer Thread
+// ============================================================================
+
+void RawRecorder::WriterThread()
+{
+  std::vector<std::unique_ptr<RawData_t>> batch;
+  batch.reserve(fConfig.maxBatch);
+
+  while (true) {
+    batch.clear();
+    auto count = fQueue.PopBatch(batch, fConfig.maxBatch,
+                                 std::chrono::milliseconds(100));
+    if (count == 0) {
+      if (fStopping && fQueue.Empty()) break;
+      continue;
+    }
+
+    WriteBatch(batch);
+
+    // The written buffers go on to decoding untouched
+    for (auto &rawData : batch) {
+      if (fSink) fSink(std::move(rawData));
+    }
+  }
+}
+
+void RawRecorder::WriteBatch(
+    const std::vector<std::unique_ptr<RawData_t>> &batch)
+{
+  if (fFailed || fRunFd < 0) {
+    return;
+  }
+
+  std::vector<RawFile::RecordHeader> headers(batch.size());
+  uint64_t writeTimeNs =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count();
+  std::vector<RawFile::IndexEntry> entries;
+  entries.reserve(batch.size());
+  std::vector<iovec> iov;
+  iov.reserve(2 * batch.size());
+  uint64_t pendingBytes = 0;
+
+  auto flush = [&]() {
+    if (entries.empty()) return true;
+    if (!WriteAll(fRunFd, iov)) {
+      Fail("write run file");
+      return false;
+    }
+    std::vector<iovec> indexIov = {
+        {entries.data(), entries.size() * sizeof(RawFile::IndexEntry)}};
+    if (!WriteAll(fIndexFd, indexIov)) {
+      Fail("write index file");
+      return false;
+    }
+    fBytesWritten.fetch_add(pendingBytes, std::memory_order_relaxed);
+    fRecordsWritten.fetch_add(entries.size(), std::memory_order_relaxed);
+    iov.clear();
+    entries.clear();
+    pendingBytes = 0;
+    return true;
+  };
+
+  for (size_t i = 0; i < batch.size(); ++i) {
+    const auto &rawData = *batch[i];
+    uint64_t recordSize = sizeof(RawFile::RecordHeader) + rawData.size;
+
+    // Rotate before the file would grow past the limit, but never leave a
+    // file without records
+    if (fFileSize > sizeof(RawFile::FileHeader) &&
+        fFileSize + recordSize > fConfig.maxFileSize) {
+      if (!flush()) return;
+      CloseFiles();
+      if (!OpenFiles()) {
+        Fail("rotate files");
+        return;
+      }
+    }
+
+    headers[i].size = rawData.size;
+    headers[i].sequence = rawData.sequence;
+    headers[i].writeTimeNs = writeTimeNs;
+    headers[i].nEvents = rawData.nEvents;
+    headers[i].reserved = 0;
+
+    RawFile::IndexEntry entry{};
+    entry.offset = fFileSize;
+    entry.sequence = rawData.sequence;
+    if (fPeek &&
+        fPeek(rawData, entry.aggregateCounter, entry.firstTimeStamp)) {
+      entry.flags = RawFile::kIndexInfoValid;
+    }
+    entries.push_back(entry);
+
+    iov.push_back({&headers[i], sizeof(RawFile::RecordHeader)});
+    if (rawData.size > 0) {
+      iov.push_back({const_cast<uint8_t *>(rawData.data.data()), rawData.size});
+    }
+    fFileSize += recordSize;
+    pendingBytes += recordSize;
+  }
+
+  flush();
+}
+
+bool RawRecorder::WriteAll(int fd, std::vector<iovec> &iov)
+{
+  size_t first = 0;
+  while (first < iov.size()) {
+    auto count =
+        static_cast<int>(std::min(iov.size() - first, kMaxIovecs));
+    ssize_t written = writev(fd, &iov[first], count);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+
+    // Skip what was written completely and trim a partial entry
+    auto remaining = static_cast<size_t>(written);
+    while (first < iov.size() && remaining >= iov[first].iov_len) {
+      remaining -= iov[first].iov_len;
+      ++first;
+    }
+    if (remaining > 0) {
+      iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + remaining;
+      iov[first].iov_len -= remaining;
+    }
+  }
+  return true;
+}
+
+// ============================================================================
+// Files
+// ============================================================================
+
+bool RawRecorder::OpenFiles()
+{
+  auto runPath = MakePath(".raw");
+  auto indexPath = MakePath(".idx");
+
+  // Existing recordings are never overwritten
+  constexpr int kFlags = O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC;
+  fRunFd = open(runPath.c_str(), kFlags, 0644);
+  if (fRunFd < 0) {
+    std::cerr << "Failed to create raw data file " << runPath << ": "
+              << std::strerror(errno) << std::endl;
+    return false;
+  }
+  fIndexFd = open(indexPath.c_str(), kFlags, 0644);
+  if (fIndexFd < 0) {
+    std::cerr << "Failed to create raw data index " << indexPath << ": "
+              << std::strerror(errno) << std::endl;
+    CloseFiles();
+    return false;
+  }
+
+  RawFile::FileHeader header{};
+  header.version = RawFile::kVersion;
+  header.headerSize = sizeof(header);
+  header.firmwareType = static_cast<uint32_t>(fFirmwareType);
+  header.moduleNumber = fModuleNumber;
+  header.fileIndex = fFileIndex;
+  header.timeStepNs = fTimeStepNs;
+  header.creationTimeNs =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count();
+
+  std::memcpy(header.magic, RawFile::kRunMagic, sizeof(header.magic));
+  std::vector<iovec> runIov = {{&header, sizeof(header)}};
+  bool ok = WriteAll(fRunFd, runIov);
+
+  RawFile::FileHeader indexHeader = header;
+  std::memcpy(indexHeader.magic, RawFile::kIndexMagic,
+              sizeof(indexHeader.magic));
+  std::vector<iovec> indexIov = {{&indexHeader, sizeof(indexHeader)}};
+  ok &= WriteAll(fIndexFd, indexIov);
+
+  if (!ok) {
+    std::cerr << "Failed to write raw data file header " << runPath
+              << std::endl;
+    CloseFiles();
+    return false;
+  }
+
+  std::cout << "Recording raw data to " << runPath << std::endl;
+  fFileSize = sizeof(header);
+  fFileIndex++;
+  fFilesWritten.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void RawRecorder::CloseFiles()
+{
+  if (fRunFd >= 0) {
+    close(fRunFd);
+    fRunFd = -1;
+  }
+  if (fIndexFd >= 0) {
+    close(fIndexFd);
+    fIndexFd = -1;
+  }
+}
+
+void RawRecorder::Fail(const std::string &what)
+{
+  std::cerr << "Raw data recording stopped, failed to " << what << ": "
+            << std::strerror(errno) << std::endl;
+  fWriteErrors.fetch_add(1, std::memory_order_relaxed);
+  fFailed = true;
+  CloseFiles();
+}
+
+std::string RawRecorder::MakePath(const char *extension) const
+{
+  char suffix[32];
+  std::snprintf(suffix, sizeof(suffix), "_mod%02u_%04u",
+                static_cast<unsigned>(fModuleNumber),
+                static_cast<unsigned>(fFileIndex));
+  return fConfig.pathPrefix + suffix + extension;
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
@@ -0,0 +1,183 @@
+#include "ReadoutController.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+// ============================================================================
+// Configuration
+// ============================================================================
+
+void ReadoutController::Configure(const ReadoutControlConfig &config,
+                                  size_t maxRawDataSize)
+{
+  fConfig = config;
+  fMaxRawDataSize = maxRawDataSize;
+  fHasLastRead = false;
+  fReadTimeoutMs.store(fConfig.readTimeoutMs, std::memory_order_relaxed);
+  fIntervalMs.store(0.0, std::memory_order_relaxed);
+  fBytesPerRead.store(0.0, std::memory_order_relaxed);
+  fEventsPerRead.store(0.0, std::memory_order_relaxed);
+  fEventsPerAggregate.store(0, std::memory_order_relaxed);
+  fTimeoutChanges.store(0, std::memory_order_relaxed);
+}
+
+ReadoutControlConfig ReadoutController::ParseConfig(
+    const ConfigurationManager &config)
+{
+  ReadoutControlConfig result;
+
+  auto goalStr = config.GetParameter("ReadoutGoal");
+  if (!goalStr.empty()) {
+    if (goalStr == "Fixed") {
+      result.goal = ReadoutGoal::Fixed;
+    } else if (goalStr == "Latency") {
+      result.goal = ReadoutGoal::Latency;
+    } else if (goalStr == "Throughput") {
+      result.goal = ReadoutGoal::Throughput;
+    } else {
+      std::cout << "Invalid ReadoutGoal \"" << goalStr
+                << "\", using default: Fixed" << std::endl;
+    }
+  }
+
+  auto parseMs = [&config](const std::string &key, uint32_t &value) {
+    auto str = config.GetParameter(key);
+    if (str.empty()) return;
+    try {
+      auto ms = std::stoi(str);
+      if (ms >= 1) value = static_cast<uint32_t>(ms);
+    } catch (...) {
+      std::cout << "Invalid " << key << " format, using default: " << value
+                << std::endl;
+    }
+  };
+  parseMs("ReadTimeoutMs", result.readTimeoutMs);
+  parseMs("ReadTimeoutMinMs", result.minReadTimeoutMs);
+  parseMs("ReadTimeoutMaxMs", result.maxReadTimeoutMs);
+  if (result.maxReadTimeoutMs < result.minReadTimeoutMs) {
+    std::cout << "ReadTimeoutMaxMs below ReadTimeoutMinMs, using "
+              << result.minReadTimeoutMs << " for both" << std::endl;
+    result.maxReadTimeoutMs = result.minReadTimeoutMs;
+  }
+
+  auto latencyStr = config.GetParameter("ReadoutTargetLatencyMs");
+  if (!latencyStr.empty()) {
+    try {
+      auto latency = std::stod(latencyStr);
+      if (latency > 0.0) result.targetLatencyMs = latency;
+    } catch (...) {
+      std::cout << "Invalid ReadoutTargetLatencyMs format, using default: "
+                << result.targetLatencyMs << std::endl;
+    }
+  }
+
+  return result;
+}
+
+// ============================================================================
+// Reader Thread
+// ============================================================================
+
+void ReadoutController::RecordRead(size_t bytes, uint32_t nEvents)
+{
+  if (!IsAdaptive()) return;
+
+  auto now = std::chrono::steady_clock::now();
+  if (!fHasLastRead) {
+    // No interval yet; the very first read also seeds the size averages
+    fLastRead = now;
+    fHasLastRead = true;
+    if (fIntervalMs.load(std::memory_order_relaxed) == 0.0) {
+      fBytesPerRead.store(static_cast<double>(bytes),
+                          std::memory_order_relaxed);
+      fEventsPerRead.store(nEvents, std::memory_order_relaxed);
+    }
+    return;
+  }
+
+  auto smooth = [](std::atomic<double> &average, double sample) {
+    double previous = average.load(std::memory_order_relaxed);
+    average.store(previous + kSmoothing * (sample - previous),
+                  std::memory_order_relaxed);
+  };
+  double intervalMs =
+      std::chrono::duration<double, std::milli>(now - fLastRead).count();
+  fLastRead = now;
+  if (fIntervalMs.load(std::memory_order_relaxed) == 0.0) {
+    fIntervalMs.store(intervalMs, std::memory_order_relaxed);
+  } else {
+    smooth(fIntervalMs, intervalMs);
+  }
+  smooth(fBytesPerRead, static_cast<double>(bytes));
+  smooth(fEventsPerRead, static_cast<double>(nEvents));
+
+  // Wait a few intervals before calling the board empty
+  double maxMs = fConfig.maxReadTimeoutMs;
+  if (fConfig.goal == ReadoutGoal::Latency) {
+    maxMs = std::min(maxMs, fConfig.targetLatencyMs);
+  }
+  double timeoutMs = std::clamp(
+      kTimeoutIntervals * fIntervalMs.load(std::memory_order_relaxed),
+      static_cast<double>(fConfig.minReadTimeoutMs),
+      std::max(maxMs, static_cast<double>(fConfig.minReadTimeoutMs)));
+  auto timeout = static_cast<uint32_t>(std::lround(timeoutMs));
+  if (timeout != fReadTimeoutMs.load(std::memory_order_relaxed)) {
+    fReadTimeoutMs.store(timeout, std::memory_order_relaxed);
+    fTimeoutChanges.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+// ============================================================================
+// Between Runs
+// ============================================================================
+
+uint32_t ReadoutController::RecommendEventsPerAggregate(uint32_t current) const
+{
+  double intervalMs = fIntervalMs.load(std::memory_order_relaxed);
+  double eventsPerRead = fEventsPerRead.load(std::memory_order_relaxed);
+  double bytesPerRead = fBytesPerRead.load(std::memory_order_relaxed);
+  if (!IsAdaptive() || current == 0 || intervalMs <= 0.0 ||
+      eventsPerRead < 1.0 || bytesPerRead <= 0.0) {
+    return current;
+  }
+
+  // Events one read can carry without filling more than half a buffer
+  double bytesPerEvent = bytesPerRead / eventsPerRead;
+  double capacity = 0.5 * fMaxRawDataSize / bytesPerEvent;
+
+  double target = capacity;
+  if (fConfig.goal == ReadoutGoal::Latency) {
+    double eventsPerMs = eventsPerRead / intervalMs;
+    target = std::min(capacity, eventsPerMs * fConfig.targetLatencyMs);
+  }
+
+  // The setting counts events per channel aggregate, so scale it rather
+  // than converting the target directly
+  double scaled = current * target / eventsPerRead;
+  return static_cast<uint32_t>(std::clamp(
+      std::lround(scaled), 1L, static_cast<long>(kMaxEventsPerAggregate)));
+}
+
+void ReadoutController::Fill(DigitizerStatistics &stats) const
+{
+  double intervalMs = fIntervalMs.load(std::memory_order_relaxed);
+  stats.readTimeoutMs = fReadTimeoutMs.load(std::memory_order_relaxed);
+  stats.readTimeoutChanges = fTimeoutChanges.load(std::memory_order_relaxed);
+  stats.eventsPerAggregate =
+      fEventsPerAggregate.load(std::memory_order_relaxed);
+  if (intervalMs > 0.0) {
+    stats.readRateHz = 1000.0 / intervalMs;
+    stats.eventRateHz =
+        fEventsPerRead.load(std::memory_order_relaxed) * stats.readRateHz;
+  }
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
@@ -0,0 +1,162 @@
+#include "ThreadPlacement.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+// ============================================================================
+// Configuration
+// ============================================================================
+
+ThreadPlacementConfig ThreadPlacement::ParseConfig(
+    const ConfigurationManager &config)
+{
+  ThreadPlacementConfig result;
+
+  auto parseList = [&config](const std::string &key, std::vector<int> &cpus) {
+    auto listStr = config.GetParameter(key);
+    if (listStr.empty()) return;
+    if (!ParseCPUList(listStr, cpus)) {
+      cpus.clear();
+      std::cout << "Invalid " << key << " \"" << listStr
+                << "\", threads are not pinned" << std::endl;
+    }
+  };
+  parseList("ReaderCPUs", result.readerCPUs);
+  parseList("DecoderCPUs", result.decoderCPUs);
+
+  auto nodeStr = config.GetParameter("NUMANode");
+  if (!nodeStr.empty()) {
+    try {
+      result.numaNode = std::stoi(nodeStr);
+    } catch (...) {
+      std::cout << "Invalid NUMANode format, using default: "
+                << result.numaNode << std::endl;
+    }
+    if (result.numaNode >= 0) {
+      result.nodeCPUs = GetNodeCPUs(result.numaNode);
+      if (result.nodeCPUs.empty()) {
+        std::cout << "NUMA node " << result.numaNode
+                  << " not found, threads are not pinned to it" << std::endl;
+      }
+    }
+  }
+
+  auto priorityStr = config.GetParameter("ReaderPriority");
+  if (!priorityStr.empty()) {
+    try {
+      auto priority = std::stoi(priorityStr);
+      if (priority >= 0 && priority <= 99) result.readerPriority = priority;
+    } catch (...) {
+      std::cout << "Invalid ReaderPriority format, using default: "
+                << result.readerPriority << std::endl;
+    }
+  }
+
+  return result;
+}
+
+bool ThreadPlacement::ParseCPUList(const std::string &list,
+                                   std::vector<int> &cpus)
+{
+  cpus.clear();
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    if (item.empty()) continue;
+    try {
+      auto dash = item.find('-');
+      int first = std::stoi(item.substr(0, dash));
+      int last = dash == std::string::npos ? first
+                                           : std::stoi(item.substr(dash + 1));
+      if (first < 0 || last < first) return false;
+      for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+    } catch (...) {
+      return false;
+    }
+  }
+  return !cpus.empty();
+}
+
+std::vector<int> ThreadPlacement::GetNodeCPUs(int node)
+{
+  std::vector<int> cpus;
+  std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) +
+                     "/cpulist");
+  std::string list;
+  if (file && std::getline(file, list)) {
+    ParseCPUList(list, cpus);
+  }
+  return cpus;
+}
+
+// ============================================================================
+// Placement
+// ============================================================================
+
+std::vector<int> ThreadPlacement::SelectCPUs(
+    const std::vector<int> &list, size_t index,
+    const ThreadPlacementConfig &config)
+{
+  if (!list.empty()) return {list[index % list.size()]};
+  return config.nodeCPUs;
+}
+
+void ThreadPlacement::PlaceReader(std::thread &thread, size_t index,
+                                  const ThreadPlacementConfig &config)
+{
+  auto cpus = SelectCPUs(config.readerCPUs, index, config);
+  if (!cpus.empty()) Pin(thread, cpus);
+  if (config.readerPriority > 0) {
+    SetRealtimePriority(thread, config.readerPriority);
+  }
+}
+
+void ThreadPlacement::PlaceDecoder(std::thread &thread, size_t index,
+                                   const ThreadPlacementConfig &config)
+{
+  auto cpus = SelectCPUs(config.decoderCPUs, index, config);
+  if (!cpus.empty()) Pin(thread, cpus);
+}
+
+bool ThreadPlacement::Pin(std::thread &thread, const std::vector<int> &cpus)
+{
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (auto cpu : cpus) {
+    if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+  }
+
+  int err = pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+  if (err != 0) {
+    std::cerr << "Failed to set thread affinity: " << std::strerror(err)
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool ThreadPlacement::SetRealtimePriority(std::thread &thread, int priority)
+{
+  sched_param param{};
+  param.sched_priority = priority;
+  int err = pthread_setschedparam(thread.native_handle(), SCHED_FIFO, &param);
+  if (err != 0) {
+    std::cerr << "Failed to set real-time priority " << priority << ": "
+              << std::strerror(err) << std::endl;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
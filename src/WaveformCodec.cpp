@@ -0,0 +1,312 @@
+#include "WaveformCodec.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+namespace
+{
+template <typename T>
+void Put(std::vector<uint8_t> &out, T value)
+{
+  const auto size = out.size();
+  out.resize(size + sizeof(T));
+  std::memcpy(out.data() + size, &value, sizeof(T));
+}
+
+template <typename T>
+T Get(const uint8_t *data)
+{
+  T value;
+  std::memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+uint64_t ZigZag(int64_t value)
+{
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+int64_t UnZigZag(uint64_t value)
+{
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+size_t VarintSize(uint64_t value)
+{
+  size_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    ++size;
+  }
+  return size;
+}
+
+void PutVarint(std::vector<uint8_t> &out, uint64_t value)
+{
+  while (value >= 0x80) {
+    out.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+// Shift left without the undefined behaviour of shifting negative values
+int32_t Restore(int64_t value, unsigned shift)
+{
+  return static_cast<int32_t>(static_cast<uint32_t>(value) << shift);
+}
+
+uint8_t EncodeAnalog(const int32_t *values, size_t n, bool delta,
+                     std::vector<uint8_t> &out)
+{
+  using Analog = WaveformCodec::Analog;
+
+  uint32_t bits = 0;
+  bool constant = true;
+  for (size_t i = 0; i < n; ++i) {
+    bits |= static_cast<uint32_t>(values[i]);
+    constant &= values[i] == values[0];
+  }
+  if (constant) {
+    Put<int32_t>(out, values[0]);
+    return static_cast<uint8_t>(Analog::Constant);
+  }
+
+  // Multiplication factors leave the low bits of every sample zero
+  unsigned shift = 0;
+  while (!((bits >> shift) & 0x1)) ++shift;
+
+  bool fits16 = true;
+  for (size_t i = 0; i < n; ++i) {
+    const int32_t value = values[i] >> shift;
+    fits16 &= value >= INT16_MIN && value <= INT16_MAX;
+  }
+  const size_t fixedSize = n * (fits16 ? sizeof(int16_t) : sizeof(int32_t));
+
+  auto encoding = fits16 ? Analog::Int16 : Analog::Int32;
+  if (delta) {
+    size_t deltaSize = 0;
+    int64_t previous = 0;
+    for (size_t i = 0; i < n && deltaSize < fixedSize; ++i) {
+      const int64_t value = values[i] >> shift;
+      deltaSize += VarintSize(ZigZag(value - previous));
+      previous = value;
+    }
+    if (deltaSize < fixedSize) encoding = Analog::Delta;
+  }
+
+  if (encoding == Analog::Delta) {
+    int64_t previous = 0;
+    for (size_t i = 0; i < n; ++i) {
+      const int64_t value = values[i] >> shift;
+      PutVarint(out, ZigZag(value - previous));
+      previous = value;
+    }
+  } else if (encoding == Analog::Int16) {
+    const auto begin = out.size();
+    out.resize(begin + n * sizeof(int16_t));
+    for (size_t i = 0; i < n; ++i) {
+      const auto value = static_cast<int16_t>(values[i] >> shift);
+      std::memcpy(out.data() + begin + i * sizeof(int16_t), &value,
+                  sizeof(int16_t));
+    }
+  } else {
+    const auto begin = out.size();
+    out.resize(begin + n * sizeof(int32_t));
+    for (size_t i = 0; i < n; ++i) {
+      const int32_t value = values[i] >> shift;
+      std::memcpy(out.data() + begin + i * sizeof(int32_t), &value,
+                  sizeof(int32_t));
+    }
+  }
+  return static_cast<uint8_t>(static_cast<uint8_t>(encoding) | shift << 2);
+}
+
+uint8_t EncodeDigital(const uint8_t *values, size_t n,
+                      std::vector<uint8_t> &out)
+{
+  using Digital = WaveformCodec::Digital;
+
+  uint8_t any = 0;
+  bool binary = true;
+  for (size_t i = 0; i < n; ++i) {
+    any |= values[i];
+    binary &= values[i] <= 1;
+  }
+  if (any == 0) return static_cast<uint8_t>(Digital::Zero);
+  if (!binary) {
+    out.insert(out.end(), values, values + n);
+    return static_cast<uint8_t>(Digital::Bytes);
+  }
+
+  const auto begin = out.size();
+  out.resize(begin + (n + 7) / 8, 0);
+  for (size_t i = 0; i < n; ++i) {
+    out[begin + i / 8] |= static_cast<uint8_t>(values[i] << (i % 8));
+  }
+  return static_cast<uint8_t>(Digital::Bits);
+}
+
+bool DecodeAnalog(uint8_t header, const uint8_t *&data, const uint8_t *end,
+                  size_t n, int32_t *__restrict out)
+{
+  using Analog = WaveformCodec::Analog;
+
+  const unsigned shift = header >> 2;
+  if (shift > 31) return false;
+  const auto available = static_cast<size_t>(end - data);
+  switch (static_cast<Analog>(header & 0x3)) {
+    case Analog::Constant: {
+      if (available < sizeof(int32_t)) return false;
+      std::fill_n(out, n, Get<int32_t>(data));
+      data += sizeof(int32_t);
+      return true;
+    }
+    case Analog::Int16: {
+      if (available / sizeof(int16_t) < n) return false;
+#pragma omp simd
+      for (size_t i = 0; i < n; ++i) {
+        out[i] = Restore(Get<int16_t>(data + i * sizeof(int16_t)), shift);
+      }
+      data += n * sizeof(int16_t);
+      return true;
+    }
+    case Analog::Int32: {
+      if (available / sizeof(int32_t) < n) return false;
+#pragma omp simd
+      for (size_t i = 0; i < n; ++i) {
+        out[i] = Restore(Get<int32_t>(data + i * sizeof(int32_t)), shift);
+      }
+      data += n * sizeof(int32_t);
+      return true;
+    }
+    case Analog::Delta: {
+      int64_t value = 0;
+      for (size_t i = 0; i < n; ++i) {
+        uint64_t zigzag = 0;
+        unsigned bitShift = 0;
+        uint8_t byte = 0;
+        do {
+          if (data == end || bitShift > 63) return false;
+          byte = *data++;
+          zigzag |= static_cast<uint64_t>(byte & 0x7F) << bitShift;
+          bitShift += 7;
+        } while (byte & 0x80);
+        value += UnZigZag(zigzag);
+        out[i] = Restore(value, shift);
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+bool DecodeDigital(uint8_t encoding, const uint8_t *&data, const uint8_t *end,
+                   size_t n, uint8_t *__restrict out)
+{
+  using Digital = WaveformCodec::Digital;
+
+  const auto available = static_cast<size_t>(end - data);
+  switch (static_cast<Digital>(encoding)) {
+    case Digital::Zero:
+      std::fill_n(out, n, 0);
+      return true;
+    case Digital::Bits:
+      if (available < (n + 7) / 8) return false;
+#pragma omp simd
+      for (size_t i = 0; i < n; ++i) out[i] = (data[i / 8] >> (i % 8)) & 0x1;
+      data += (n + 7) / 8;
+      return true;
+    case Digital::Bytes:
+      if (available < n) return false;
+      std::memcpy(out, data, n);
+      data += n;
+      return true;
+  }
+  return false;
+}
+}  // namespace
+
+// ============================================================================
+// Encoding
+// ============================================================================
+
+void WaveformCodec::Encode(const EventData &event, bool delta,
+                           std::vector<uint8_t> &out)
+{
+  const size_t n = event.waveformSize;
+  out.assign(kHeaderSize, 0);
+  if (n == 0) return;
+
+  // The payloads are appended, the header bytes filled in afterwards
+  const uint8_t ap1Header =
+      EncodeAnalog(event.analogProbe1.data(), n, delta, out);
+  const uint8_t ap2Header =
+      EncodeAnalog(event.analogProbe2.data(), n, delta, out);
+  const uint8_t *digital[] = {
+      event.digitalProbe1.data(), event.digitalProbe2.data(),
+      event.digitalProbe3.data(), event.digitalProbe4.data()};
+  uint8_t digitalHeader = 0;
+  for (size_t probe = 0; probe < 4; ++probe) {
+    digitalHeader |= static_cast<uint8_t>(
+        EncodeDigital(digital[probe], n, out) << (2 * probe));
+  }
+  out[0] = ap1Header;
+  out[1] = ap2Header;
+  out[2] = digitalHeader;
+}
+
+void WaveformCodec::Compress(const uint8_t *words, size_t size,
+                             const PackedWaveformInfo &raw, bool delta,
+                             EventData &event)
+{
+  // Reused by every trace of this thread, so neither allocates once warm
+  thread_local EventData tScratch;
+  thread_local std::vector<uint8_t> tEncoded;
+
+  tScratch.packedWaveform.assign(words, words + size);
+  tScratch.packedWaveformInfo = raw;
+  tScratch.UnpackWaveform();
+  Encode(tScratch, delta, tEncoded);
+
+  event.packedWaveform.assign(tEncoded.begin(), tEncoded.end());
+  event.packedWaveformInfo = PackedWaveformInfo();
+  event.packedWaveformInfo.format = PackedWaveformInfo::Format::Compact;
+  event.packedWaveformInfo.nSamples = raw.nSamples;
+}
+
+// ============================================================================
+// Decoding
+// ============================================================================
+
+bool WaveformCodec::Decode(const uint8_t *data, size_t size, size_t nSamples,
+                           const WaveformUnpack::Output &out)
+{
+  if (nSamples == 0) return true;
+  if (size < kHeaderSize) return false;
+
+  const uint8_t *end = data + size;
+  const uint8_t ap1Header = data[0];
+  const uint8_t ap2Header = data[1];
+  const uint8_t digitalHeader = data[2];
+  data += kHeaderSize;
+
+  uint8_t *digital[] = {out.digitalProbe1, out.digitalProbe2,
+                        out.digitalProbe3, out.digitalProbe4};
+  bool ok = DecodeAnalog(ap1Header, data, end, nSamples, out.analogProbe1) &&
+            DecodeAnalog(ap2Header, data, end, nSamples, out.analogProbe2);
+  for (size_t probe = 0; ok && probe < 4; ++probe) {
+    ok = DecodeDigital((digitalHeader >> (2 * probe)) & 0x3, data, end,
+                       nSamples, digital[probe]);
+  }
+  return ok;
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA
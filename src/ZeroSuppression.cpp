@@ -0,0 +1,154 @@
+#include "ZeroSuppression.hpp"
+
+#include <iostream>
+#include <string>
+
+#include "EventData.hpp"
+
+namespace DELILA
+{
+namespace Digitizer
+{
+
+namespace
+{
+// Reads "A" or "A..B" into [first, last]
+bool ParseChannels(const std::string &spec, size_t &first, size_t &last)
+{
+  try {
+    auto dots = spec.find("..");
+    size_t pos = 0;
+    if (dots == std::string::npos) {
+      first = last = std::stoul(spec, &pos);
+      if (pos != spec.size()) return false;
+    } else {
+      first = std::stoul(spec.substr(0, dots), &pos);
+      if (pos != dots) return false;
+      auto lastStr = spec.substr(dots + 2);
+      last = std::stoul(lastStr, &pos);
+      if (pos != lastStr.size()) return false;
+    }
+  } catch (...) {
+    return false;
+  }
+  return first <= last && last < ZeroSuppressionConfig::kMaxChannels;
+}
+
+// Reads a number (decimal, 0x hexadecimal) or flag names joined with '|'
+bool ParseFlags(const std::string &value, uint64_t &flags)
+{
+  try {
+    size_t pos = 0;
+    auto number = std::stoull(value, &pos, 0);
+    if (pos == value.size()) {
+      flags = number;
+      return true;
+    }
+  } catch (...) {
+  }
+
+  uint64_t result = 0;
+  size_t begin = 0;
+  while (begin <= value.size()) {
+    auto end = value.find('|', begin);
+    if (end == std::string::npos) end = value.size();
+    auto name = value.substr(begin, end - begin);
+    name.erase(0, name.find_first_not_of(" \t"));
+    name.erase(name.find_last_not_of(" \t") + 1);
+    if (name == "PILEUP") {
+      result |= EventData::FLAG_PILEUP;
+    } else if (name == "TRIGGER_LOST") {
+      result |= EventData::FLAG_TRIGGER_LOST;
+    } else if (name == "OVER_RANGE") {
+      result |= EventData::FLAG_OVER_RANGE;
+    } else if (name == "1024_TRIGGER") {
+      result |= EventData::FLAG_1024_TRIGGER;
+    } else if (name == "N_LOST_TRIGGER") {
+      result |= EventData::FLAG_N_LOST_TRIGGER;
+    } else {
+      return false;
+    }
+    begin = end + 1;
+  }
+  flags = result;
+  return true;
+}
+
+bool ParseEnergy(const std::string &value, uint16_t &energy)
+{
+  try {
+    size_t pos = 0;
+    auto number = std::stoul(value, &pos, 0);
+    if (pos != value.size() || number > UINT16_MAX) return false;
+    energy = static_cast<uint16_t>(number);
+  } catch (...) {
+    return false;
+  }
+  return true;
+}
+}  // namespace
+
+// ============================================================================
+// Configuration
+// ============================================================================
+
+void ZeroSuppression::Configure(const ZeroSuppressionConfig &config)
+{
+  fConfig = config;
+  fEnabled = false;
+  for (const auto &channel : fConfig.channels) {
+    if (channel.energyMin != 0 || channel.energyMax != UINT16_MAX ||
+        channel.rejectFlags != 0) {
+      fEnabled = true;
+    }
+  }
+}
+
+ZeroSuppressionConfig ZeroSuppression::ParseConfig(
+    const ConfigurationManager &config)
+{
+  ZeroSuppressionConfig result;
+
+  // Applies value to channels [first, last]; false if value is invalid
+  auto apply = [&result](const std::string &name, const std::string &value,
+                         size_t first, size_t last) {
+    for (size_t ch = first; ch <= last; ++ch) {
+      auto &channel = result.channels[ch];
+      bool valid = name == "EnergyMin"   ? ParseEnergy(value, channel.energyMin)
+                   : name == "EnergyMax" ? ParseEnergy(value, channel.energyMax)
+                                         : ParseFlags(value, channel.rejectFlags);
+      if (!valid) return false;
+    }
+    return true;
+  };
+
+  // ZeroSuppressEnergyMin sets every channel, ZeroSuppressEnergyMin/0..7
+  // then overrides channels 0 to 7
+  static const std::string kPrefix = "ZeroSuppress";
+  for (const char *name : {"EnergyMin", "EnergyMax", "RejectFlags"}) {
+    auto key = kPrefix + name;
+    auto value = config.GetParameter(key);
+    if (!value.empty() &&
+        !apply(name, value, 0, ZeroSuppressionConfig::kMaxChannels - 1)) {
+      std::cout << "Invalid " << key << " \"" << value
+                << "\", using default for all channels" << std::endl;
+    }
+
+    for (const auto &paramKey : config.GetParameterKeys()) {
+      if (paramKey.compare(0, key.size() + 1, key + "/") != 0) continue;
+      size_t first = 0;
+      size_t last = 0;
+      if (!ParseChannels(paramKey.substr(key.size() + 1), first, last) ||
+          !apply(name, config.GetParameter(paramKey), first, last)) {
+        std::cout << "Invalid " << paramKey << " \""
+                  << config.GetParameter(paramKey) << "\", ignored"
+                  << std::endl;
+      }
+    }
+  }
+
+  return result;
+}
+
+}  // namespace Digitizer
+}  // namespace DELILA